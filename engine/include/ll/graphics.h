@@ -1,11 +1,13 @@
 #pragma once
 
 #include "../mercury_api.h"
+#include "../mercury_slot_map.h"
 #include "mercury_shader.h"
 #include <string>
 #include <glm/glm.hpp>
 #include <array>
 #include <variant>
+#include <span>
 #include <functional>
 
 namespace mercury {
@@ -252,6 +254,9 @@ struct FormatInfo
 
 const FormatInfo& GetFormatInfo(Format format);
 
+/// @brief Bytes of a tightly packed width x height x depth region, compressed formats round up to whole blocks
+size_t GetFormatDataSize(Format format, size_t width, size_t height, size_t depth = 1);
+
 struct ShaderBytecodeView
 {
   const void* data = nullptr;
@@ -266,12 +271,15 @@ enum class ShaderResourceType
 	ReadOnlyBuffer,
     RWImage,
 	SampledImage2D,
+	SampledImage2DTable, // array of sampled 2D textures indexed in the shader, see Device::GetMaxTextureTableSize
+	DynamicUniformBuffer, // uniform buffer range moved at bind time by a SetParameterBlock dynamic offset
 };
 
 struct BindingSlotDescriptor
 {
 	u8 bindingSlot = 0;
 	ShaderResourceType resourceType = ShaderResourceType::Undefined;
+	u32 arraySize = 1;
 };
 
 struct BindingSetLayoutDescriptor
@@ -288,6 +296,14 @@ struct BindingSetLayoutDescriptor
     {
 		return AddSlot(static_cast<u8>(allSlots.size()), resourceType);
     }
+
+    /// @brief Add a table of up to maxTextures sampled 2D textures, sharing one sampler.
+    /// Entries that are never written stay unbound and must not be sampled.
+    BindingSetLayoutDescriptor& AddTextureTable(u32 maxTextures)
+    {
+        allSlots.push_back({ static_cast<u8>(allSlots.size()), ShaderResourceType::SampledImage2DTable, maxTextures });
+        return *this;
+    }
 };
 
 
@@ -313,6 +329,13 @@ enum class CullMode : u8
     FrontAndBack
 };
 
+/// @brief AlphaBlend is straight alpha: color * a + destination * (1 - a).
+enum class BlendMode : u8
+{
+    Opaque,
+    AlphaBlend
+};
+
 enum class PrimitiveTopology : u8
 {
     TriangleList,
@@ -347,6 +370,12 @@ struct ParameterResourceTexture
     TextureHandle texture;
 };
 
+struct ParameterResourceTextureTable
+{
+    u32 firstElement = 0;
+    std::vector<TextureHandle> textures; // written to firstElement, firstElement + 1, ...
+};
+
 struct ParameterResourceRWImage
 {
 
@@ -362,6 +391,7 @@ struct ParameterBlockDescriptor
 	std::vector<std::variant<
         ParameterResourceBuffer,
         ParameterResourceTexture,
+        ParameterResourceTextureTable,
         ParameterResourceRWImage,
 		ParameterResourceEmpty>> resources;
 
@@ -377,6 +407,13 @@ struct ParameterBlockDescriptor
         return *this;
     }
 
+    /// @brief Write textures into a texture table slot starting at firstElement, other entries keep their contents.
+    ParameterBlockDescriptor& AddTextureTable(std::span<const TextureHandle> textures, u32 firstElement = 0)
+    {
+        resources.push_back(ParameterResourceTextureTable{ firstElement, { textures.begin(), textures.end() } });
+        return *this;
+    }
+
     ParameterBlockDescriptor& AddResource(const ParameterResourceBuffer& bufferResource)
     {
         resources.push_back(bufferResource);
@@ -423,6 +460,7 @@ struct RasterizePipelineDescriptor : public PipelineBindingLayoutDescriptor
     PolygonMode polygonMode = PolygonMode::Fill;
     CullMode cullMode = CullMode::None;
 	PrimitiveTopology primitiveTopology = PrimitiveTopology::TriangleList;
+	BlendMode blendMode = BlendMode::Opaque;
 
 	bool writeDepth = false;
 	bool testDepth = false;
@@ -438,6 +476,22 @@ struct RasterizePipelineDescriptor : public PipelineBindingLayoutDescriptor
     }
 };
 
+/// @brief Compute pipelines are dispatched outside render passes, see CommandList::Dispatch.
+struct ComputePipelineDescriptor : public PipelineBindingLayoutDescriptor
+{
+	Handle<u32> computeShader;
+};
+
+/// @brief Arguments read by CommandList::DrawIndirect, same layout on every backend.
+/// Keep firstInstance 0 when the shader reads SV_InstanceID, not every backend adds it there.
+struct DrawIndirectArguments
+{
+	u32 vertexCount = 0;
+	u32 instanceCount = 0;
+	u32 firstVertex = 0;
+	u32 firstInstance = 0;
+};
+
 struct TimelineSemaphore
 {
   void* nativePtr;
@@ -489,8 +543,23 @@ struct CommandList
 
   void SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID);
 
+  /// @brief Binds the block with one offset per DynamicUniformBuffer slot, in slot order. The offsets are added to the
+  /// offset the buffer was written with and must be multiples of Device::UploadRingAlignment, so one block pointing at
+  /// the upload ring serves every draw. Write those slots with an explicit size, the range moves but doesn't grow.
+  void SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID, std::span<const u32> dynamicOffsets);
+
   void SetIndexBuffer(BufferHandle bufferID); //only 16bit buffers supports
   void SetVertexBuffer(BufferHandle bufferID, u8 stride, u8 slot = 0, size_t offset = 0);
+
+  /// @brief Draws with the DrawIndirectArguments stored at offset in bufferID, usually written by an earlier dispatch.
+  void DrawIndirect(BufferHandle bufferID, size_t offset = 0);
+
+  /// @brief Runs the bound compute pipeline. Only valid outside render passes, on the frame command list record it
+  /// between Swapchain::AcquireNextImage and Swapchain::BeginFinalPass.
+  void Dispatch(u32 groupCountX, u32 groupCountY = 1, u32 groupCountZ = 1);
+
+  /// @brief Makes buffer writes of the dispatches recorded so far visible to later dispatches, draws and indirect arguments.
+  void DispatchBarrier();
 };
 
 struct CommandPool
@@ -604,7 +673,8 @@ enum class BufferType
     IndexBuffer,
     UniformBuffer,
     StorageBuffer,
-	StagingBuffer
+	StagingBuffer,
+	IndirectBuffer // storage buffer that can also hold DrawIndirectArguments
 };
 
 struct BufferDescriptor
@@ -615,6 +685,18 @@ struct BufferDescriptor
 	BufferType type = BufferType::StagingBuffer;
 };
 
+/// @brief Transient range of the device upload ring. Valid until the frame in flight it was allocated in is reused,
+/// write the data through cpuAddress and bind (buffer, offset, size) like any other buffer range.
+struct UploadAllocation
+{
+	BufferHandle buffer;
+	size_t offset = 0;
+	size_t size = 0;
+	void* cpuAddress = nullptr;
+
+	bool IsValid() const { return cpuAddress != nullptr; }
+};
+
 struct TextureDescriptor
 {
     size_t width = 1;
@@ -662,10 +744,31 @@ public:
   void UpdatePipelineState(PsoHandle psoID, const RasterizePipelineDescriptor& desc);
   void DestroyRasterizePipeline(PsoHandle psoID);
 
+  PsoHandle CreateComputePipeline(const ComputePipelineDescriptor& desc);
+  void DestroyComputePipeline(PsoHandle psoID);
+
   BufferHandle CreateBuffer(const BufferDescriptor& desc);
   void DestroyBuffer(BufferHandle bufferID);
   void UpdateBuffer(BufferHandle bufferID, const void* data, size_t size, size_t offset = 0);
 
+  /// @brief CPU pointer to the whole buffer that stays valid until the buffer is destroyed, nullptr when the backend
+  /// can't keep buffers mapped. Writes through it must be published with FlushBuffer before the GPU reads them.
+  void* GetMappedBufferPointer(BufferHandle bufferID);
+  void FlushBuffer(BufferHandle bufferID, size_t offset, size_t size);
+
+  /// @brief Sub-allocates the upload ring of the current frame in flight, a memcpy and a pointer bump.
+  /// Call between the start of the frame (canvas tick, OnFinalPass, OnImgui) and Present. Written ranges are published
+  /// by FlushUploads, which runs before Present and before SubmitOneTimeCommandsList records its commands.
+  /// Returns an invalid allocation when this frame's ring space is exhausted.
+  /// @param alignment 0 uses UploadRingAlignment, which satisfies uniform and storage buffer offsets on every backend.
+  UploadAllocation AllocateUpload(size_t size, size_t alignment = 0);
+  UploadAllocation Upload(const void* data, size_t size, size_t alignment = 0);
+
+  static constexpr size_t UploadRingAlignment = 256;
+
+  /// @brief Makes the upload ring ranges allocated so far visible to the GPU, every range once per frame.
+  void FlushUploads();
+
   TextureHandle CreateTexture(const TextureDescriptor& desc);
   void DestroyTexture(TextureHandle textureID);
   void UpdateTexture(TextureHandle textureID, const void* data, size_t size, size_t offset = 0);
@@ -684,6 +787,9 @@ public:
   ParameterBlockLayoutHandle CreateParameterBlockLayout(const BindingSetLayoutDescriptor& layoutDesc, int setIndex);
   void DestroyParameterBlockLayout(ParameterBlockLayoutHandle layoutID);
 
+  /// @brief Largest arraySize accepted for ShaderResourceType::SampledImage2DTable, 0 when texture tables are not supported.
+  u32 GetMaxTextureTableSize();
+
   ParameterBlockHandle CreateParameterBlock(const ParameterBlockLayoutHandle& layoutID);
   void UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const ParameterBlockDescriptor& pbDesc);
   void DestroyParameterBlock(ParameterBlockHandle parameterBlockID);
@@ -696,6 +802,11 @@ public:
 
 class Swapchain {
 public:
+  /// @brief Frames the CPU records ahead of the GPU, independent of the number of swapchain images.
+  /// Every backend frame ring and every per-frame engine ring (upload ring, frame allocator, canvas buffers) has this
+  /// many slots, so a slot is free to reuse once AcquireNextImage returns for it again.
+  static constexpr u8 NumFramesInFlight = 2;
+
   glm::vec4 clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
   float clearDepth = 1.0f;
   u8 clearStencil = 0;
@@ -709,8 +820,10 @@ public:
 
   void Shutdown();
 
-  /// @returns final pass command list
+  /// @returns frame command list, outside any pass until BeginFinalPass
   CommandList AcquireNextImage();
+  /// @brief Clears the backbuffer and starts the final pass on the frame command list, compute work goes before it.
+  void BeginFinalPass(CommandList& commandList);
   void Present();
 
   void SetFullscreen(bool fullscreen);
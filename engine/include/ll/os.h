@@ -24,6 +24,19 @@ struct OSInfo {
   OSArchitecture architecture;
 };
 
+/// @brief Backing hints for reserved memory. Platforms silently ignore the hints they can't honour.
+struct MemoryPolicy {
+  enum Flags : u8 {
+    None = 0,
+    TransparentHugePages = 1 << 0, // region is aligned to the huge page size and advised as huge page backed
+    ExplicitHugePages = 1 << 1,    // region comes from the hugetlb pool, size must be a multiple of the huge page size. Falls back to TransparentHugePages
+    Prefault = 1 << 2,             // CommitMemory faults the pages in immediately instead of on first touch
+  };
+
+  u8 flags = None;
+  i32 numaNode = -1; // -1 keeps the first touch placement
+};
+
 class OS {
 public:
   OS() = default;
@@ -77,9 +90,10 @@ public:
 	}
 
   size_t GetPageSize();
-  void* ReserveMemory(size_t size);
+  void* ReserveMemory(size_t size, const MemoryPolicy& policy = MemoryPolicy());
   void ReleaseMemory(void* ptr, size_t size);
-  void CommitMemory(void* ptr, size_t size);
+  void CommitMemory(void* ptr, size_t size, const MemoryPolicy& policy = MemoryPolicy());
+  /// @brief Returns the physical pages to the system, the range stays reserved.
   void DecommitMemory(void* ptr, size_t size);
 
   const char* GetName();
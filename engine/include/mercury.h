@@ -2,6 +2,7 @@
 
 #include "mercury_api.h"
 #include "mercury_simd.h"
+#include "mercury_simd_math.h"
 #include "mercury_utils.h"
 #include "mercury_application.h"
 #include "mercury_input.h"
@@ -2,6 +2,9 @@
 
 #include <type_traits>
 #include <string>
+#include <vector>
+#include <utility>
+#include <cassert>
 
 // Feature availability macros
 #if MERCURY_UWP
@@ -145,6 +148,18 @@ namespace mercury
     typedef __m128i i32x4;
     typedef __m128i u32x4;
     typedef __m128d f64x2;
+
+    // x86/x64 AVX2 and AVX-512 wide types, only operate on them in code compiled for that instruction set
+    // and reached through the runtime dispatcher (see mercury_simd.h)
+    typedef __m256 f32x8;
+    typedef __m256i i32x8;
+    typedef __m256i u32x8;
+    typedef __m256d f64x4;
+
+    typedef __m512 f32x16;
+    typedef __m512i i32x16;
+    typedef __m512i u32x16;
+    typedef __m512d f64x8;
 #endif
     #if MERCURY_USE_CPP20_FEATURES
     typedef char8_t c8;    
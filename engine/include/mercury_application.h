@@ -79,10 +79,13 @@ namespace mercury
     struct VKConfig
     {
       bool useDynamicRendering : 1;
+      /// @brief File the VkPipelineCache is loaded from at device init and saved to at shutdown, nullptr disables it
+      const char* pipelineCachePath;
 
       VKConfig()
       {
           useDynamicRendering = false;
+          pipelineCachePath = "mercury_vk_pipeline_cache.bin";
 	  }
     };
 
@@ -106,12 +109,16 @@ namespace mercury
       bool enable : 1;
       bool enableDocking : 1;
 	  bool enableViewports : 1;
+      bool showMemoryStats : 1; // per bucket telemetry of the graphics memory allocator
+      bool showFrameTiming : 1; // frame time graph and percentiles from the engine clock
 
       ImguiConfig()
       {
           enable = true;
 		  enableDocking = false;
           enableViewports = false; 
+          showMemoryStats = false;
+          showFrameTiming = false;
       }
     } imgui;
     struct Graphics
@@ -125,6 +132,8 @@ namespace mercury
 
       u8 explicitAdapterIndex = 255; // if 255 - no explicit adapter index is set
 
+      u32 uploadRingSize = 4 * 1024 * 1024; // per frame in flight, see Device::AllocateUpload
+
       enum class AdapterTypePreference
       {
         HighPerformance,
@@ -230,6 +239,55 @@ namespace mercury
     } appVersion = Version{{{0, 0, 1}}};
   };
 
+  /// @brief Engine clock owned by the application loop. It is stamped once at the start of every frame from a monotonic
+  /// source, so everything inside one tick (application, canvas, graphics) sees the same time.
+  namespace clock
+  {
+    /// @brief Timing of the current frame. Scaled values follow SetTimeScale and stop while paused, unscaled ones
+    /// always follow the wall clock. Deltas are clamped so a breakpoint or a dragged window doesn't jump animations.
+    struct FrameTiming
+    {
+      f64 time = 0.0;              // scaled seconds since the application was initialized
+      f64 unscaledTime = 0.0;      // wall seconds since the application was initialized
+      f32 deltaTime = 0.0f;        // scaled and clamped
+      f32 unscaledDeltaTime = 0.0f; // clamped
+      f32 smoothedDeltaTime = 0.0f; // exponential moving average of unscaledDeltaTime
+      u64 frameIndex = 0;
+    };
+
+    /// @brief Recent raw frame durations, for telemetry. Samples are milliseconds, oldest first.
+    struct FrameTimingStats
+    {
+      static constexpr u32 NumSamples = 256;
+
+      f32 samples[NumSamples] = {};
+      u32 count = 0;
+
+      f32 minMs = 0.0f;
+      f32 avgMs = 0.0f;
+      f32 maxMs = 0.0f;
+      f32 p99Ms = 0.0f;
+    };
+
+    const FrameTiming &GetFrameTiming();
+
+    inline f64 GetTime() { return GetFrameTiming().time; }
+    inline f32 GetDeltaTime() { return GetFrameTiming().deltaTime; }
+    inline f32 GetUnscaledDeltaTime() { return GetFrameTiming().unscaledDeltaTime; }
+    inline f32 GetSmoothedDeltaTime() { return GetFrameTiming().smoothedDeltaTime; }
+    inline u64 GetFrameIndex() { return GetFrameTiming().frameIndex; }
+
+    /// @brief Multiplier for the scaled time, applied from the next frame. Negative values are clamped to 0.
+    void SetTimeScale(f32 scale);
+    f32 GetTimeScale();
+
+    /// @brief While paused the scaled delta is 0 and the scaled time holds, the unscaled values keep running.
+    void SetPaused(bool paused);
+    bool IsPaused();
+
+    void GetFrameTimingStats(FrameTimingStats &outStats);
+  } // namespace clock
+
   class Application
   {
   protected:
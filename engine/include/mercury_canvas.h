@@ -2,13 +2,128 @@
 #include "mercury_api.h"
 #include <glm/glm.hpp>
 #include "ll/graphics.h"
+#include <string_view>
+#include <vector>
 
 namespace mercury {
 	namespace canvas
 	{
+		/// @brief Queues a sprite for this frame. Sprites are drawn instanced, one draw per texture, so submission order
+		/// is kept only among sprites sharing a texture. Textures registered with Atlas::AddImage are drawn from a shared
+		/// atlas page instead, their uv0/uv1 (expected in [0,1]) are remapped to the packed region.
+		/// Any thread may queue sprites at any time, each into its own queue whose lock is only contended while the tick
+		/// takes the queues over. Sprites queued during a tick are drawn by the next one. Sprites of one thread keep
+		/// their order, the order between threads is unspecified.
 		void DrawSprite(glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color);
 		void DrawSprite(ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color);
 
+		/// @brief Culls sprites on the GPU: a compute pass drops sprites whose bounding circle misses the canvas and compacts
+		/// the rest, which are drawn with DrawIndirect. Off by default, the compaction does not keep the submission order,
+		/// not even among sprites sharing a texture, so overlapping sprites may swap from frame to frame.
+		/// @returns false when the backend has no culling shader or no instanced sprites, sprites are then drawn as before
+		bool SetGpuCulling(bool enabled);
+
+		struct LayerHandle : public Handle<u32>
+		{
+		};
+
+		/// @brief Creates a retained sprite layer. Its sprites stay on the GPU between frames and only the ones changed
+		/// since the last frame are uploaded again, a layer left untouched costs its draws only.
+		/// Layers with a negative order are drawn below the sprites queued with DrawSprite, the others above them,
+		/// lower orders first. Layers are not thread safe, use them from the thread ticking the canvas.
+		LayerHandle CreateLayer(i32 order);
+		void DestroyLayer(LayerHandle layer);
+		void SetLayerVisible(LayerHandle layer, bool visible);
+
+		/// @brief Removes every sprite of the layer, indices returned by AddLayerSprite start over from 0.
+		void ClearLayer(LayerHandle layer);
+
+		/// @brief Appends a sprite, layer sprites are drawn in the order they were added. Consecutive sprites sharing a
+		/// texture are drawn together, so group sprites by texture where the order allows. Layers skip the atlas.
+		/// @returns index of the sprite in the layer, valid until ClearLayer
+		u32 AddLayerSprite(LayerHandle layer, ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color);
+		void UpdateLayerSprite(LayerHandle layer, u32 spriteIndex, ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color);
+
+		struct FontHandle : public Handle<u32>
+		{
+		};
+
+		/// @brief Loads a TrueType font for DrawText. Printable ASCII and extraCharacters (UTF-8) are rendered into signed
+		/// distance field pages right away, drawing never rasterizes. The canvas keeps its own copy of ttfData.
+		/// @returns an invalid handle when ttfData is not a font the rasterizer can read
+		FontHandle LoadFont(const void* ttfData, size_t ttfSize, std::u8string_view extraCharacters = {});
+		void UnloadFont(FontHandle font);
+
+		/// @brief Renders the glyphs of text the font doesn't have yet, call at load time. DrawText draws characters
+		/// without a glyph as '?'.
+		void PreloadGlyphs(FontHandle font, std::u8string_view text);
+
+		/// @brief Queues text for this frame, position is the top left corner of the first line and size the font pixel
+		/// height, '\n' starts a new line. Layouts of strings drawn recently are cached, so redrawing the same text only
+		/// places its glyphs. Text is drawn above the sprites queued with DrawSprite, one instanced draw per glyph page.
+		/// Any thread may queue text between canvas ticks.
+		void DrawText(FontHandle font, std::u8string_view text, glm::vec2 position, float size, PackedColor color);
+
+		/// @brief Width of the longest line and height of all lines of text drawn at size.
+		glm::vec2 MeasureText(FontHandle font, std::u8string_view text, float size);
+
+		/// @brief Skyline bottom-left rectangle packer. Rectangles can't be freed one by one, the whole packer is Reset instead.
+		class AtlasPacker
+		{
+		public:
+			void Reset(u32 width, u32 height);
+
+			/// @brief Finds room for a width x height rectangle, lowest top edge first, then the tightest skyline segment.
+			/// @returns false when the rectangle does not fit anywhere
+			bool Pack(u32 width, u32 height, u32& outX, u32& outY);
+
+			u32 GetWidth() const { return atlasWidth; }
+			u32 GetHeight() const { return atlasHeight; }
+
+			/// @brief Fraction of the atlas area covered by packed rectangles.
+			float GetOccupancy() const;
+
+		private:
+			struct SkylineNode
+			{
+				u32 x;
+				u32 y;
+				u32 width;
+			};
+
+			bool Fits(size_t nodeIndex, u32 width, u32 height, u32& outY) const;
+
+			std::vector<SkylineNode> skyline;
+			u32 atlasWidth = 0;
+			u32 atlasHeight = 0;
+			u64 usedArea = 0;
+		};
+
+		/// @brief Runtime atlas for small sprite images. Registered images are packed into shared RGBA8 pages the first time
+		/// they are drawn, so sprites using different images still batch into one draw. When every page is full the least
+		/// recently used page that no frame in flight reads anymore is evicted and refilled on demand.
+		class Atlas
+		{
+		public:
+			struct Stats
+			{
+				u32 numPages = 0;
+				u32 numImages = 0;
+				u32 numResidentImages = 0;
+				u32 numUploads = 0;
+				u32 numEvictions = 0;
+			};
+
+			/// @brief Registers texture as an atlas candidate. The canvas keeps its own copy of rgba8Pixels, width*height*4 bytes.
+			/// @returns false when the image is too large for the atlas, such textures keep being drawn on their own
+			static bool AddImage(ll::graphics::TextureHandle texture, u32 width, u32 height, const void* rgba8Pixels);
+
+			/// @brief Forgets texture, call before destroying it. Its atlas region is reclaimed when its page is evicted.
+			static void RemoveImage(ll::graphics::TextureHandle texture);
+
+			static Stats GetStats();
+		};
+
 		ll::graphics::BufferHandle GetCanvasScene2DConstantsBuffer();
 
 		void DrawDedicatedMesh(ll::graphics::BufferHandle vertexBuffer, u32 numVertices, glm::mat4 MVP);
@@ -4,15 +4,30 @@
 
 namespace mercury::ll::graphics::embedded_shaders {
 
+	// canvas_sprite_cull - CS
+	mercury::ll::graphics::ShaderBytecodeView CanvasSpriteCullCS();
+
+	// canvas_text - PS
+	mercury::ll::graphics::ShaderBytecodeView CanvasTextPS();
+
 	// dedicated_sprite - VS
 	mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteVS();
 
+	// dedicated_sprite - VS
+	mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteInstancedVS();
+
 	// dedicated_sprite - PS
 	mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteColorPS();
 
 	// dedicated_sprite - PS
 	mercury::ll::graphics::ShaderBytecodeView DedicatedSpritePS();
 
+	// dedicated_sprite_bindless - VS
+	mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessVS();
+
+	// dedicated_sprite_bindless - PS
+	mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessPS();
+
 	// dedicated_static_mesh - VS
 	mercury::ll::graphics::ShaderBytecodeView DedicatedStaticMeshVS();
 
@@ -1,5 +1,6 @@
 #pragma once
 #include <mercury_api.h>
+#include <mercury_memory.h>
 #include <glm/glm.hpp>
 
 namespace mercury
@@ -22,16 +23,30 @@ namespace mercury
             }
         };
 
+        /// @brief CPU side mesh. Storage comes from the given arena (global heap by default),
+        /// temporaries of the generators and RecomputeTangents come from the thread scratch allocator.
         struct StaticMeshData
         {
-            std::vector<DedicatedStaticMeshVertex> vertices;
-			std::vector<u16> indices;
+            memory::ArenaVector<DedicatedStaticMeshVertex> vertices;
+			memory::ArenaVector<u16> indices;
 
-            void RecomputeTangents();
+            StaticMeshData(memory::ArenaRef arena = {})
+                : vertices(memory::ArenaAllocatorSTL<DedicatedStaticMeshVertex>(arena)), indices(memory::ArenaAllocatorSTL<u16>(arena)) {
+            }
+
+            /// @brief Tangents and binormals from positions, UVs and normals, vectorized with mercury_simd.
+            /// numThreads > 1 splits the face and vertex passes into ranges (0 = hardware concurrency).
+            void RecomputeTangents(u32 numThreads = 1);
+
+            /// @brief Smooth area weighted normals. Vertices not referenced by any face keep their normal.
+            void RecomputeNormals(u32 numThreads = 1);
+
+            /// @brief Original one triangle at a time implementation, the reference for RecomputeTangents.
+            void RecomputeTangentsScalar();
         };
 
-		StaticMeshData CreatePlaneMesh(float width = 16.0f, float height = 16.0f, u16 subdivisionsWidth = 8, u16 subdivisionsHeight = 8);
-		StaticMeshData CreateCubeMesh(float size = 2.0f);
-		StaticMeshData CreateGeoSphereMesh(float radius = 1.0f, u8 subdivisions = 4);
+		StaticMeshData CreatePlaneMesh(float width = 16.0f, float height = 16.0f, u16 subdivisionsWidth = 8, u16 subdivisionsHeight = 8, memory::ArenaRef arena = {});
+		StaticMeshData CreateCubeMesh(float size = 2.0f, memory::ArenaRef arena = {});
+		StaticMeshData CreateGeoSphereMesh(float radius = 1.0f, u8 subdivisions = 4, memory::ArenaRef arena = {});
 	}
 }
\ No newline at end of file
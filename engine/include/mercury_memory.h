@@ -1,12 +1,58 @@
 #pragma once
 
 #include "mercury_api.h"
+#include "ll/os.h"
 #include <vector>
-#include <stack>
+#include <cstdint>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <new>
 
 namespace mercury {
 
 namespace memory {
+    /// @brief Order in which freed bucket slots are handed out again.
+    /// LIFO reuses the most recently freed (cache-hot) slot, FIFO spreads reuse over all free slots.
+    enum class FreeListPolicy : u8
+    {
+        LIFO,
+        FIFO,
+    };
+
+    /// @brief Binary allocation trace written by ReservedAllocator when InitDesc::traceFilePath is set.
+    /// The file is a Header followed by fixed size Event records in call order. A deallocation refers to its
+    /// allocation by address, lifetimes are recovered offline (see tools/allocator_tuner).
+    namespace trace
+    {
+        static constexpr u32 Magic = 0x4352544D; //'MTRC'
+        static constexpr u32 Version = 1;
+
+        enum class EventType : u8
+        {
+            Allocate,
+            Deallocate,
+        };
+
+        struct Header
+        {
+            u32 magic = Magic;
+            u32 version = Version;
+        };
+
+        struct Event
+        {
+            u64 address = 0;
+            u32 size = 0; //0 for deallocations
+            EventType type = EventType::Allocate;
+            u8 padding[3] = {};
+        };
+
+        static_assert(sizeof(Event) == 16);
+    }
+
     struct ReservedAllocator
     {
         struct InitDesc
@@ -19,24 +65,145 @@ namespace memory {
             };
 
             std::vector<MemoryBucketInfo> bucketsInfo;
+            FreeListPolicy freeListPolicy = FreeListPolicy::LIFO;
+
+            /// @brief Allows Allocate/Deallocate from any thread. Each thread serves small allocations from its own
+            /// magazines (chains of magazineSize free slots) and exchanges full magazines with a lock-free per bucket depot.
+            bool threadSafe = false;
+            u16 magazineSize = 64;
+
+            /// @brief Period of a background thread that calls Trim(), 0 disables it. Requires threadSafe.
+            u32 backgroundTrimIntervalMs = 0;
+
+            /// @brief Streams every Allocate/Deallocate to this file (see memory::trace), nullptr disables recording.
+            const char* traceFilePath = nullptr;
+
+            /// @brief Backing of the bucket reservation and of the per bucket side tables, used on every commit as well.
+            ll::os::MemoryPolicy memoryPolicy;
+        };
+
+        /// @brief Chain of free slots linked through their first 4 bytes, cached by one thread.
+        struct Magazine
+        {
+            u32 head = 0xFFFFFFFF;
+            u32 count = 0;
+        };
+
+        static constexpr u8 NumStatShards = 8;
+        static constexpr u8 NumSizeHistogramBins = 16;
+
+        /// @brief Slice of the bucket counters. Every thread bumps the shard it picked once with relaxed atomics,
+        /// so threads rarely share a cache line. A live counter may wrap inside one shard, the sum over shards is exact.
+        struct alignas(64) BucketStatShard
+        {
+            std::atomic<u64> allocationsCount{0};
+            std::atomic<u64> allocatedMemUser{0};
+
+            std::atomic<u64> totalAllocationsCount{0};
+            std::atomic<u64> totalAllocatedMemUser{0};
+
+            //bin i counts requests of (i, i + 1] / NumSizeHistogramBins of the element size
+            std::atomic<u64> sizeHistogram[NumSizeHistogramBins] = {};
+        };
+
+        struct alignas(64) StatShard
+        {
+            std::atomic<u64> totalAllocationsCount{0};
+            std::atomic<u64> totalAllocatedMemUser{0};
+            std::atomic<u64> totalAllocatedMemSystem{0};
+
+            std::atomic<u64> totalReallocsCount{0};
+            std::atomic<u64> totalReallocsSaveBySameBucket{0};
+            std::atomic<u64> totalMallocAllocations{0};
+        };
+
+        struct BucketSnapshot
+        {
+            u16 elementSize = 0;
+            u64 reservedSize = 0;
+            u64 committedSize = 0;
+
+            //fields below need MERCURY_USE_MEMORY_STAT
+            u64 allocationsCount = 0;
+            u64 usedSize = 0; //live slots * element size
+            u64 userSize = 0; //bytes requested for the live slots, usedSize - userSize is lost to rounding
+            u64 totalAllocationsCount = 0;
+            u64 totalAllocatedMemUser = 0;
+            u64 totalSystemPagesCommitted = 0;
+            u64 totalDecommittedSize = 0;
+            u64 sizeHistogram[NumSizeHistogramBins] = {};
+        };
+
+        struct Snapshot
+        {
+            u64 reservedSize = 0;
+            u64 committedSize = 0;
+            u64 totalTrimmedSize = 0;
+
+            //fields below need MERCURY_USE_MEMORY_STAT
+            u64 totalAllocationsCount = 0;
+            u64 totalAllocatedMemUser = 0;
+            u64 totalAllocatedMemSystem = 0;
+            u64 totalReallocsCount = 0;
+            u64 totalReallocsSaveBySameBucket = 0;
+            u64 totalMallocAllocations = 0;
+
+            std::vector<BucketSnapshot> buckets;
         };
 
         /// @brief Memory bucket for desired element size. Element size must be less than 64KB.
         /// maximumReservedSize and initialCommittedSize must be a multiple of the page size.
         /// maximumReservedSize and initialCommittedSize must evenly divide by the elementSize.
+        /// The bucket does not own its address range: it lives in a slot of the allocator's single reservation.
+        /// Free slots form an intrusive list: each freed slot stores the id of the next free slot in its first 4 bytes.
         struct Bucket
         {
-            Bucket(u16 elementSize, u32 maximumReservedSize, u32 initialCommitedSize);
+            static constexpr u32 InvalidSlot = 0xFFFFFFFF;
+
+            Bucket(void* region, u16 elementSize, u32 maximumReservedSize, u32 initialCommitedSize, FreeListPolicy freeListPolicy, const ll::os::MemoryPolicy& memoryPolicy);
             ~Bucket();
 
             void* beginRegion = nullptr;
             u32 maximumReservedSize = 0;
 
+            u32 commitedSize = 0;
+            u32 initialCommitedSize = 0; //Trim never goes below it
             u32 commitedElements = 0;            
             u32 lastAllocatedID = 0;
             u32 maximumReservedElements = 0;
             u16 elementSize = 0;
-            std::stack<u32> freeList;
+            FreeListPolicy freeListPolicy = FreeListPolicy::LIFO;
+            ll::os::MemoryPolicy memoryPolicy;
+
+            u32 freeListHead = InvalidSlot;
+            u32 freeListTail = InvalidSlot; //FIFO appends freed slots here
+
+            //thread safe mode: the bucket itself is only touched under the mutex, full magazines go through the depot.
+            //depot head packs an ABA tag in the high 32 bits and the first slot id of the top magazine in the low 32 bits,
+            //the second u32 of that slot links to the next magazine in the depot
+            std::mutex mutex;
+            std::atomic<u64> depotHead{InvalidSlot};
+            std::atomic<u32> depotReaders{0}; //threads inside PopMagazineFromDepot, Trim waits for them before decommit
+
+            void PushMagazineToDepot(u32 head);
+            u32 PopMagazineFromDepot();
+            bool RefillMagazine(Magazine& magazine, u16 magazineSize);
+            void ReturnMagazine(Magazine& magazine);
+            void FreeMagazineSlots(const Magazine& magazine); //caller holds the mutex
+
+            /// @brief Decommits the pages past the last allocated slot. Free slots in that range leave the free list.
+            /// A non zero magazineSize also drains the depot first (thread safe mode). Returns the decommitted bytes.
+            size_t Trim(u16 magazineSize);
+
+            inline void* GetSlotPtr(u32 id) const
+            {
+                return (u8*)beginRegion + (size_t)id * elementSize;
+            }
+
+            inline u32 GetSlotId(const void* ptr) const
+            {
+                return (u32)((const u8*)ptr - (const u8*)beginRegion) / elementSize;
+            }
 
             void* Allocate(u16 size);
             void Deallocate(void* ptr);
@@ -46,56 +213,107 @@ namespace memory {
 
             #ifdef MERCURY_USE_MEMORY_STAT
 
-            u64 totalCommittedMem = 0;
+            //commit counters change under the mutex only, snapshots read them without it
+            std::atomic<u64> totalSystemPagesCommitted{0};
+            std::atomic<u64> totalDecommittedMem{0};
 
-            //current allocations
-            u64 allocationsCount = 0;
-            u64 allocatedMemSystem = 0;
-            u64 allocatedMemUser = 0;
+            //requested size of every slot in its own reservation, committed in step with the bucket
+            u16* userSizes = nullptr;
+            u32 userSizesReservedSize = 0;
+            u32 userSizesCommitedSize = 0;
+            void ResizeUserSizes(u32 elements);
 
-            u64 totalAllocationsCount = 0;
-            u64 totalAllocatedMemSystem = 0;
-            u64 totalAllocatedMemUser = 0;
-
-            u64 totalSystemPagesCommitted = 0;
-            std::vector<u16> allocationUserSizes;
-            u16 DeallocateAndReturnUserSize(void* ptr);
-
-            void ResetFrame();
-            void DumpStatsTotal();
-            void DumpStateFrame();
+            BucketStatShard stats[NumStatShards];
             #endif
         };
 
+        static constexpr u8 InvalidBucket = 0xFF;
+        static constexpr u8 MaxThreadCachedBuckets = 32;
+        static constexpr u8 MaxThreadSafeAllocators = 4;
+
+        //size classes are 8 bytes wide, so the table covers every possible u16 element size
+        static constexpr u8 SizeClassShift = 3;
+        static constexpr u32 SizeClassGranularity = 1u << SizeClassShift;
+        static constexpr u32 NumSizeClasses = (0xFFFFu + SizeClassGranularity - 1) / SizeClassGranularity + 1;
+
         Bucket *buckets;
 
         //dedicated sizes for improve cache locality while finding correct bucket
         u16 *bucketSizes; 
         u8 numBuckets;
 
+        //all buckets share one reservation, bucket i starts at beginRegion + (i << bucketRegionShift)
+        void* beginRegion = nullptr;
+        size_t reservedRegionSize = 0;
+        u8 bucketRegionShift = 0;
+        u16 maxBucketElementSize = 0;
+
+        //maps a size class to the smallest bucket able to hold it
+        u8 sizeClassToBucket[NumSizeClasses];
+
+        bool threadSafe = false;
+        u16 magazineSize = 0;
+        u8 threadCacheIndex = 0; //slot in the thread local cache table, valid in thread safe mode only
+
+        std::atomic<u64> totalTrimmedSize{0};
+
+        //trace recording, events are buffered and written in blocks
+        static constexpr u32 TraceBufferEvents = 4096;
+
+        FILE* traceFile = nullptr;
+        std::mutex traceMutex;
+        std::vector<trace::Event> traceBuffer;
+        void RecordTraceEvent(trace::EventType type, const void* ptr, size_t size);
+        void FlushTrace();
+
+        std::thread* trimThread = nullptr;
+        std::mutex trimMutex;
+        std::condition_variable trimCondition;
+        bool trimThreadStop = false;
+
         ReservedAllocator(const InitDesc& desc);
         ~ReservedAllocator();
 
         void* Allocate(size_t size);
         void Deallocate(void* ptr);
-        void* ReAllocate(void* ptr, u16 size);
-       
-        #ifdef MERCURY_USE_MEMORY_STAT
+        void* ReAllocate(void* ptr, size_t size);
+
+        /// @brief Returns the calling thread's cached slots to the buckets. Call it from worker threads that go idle;
+        /// thread exit does it automatically.
+        void FlushThreadCache();
 
-        //current allocations
-        u64 allocationsCount = 0;
-        u64 allocatedMemSystem = 0;
-        u64 allocatedMemUser = 0;
+        /// @brief Returns fully free trailing pages of every bucket to the system and reports the number of bytes.
+        /// In thread safe mode it first flushes the calling thread's cache and drains idle magazines,
+        /// slots cached by other threads stay committed. Otherwise call it from the thread that owns the allocator.
+        size_t Trim();
 
-        u64 totalAllocationsCount = 0;
-        u64 totalAllocatedMemSystem = 0;
-        u64 totalAllocatedMemUser = 0;
+        void* AllocateThreadCached(u8 bucketIndex);
+        void DeallocateThreadCached(u8 bucketIndex, void* ptr);
 
-        u64 totalReallocsCount = 0;
-        u64 totalReallocsSaveBySameBucket = 0;
-        u64 totalSystemAllocationsCount = 0;
+        /// @brief Returns the bucket serving allocations of the given size, or InvalidBucket if it goes to the system heap.
+        inline u8 GetBucketIndexForSize(size_t size) const
+        {
+            IF_UNLIKELY(size > maxBucketElementSize)
+                return InvalidBucket;
+
+            return sizeClassToBucket[(size + SizeClassGranularity - 1) >> SizeClassShift];
+        }
+
+        /// @brief Returns the bucket owning the pointer, or InvalidBucket if the pointer was not allocated by buckets.
+        inline u8 GetBucketIndexForPtr(const void* ptr) const
+        {
+            uintptr_t index = ((uintptr_t)ptr - (uintptr_t)beginRegion) >> bucketRegionShift;
+            return index < numBuckets ? (u8)index : InvalidBucket;
+        }
+       
+        /// @brief Copies the counters of the allocator and its buckets. Cheap enough to call once per frame from any thread.
+        void GetSnapshot(Snapshot& snapshot);
 
-        u64 totalMallocAllocations = 0;
+        #ifdef MERCURY_USE_MEMORY_STAT
+        StatShard stats[NumStatShards];
+
+        void RecordAllocation(u8 bucketIndex, void* ptr, size_t size);
+        void RecordDeallocation(u8 bucketIndex, void* ptr);
         #endif
 
         void ResetFrame();
@@ -106,6 +324,236 @@ namespace memory {
         void DumpStatePerBucketFrame();
     };
 
+    /// @brief Linear (bump) allocator for data that lives for one frame only.
+    /// Every frame in flight owns an arena inside a single reservation. BeginFrame resets the arena of that frame,
+    /// so it must be called once the GPU finished the previous use of the frame slot.
+    /// Deallocation is a no-op. Not thread safe: use it from the tick thread.
+    struct FrameAllocator
+    {
+        static constexpr u8 MaxFramesInFlight = 4;
+
+        struct InitDesc
+        {
+            u8 numFramesInFlight = 2;
+            size_t maximumReservedSizePerFrame = 64_MB;
+            size_t commitGranularity = 256_KB; //must be a multiple of the page size
+            ll::os::MemoryPolicy memoryPolicy;
+        };
+
+        struct Arena
+        {
+            u8* beginRegion = nullptr;
+            size_t offset = 0;
+            size_t commitedSize = 0;
+            size_t highWaterMark = 0;
+        };
+
+        Arena arenas[MaxFramesInFlight];
+        u8 numFramesInFlight = 0;
+        u8 currentFrame = 0;
+
+        void* beginRegion = nullptr;
+        size_t maximumReservedSizePerFrame = 0;
+        size_t commitGranularity = 0;
+        ll::os::MemoryPolicy memoryPolicy;
+
+        FrameAllocator(const InitDesc& desc);
+        ~FrameAllocator();
+
+        /// @brief Switches to the arena of the given frame in flight and discards everything allocated in it.
+        void BeginFrame(u8 frameInFlightIndex);
+
+        void* Allocate(size_t size, size_t alignment = 16);
+
+        template <typename T>
+        T* AllocateArray(size_t count)
+        {
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        size_t GetUsedSize() const { return arenas[currentFrame].offset; }
+        size_t GetCommitedSize() const { return arenas[currentFrame].commitedSize; }
+    };
+
+    extern FrameAllocator* gFrameAllocator;
+
+    /// @brief STL allocator adapter over a FrameAllocator. Falls back to the global heap if no frame allocator is given,
+    /// so containers stay usable before the graphics system is up.
+    template <typename T>
+    struct FrameAllocatorSTL
+    {
+        using value_type = T;
+
+        FrameAllocator* allocator = nullptr;
+
+        FrameAllocatorSTL(FrameAllocator* frameAllocator = gFrameAllocator) noexcept : allocator(frameAllocator) {}
+
+        template <typename U>
+        FrameAllocatorSTL(const FrameAllocatorSTL<U>& other) noexcept : allocator(other.allocator) {}
+
+        T* allocate(size_t n)
+        {
+            IF_LIKELY(allocator)
+            {
+                // containers never check for nullptr, report exhaustion the way operator new does
+                T* result = allocator->AllocateArray<T>(n);
+                IF_UNLIKELY(result == nullptr && n > 0)
+                    throw std::bad_alloc();
+
+                return result;
+            }
+
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, [[maybe_unused]] size_t n) noexcept
+        {
+            IF_UNLIKELY(!allocator)
+                ::operator delete(ptr);
+        }
+
+        template <typename U>
+        bool operator==(const FrameAllocatorSTL<U>& other) const noexcept { return allocator == other.allocator; }
+
+        template <typename U>
+        bool operator!=(const FrameAllocatorSTL<U>& other) const noexcept { return allocator != other.allocator; }
+    };
+
+    /// @brief Transient vector, storage is released when its frame slot comes around again. Do not keep across frames.
+    template <typename T>
+    using FrameVector = std::vector<T, FrameAllocatorSTL<T>>;
+
+    /// @brief Stack-like arena for the temporaries of a single operation (mesh generation, tangent solving...).
+    /// Memory is released all at once by rewinding to a marker, ScratchScope does it on scope exit.
+    /// Committed pages are kept, so once warmed up allocations reach neither the OS nor the global heap.
+    /// Not thread safe: use GetThreadScratchAllocator() to get the calling thread's instance.
+    struct ScratchAllocator
+    {
+        struct InitDesc
+        {
+            size_t maximumReservedSize = 64_MB;
+            size_t commitGranularity = 64_KB; //must be a multiple of the page size
+            ll::os::MemoryPolicy memoryPolicy;
+        };
+
+        u8* beginRegion = nullptr;
+        size_t offset = 0;
+        size_t commitedSize = 0;
+        size_t highWaterMark = 0;
+        size_t maximumReservedSize = 0;
+        size_t commitGranularity = 0;
+        ll::os::MemoryPolicy memoryPolicy;
+
+        ScratchAllocator(const InitDesc& desc);
+        ~ScratchAllocator();
+
+        void* Allocate(size_t size, size_t alignment = 16);
+
+        /// @brief Gives the memory back right away only if it is the most recent allocation (growing vectors),
+        /// anything else is reclaimed by the next Rewind.
+        void Deallocate(void* ptr, size_t size);
+
+        template <typename T>
+        T* AllocateArray(size_t count)
+        {
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        size_t GetMarker() const { return offset; }
+        void Rewind(size_t marker);
+
+        size_t GetUsedSize() const { return offset; }
+        size_t GetCommitedSize() const { return commitedSize; }
+    };
+
+    /// @brief Lazily created scratch allocator of the calling thread, lives until the thread exits.
+    ScratchAllocator* GetThreadScratchAllocator();
+
+    /// @brief Rewinds the scratch allocator to the position it had when the scope was entered.
+    struct ScratchScope
+    {
+        ScratchAllocator* allocator = nullptr;
+        size_t marker = 0;
+
+        ScratchScope(ScratchAllocator* scratchAllocator = GetThreadScratchAllocator())
+            : allocator(scratchAllocator), marker(scratchAllocator->GetMarker()) {}
+        ~ScratchScope() { allocator->Rewind(marker); }
+
+        ScratchScope(const ScratchScope&) = delete;
+        ScratchScope& operator=(const ScratchScope&) = delete;
+    };
+
+    /// @brief Memory source for containers that should not use the global heap: a ReservedAllocator,
+    /// a ScratchAllocator or, when neither is set, the global heap.
+    struct ArenaRef
+    {
+        ReservedAllocator* reserved = nullptr;
+        ScratchAllocator* scratch = nullptr;
+
+        static ArenaRef Heap() { return ArenaRef{}; }
+        static ArenaRef Reserved(ReservedAllocator* allocator) { return ArenaRef{ allocator, nullptr }; }
+        static ArenaRef Scratch(ScratchAllocator* allocator = GetThreadScratchAllocator()) { return ArenaRef{ nullptr, allocator }; }
+
+        void* Allocate(size_t size, size_t alignment)
+        {
+            IF_LIKELY(scratch)
+                return scratch->Allocate(size, alignment);
+
+            if (reserved)
+                return reserved->Allocate(size);
+
+            return ::operator new(size);
+        }
+
+        void Deallocate(void* ptr, size_t size)
+        {
+            IF_LIKELY(scratch)
+                scratch->Deallocate(ptr, size);
+            else if (reserved)
+                reserved->Deallocate(ptr);
+            else
+                ::operator delete(ptr);
+        }
+
+        bool operator==(const ArenaRef& other) const { return reserved == other.reserved && scratch == other.scratch; }
+        bool operator!=(const ArenaRef& other) const { return !(*this == other); }
+    };
+
+    /// @brief STL allocator adapter over an ArenaRef.
+    template <typename T>
+    struct ArenaAllocatorSTL
+    {
+        using value_type = T;
+        using propagate_on_container_move_assignment = std::true_type;
+        using propagate_on_container_swap = std::true_type;
+
+        ArenaRef arena;
+
+        ArenaAllocatorSTL(ArenaRef arenaRef = {}) noexcept : arena(arenaRef) {}
+
+        template <typename U>
+        ArenaAllocatorSTL(const ArenaAllocatorSTL<U>& other) noexcept : arena(other.arena) {}
+
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(arena.Allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept
+        {
+            arena.Deallocate(ptr, n * sizeof(T));
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocatorSTL<U>& other) const noexcept { return arena == other.arena; }
+
+        template <typename U>
+        bool operator!=(const ArenaAllocatorSTL<U>& other) const noexcept { return arena != other.arena; }
+    };
+
+    template <typename T>
+    using ArenaVector = std::vector<T, ArenaAllocatorSTL<T>>;
+
     extern ReservedAllocator* gGraphicsMemoryAllocator;
 }
 }
\ No newline at end of file
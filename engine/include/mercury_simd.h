@@ -2,11 +2,33 @@
 
 #include "mercury_api.h"
 
+// Everything inline below compiles to the instruction set of the including translation unit, and the wide kernel
+// units in engine/src/simd are built with -mavx2/-mavx512f. Each instruction set gets its own inline namespace, so
+// those copies have their own symbols and the linker can never hand a VEX/EVEX encoded helper to baseline code.
+// Call sites keep writing simd::add_f32x4.
+#if defined(__AVX512F__)
+#define MERCURY_SIMD_ISA_NAMESPACE isa_avx512
+#elif defined(__AVX2__) && defined(__FMA__)
+#define MERCURY_SIMD_ISA_NAMESPACE isa_avx2_fma
+#elif defined(__AVX2__)
+#define MERCURY_SIMD_ISA_NAMESPACE isa_avx2
+#elif defined(__AVX__)
+#define MERCURY_SIMD_ISA_NAMESPACE isa_avx
+#elif defined(__ARM_NEON)
+#define MERCURY_SIMD_ISA_NAMESPACE isa_neon
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+#define MERCURY_SIMD_ISA_NAMESPACE isa_wasm128
+#else
+#define MERCURY_SIMD_ISA_NAMESPACE isa_sse41
+#endif
+
 namespace mercury {
 
 // SIMD utility functions for cross-platform compatibility
 namespace simd {
 
+inline namespace MERCURY_SIMD_ISA_NAMESPACE {
+
 // Float32x4 operations
 inline f32x4 make_f32x4(f32 x, f32 y, f32 z, f32 w) {
 #if defined(__ARM_NEON)
@@ -224,6 +246,853 @@ inline i32x4 splat_i32x4(i32 value) {
 #endif
 }
 
+inline i32x4 load_i32x4(const i32* ptr) {
+#if defined(__ARM_NEON)
+    return vld1q_s32(ptr);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_load(ptr);
+#else
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+#endif
+}
+
+inline void store_i32x4(i32* ptr, i32x4 v) {
+#if defined(__ARM_NEON)
+    vst1q_s32(ptr, v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    wasm_v128_store(ptr, v);
+#else
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), v);
+#endif
+}
+
+// ptr must be 16-byte aligned
+inline f32x4 load_aligned_f32x4(const f32* ptr) {
+#if defined(__ARM_NEON)
+    return vld1q_f32(ptr);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_load(ptr);
+#else
+    return _mm_load_ps(ptr);
+#endif
+}
+
+// ptr must be 16-byte aligned
+inline void store_aligned_f32x4(f32* ptr, f32x4 v) {
+#if defined(__ARM_NEON)
+    vst1q_f32(ptr, v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    wasm_v128_store(ptr, v);
+#else
+    _mm_store_ps(ptr, v);
+#endif
+}
+
+// Non-temporal store for write-once data (upload buffers, large copies), ptr must be 16-byte aligned.
+// Call stream_fence() before the data is consumed by another thread or the GPU.
+// NEON and WASM have no non-temporal hint here, it is a regular store.
+inline void stream_f32x4(f32* ptr, f32x4 v) {
+#if defined(__ARM_NEON)
+    vst1q_f32(ptr, v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    wasm_v128_store(ptr, v);
+#else
+    _mm_stream_ps(ptr, v);
+#endif
+}
+
+inline void stream_fence() {
+#if !defined(__ARM_NEON) && !defined(MERCURY_LL_OS_EMSCRIPTEN)
+    _mm_sfence();
+#endif
+}
+
+// Lane gathers: out[i] = base[indices[i]]. Uses vgatherdps with AVX2, lane by lane otherwise.
+inline f32x4 gather_f32x4(const f32* base, i32x4 indices) {
+#if defined(__ARM_NEON)
+    f32x4 r = vdupq_n_f32(base[vgetq_lane_s32(indices, 0)]);
+    r = vsetq_lane_f32(base[vgetq_lane_s32(indices, 1)], r, 1);
+    r = vsetq_lane_f32(base[vgetq_lane_s32(indices, 2)], r, 2);
+    return vsetq_lane_f32(base[vgetq_lane_s32(indices, 3)], r, 3);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_make(base[wasm_i32x4_extract_lane(indices, 0)], base[wasm_i32x4_extract_lane(indices, 1)],
+        base[wasm_i32x4_extract_lane(indices, 2)], base[wasm_i32x4_extract_lane(indices, 3)]);
+#elif defined(__AVX2__)
+    return _mm_i32gather_ps(base, indices, 4);
+#else
+    return _mm_setr_ps(base[_mm_cvtsi128_si32(indices)], base[_mm_extract_epi32(indices, 1)],
+        base[_mm_extract_epi32(indices, 2)], base[_mm_extract_epi32(indices, 3)]);
+#endif
+}
+
+inline i32x4 gather_i32x4(const i32* base, i32x4 indices) {
+#if defined(__ARM_NEON)
+    i32x4 r = vdupq_n_s32(base[vgetq_lane_s32(indices, 0)]);
+    r = vsetq_lane_s32(base[vgetq_lane_s32(indices, 1)], r, 1);
+    r = vsetq_lane_s32(base[vgetq_lane_s32(indices, 2)], r, 2);
+    return vsetq_lane_s32(base[vgetq_lane_s32(indices, 3)], r, 3);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_make(base[wasm_i32x4_extract_lane(indices, 0)], base[wasm_i32x4_extract_lane(indices, 1)],
+        base[wasm_i32x4_extract_lane(indices, 2)], base[wasm_i32x4_extract_lane(indices, 3)]);
+#elif defined(__AVX2__)
+    return _mm_i32gather_epi32(base, indices, 4);
+#else
+    return _mm_setr_epi32(base[_mm_cvtsi128_si32(indices)], base[_mm_extract_epi32(indices, 1)],
+        base[_mm_extract_epi32(indices, 2)], base[_mm_extract_epi32(indices, 3)]);
+#endif
+}
+
+// Conversions and bit casts
+inline f32x4 convert_i32x4_to_f32x4(i32x4 v) {
+#if defined(__ARM_NEON)
+    return vcvtq_f32_s32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_convert_i32x4(v);
+#else
+    return _mm_cvtepi32_ps(v);
+#endif
+}
+
+// Rounds toward zero. Out of range lanes are unspecified (SSE returns INT_MIN, NEON/WASM saturate).
+inline i32x4 truncate_f32x4_to_i32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vcvtq_s32_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_trunc_sat_f32x4(v);
+#else
+    return _mm_cvttps_epi32(v);
+#endif
+}
+
+// Rounds to nearest, ties to even
+inline i32x4 round_f32x4_to_i32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vcvtnq_s32_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(v));
+#else
+    return _mm_cvtps_epi32(v);
+#endif
+}
+
+inline i32x4 cast_f32x4_to_i32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vreinterpretq_s32_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return v;
+#else
+    return _mm_castps_si128(v);
+#endif
+}
+
+inline f32x4 cast_i32x4_to_f32x4(i32x4 v) {
+#if defined(__ARM_NEON)
+    return vreinterpretq_f32_s32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return v;
+#else
+    return _mm_castsi128_ps(v);
+#endif
+}
+
+inline u32x4 cast_i32x4_to_u32x4(i32x4 v) {
+#if defined(__ARM_NEON)
+    return vreinterpretq_u32_s32(v);
+#else
+    return v;
+#endif
+}
+
+inline i32x4 cast_u32x4_to_i32x4(u32x4 v) {
+#if defined(__ARM_NEON)
+    return vreinterpretq_s32_u32(v);
+#else
+    return v;
+#endif
+}
+
+// Comparisons return a u32x4 mask, every lane is either all ones or all zeros
+inline u32x4 cmpeq_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vceqq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_eq(a, b);
+#else
+    return _mm_castps_si128(_mm_cmpeq_ps(a, b));
+#endif
+}
+
+inline u32x4 cmplt_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vcltq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_lt(a, b);
+#else
+    return _mm_castps_si128(_mm_cmplt_ps(a, b));
+#endif
+}
+
+inline u32x4 cmple_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vcleq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_le(a, b);
+#else
+    return _mm_castps_si128(_mm_cmple_ps(a, b));
+#endif
+}
+
+inline u32x4 cmpgt_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vcgtq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_gt(a, b);
+#else
+    return _mm_castps_si128(_mm_cmpgt_ps(a, b));
+#endif
+}
+
+inline u32x4 cmpge_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vcgeq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_ge(a, b);
+#else
+    return _mm_castps_si128(_mm_cmpge_ps(a, b));
+#endif
+}
+
+inline u32x4 cmpeq_i32x4(i32x4 a, i32x4 b) {
+#if defined(__ARM_NEON)
+    return vceqq_s32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_eq(a, b);
+#else
+    return _mm_cmpeq_epi32(a, b);
+#endif
+}
+
+inline u32x4 cmplt_i32x4(i32x4 a, i32x4 b) {
+#if defined(__ARM_NEON)
+    return vcltq_s32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_lt(a, b);
+#else
+    return _mm_cmplt_epi32(a, b);
+#endif
+}
+
+inline u32x4 cmpgt_i32x4(i32x4 a, i32x4 b) {
+#if defined(__ARM_NEON)
+    return vcgtq_s32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_gt(a, b);
+#else
+    return _mm_cmpgt_epi32(a, b);
+#endif
+}
+
+// Mask logic
+inline u32x4 and_u32x4(u32x4 a, u32x4 b) {
+#if defined(__ARM_NEON)
+    return vandq_u32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_and(a, b);
+#else
+    return _mm_and_si128(a, b);
+#endif
+}
+
+inline u32x4 or_u32x4(u32x4 a, u32x4 b) {
+#if defined(__ARM_NEON)
+    return vorrq_u32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_or(a, b);
+#else
+    return _mm_or_si128(a, b);
+#endif
+}
+
+inline u32x4 xor_u32x4(u32x4 a, u32x4 b) {
+#if defined(__ARM_NEON)
+    return veorq_u32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_xor(a, b);
+#else
+    return _mm_xor_si128(a, b);
+#endif
+}
+
+// a & ~b
+inline u32x4 andnot_u32x4(u32x4 a, u32x4 b) {
+#if defined(__ARM_NEON)
+    return vbicq_u32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_andnot(a, b);
+#else
+    return _mm_andnot_si128(b, a);
+#endif
+}
+
+// Bit i is set when lane i of the mask is set
+inline u32 movemask_u32x4(u32x4 mask) {
+#if defined(__ARM_NEON)
+    static const i32 shifts[4] = { 0, 1, 2, 3 };
+    return vaddvq_u32(vshlq_u32(vshrq_n_u32(mask, 31), vld1q_s32(shifts)));
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_bitmask(mask);
+#else
+    return static_cast<u32>(_mm_movemask_ps(_mm_castsi128_ps(mask)));
+#endif
+}
+
+inline bool any_u32x4(u32x4 mask) {
+    return movemask_u32x4(mask) != 0;
+}
+
+inline bool all_u32x4(u32x4 mask) {
+    return movemask_u32x4(mask) == 0xF;
+}
+
+// Per lane mask ? a : b
+inline f32x4 select_f32x4(u32x4 mask, f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vbslq_f32(mask, a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_bitselect(a, b, mask);
+#else
+    return _mm_blendv_ps(b, a, _mm_castsi128_ps(mask));
+#endif
+}
+
+inline i32x4 select_i32x4(u32x4 mask, i32x4 a, i32x4 b) {
+#if defined(__ARM_NEON)
+    return vbslq_s32(mask, a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_v128_bitselect(a, b, mask);
+#else
+    return _mm_blendv_epi8(b, a, mask);
+#endif
+}
+
+// Arithmetic
+// NaN handling of min/max differs between backends, do not rely on it
+inline f32x4 min_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vminq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_pmin(a, b);
+#else
+    return _mm_min_ps(a, b);
+#endif
+}
+
+inline f32x4 max_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vmaxq_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_pmax(a, b);
+#else
+    return _mm_max_ps(a, b);
+#endif
+}
+
+inline i32x4 min_i32x4(i32x4 a, i32x4 b) {
+#if defined(__ARM_NEON)
+    return vminq_s32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_min(a, b);
+#else
+    return _mm_min_epi32(a, b);
+#endif
+}
+
+inline i32x4 max_i32x4(i32x4 a, i32x4 b) {
+#if defined(__ARM_NEON)
+    return vmaxq_s32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_max(a, b);
+#else
+    return _mm_max_epi32(a, b);
+#endif
+}
+
+inline f32x4 abs_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vabsq_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_abs(v);
+#else
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+#endif
+}
+
+inline i32x4 abs_i32x4(i32x4 v) {
+#if defined(__ARM_NEON)
+    return vabsq_s32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_abs(v);
+#else
+    return _mm_abs_epi32(v);
+#endif
+}
+
+inline f32x4 neg_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vnegq_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_neg(v);
+#else
+    return _mm_xor_ps(_mm_set1_ps(-0.0f), v);
+#endif
+}
+
+inline f32x4 sqrt_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vsqrtq_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_sqrt(v);
+#else
+    return _mm_sqrt_ps(v);
+#endif
+}
+
+// Estimate refined with one Newton-Raphson step (~22 bits). WASM has no estimate, it divides.
+inline f32x4 rsqrt_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    f32x4 y = vrsqrteq_f32(v);
+    return vmulq_f32(y, vrsqrtsq_f32(vmulq_f32(v, y), y));
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_div(wasm_f32x4_splat(1.0f), wasm_f32x4_sqrt(v));
+#else
+    __m128 y = _mm_rsqrt_ps(v);
+    __m128 halfVYY = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), v), _mm_mul_ps(y, y));
+    return _mm_mul_ps(y, _mm_sub_ps(_mm_set1_ps(1.5f), halfVYY));
+#endif
+}
+
+inline f32x4 floor_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vrndmq_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_floor(v);
+#else
+    return _mm_floor_ps(v);
+#endif
+}
+
+inline f32x4 ceil_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vrndpq_f32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_ceil(v);
+#else
+    return _mm_ceil_ps(v);
+#endif
+}
+
+// a * b + c. Fused on NEON and on x86 with FMA, separate multiply and add otherwise.
+inline f32x4 fmadd_f32x4(f32x4 a, f32x4 b, f32x4 c) {
+#if defined(__ARM_NEON)
+    return vfmaq_f32(c, a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_add(wasm_f32x4_mul(a, b), c);
+#elif defined(__FMA__)
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+// c - a * b
+inline f32x4 fnmadd_f32x4(f32x4 a, f32x4 b, f32x4 c) {
+#if defined(__ARM_NEON)
+    return vfmsq_f32(c, a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_f32x4_sub(c, wasm_f32x4_mul(a, b));
+#elif defined(__FMA__)
+    return _mm_fnmadd_ps(a, b, c);
+#else
+    return _mm_sub_ps(c, _mm_mul_ps(a, b));
+#endif
+}
+
+// Shuffles, lane indices are compile time constants in [0, 3]
+// result = { v[X], v[Y], v[Z], v[W] }
+template<int X, int Y, int Z, int W>
+inline f32x4 swizzle_f32x4(f32x4 v) {
+    static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4 && Z >= 0 && Z < 4 && W >= 0 && W < 4, "lane index out of range");
+#if defined(__ARM_NEON)
+    f32x4 r = vdupq_n_f32(vgetq_lane_f32(v, X));
+    r = vsetq_lane_f32(vgetq_lane_f32(v, Y), r, 1);
+    r = vsetq_lane_f32(vgetq_lane_f32(v, Z), r, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(v, W), r, 3);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_shuffle(v, v, X, Y, Z, W);
+#else
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+#endif
+}
+
+// result = { a[X], a[Y], b[Z], b[W] }
+template<int X, int Y, int Z, int W>
+inline f32x4 shuffle_f32x4(f32x4 a, f32x4 b) {
+    static_assert(X >= 0 && X < 4 && Y >= 0 && Y < 4 && Z >= 0 && Z < 4 && W >= 0 && W < 4, "lane index out of range");
+#if defined(__ARM_NEON)
+    f32x4 r = vdupq_n_f32(vgetq_lane_f32(a, X));
+    r = vsetq_lane_f32(vgetq_lane_f32(a, Y), r, 1);
+    r = vsetq_lane_f32(vgetq_lane_f32(b, Z), r, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(b, W), r, 3);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_shuffle(a, b, X, Y, Z + 4, W + 4);
+#else
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+#endif
+}
+
+// result = { a[0], b[0], a[1], b[1] }
+inline f32x4 unpacklo_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vzip1q_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_shuffle(a, b, 0, 4, 1, 5);
+#else
+    return _mm_unpacklo_ps(a, b);
+#endif
+}
+
+// result = { a[2], b[2], a[3], b[3] }
+inline f32x4 unpackhi_f32x4(f32x4 a, f32x4 b) {
+#if defined(__ARM_NEON)
+    return vzip2q_f32(a, b);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    return wasm_i32x4_shuffle(a, b, 2, 6, 3, 7);
+#else
+    return _mm_unpackhi_ps(a, b);
+#endif
+}
+
+// In place 4x4 transpose, rows become columns (AoS <-> SoA)
+inline void transpose_f32x4(f32x4& r0, f32x4& r1, f32x4& r2, f32x4& r3) {
+    f32x4 t0 = unpacklo_f32x4(r0, r1); // r0.x r1.x r0.y r1.y
+    f32x4 t1 = unpacklo_f32x4(r2, r3); // r2.x r3.x r2.y r3.y
+    f32x4 t2 = unpackhi_f32x4(r0, r1); // r0.z r1.z r0.w r1.w
+    f32x4 t3 = unpackhi_f32x4(r2, r3); // r2.z r3.z r2.w r3.w
+    r0 = shuffle_f32x4<0, 1, 0, 1>(t0, t1);
+    r1 = shuffle_f32x4<2, 3, 2, 3>(t0, t1);
+    r2 = shuffle_f32x4<0, 1, 0, 1>(t2, t3);
+    r3 = shuffle_f32x4<2, 3, 2, 3>(t2, t3);
+}
+
+// Horizontal reductions
+inline f32 hsum_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vaddvq_f32(v);
+#else
+    f32x4 s = add_f32x4(v, swizzle_f32x4<2, 3, 0, 1>(v));
+    s = add_f32x4(s, swizzle_f32x4<1, 0, 3, 2>(s));
+    return extract_lane_f32x4<0>(s);
+#endif
+}
+
+inline f32 hmin_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vminvq_f32(v);
+#else
+    f32x4 s = min_f32x4(v, swizzle_f32x4<2, 3, 0, 1>(v));
+    s = min_f32x4(s, swizzle_f32x4<1, 0, 3, 2>(s));
+    return extract_lane_f32x4<0>(s);
+#endif
+}
+
+inline f32 hmax_f32x4(f32x4 v) {
+#if defined(__ARM_NEON)
+    return vmaxvq_f32(v);
+#else
+    f32x4 s = max_f32x4(v, swizzle_f32x4<2, 3, 0, 1>(v));
+    s = max_f32x4(s, swizzle_f32x4<1, 0, 3, 2>(s));
+    return extract_lane_f32x4<0>(s);
+#endif
+}
+
+inline i32 hsum_i32x4(i32x4 v) {
+#if defined(__ARM_NEON)
+    return vaddvq_s32(v);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    i32x4 s = wasm_i32x4_add(v, wasm_i32x4_shuffle(v, v, 2, 3, 0, 1));
+    s = wasm_i32x4_add(s, wasm_i32x4_shuffle(s, s, 1, 0, 3, 2));
+    return wasm_i32x4_extract_lane(s, 0);
+#else
+    __m128i s = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s);
+#endif
+}
+
+inline f32 dot4_f32x4(f32x4 a, f32x4 b) {
+    return hsum_f32x4(mul_f32x4(a, b));
+}
+
+
+// Wide x86 types. These functions exist only in translation units compiled with the matching
+// instruction set (see engine/src/simd), the rest of the engine reaches them through GetKernels().
+#if defined(__AVX2__)
+
+// Float32x8 operations (AVX2)
+inline f32x8 make_f32x8(f32 x0, f32 x1, f32 x2, f32 x3, f32 x4, f32 x5, f32 x6, f32 x7) {
+    return _mm256_setr_ps(x0, x1, x2, x3, x4, x5, x6, x7);
+}
+
+inline f32x8 add_f32x8(f32x8 a, f32x8 b) {
+    return _mm256_add_ps(a, b);
+}
+
+inline f32x8 sub_f32x8(f32x8 a, f32x8 b) {
+    return _mm256_sub_ps(a, b);
+}
+
+inline f32x8 mul_f32x8(f32x8 a, f32x8 b) {
+    return _mm256_mul_ps(a, b);
+}
+
+inline f32x8 div_f32x8(f32x8 a, f32x8 b) {
+    return _mm256_div_ps(a, b);
+}
+
+template<int LaneIndex>
+inline f32 extract_lane_f32x8(f32x8 v) {
+    __m128 half = _mm256_extractf128_ps(v, LaneIndex / 4);
+    return _mm_cvtss_f32(_mm_shuffle_ps(half, half, _MM_SHUFFLE(LaneIndex % 4, LaneIndex % 4, LaneIndex % 4, LaneIndex % 4)));
+}
+
+inline f32x8 load_f32x8(const f32* ptr) {
+    return _mm256_loadu_ps(ptr);
+}
+
+inline void store_f32x8(f32* ptr, f32x8 v) {
+    _mm256_storeu_ps(ptr, v);
+}
+
+inline f32x8 splat_f32x8(f32 value) {
+    return _mm256_set1_ps(value);
+}
+
+// Int32x8 operations (AVX2)
+inline i32x8 make_i32x8(i32 x0, i32 x1, i32 x2, i32 x3, i32 x4, i32 x5, i32 x6, i32 x7) {
+    return _mm256_setr_epi32(x0, x1, x2, x3, x4, x5, x6, x7);
+}
+
+inline i32x8 add_i32x8(i32x8 a, i32x8 b) {
+    return _mm256_add_epi32(a, b);
+}
+
+inline i32x8 sub_i32x8(i32x8 a, i32x8 b) {
+    return _mm256_sub_epi32(a, b);
+}
+
+inline i32x8 mul_i32x8(i32x8 a, i32x8 b) {
+    return _mm256_mullo_epi32(a, b);
+}
+
+template<int LaneIndex>
+inline i32 extract_lane_i32x8(i32x8 v) {
+    return _mm256_extract_epi32(v, LaneIndex);
+}
+
+inline i32x8 splat_i32x8(i32 value) {
+    return _mm256_set1_epi32(value);
+}
+
+// Float64x4 operations (AVX2)
+inline f64x4 make_f64x4(f64 x, f64 y, f64 z, f64 w) {
+    return _mm256_setr_pd(x, y, z, w);
+}
+
+inline f64x4 add_f64x4(f64x4 a, f64x4 b) {
+    return _mm256_add_pd(a, b);
+}
+
+inline f64x4 sub_f64x4(f64x4 a, f64x4 b) {
+    return _mm256_sub_pd(a, b);
+}
+
+inline f64x4 mul_f64x4(f64x4 a, f64x4 b) {
+    return _mm256_mul_pd(a, b);
+}
+
+inline f64x4 div_f64x4(f64x4 a, f64x4 b) {
+    return _mm256_div_pd(a, b);
+}
+
+template<int LaneIndex>
+inline f64 extract_lane_f64x4(f64x4 v) {
+    __m128d half = _mm256_extractf128_pd(v, LaneIndex / 2);
+    return _mm_cvtsd_f64(_mm_shuffle_pd(half, half, _MM_SHUFFLE2(LaneIndex % 2, LaneIndex % 2)));
+}
+
+#endif // __AVX2__
+
+#if defined(__AVX512F__)
+
+// Float32x16 operations (AVX-512F)
+inline f32x16 make_f32x16(f32 x0, f32 x1, f32 x2, f32 x3, f32 x4, f32 x5, f32 x6, f32 x7,
+    f32 x8, f32 x9, f32 x10, f32 x11, f32 x12, f32 x13, f32 x14, f32 x15) {
+    return _mm512_set_ps(x15, x14, x13, x12, x11, x10, x9, x8, x7, x6, x5, x4, x3, x2, x1, x0);
+}
+
+inline f32x16 add_f32x16(f32x16 a, f32x16 b) {
+    return _mm512_add_ps(a, b);
+}
+
+inline f32x16 sub_f32x16(f32x16 a, f32x16 b) {
+    return _mm512_sub_ps(a, b);
+}
+
+inline f32x16 mul_f32x16(f32x16 a, f32x16 b) {
+    return _mm512_mul_ps(a, b);
+}
+
+inline f32x16 div_f32x16(f32x16 a, f32x16 b) {
+    return _mm512_div_ps(a, b);
+}
+
+template<int LaneIndex>
+inline f32 extract_lane_f32x16(f32x16 v) {
+    __m128 quarter = _mm512_extractf32x4_ps(v, LaneIndex / 4);
+    return _mm_cvtss_f32(_mm_shuffle_ps(quarter, quarter, _MM_SHUFFLE(LaneIndex % 4, LaneIndex % 4, LaneIndex % 4, LaneIndex % 4)));
+}
+
+inline f32x16 load_f32x16(const f32* ptr) {
+    return _mm512_loadu_ps(ptr);
+}
+
+inline void store_f32x16(f32* ptr, f32x16 v) {
+    _mm512_storeu_ps(ptr, v);
+}
+
+inline f32x16 splat_f32x16(f32 value) {
+    return _mm512_set1_ps(value);
+}
+
+// Int32x16 operations (AVX-512F)
+inline i32x16 make_i32x16(i32 x0, i32 x1, i32 x2, i32 x3, i32 x4, i32 x5, i32 x6, i32 x7,
+    i32 x8, i32 x9, i32 x10, i32 x11, i32 x12, i32 x13, i32 x14, i32 x15) {
+    return _mm512_set_epi32(x15, x14, x13, x12, x11, x10, x9, x8, x7, x6, x5, x4, x3, x2, x1, x0);
+}
+
+inline i32x16 add_i32x16(i32x16 a, i32x16 b) {
+    return _mm512_add_epi32(a, b);
+}
+
+inline i32x16 sub_i32x16(i32x16 a, i32x16 b) {
+    return _mm512_sub_epi32(a, b);
+}
+
+inline i32x16 mul_i32x16(i32x16 a, i32x16 b) {
+    return _mm512_mullo_epi32(a, b);
+}
+
+template<int LaneIndex>
+inline i32 extract_lane_i32x16(i32x16 v) {
+    return _mm_extract_epi32(_mm512_extracti32x4_epi32(v, LaneIndex / 4), LaneIndex % 4);
+}
+
+inline i32x16 splat_i32x16(i32 value) {
+    return _mm512_set1_epi32(value);
+}
+
+// Float64x8 operations (AVX-512F)
+inline f64x8 make_f64x8(f64 x0, f64 x1, f64 x2, f64 x3, f64 x4, f64 x5, f64 x6, f64 x7) {
+    return _mm512_set_pd(x7, x6, x5, x4, x3, x2, x1, x0);
+}
+
+inline f64x8 add_f64x8(f64x8 a, f64x8 b) {
+    return _mm512_add_pd(a, b);
+}
+
+inline f64x8 sub_f64x8(f64x8 a, f64x8 b) {
+    return _mm512_sub_pd(a, b);
+}
+
+inline f64x8 mul_f64x8(f64x8 a, f64x8 b) {
+    return _mm512_mul_pd(a, b);
+}
+
+inline f64x8 div_f64x8(f64x8 a, f64x8 b) {
+    return _mm512_div_pd(a, b);
+}
+
+template<int LaneIndex>
+inline f64 extract_lane_f64x8(f64x8 v) {
+    __m256d half = _mm512_extractf64x4_pd(v, LaneIndex / 4);
+    __m128d quarter = _mm256_extractf128_pd(half, (LaneIndex / 2) % 2);
+    return _mm_cvtsd_f64(_mm_shuffle_pd(quarter, quarter, _MM_SHUFFLE2(LaneIndex % 2, LaneIndex % 2)));
+}
+
+#endif // __AVX512F__
+
+} // inline namespace MERCURY_SIMD_ISA_NAMESPACE
+
+// Runtime dispatch
+enum class InstructionSet : u8
+{
+    Scalar,
+    SSE41,
+    AVX2,   // AVX2 + FMA
+    AVX512, // AVX-512F
+    NEON,
+    WASM128,
+};
+
+const char* GetInstructionSetName(InstructionSet isa);
+
+struct CpuFeatures
+{
+    bool sse41 = false;
+    bool avx = false;
+    bool avx2 = false;
+    bool fma = false;
+    bool avx512f = false;
+    bool avx512dq = false;
+    bool avx512bw = false;
+    bool avx512vl = false;
+    bool osSavesYmm = false; // XCR0 enables the AVX register state
+    bool osSavesZmm = false; // XCR0 enables the AVX-512 register state
+};
+
+/// @brief CPUID/XGETBV results, queried once.
+const CpuFeatures& GetCpuFeatures();
+
+/// @brief Widest instruction set supported by both the binary and the CPU.
+InstructionSet GetBestInstructionSet();
+
+/// @brief Batch kernels over plain float arrays, one table per instruction set.
+/// Tails shorter than the vector width are handled inside, no padding or alignment is required.
+struct Kernels
+{
+    InstructionSet isa = InstructionSet::Scalar;
+    u32 width = 1; // f32 lanes per vector
+
+    void (*add)(f32* out, const f32* a, const f32* b, size_t count) = nullptr;
+    void (*mul)(f32* out, const f32* a, const f32* b, size_t count) = nullptr;
+    void (*mulAdd)(f32* out, const f32* a, const f32* b, const f32* c, size_t count) = nullptr; // out = a * b + c
+    void (*scale)(f32* out, const f32* in, f32 s, size_t count) = nullptr;
+    f32 (*dot)(const f32* a, const f32* b, size_t count) = nullptr;
+
+    /// @brief Transforms SoA points (w = 1) by a column-major 4x4 matrix (glm layout), the projective row is ignored.
+    void (*transformPoints)(const f32* matrix, const f32* inX, const f32* inY, const f32* inZ,
+        f32* outX, f32* outY, f32* outZ, size_t count) = nullptr;
+};
+
+/// @brief Kernels for the given instruction set, nullptr if the binary or the CPU lacks it.
+const Kernels* GetKernels(InstructionSet isa);
+
+/// @brief Currently selected kernels. The best instruction set is picked on first use.
+const Kernels& GetKernels();
+
+/// @brief Forces a specific instruction set (benchmarks, bug hunting). Returns false if it is unavailable.
+bool SelectKernels(InstructionSet isa);
+
 } // namespace simd
 
-} // namespace mercury 
\ No newline at end of file
+} // namespace mercury
@@ -0,0 +1,380 @@
+#pragma once
+
+#include "mercury_simd.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <span>
+
+namespace mercury {
+
+// Structure-of-arrays math on top of mercury_simd.h: every type holds 4 independent values, one per lane.
+// glm stays the interface at the edges, load_*/store_* convert 4 glm values to and from lanes,
+// the span functions below do that internally for bulk work.
+namespace simd {
+
+// same per instruction set namespace as mercury_simd.h, the bulk functions at the end stay outside of it
+inline namespace MERCURY_SIMD_ISA_NAMESPACE {
+
+struct vec3x4 {
+    f32x4 x, y, z;
+};
+
+struct vec4x4 {
+    f32x4 x, y, z, w;
+};
+
+// Lanes hold (x, y, z, w) like glm::quat, w is the real part
+struct quatx4 {
+    f32x4 x, y, z, w;
+};
+
+// Four column-major glm style matrices, c[column][row] holds that element for all 4 matrices
+struct mat4x4 {
+    f32x4 c[4][4];
+};
+
+// glm interop, src/dst point to 4 consecutive values
+inline vec3x4 load_vec3x4(const glm::vec3* src) {
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(f32), "glm::vec3 must be tightly packed");
+
+    // 12 floats: p = x0 y0 z0 x1, q = y1 z1 x2 y2, r = z2 x3 y3 z3
+    const f32* data = &src[0].x;
+    f32x4 p = load_f32x4(data);
+    f32x4 q = load_f32x4(data + 4);
+    f32x4 r = load_f32x4(data + 8);
+
+    f32x4 x2y2z2x3 = shuffle_f32x4<2, 3, 0, 1>(q, r);
+    f32x4 y0z0y1z1 = shuffle_f32x4<1, 2, 0, 1>(p, q);
+    f32x4 y2y2y3y3 = shuffle_f32x4<3, 3, 2, 2>(q, r);
+    f32x4 z2z3z2z3 = swizzle_f32x4<0, 3, 0, 3>(r);
+
+    vec3x4 v;
+    v.x = shuffle_f32x4<0, 3, 0, 3>(p, x2y2z2x3);
+    v.y = shuffle_f32x4<0, 2, 0, 2>(y0z0y1z1, y2y2y3y3);
+    v.z = shuffle_f32x4<1, 3, 0, 1>(y0z0y1z1, z2z3z2z3);
+    return v;
+}
+
+inline void store_vec3x4(glm::vec3* dst, const vec3x4& v) {
+    f32x4 xy01 = unpacklo_f32x4(v.x, v.y); // x0 y0 x1 y1
+    f32x4 xy23 = unpackhi_f32x4(v.x, v.y); // x2 y2 x3 y3
+
+    f32x4 p = shuffle_f32x4<0, 1, 0, 2>(xy01, shuffle_f32x4<0, 0, 1, 1>(v.z, v.x));
+    f32x4 q = shuffle_f32x4<0, 2, 0, 1>(shuffle_f32x4<3, 3, 1, 1>(xy01, v.z), xy23);
+    f32x4 r = swizzle_f32x4<2, 0, 1, 3>(shuffle_f32x4<2, 3, 2, 3>(xy23, v.z));
+
+    f32* data = &dst[0].x;
+    store_f32x4(data, p);
+    store_f32x4(data + 4, q);
+    store_f32x4(data + 8, r);
+}
+
+inline vec4x4 load_vec4x4(const glm::vec4* src) {
+    static_assert(sizeof(glm::vec4) == 4 * sizeof(f32), "glm::vec4 must be tightly packed");
+
+    vec4x4 v;
+    v.x = load_f32x4(&src[0].x);
+    v.y = load_f32x4(&src[1].x);
+    v.z = load_f32x4(&src[2].x);
+    v.w = load_f32x4(&src[3].x);
+    transpose_f32x4(v.x, v.y, v.z, v.w);
+    return v;
+}
+
+inline void store_vec4x4(glm::vec4* dst, vec4x4 v) {
+    transpose_f32x4(v.x, v.y, v.z, v.w);
+    store_f32x4(&dst[0].x, v.x);
+    store_f32x4(&dst[1].x, v.y);
+    store_f32x4(&dst[2].x, v.z);
+    store_f32x4(&dst[3].x, v.w);
+}
+
+inline quatx4 load_quatx4(const glm::quat* src) {
+    quatx4 q;
+    q.x = make_f32x4(src[0].x, src[1].x, src[2].x, src[3].x);
+    q.y = make_f32x4(src[0].y, src[1].y, src[2].y, src[3].y);
+    q.z = make_f32x4(src[0].z, src[1].z, src[2].z, src[3].z);
+    q.w = make_f32x4(src[0].w, src[1].w, src[2].w, src[3].w);
+    return q;
+}
+
+inline void store_quatx4(glm::quat* dst, const quatx4& q) {
+    alignas(16) f32 x[4], y[4], z[4], w[4];
+    store_aligned_f32x4(x, q.x);
+    store_aligned_f32x4(y, q.y);
+    store_aligned_f32x4(z, q.z);
+    store_aligned_f32x4(w, q.w);
+
+    for (int i = 0; i < 4; ++i) {
+        dst[i].x = x[i];
+        dst[i].y = y[i];
+        dst[i].z = z[i];
+        dst[i].w = w[i];
+    }
+}
+
+inline mat4x4 load_mat4x4(const glm::mat4* src) {
+    mat4x4 m;
+    for (int c = 0; c < 4; ++c) {
+        m.c[c][0] = load_f32x4(&src[0][c][0]);
+        m.c[c][1] = load_f32x4(&src[1][c][0]);
+        m.c[c][2] = load_f32x4(&src[2][c][0]);
+        m.c[c][3] = load_f32x4(&src[3][c][0]);
+        transpose_f32x4(m.c[c][0], m.c[c][1], m.c[c][2], m.c[c][3]);
+    }
+    return m;
+}
+
+inline void store_mat4x4(glm::mat4* dst, const mat4x4& m) {
+    for (int c = 0; c < 4; ++c) {
+        f32x4 r0 = m.c[c][0], r1 = m.c[c][1], r2 = m.c[c][2], r3 = m.c[c][3];
+        transpose_f32x4(r0, r1, r2, r3);
+        store_f32x4(&dst[0][c][0], r0);
+        store_f32x4(&dst[1][c][0], r1);
+        store_f32x4(&dst[2][c][0], r2);
+        store_f32x4(&dst[3][c][0], r3);
+    }
+}
+
+inline vec3x4 splat_vec3x4(const glm::vec3& v) {
+    return { splat_f32x4(v.x), splat_f32x4(v.y), splat_f32x4(v.z) };
+}
+
+inline vec4x4 splat_vec4x4(const glm::vec4& v) {
+    return { splat_f32x4(v.x), splat_f32x4(v.y), splat_f32x4(v.z), splat_f32x4(v.w) };
+}
+
+inline quatx4 splat_quatx4(const glm::quat& q) {
+    return { splat_f32x4(q.x), splat_f32x4(q.y), splat_f32x4(q.z), splat_f32x4(q.w) };
+}
+
+inline mat4x4 splat_mat4x4(const glm::mat4& m) {
+    mat4x4 r;
+    for (int c = 0; c < 4; ++c) {
+        for (int row = 0; row < 4; ++row)
+            r.c[c][row] = splat_f32x4(m[c][row]);
+    }
+    return r;
+}
+
+// vec3x4
+inline vec3x4 operator+(const vec3x4& a, const vec3x4& b) {
+    return { add_f32x4(a.x, b.x), add_f32x4(a.y, b.y), add_f32x4(a.z, b.z) };
+}
+
+inline vec3x4 operator-(const vec3x4& a, const vec3x4& b) {
+    return { sub_f32x4(a.x, b.x), sub_f32x4(a.y, b.y), sub_f32x4(a.z, b.z) };
+}
+
+inline vec3x4 operator*(const vec3x4& a, const vec3x4& b) {
+    return { mul_f32x4(a.x, b.x), mul_f32x4(a.y, b.y), mul_f32x4(a.z, b.z) };
+}
+
+inline vec3x4 operator*(const vec3x4& a, f32x4 s) {
+    return { mul_f32x4(a.x, s), mul_f32x4(a.y, s), mul_f32x4(a.z, s) };
+}
+
+inline vec3x4 operator-(const vec3x4& a) {
+    return { neg_f32x4(a.x), neg_f32x4(a.y), neg_f32x4(a.z) };
+}
+
+// a * b + c
+inline vec3x4 fmadd(const vec3x4& a, f32x4 b, const vec3x4& c) {
+    return { fmadd_f32x4(a.x, b, c.x), fmadd_f32x4(a.y, b, c.y), fmadd_f32x4(a.z, b, c.z) };
+}
+
+inline f32x4 dot(const vec3x4& a, const vec3x4& b) {
+    return fmadd_f32x4(a.z, b.z, fmadd_f32x4(a.y, b.y, mul_f32x4(a.x, b.x)));
+}
+
+inline vec3x4 cross(const vec3x4& a, const vec3x4& b) {
+    return {
+        fnmadd_f32x4(a.z, b.y, mul_f32x4(a.y, b.z)),
+        fnmadd_f32x4(a.x, b.z, mul_f32x4(a.z, b.x)),
+        fnmadd_f32x4(a.y, b.x, mul_f32x4(a.x, b.y)),
+    };
+}
+
+inline f32x4 length(const vec3x4& v) {
+    return sqrt_f32x4(dot(v, v));
+}
+
+// Uses rsqrt_f32x4 (~22 bits), zero length vectors produce NaN like glm::normalize
+inline vec3x4 normalize(const vec3x4& v) {
+    return v * rsqrt_f32x4(dot(v, v));
+}
+
+inline vec3x4 lerp(const vec3x4& a, const vec3x4& b, f32x4 t) {
+    return fmadd(b - a, t, a);
+}
+
+inline vec3x4 min(const vec3x4& a, const vec3x4& b) {
+    return { min_f32x4(a.x, b.x), min_f32x4(a.y, b.y), min_f32x4(a.z, b.z) };
+}
+
+inline vec3x4 max(const vec3x4& a, const vec3x4& b) {
+    return { max_f32x4(a.x, b.x), max_f32x4(a.y, b.y), max_f32x4(a.z, b.z) };
+}
+
+inline vec3x4 select(u32x4 mask, const vec3x4& a, const vec3x4& b) {
+    return { select_f32x4(mask, a.x, b.x), select_f32x4(mask, a.y, b.y), select_f32x4(mask, a.z, b.z) };
+}
+
+// vec4x4
+inline vec4x4 operator+(const vec4x4& a, const vec4x4& b) {
+    return { add_f32x4(a.x, b.x), add_f32x4(a.y, b.y), add_f32x4(a.z, b.z), add_f32x4(a.w, b.w) };
+}
+
+inline vec4x4 operator-(const vec4x4& a, const vec4x4& b) {
+    return { sub_f32x4(a.x, b.x), sub_f32x4(a.y, b.y), sub_f32x4(a.z, b.z), sub_f32x4(a.w, b.w) };
+}
+
+inline vec4x4 operator*(const vec4x4& a, const vec4x4& b) {
+    return { mul_f32x4(a.x, b.x), mul_f32x4(a.y, b.y), mul_f32x4(a.z, b.z), mul_f32x4(a.w, b.w) };
+}
+
+inline vec4x4 operator*(const vec4x4& a, f32x4 s) {
+    return { mul_f32x4(a.x, s), mul_f32x4(a.y, s), mul_f32x4(a.z, s), mul_f32x4(a.w, s) };
+}
+
+inline f32x4 dot(const vec4x4& a, const vec4x4& b) {
+    return fmadd_f32x4(a.w, b.w, fmadd_f32x4(a.z, b.z, fmadd_f32x4(a.y, b.y, mul_f32x4(a.x, b.x))));
+}
+
+inline vec4x4 normalize(const vec4x4& v) {
+    return v * rsqrt_f32x4(dot(v, v));
+}
+
+// quatx4
+inline quatx4 operator*(const quatx4& a, const quatx4& b) {
+    quatx4 r;
+    r.w = fnmadd_f32x4(a.z, b.z, fnmadd_f32x4(a.y, b.y, fnmadd_f32x4(a.x, b.x, mul_f32x4(a.w, b.w))));
+    r.x = fnmadd_f32x4(a.z, b.y, fmadd_f32x4(a.y, b.z, fmadd_f32x4(a.x, b.w, mul_f32x4(a.w, b.x))));
+    r.y = fnmadd_f32x4(a.x, b.z, fmadd_f32x4(a.z, b.x, fmadd_f32x4(a.y, b.w, mul_f32x4(a.w, b.y))));
+    r.z = fnmadd_f32x4(a.y, b.x, fmadd_f32x4(a.x, b.y, fmadd_f32x4(a.z, b.w, mul_f32x4(a.w, b.z))));
+    return r;
+}
+
+inline quatx4 conjugate(const quatx4& q) {
+    return { neg_f32x4(q.x), neg_f32x4(q.y), neg_f32x4(q.z), q.w };
+}
+
+inline quatx4 normalize(const quatx4& q) {
+    vec4x4 v = normalize(vec4x4{ q.x, q.y, q.z, q.w });
+    return { v.x, v.y, v.z, v.w };
+}
+
+// Rotates v by unit quaternion q: v + 2w(u x v) + 2u x (u x v)
+inline vec3x4 rotate(const quatx4& q, const vec3x4& v) {
+    const vec3x4 u{ q.x, q.y, q.z };
+    const vec3x4 t = cross(u, v) * splat_f32x4(2.0f);
+    return v + t * q.w + cross(u, t);
+}
+
+// Normalized lerp along the shortest arc, cheap replacement for slerp on small angles
+inline quatx4 nlerp(const quatx4& a, const quatx4& b, f32x4 t) {
+    f32x4 cosAngle = dot(vec4x4{ a.x, a.y, a.z, a.w }, vec4x4{ b.x, b.y, b.z, b.w });
+    f32x4 sign = select_f32x4(cmplt_f32x4(cosAngle, splat_f32x4(0.0f)), splat_f32x4(-1.0f), splat_f32x4(1.0f));
+    f32x4 tb = mul_f32x4(t, sign);
+    f32x4 ta = sub_f32x4(splat_f32x4(1.0f), t);
+
+    return normalize(quatx4{
+        fmadd_f32x4(b.x, tb, mul_f32x4(a.x, ta)),
+        fmadd_f32x4(b.y, tb, mul_f32x4(a.y, ta)),
+        fmadd_f32x4(b.z, tb, mul_f32x4(a.z, ta)),
+        fmadd_f32x4(b.w, tb, mul_f32x4(a.w, ta)),
+    });
+}
+
+// mat4x4
+inline vec4x4 operator*(const mat4x4& m, const vec4x4& v) {
+    vec4x4 r;
+    f32x4* out = &r.x;
+    for (int row = 0; row < 4; ++row) {
+        out[row] = fmadd_f32x4(m.c[3][row], v.w, fmadd_f32x4(m.c[2][row], v.z,
+            fmadd_f32x4(m.c[1][row], v.y, mul_f32x4(m.c[0][row], v.x))));
+    }
+    return r;
+}
+
+inline mat4x4 operator*(const mat4x4& a, const mat4x4& b) {
+    mat4x4 r;
+    for (int c = 0; c < 4; ++c) {
+        for (int row = 0; row < 4; ++row) {
+            r.c[c][row] = fmadd_f32x4(a.c[3][row], b.c[c][3], fmadd_f32x4(a.c[2][row], b.c[c][2],
+                fmadd_f32x4(a.c[1][row], b.c[c][1], mul_f32x4(a.c[0][row], b.c[c][0]))));
+        }
+    }
+    return r;
+}
+
+// Point (w = 1) through an affine matrix, the projective row is ignored
+inline vec3x4 transform_point(const mat4x4& m, const vec3x4& p) {
+    vec3x4 r;
+    f32x4* out = &r.x;
+    for (int row = 0; row < 3; ++row) {
+        out[row] = fmadd_f32x4(m.c[2][row], p.z, fmadd_f32x4(m.c[1][row], p.y,
+            fmadd_f32x4(m.c[0][row], p.x, m.c[3][row])));
+    }
+    return r;
+}
+
+// Translation * rotation * scale, the same matrix as glm::translate(t) * glm::mat4_cast(r) * glm::scale(s)
+inline mat4x4 compose_trs(const vec3x4& t, const quatx4& r, const vec3x4& s) {
+    const f32x4 one = splat_f32x4(1.0f);
+    const f32x4 zero = splat_f32x4(0.0f);
+    const f32x4 two = splat_f32x4(2.0f);
+
+    const f32x4 x2 = mul_f32x4(r.x, two), y2 = mul_f32x4(r.y, two), z2 = mul_f32x4(r.z, two);
+    const f32x4 xx = mul_f32x4(r.x, x2), yy = mul_f32x4(r.y, y2), zz = mul_f32x4(r.z, z2);
+    const f32x4 xy = mul_f32x4(r.x, y2), xz = mul_f32x4(r.x, z2), yz = mul_f32x4(r.y, z2);
+    const f32x4 wx = mul_f32x4(r.w, x2), wy = mul_f32x4(r.w, y2), wz = mul_f32x4(r.w, z2);
+
+    mat4x4 m;
+    m.c[0][0] = mul_f32x4(sub_f32x4(one, add_f32x4(yy, zz)), s.x);
+    m.c[0][1] = mul_f32x4(add_f32x4(xy, wz), s.x);
+    m.c[0][2] = mul_f32x4(sub_f32x4(xz, wy), s.x);
+    m.c[0][3] = zero;
+
+    m.c[1][0] = mul_f32x4(sub_f32x4(xy, wz), s.y);
+    m.c[1][1] = mul_f32x4(sub_f32x4(one, add_f32x4(xx, zz)), s.y);
+    m.c[1][2] = mul_f32x4(add_f32x4(yz, wx), s.y);
+    m.c[1][3] = zero;
+
+    m.c[2][0] = mul_f32x4(add_f32x4(xz, wy), s.z);
+    m.c[2][1] = mul_f32x4(sub_f32x4(yz, wx), s.z);
+    m.c[2][2] = mul_f32x4(sub_f32x4(one, add_f32x4(xx, yy)), s.z);
+    m.c[2][3] = zero;
+
+    m.c[3][0] = t.x;
+    m.c[3][1] = t.y;
+    m.c[3][2] = t.z;
+    m.c[3][3] = one;
+    return m;
+}
+
+} // inline namespace MERCURY_SIMD_ISA_NAMESPACE
+
+// Bulk operations over glm arrays. Output may alias input. The matrix is applied as an affine transform
+// (no perspective divide), remainders that do not fill a 4-wide block go through scalar glm.
+
+/// @brief out[i] = m * vec4(in[i], 1). Runs on the GetKernels() table when it is wider than 4 lanes.
+void transform_points(const glm::mat4& m, std::span<const glm::vec3> in, std::span<glm::vec3> out);
+
+/// @brief out[i] = normalize(normalMatrix * in[i]), normalMatrix is usually transpose(inverse(mat3(model)))
+void transform_normals(const glm::mat3& normalMatrix, std::span<const glm::vec3> in, std::span<glm::vec3> out);
+
+/// @brief out[i] = a[i] * b[i]
+void multiply_mat4(std::span<const glm::mat4> a, std::span<const glm::mat4> b, std::span<glm::mat4> out);
+
+/// @brief out[i] = parent * local[i], the common "instance local to world" case
+void multiply_mat4(const glm::mat4& parent, std::span<const glm::mat4> local, std::span<glm::mat4> out);
+
+/// @brief out[i] = translate(t[i]) * mat4_cast(r[i]) * scale(s[i])
+void compose_trs(std::span<const glm::vec3> t, std::span<const glm::quat> r, std::span<const glm::vec3> s,
+    std::span<glm::mat4> out);
+
+} // namespace simd
+
+} // namespace mercury
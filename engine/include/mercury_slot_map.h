@@ -0,0 +1,175 @@
+#pragma once
+
+#include "mercury_api.h"
+#include "ll/os.h"
+#include <type_traits>
+#include <vector>
+#include <utility>
+
+namespace mercury
+{
+    /// @brief Generational slot map used for backend resource tables.
+    /// A handle value packs the slot index in the low IndexBits bits and the slot generation
+    /// in the remaining bits. Removing an element bumps the generation of its slot, so stale
+    /// handles fail validation instead of aliasing whatever reuses the slot.
+    /// Values are kept densely packed (swap-and-pop on removal) and freed slots are recycled
+    /// through an intrusive free list, so create/destroy churn does not grow the tables.
+    template<typename T, typename H = u32, u32 IndexBits = 20>
+    class SlotMap
+    {
+        static_assert(std::is_unsigned_v<H> && std::is_integral_v<H>, "SlotMap handle must be unsigned integral");
+        static_assert(IndexBits > 0 && IndexBits < sizeof(H) * 8, "SlotMap needs bits for both index and generation");
+
+    public:
+        static constexpr H InvalidValue = (H)-1;
+        static constexpr u32 IndexMask = (u32(1) << IndexBits) - 1;
+        static constexpr u32 MaxGeneration = u32(H(-1) >> IndexBits);
+        // Index IndexMask is never handed out, so a packed handle can never be equal to InvalidValue
+        static constexpr u32 MaxSlots = IndexMask;
+
+        static constexpr u32 IndexOf(H handle) { return u32(handle) & IndexMask; }
+        static constexpr u32 GenerationOf(H handle) { return u32(handle) >> IndexBits; }
+
+        template<typename... Args>
+        H Emplace(Args&&... args)
+        {
+            u32 slotIndex;
+            if (freeHead != NoSlot)
+            {
+                slotIndex = freeHead;
+                freeHead = slots[slotIndex].indexOrNextFree;
+            }
+            else
+            {
+                MERCURY_ASSERT(slots.size() < MaxSlots); // SlotMap out of slots
+                slotIndex = static_cast<u32>(slots.size());
+                slots.push_back({ NoSlot, 0 });
+            }
+
+            Slot& slot = slots[slotIndex];
+            slot.indexOrNextFree = static_cast<u32>(values.size());
+            values.emplace_back(std::forward<Args>(args)...);
+            denseToSlot.push_back(slotIndex);
+
+            return static_cast<H>((slot.generation << IndexBits) | slotIndex);
+        }
+
+        bool Contains(H handle) const
+        {
+            const u32 slotIndex = IndexOf(handle);
+            if (handle == InvalidValue || slotIndex >= slots.size())
+                return false;
+
+            const Slot& slot = slots[slotIndex];
+            return slot.generation == GenerationOf(handle)
+                && slot.indexOrNextFree < denseToSlot.size()
+                && denseToSlot[slot.indexOrNextFree] == slotIndex;
+        }
+
+        /// @brief Returns nullptr if the handle is invalid or was already removed
+        T* Get(H handle)
+        {
+            return Contains(handle) ? &values[slots[IndexOf(handle)].indexOrNextFree] : nullptr;
+        }
+
+        const T* Get(H handle) const
+        {
+            return Contains(handle) ? &values[slots[IndexOf(handle)].indexOrNextFree] : nullptr;
+        }
+
+        T& operator[](H handle)
+        {
+            MERCURY_ASSERT(Contains(handle)); // stale or invalid handle
+            return values[slots[IndexOf(handle)].indexOrNextFree];
+        }
+
+        const T& operator[](H handle) const
+        {
+            MERCURY_ASSERT(Contains(handle)); // stale or invalid handle
+            return values[slots[IndexOf(handle)].indexOrNextFree];
+        }
+
+        bool Remove(H handle)
+        {
+            if (!Contains(handle))
+                return false;
+
+            const u32 slotIndex = IndexOf(handle);
+            const u32 denseIndex = slots[slotIndex].indexOrNextFree;
+            const u32 lastIndex = static_cast<u32>(values.size() - 1);
+
+            if (denseIndex != lastIndex)
+            {
+                values[denseIndex] = std::move(values[lastIndex]);
+                denseToSlot[denseIndex] = denseToSlot[lastIndex];
+                slots[denseToSlot[denseIndex]].indexOrNextFree = denseIndex;
+            }
+
+            values.pop_back();
+            denseToSlot.pop_back();
+            ReleaseSlot(slotIndex);
+            return true;
+        }
+
+        void clear()
+        {
+            for (u32 slotIndex : denseToSlot)
+                ReleaseSlot(slotIndex);
+
+            values.clear();
+            denseToSlot.clear();
+        }
+
+        void reserve(size_t count)
+        {
+            values.reserve(count);
+            denseToSlot.reserve(count);
+            slots.reserve(count);
+        }
+
+        size_t size() const { return values.size(); }
+        bool empty() const { return values.empty(); }
+
+        /// @brief Dense iteration over live values, order is not stable across Remove
+        auto begin() { return values.begin(); }
+        auto end() { return values.end(); }
+        auto begin() const { return values.begin(); }
+        auto end() const { return values.end(); }
+
+        /// @brief Handle of the value at dense position i, for use while iterating
+        H HandleAt(size_t denseIndex) const
+        {
+            const u32 slotIndex = denseToSlot[denseIndex];
+            return static_cast<H>((slots[slotIndex].generation << IndexBits) | slotIndex);
+        }
+
+    private:
+        static constexpr u32 NoSlot = 0xFFFFFFFFu;
+
+        struct Slot
+        {
+            u32 indexOrNextFree; // dense index while alive, next free slot otherwise
+            u32 generation;
+        };
+
+        void ReleaseSlot(u32 slotIndex)
+        {
+            Slot& slot = slots[slotIndex];
+            slot.indexOrNextFree = NoSlot;
+
+            // A slot whose generation is exhausted is retired instead of wrapping around,
+            // otherwise a very old handle could become valid again
+            if (slot.generation >= MaxGeneration)
+                return;
+
+            slot.generation++;
+            slot.indexOrNextFree = freeHead;
+            freeHead = slotIndex;
+        }
+
+        std::vector<T> values;
+        std::vector<u32> denseToSlot;
+        std::vector<Slot> slots;
+        u32 freeHead = NoSlot;
+    };
+}
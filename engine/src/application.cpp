@@ -13,6 +13,8 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <atomic>
+#include <algorithm>
 
 using namespace mercury;
 
@@ -22,10 +24,107 @@ Application::Application() { g_currentApplication = this; }
 
 Application::~Application() { g_currentApplication = nullptr; }
 
+// Engine clock, ticked by the main loop thread only. Scale and pause may be flipped from any thread and are picked up
+// at the next frame start.
+namespace {
+  using ClockSource = std::chrono::steady_clock;
+
+  constexpr f32 kMaxFrameDelta = 0.25f;   // longer frames are treated as a stall, not as elapsed game time
+  constexpr f32 kSmoothingFactor = 0.1f;  // weight of the newest frame in the moving average
+
+  struct EngineClock {
+    ClockSource::time_point startStamp;
+    ClockSource::time_point frameStamp;
+    bool started = false;
+
+    clock::FrameTiming timing;
+
+    f32 history[clock::FrameTimingStats::NumSamples] = {};
+    u32 historyOffset = 0; // next slot to write
+    u32 historyCount = 0;
+
+    std::atomic<f32> timeScale = 1.0f;
+    std::atomic<bool> paused = false;
+  };
+
+  EngineClock gClock;
+
+  void StartEngineClock(ClockSource::time_point now = ClockSource::now()) {
+    gClock.startStamp = gClock.frameStamp = now;
+    gClock.timing = {};
+    gClock.historyOffset = gClock.historyCount = 0;
+    gClock.started = true;
+  }
+
+  void StampFrameStart() {
+    auto now = ClockSource::now();
+    if (!gClock.started)
+      StartEngineClock(now);
+
+    f32 rawDelta = std::chrono::duration<f32>(now - gClock.frameStamp).count();
+    gClock.frameStamp = now;
+
+    auto &timing = gClock.timing;
+    f32 delta = std::min(rawDelta, kMaxFrameDelta);
+    f32 scaledDelta = gClock.paused.load(std::memory_order_relaxed) ? 0.0f : delta * gClock.timeScale.load(std::memory_order_relaxed);
+
+    timing.unscaledTime = std::chrono::duration<f64>(now - gClock.startStamp).count();
+    timing.time += scaledDelta;
+    timing.unscaledDeltaTime = delta;
+    timing.deltaTime = scaledDelta;
+    timing.smoothedDeltaTime = timing.smoothedDeltaTime == 0.0f ? delta : timing.smoothedDeltaTime + (delta - timing.smoothedDeltaTime) * kSmoothingFactor;
+    timing.frameIndex++;
+
+    // telemetry keeps the unclamped duration, stalls are what it is there to show
+    gClock.history[gClock.historyOffset] = rawDelta * 1000.0f;
+    gClock.historyOffset = (gClock.historyOffset + 1) % clock::FrameTimingStats::NumSamples;
+    gClock.historyCount = std::min(gClock.historyCount + 1, clock::FrameTimingStats::NumSamples);
+  }
+} // namespace
+
+const clock::FrameTiming &clock::GetFrameTiming() { return gClock.timing; }
+
+void clock::SetTimeScale(f32 scale) { gClock.timeScale.store(std::max(scale, 0.0f), std::memory_order_relaxed); }
+
+f32 clock::GetTimeScale() { return gClock.timeScale.load(std::memory_order_relaxed); }
+
+void clock::SetPaused(bool paused) { gClock.paused.store(paused, std::memory_order_relaxed); }
+
+bool clock::IsPaused() { return gClock.paused.load(std::memory_order_relaxed); }
+
+void clock::GetFrameTimingStats(FrameTimingStats &outStats) {
+  constexpr u32 numSamples = FrameTimingStats::NumSamples;
+
+  outStats.count = gClock.historyCount;
+  u32 first = (gClock.historyOffset + numSamples - gClock.historyCount) % numSamples;
+  for (u32 i = 0; i < gClock.historyCount; ++i)
+    outStats.samples[i] = gClock.history[(first + i) % numSamples];
+
+  if (outStats.count == 0) {
+    outStats.minMs = outStats.avgMs = outStats.maxMs = outStats.p99Ms = 0.0f;
+    return;
+  }
+
+  f32 sorted[numSamples];
+  std::copy_n(outStats.samples, outStats.count, sorted);
+  std::sort(sorted, sorted + outStats.count);
+
+  f32 sum = 0.0f;
+  for (u32 i = 0; i < outStats.count; ++i)
+    sum += sorted[i];
+
+  outStats.minMs = sorted[0];
+  outStats.maxMs = sorted[outStats.count - 1];
+  outStats.avgMs = sum / (f32)outStats.count;
+  outStats.p99Ms = sorted[std::min(outStats.count - 1, (outStats.count * 99) / 100)];
+}
+
 void TickCurrentApplication() {
 
  // mercury::ll::os::gOS->Update();
 
+  StampFrameStart();
+
   MercuryInputPreTick();
 
   g_currentApplication->Tick();
@@ -70,6 +169,9 @@ void InitializeCurrentApplication() {
   std::cout << "Graphics initialisation time: " << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start).count() << " ms" << std::endl;
 
   g_currentApplication->Initialize();
+
+  // the first frame measures from here, not from the start of the (long) initialization
+  StartEngineClock();
 }
 
 void ShutdownCurrentApplication() {
@@ -1,11 +1,21 @@
 #include "canvas.h"
 #include <mercury_log.h>
 #include <ll/graphics.h>
+#include <ll/os.h>
+#include "worker_pool.h"
+#include <mercury_application.h>
 #include <mercury_embedded_shaders.h>
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <mutex>
 
 using namespace mercury;
 ll::graphics::ParameterBlockLayoutHandle gCanvasParameterBlockLayout;
 ll::graphics::ParameterBlockLayoutHandle gCanvasSpriteTextureParameterBlockLayout;
+ll::graphics::ParameterBlockLayoutHandle gCanvasSpriteInstancesParameterBlockLayout;
+ll::graphics::ParameterBlockLayoutHandle gCanvasSpriteTextureTableParameterBlockLayout;
+ll::graphics::ParameterBlockLayoutHandle gCanvasSpriteCullParameterBlockLayout;
 
 ll::graphics::TextureHandle gWhiteTextureHandle;
 ll::graphics::ParameterBlockHandle gWhiteTexturePlaceholder;
@@ -14,49 +24,323 @@ using namespace ll::graphics;
 
 constexpr int CANVAS_PER_FRAME_SET_INDEX = 0;
 constexpr int CANVAS_SPRITE_TEXTURE_SET_INDEX = 1;
+constexpr int CANVAS_SPRITE_INSTANCES_SET_INDEX = 2;
+constexpr int CANVAS_SPRITE_CULL_SET_INDEX = 1; // compute pipeline, set 0 stays the per frame block
 
+constexpr u32 CANVAS_SPRITE_CULL_GROUP_SIZE = 64; // numthreads of CanvasSpriteCullCS
+constexpr u32 CANVAS_MIN_SPRITE_DRAW_RECORDS = 64;
+
+constexpr u32 CANVAS_MIN_SPRITE_INSTANCES = 4096;
+constexpr u32 CANVAS_MIN_LAYER_SPRITE_INSTANCES = 256;
+constexpr u32 CANVAS_MIN_TEXT_GLYPH_INSTANCES = 1024;
+constexpr u32 CANVAS_MAX_SPRITE_TEXTURES = 1024;
+
+// below this many sprites per thread spawning costs more than it saves
+constexpr u32 CANVAS_MIN_SPRITES_PER_THREAD = 8192;
+constexpr u32 CANVAS_MIN_SPRITES_PER_CHUNK = 1024;
+
+struct SpriteInstanceBufferResources
+{
+	ll::graphics::BufferHandle spriteInstanceBuffer;
+	ll::graphics::ParameterBlockHandle spriteInstanceParameterBlock;
+	u32 spriteInstanceCapacity = 0;
+};
 
 struct CanvasFrameResources
 {
-	ll::graphics::BufferHandle scene2DConstantBuffer;
+	ll::graphics::BufferHandle scene2DConstantBuffer; // used when the device upload ring is not available
 	ll::graphics::ParameterBlockHandle scene2DParameterBlock;
+	ll::graphics::BufferHandle scene2DBoundBuffer; // buffer scene2DParameterBlock currently points at
+	u32 scene2DDynamicOffset = 0; // of this frame's constants in scene2DBoundBuffer
+
+	SpriteInstanceBufferResources spriteInstances;
+
+	ll::graphics::ParameterBlockHandle spriteTextureTable;
+	u32 spriteTextureTableEntries = 0; // leading gSpriteTextures entries already written to spriteTextureTable
+
+	// GPU culling, the culling pass compacts spriteInstances into visibleSpriteBuffer
+	ll::graphics::BufferHandle spriteCullConstantBuffer;
+	ll::graphics::BufferHandle visibleSpriteBuffer;
+	ll::graphics::ParameterBlockHandle visibleSpriteParameterBlock;
+	u32 visibleSpriteCapacity = 0;
+	ll::graphics::BufferHandle spriteDrawRecordBuffer;
+	u32 spriteDrawRecordCapacity = 0;
+	ll::graphics::ParameterBlockHandle spriteCullParameterBlock;
+
+	// buffers of destroyed layers, released once this frame in flight is recorded again
+	std::vector<SpriteInstanceBufferResources> retiredLayerResources;
+
+	SpriteInstanceBufferResources textInstances;
 };
 
 std::vector<CanvasFrameResources> gCanvasFrameResources;
 
 
-struct SpriteTransform
+struct Sprite2D
 {
-	glm::vec2 position;
-	glm::vec2 size;
-	glm::vec2 uv0;
-	glm::vec2 uv1;
+	SpriteTransform transform;
+	ll::graphics::TextureHandle texture;
+};
 
-	float angle;
-	PackedColor color;
+// Every thread queuing sprites appends to its own queue. The queue is double buffered: DrawSprite appends to pending
+// under the queue lock, which only the tick contends for when it swaps pending in at its start, so sprites queued
+// while a tick runs are drawn by the next one.
+struct CanvasSpriteQueue
+{
+	std::mutex mutex;
+	std::vector<Sprite2D> pending; // owning thread appends
+	std::vector<Sprite2D> sprites; // swapped in at tick start, read by the canvas only
+	bool released = false; // owning thread exited, recycled once drained
 };
 
-struct Sprite2D
+// Hands the queue back when its thread exits. Queues are never freed, a recycled one goes to the next new thread.
+struct CanvasSpriteQueueOwner
+{
+	CanvasSpriteQueue* queue = nullptr;
+	~CanvasSpriteQueueOwner();
+};
+
+std::mutex gSpriteQueuesMutex;
+std::vector<std::unique_ptr<CanvasSpriteQueue>> gSpriteQueues; // drawn in this order
+std::vector<CanvasSpriteQueue*> gFreeSpriteQueues;
+thread_local CanvasSpriteQueueOwner tSpriteQueue;
+
+CanvasSpriteQueueOwner::~CanvasSpriteQueueOwner()
+{
+	if (queue == nullptr)
+		return;
+
+	std::lock_guard<std::mutex> lock(gSpriteQueuesMutex);
+	queue->released = true;
+}
+
+CanvasSpriteQueue& GetThreadSpriteQueue()
+{
+	IF_LIKELY (tSpriteQueue.queue != nullptr)
+		return *tSpriteQueue.queue;
+
+	std::lock_guard<std::mutex> lock(gSpriteQueuesMutex);
+
+	if (!gFreeSpriteQueues.empty())
+	{
+		tSpriteQueue.queue = gFreeSpriteQueues.back();
+		gFreeSpriteQueues.pop_back();
+	}
+	else
+	{
+		tSpriteQueue.queue = gSpriteQueues.emplace_back(std::make_unique<CanvasSpriteQueue>()).get();
+	}
+
+	return *tSpriteQueue.queue;
+}
+
+// Takes what every thread queued since the last tick, producers keep appending to the emptied buffers.
+void SwapSpriteQueues()
+{
+	std::lock_guard<std::mutex> lock(gSpriteQueuesMutex);
+
+	for (auto& queue : gSpriteQueues)
+	{
+		std::lock_guard<std::mutex> queueLock(queue->mutex);
+		std::swap(queue->pending, queue->sprites);
+	}
+}
+
+// Empties every queue once drawn, queues of exited threads go back to the free list once fully drained.
+void ClearSpriteQueues()
+{
+	std::lock_guard<std::mutex> lock(gSpriteQueuesMutex);
+
+	for (auto& queue : gSpriteQueues)
+	{
+		queue->sprites.clear();
+
+		// the owner is gone, nothing appends to pending anymore
+		if (queue->released && queue->pending.empty())
+		{
+			queue->released = false;
+			gFreeSpriteQueues.push_back(queue.get());
+		}
+	}
+}
+
+// A slice of one queue, processed by a single worker. Textures are deduplicated per chunk in parallel first,
+// so only the distinct ones go through the atlas and the shared batch and table maps.
+struct SpriteChunk
+{
+	const Sprite2D* sprites = nullptr;
+	u32 numSprites = 0;
+	u32 firstSprite = 0; // submission index of sprites[0]
+
+	std::vector<u64> textureKeys; // distinct SpriteTextureKey values in order of first use
+	std::vector<u32> textureCounts; // sprites per textureKeys entry
+	std::vector<u32> spriteTextures; // textureKeys index of every sprite
+	std::unordered_map<u64, u32> textureLookup;
+
+	std::vector<u32> textureTargets; // gSpriteTargets index per textureKeys entry
+	std::vector<u32> batchCursors; // per batch write position of this chunk's first sprite
+};
+
+std::vector<SpriteChunk> gSpriteChunks; // only grows, so the per chunk vectors keep their capacity
+u32 gNumSpriteChunks = 0;
+
+// distinct sprite textures of the frame, after atlas remapping
+struct SpriteTarget
+{
+	ll::graphics::TextureHandle texture;
+	glm::vec2 uvOffset = glm::vec2(0.0f);
+	glm::vec2 uvScale = glm::vec2(1.0f);
+	u32 slot = 0; // texture table index or batch index
+};
+
+std::vector<SpriteTarget> gSpriteTargets;
+std::unordered_map<u64, u32> gSpriteTargetByKey;
+
+// matches SpriteInstance in mercury_base.slang
+struct SpriteInstance
 {
 	SpriteTransform transform;
+	u32 textureIndex;
+	u32 batchIndex; // gSpriteDrawRecords index, read by the GPU culling pass only
+};
+
+static_assert(sizeof(SpriteInstance) == 48, "SpriteInstance must match the shader side stride");
+
+struct SpriteBatchConstants
+{
+	u32 firstSprite;
+};
+
+// sprites sharing a texture, a contiguous range of gSpriteInstances
+struct SpriteBatch
+{
 	ll::graphics::TextureHandle texture;
+	u32 firstSprite = 0;
+	u32 numSprites = 0;
+};
+
+// matches SpriteDrawRecord in canvas_sprite_cull.slang, one per batch
+struct SpriteDrawRecord
+{
+	DrawIndirectArguments arguments;
+	u32 firstSprite = 0; // where the culling pass compacts the visible sprites of the batch
+	u32 padding[3] = {};
+};
+
+static_assert(sizeof(SpriteDrawRecord) == 32, "SpriteDrawRecord must match the shader side stride");
+
+// matches the uniform part of SpriteCullParameters in canvas_sprite_cull.slang
+struct SpriteCullConstants
+{
+	u32 numSprites = 0;
+	u32 padding[3] = {};
 };
 
-std::vector<Sprite2D> gSpritesToDraw;
+std::vector<SpriteInstance> gSpriteInstances;
+std::vector<SpriteBatch> gSpriteBatches;
+std::unordered_map<u32, u32> gSpriteBatchByTexture;
+std::vector<u32> gSpriteBatchFill;
 
 mercury::ll::graphics::PsoHandle testDedicatedSpritePSO;
 mercury::ll::graphics::ShaderHandle testDedicatedSpriteVS;
 mercury::ll::graphics::ShaderHandle testDedicatedSpriteFS;
 
+mercury::ll::graphics::PsoHandle gInstancedSpritePSO;
+mercury::ll::graphics::ShaderHandle gInstancedSpriteVS;
+bool gSpriteInstancingSupported = false;
+
+mercury::ll::graphics::PsoHandle gBindlessSpritePSO;
+mercury::ll::graphics::ShaderHandle gBindlessSpriteVS;
+mercury::ll::graphics::ShaderHandle gBindlessSpritePS;
+bool gSpriteTextureTablesSupported = false;
+u32 gSpriteTextureTableSize = 0;
+
+mercury::ll::graphics::PsoHandle gSpriteCullPSO;
+mercury::ll::graphics::ShaderHandle gSpriteCullCS;
+bool gSpriteGpuCullingSupported = false;
+bool gSpriteGpuCullingEnabled = false;
+std::vector<SpriteDrawRecord> gSpriteDrawRecords;
+
+// how PrepareQueuedSprites laid out this frame's sprites, DrawQueuedSprites replays it inside the final pass
+enum class SpriteDrawPath
+{
+	None,
+	Bindless,
+	Instanced,
+	Dedicated
+};
+
+SpriteDrawPath gSpriteDrawPath = SpriteDrawPath::None;
+bool gSpriteDrawCulled = false;
+
+mercury::ll::graphics::PsoHandle gTextPSO;
+mercury::ll::graphics::ShaderHandle gTextPS;
+bool gTextDistanceFieldSupported = false;
+std::vector<SpriteInstance> gTextInstances;
+
+struct TextPageRange
+{
+	ll::graphics::TextureHandle page;
+	u32 numGlyphs = 0;
+};
+
+std::vector<TextPageRange> gTextPageRanges; // gTextInstances split by glyph page
+
+// bindless path, every texture drawn gets a stable slot in the per frame texture tables
+std::vector<ll::graphics::TextureHandle> gSpriteTextures;
+std::unordered_map<u32, u32> gSpriteTextureIndices;
+
 std::unordered_map<u32, ll::graphics::ParameterBlockHandle> gSpriteTextureParameterBlocks;
 
+// Retained sprites, every frame in flight keeps its own instance buffer and uploads only the range changed
+// since it was last recorded.
+struct CanvasLayer
+{
+	struct FrameState
+	{
+		SpriteInstanceBufferResources resources;
+		u32 dirtyBegin = 0;
+		u32 dirtyEnd = 0; // empty range when equal to dirtyBegin
+	};
+
+	i32 order = 0;
+	bool visible = true;
+
+	std::vector<SpriteInstance> instances;
+	std::vector<ll::graphics::TextureHandle> textures; // per instance
+	std::vector<SpriteBatch> batches; // runs of consecutive instances sharing a texture
+	bool batchesDirty = false;
+
+	std::vector<FrameState> frames;
+
+	void MarkDirty(u32 begin, u32 end)
+	{
+		for (auto& frame : frames)
+		{
+			if (frame.dirtyBegin == frame.dirtyEnd)
+			{
+				frame.dirtyBegin = begin;
+				frame.dirtyEnd = end;
+			}
+			else
+			{
+				frame.dirtyBegin = std::min(frame.dirtyBegin, begin);
+				frame.dirtyEnd = std::max(frame.dirtyEnd, end);
+			}
+		}
+	}
+};
+
+SlotMap<CanvasLayer> gCanvasLayers;
+std::vector<canvas::LayerHandle> gCanvasLayerOrder; // sorted by CanvasLayer::order, creation order among equal ones
+
 void MercuryCanvasInitialize(int numFramesInFlight)
 {
 	MLOG_DEBUG(u8"MercuryCanvasInitialize - Starting");
 
 
 	ll::graphics::BindingSetLayoutDescriptor layoutDesc = {};
-	layoutDesc.AddSlot(ll::graphics::ShaderResourceType::UniformBuffer);
+	layoutDesc.AddSlot(ll::graphics::ShaderResourceType::DynamicUniformBuffer);
 
 	gCanvasParameterBlockLayout = ll::graphics::gDevice->CreateParameterBlockLayout(layoutDesc, CANVAS_PER_FRAME_SET_INDEX);
 
@@ -73,7 +357,19 @@ void MercuryCanvasInitialize(int numFramesInFlight)
 
 		ll::graphics::gDevice->UpdateParameterBlock(gWhiteTexturePlaceholder, pbDesc);
 	}
-	
+
+	MercuryCanvasAtlasInitialize(numFramesInFlight);
+	{
+		// untextured sprites join the atlas pages too, same texel as GetBlackOpaqueTexture
+		const u32 placeholderPixel = 0xFF000000;
+		canvas::Atlas::AddImage(gWhiteTextureHandle, 1, 1, &placeholderPixel);
+	}
+
+	{
+		ll::graphics::BindingSetLayoutDescriptor layoutDesc3 = {};
+		layoutDesc3.AddSlot(ll::graphics::ShaderResourceType::ReadOnlyBuffer);
+		gCanvasSpriteInstancesParameterBlockLayout = ll::graphics::gDevice->CreateParameterBlockLayout(layoutDesc3, CANVAS_SPRITE_INSTANCES_SET_INDEX);
+	}
 
 	gCanvasFrameResources.resize(numFramesInFlight);
 
@@ -87,8 +383,9 @@ void MercuryCanvasInitialize(int numFramesInFlight)
 		gCanvasFrameResources[i].scene2DParameterBlock = ll::graphics::gDevice->CreateParameterBlock(gCanvasParameterBlockLayout);
 
 		ll::graphics::ParameterBlockDescriptor pbDesc = {};
-		pbDesc.AddBuffer(gCanvasFrameResources[i].scene2DConstantBuffer);
+		pbDesc.AddBuffer(gCanvasFrameResources[i].scene2DConstantBuffer, 0, sizeof(Scene2DConstants));
 		ll::graphics::gDevice->UpdateParameterBlock(gCanvasFrameResources[i].scene2DParameterBlock, pbDesc);
+		gCanvasFrameResources[i].scene2DBoundBuffer = gCanvasFrameResources[i].scene2DConstantBuffer;
 
 	}
 
@@ -99,83 +396,1081 @@ void MercuryCanvasInitialize(int numFramesInFlight)
 	dedicatedSpritePsoDesc.vertexShader = testDedicatedSpriteVS;// testDedicatedSpriteVS;
 	dedicatedSpritePsoDesc.fragmentShader = testDedicatedSpriteFS;
 	dedicatedSpritePsoDesc.pushConstantSize = sizeof(SpriteTransform);
-	dedicatedSpritePsoDesc.bindingSetLayouts[0].AddSlot(ll::graphics::ShaderResourceType::UniformBuffer); //simulate canvas binding set layout
+	dedicatedSpritePsoDesc.bindingSetLayouts[0].AddSlot(ll::graphics::ShaderResourceType::DynamicUniformBuffer); //simulate canvas binding set layout
 	dedicatedSpritePsoDesc.bindingSetLayouts[1].AddSlot(ll::graphics::ShaderResourceType::SampledImage2D); //simulate canvas binding set layout
 
 
 	dedicatedSpritePsoDesc.primitiveTopology = ll::graphics::PrimitiveTopology::TriangleStrip;
 	testDedicatedSpritePSO = ll::graphics::gDevice->CreateRasterizePipeline(dedicatedSpritePsoDesc);
+
+	// backends without the instanced shader embedded keep drawing sprite by sprite
+	ll::graphics::ShaderBytecodeView instancedVSBytecode = ll::graphics::embedded_shaders::DedicatedSpriteInstancedVS();
+	gSpriteInstancingSupported = instancedVSBytecode.size > 0;
+
+	if (gSpriteInstancingSupported)
+	{
+		gInstancedSpriteVS = ll::graphics::gDevice->CreateShaderModule(instancedVSBytecode);
+
+		ll::graphics::RasterizePipelineDescriptor instancedSpritePsoDesc = dedicatedSpritePsoDesc;
+		instancedSpritePsoDesc.vertexShader = gInstancedSpriteVS;
+		instancedSpritePsoDesc.pushConstantSize = sizeof(SpriteBatchConstants);
+		instancedSpritePsoDesc.bindingSetLayouts[2].AddSlot(ll::graphics::ShaderResourceType::ReadOnlyBuffer);
+		gInstancedSpritePSO = ll::graphics::gDevice->CreateRasterizePipeline(instancedSpritePsoDesc);
+
+		// without the distance field shader glyph pages hold plain coverage the sprite shader blends
+		ll::graphics::ShaderBytecodeView textPSBytecode = ll::graphics::embedded_shaders::CanvasTextPS();
+		gTextDistanceFieldSupported = textPSBytecode.size > 0;
+
+		ll::graphics::RasterizePipelineDescriptor textPsoDesc = instancedSpritePsoDesc;
+		textPsoDesc.blendMode = ll::graphics::BlendMode::AlphaBlend;
+
+		if (gTextDistanceFieldSupported)
+		{
+			gTextPS = ll::graphics::gDevice->CreateShaderModule(textPSBytecode);
+			textPsoDesc.fragmentShader = gTextPS;
+		}
+
+		gTextPSO = ll::graphics::gDevice->CreateRasterizePipeline(textPsoDesc);
+
+		// all sprites in one draw when the device can index textures from a table
+		ll::graphics::ShaderBytecodeView bindlessVSBytecode = ll::graphics::embedded_shaders::DedicatedSpriteBindlessVS();
+		ll::graphics::ShaderBytecodeView bindlessPSBytecode = ll::graphics::embedded_shaders::DedicatedSpriteBindlessPS();
+		const u32 maxTextureTableSize = ll::graphics::gDevice->GetMaxTextureTableSize();
+
+		gSpriteTextureTablesSupported = maxTextureTableSize > 0 && bindlessVSBytecode.size > 0 && bindlessPSBytecode.size > 0;
+
+		if (gSpriteTextureTablesSupported)
+		{
+			gSpriteTextureTableSize = std::min(CANVAS_MAX_SPRITE_TEXTURES, maxTextureTableSize);
+
+			ll::graphics::BindingSetLayoutDescriptor layoutDesc4 = {};
+			layoutDesc4.AddTextureTable(gSpriteTextureTableSize);
+			gCanvasSpriteTextureTableParameterBlockLayout = ll::graphics::gDevice->CreateParameterBlockLayout(layoutDesc4, CANVAS_SPRITE_TEXTURE_SET_INDEX);
+
+			for (auto& frame : gCanvasFrameResources)
+			{
+				frame.spriteTextureTable = ll::graphics::gDevice->CreateParameterBlock(gCanvasSpriteTextureTableParameterBlockLayout);
+			}
+
+			gBindlessSpriteVS = ll::graphics::gDevice->CreateShaderModule(bindlessVSBytecode);
+			gBindlessSpritePS = ll::graphics::gDevice->CreateShaderModule(bindlessPSBytecode);
+
+			ll::graphics::RasterizePipelineDescriptor bindlessSpritePsoDesc = instancedSpritePsoDesc;
+			bindlessSpritePsoDesc.vertexShader = gBindlessSpriteVS;
+			bindlessSpritePsoDesc.fragmentShader = gBindlessSpritePS;
+			bindlessSpritePsoDesc.bindingSetLayouts[CANVAS_SPRITE_TEXTURE_SET_INDEX] = layoutDesc4;
+			gBindlessSpritePSO = ll::graphics::gDevice->CreateRasterizePipeline(bindlessSpritePsoDesc);
+		}
+		else
+		{
+			MLOG_DEBUG(u8"MercuryCanvasInitialize - no texture tables for %s, one sprite draw per texture", ll::graphics::GetBackendName());
+		}
+
+		ll::graphics::ShaderBytecodeView cullCSBytecode = ll::graphics::embedded_shaders::CanvasSpriteCullCS();
+		gSpriteGpuCullingSupported = cullCSBytecode.size > 0;
+
+		if (gSpriteGpuCullingSupported)
+		{
+			ll::graphics::BindingSetLayoutDescriptor layoutDesc5 = {};
+			layoutDesc5.AddSlot(ll::graphics::ShaderResourceType::UniformBuffer);
+			layoutDesc5.AddSlot(ll::graphics::ShaderResourceType::ReadOnlyBuffer);
+			layoutDesc5.AddSlot(ll::graphics::ShaderResourceType::RWBuffer);
+			layoutDesc5.AddSlot(ll::graphics::ShaderResourceType::RWBuffer);
+			gCanvasSpriteCullParameterBlockLayout = ll::graphics::gDevice->CreateParameterBlockLayout(layoutDesc5, CANVAS_SPRITE_CULL_SET_INDEX);
+
+			gSpriteCullCS = ll::graphics::gDevice->CreateShaderModule(cullCSBytecode);
+
+			ll::graphics::ComputePipelineDescriptor cullPsoDesc = {};
+			cullPsoDesc.computeShader = gSpriteCullCS;
+			cullPsoDesc.bindingSetLayouts[CANVAS_PER_FRAME_SET_INDEX].AddSlot(ll::graphics::ShaderResourceType::DynamicUniformBuffer);
+			cullPsoDesc.bindingSetLayouts[CANVAS_SPRITE_CULL_SET_INDEX] = layoutDesc5;
+			gSpriteCullPSO = ll::graphics::gDevice->CreateComputePipeline(cullPsoDesc);
+		}
+	}
+	else
+	{
+		MLOG_WARNING(u8"MercuryCanvasInitialize - no instanced sprite shader for %s, drawing sprites one by one", ll::graphics::GetBackendName());
+
+		ll::graphics::RasterizePipelineDescriptor textPsoDesc = dedicatedSpritePsoDesc;
+		textPsoDesc.blendMode = ll::graphics::BlendMode::AlphaBlend;
+		gTextPSO = ll::graphics::gDevice->CreateRasterizePipeline(textPsoDesc);
+	}
+
+	MercuryCanvasTextInitialize(numFramesInFlight, gTextDistanceFieldSupported);
+}
+
+void DestroySpriteInstanceBuffer(SpriteInstanceBufferResources& resources)
+{
+	if (!resources.spriteInstanceBuffer.isValid())
+		return;
+
+	gDevice->DestroyParameterBlock(resources.spriteInstanceParameterBlock);
+	gDevice->DestroyBuffer(resources.spriteInstanceBuffer);
+	resources.spriteInstanceBuffer.Invalidate();
+	resources.spriteInstanceCapacity = 0;
+}
+
+// Makes room for numSprites instances, the caller's frame in flight must be done on the GPU.
+// Returns true when the buffer was recreated and every instance has to be uploaded again.
+bool ReserveSpriteInstanceBuffer(SpriteInstanceBufferResources& resources, u32 numSprites, u32 minCapacity)
+{
+	if (numSprites <= resources.spriteInstanceCapacity)
+		return false;
+
+	DestroySpriteInstanceBuffer(resources);
+
+	resources.spriteInstanceCapacity = std::max(minCapacity, std::bit_ceil(numSprites));
+
+	BufferDescriptor bdesc = {};
+	bdesc.size = resources.spriteInstanceCapacity * sizeof(SpriteInstance);
+	bdesc.type = BufferType::StorageBuffer;
+	resources.spriteInstanceBuffer = gDevice->CreateBuffer(bdesc);
+
+	resources.spriteInstanceParameterBlock = gDevice->CreateParameterBlock(gCanvasSpriteInstancesParameterBlockLayout);
+
+	ll::graphics::ParameterBlockDescriptor pbDesc = {};
+	pbDesc.AddBuffer(resources.spriteInstanceBuffer);
+	gDevice->UpdateParameterBlock(resources.spriteInstanceParameterBlock, pbDesc);
+	return true;
 }
 
 void MercuryCanvasShutdown()
 {
+	for (const auto& layer : gCanvasLayerOrder)
+	{
+		for (auto& frame : gCanvasLayers[layer.handle].frames)
+			DestroySpriteInstanceBuffer(frame.resources);
+
+		gCanvasLayers.Remove(layer.handle);
+	}
+	gCanvasLayerOrder.clear();
 
 	for (auto &cfr : gCanvasFrameResources)
 	{
 		gDevice->DestroyBuffer(cfr.scene2DConstantBuffer);
 		cfr.scene2DConstantBuffer.Invalidate();
+
+		DestroySpriteInstanceBuffer(cfr.spriteInstances);
+
+		if (cfr.spriteTextureTable.isValid())
+		{
+			gDevice->DestroyParameterBlock(cfr.spriteTextureTable);
+			cfr.spriteTextureTable.Invalidate();
+		}
+
+		if (cfr.spriteCullConstantBuffer.isValid())
+		{
+			gDevice->DestroyBuffer(cfr.spriteCullConstantBuffer);
+			cfr.spriteCullConstantBuffer.Invalidate();
+		}
+
+		if (cfr.visibleSpriteBuffer.isValid())
+		{
+			gDevice->DestroyParameterBlock(cfr.visibleSpriteParameterBlock);
+			gDevice->DestroyBuffer(cfr.visibleSpriteBuffer);
+			cfr.visibleSpriteBuffer.Invalidate();
+		}
+
+		if (cfr.spriteDrawRecordBuffer.isValid())
+		{
+			gDevice->DestroyBuffer(cfr.spriteDrawRecordBuffer);
+			cfr.spriteDrawRecordBuffer.Invalidate();
+		}
+
+		if (cfr.spriteCullParameterBlock.isValid())
+		{
+			gDevice->DestroyParameterBlock(cfr.spriteCullParameterBlock);
+			cfr.spriteCullParameterBlock.Invalidate();
+		}
+
+		for (auto& resources : cfr.retiredLayerResources)
+			DestroySpriteInstanceBuffer(resources);
+		cfr.retiredLayerResources.clear();
+
+		DestroySpriteInstanceBuffer(cfr.textInstances);
 	}
 
+	MercuryCanvasTextShutdown();
+	MercuryCanvasAtlasShutdown();
+	SwapSpriteQueues(); // drops what was queued after the last tick
+	ClearSpriteQueues();
+
 	gCanvasFrameResources.clear();
+	gSpriteTextures.clear();
+	gSpriteTextureIndices.clear();
+
+	for (const auto& [texture, parameterBlock] : gSpriteTextureParameterBlocks)
+		ll::graphics::gDevice->DestroyParameterBlock(parameterBlock);
+	gSpriteTextureParameterBlocks.clear();
+
+	ll::graphics::gDevice->DestroyParameterBlock(gWhiteTexturePlaceholder);
 
 	ll::graphics::gDevice->DestroyParameterBlockLayout(gCanvasParameterBlockLayout);
+	ll::graphics::gDevice->DestroyParameterBlockLayout(gCanvasSpriteTextureParameterBlockLayout);
+	ll::graphics::gDevice->DestroyParameterBlockLayout(gCanvasSpriteInstancesParameterBlockLayout);
+
+	if (gSpriteTextureTablesSupported)
+		ll::graphics::gDevice->DestroyParameterBlockLayout(gCanvasSpriteTextureTableParameterBlockLayout);
+
+	ll::graphics::gDevice->DestroyRasterizePipeline(gTextPSO);
+	if (gTextDistanceFieldSupported)
+		ll::graphics::gDevice->DestroyShaderModule(gTextPS);
+
+	if (gSpriteTextureTablesSupported)
+	{
+		ll::graphics::gDevice->DestroyRasterizePipeline(gBindlessSpritePSO);
+		ll::graphics::gDevice->DestroyShaderModule(gBindlessSpriteVS);
+		ll::graphics::gDevice->DestroyShaderModule(gBindlessSpritePS);
+	}
+
+	if (gSpriteInstancingSupported)
+	{
+		ll::graphics::gDevice->DestroyRasterizePipeline(gInstancedSpritePSO);
+		ll::graphics::gDevice->DestroyShaderModule(gInstancedSpriteVS);
+	}
+
+	ll::graphics::gDevice->DestroyRasterizePipeline(testDedicatedSpritePSO);
+	ll::graphics::gDevice->DestroyShaderModule(testDedicatedSpriteVS);
+	ll::graphics::gDevice->DestroyShaderModule(testDedicatedSpriteFS);
+
+	if (gSpriteGpuCullingSupported)
+	{
+		ll::graphics::gDevice->DestroyComputePipeline(gSpriteCullPSO);
+		ll::graphics::gDevice->DestroyShaderModule(gSpriteCullCS);
+		ll::graphics::gDevice->DestroyParameterBlockLayout(gCanvasSpriteCullParameterBlockLayout);
+	}
 	MLOG_DEBUG(u8"MercuryCanvasShutdown - Starting");
 }
 
-void MercuryCanvasTick(mercury::ll::graphics::CommandList& cl, int frameInFlightIndex)
+ll::graphics::ParameterBlockHandle GetSpriteTextureParameterBlock(ll::graphics::TextureHandle texture)
 {
-	static float ctime = 0.0f;
-	ctime += 0.016f; // TODO: Replace with actual delta time
+	if (!texture.isValid())
+		return gWhiteTexturePlaceholder;
 
-	Scene2DConstants scene2DConstants = {};
-	scene2DConstants.canvasSize = glm::vec4((float)gSwapchain->GetWidth(), (float)gSwapchain->GetHeight(), 2.0f / (float)gSwapchain->GetWidth(), (ll::graphics::IsYFlipped() ? -2.0f : 2.0f) / (float)gSwapchain->GetHeight());
-	scene2DConstants.time = ctime;
-	scene2DConstants.deltaTime = 0.016f; // TODO: Replace with actual delta time
-	scene2DConstants.prerptationMatrix = glm::mat2x2(1.0f); // Identity matrix for now
+	auto texIt = gSpriteTextureParameterBlocks.find(texture.handle);
+
+	if (texIt == gSpriteTextureParameterBlocks.end())
+	{
+		ll::graphics::ParameterBlockHandle parameterBlock = ll::graphics::gDevice->CreateParameterBlock(gCanvasSpriteTextureParameterBlockLayout);
+		ll::graphics::ParameterBlockDescriptor pbDesc = {};
+		pbDesc.AddSampledTexture2D(texture);
+		ll::graphics::gDevice->UpdateParameterBlock(parameterBlock, pbDesc);
+		texIt = gSpriteTextureParameterBlocks.emplace(texture.handle, parameterBlock).first;
+	}
 
-	gDevice->UpdateBuffer(gCanvasFrameResources[frameInFlightIndex].scene2DConstantBuffer, &scene2DConstants, sizeof(Scene2DConstants));
+	return texIt->second;
+}
 
-	//cl.SetParameterBlockLayout(CANVAS_PER_FRAME_SET_INDEX, gCanvasParameterBlockLayout);
+void MercuryCanvasForgetSpriteTexture(ll::graphics::TextureHandle texture)
+{
+	auto texIt = gSpriteTextureParameterBlocks.find(texture.handle);
+	if (texIt != gSpriteTextureParameterBlocks.end())
+	{
+		// the device keeps the set alive until the frames in flight that bound it retired
+		ll::graphics::gDevice->DestroyParameterBlock(texIt->second);
+		gSpriteTextureParameterBlocks.erase(texIt);
+	}
 
-	cl.SetPSO(testDedicatedSpritePSO);
-	//cl.SetUniformBuffer(0, gCanvasFrameResources[frameInFlightIndex].scene2DConstantBuffer);
-	cl.SetParameterBlock(CANVAS_PER_FRAME_SET_INDEX, gCanvasFrameResources[frameInFlightIndex].scene2DParameterBlock);
+	// table entries never move, so start the tables over like BuildSpriteTextureTableSlots does when they are full
+	if (gSpriteTextureIndices.contains(texture.handle))
+	{
+		gSpriteTextures.clear();
+		gSpriteTextureIndices.clear();
+		for (auto& frame : gCanvasFrameResources)
+			frame.spriteTextureTableEntries = 0;
+	}
+}
+
+u32 ResolveSpriteThreadCount(size_t numSprites)
+{
+#if defined(MERCURY_LL_OS_EMSCRIPTEN)
+	return 1;
+#else
+	const u32 numThreads = workers::GetNumWorkers() + 1;
+	return static_cast<u32>(std::min<size_t>(numThreads, std::max<size_t>(1, numSprites / CANVAS_MIN_SPRITES_PER_THREAD)));
+#endif
+}
+
+// Runs fn on every chunk on the shared worker pool, threads pull chunks until none are left. The calling thread works too.
+template<typename Fn>
+void ForEachSpriteChunk(u32 numThreads, Fn&& fn)
+{
+	workers::ParallelFor(gNumSpriteChunks, numThreads, [&fn](u32 i) { fn(gSpriteChunks[i]); });
+}
+
+// Splits the thread queues into gSpriteChunks.
+// Returns the number of queued sprites, outNumThreads the workers worth using for them.
+u32 GatherSpriteChunks(u32& outNumThreads)
+{
+	std::lock_guard<std::mutex> lock(gSpriteQueuesMutex);
+
+	size_t numSprites = 0;
+	for (const auto& queue : gSpriteQueues)
+		numSprites += queue->sprites.size();
+
+	outNumThreads = ResolveSpriteThreadCount(numSprites);
+
+	// a few chunks per worker so uneven queues still balance
+	const size_t chunkSize = outNumThreads > 1 ? std::max<size_t>(CANVAS_MIN_SPRITES_PER_CHUNK, numSprites / (outNumThreads * 4)) : SIZE_MAX;
 
-	for(auto& sprite : gSpritesToDraw)
+	gNumSpriteChunks = 0;
+	u32 firstSprite = 0;
+
+	for (const auto& queue : gSpriteQueues)
 	{
-		if (sprite.texture.isValid())
+		const size_t queueSize = queue->sprites.size();
+
+		for (size_t begin = 0; begin < queueSize; begin += chunkSize)
 		{
-			auto texIt = gSpriteTextureParameterBlocks.find(sprite.texture.handle);
+			if (gNumSpriteChunks == gSpriteChunks.size())
+				gSpriteChunks.emplace_back();
+
+			SpriteChunk& chunk = gSpriteChunks[gNumSpriteChunks++];
+			chunk.sprites = queue->sprites.data() + begin;
+			chunk.numSprites = static_cast<u32>(std::min(chunkSize, queueSize - begin));
+			chunk.firstSprite = firstSprite;
+			firstSprite += chunk.numSprites;
+		}
+	}
+
+	return firstSprite;
+}
+
+// Texture handle in the low bits, the high bit set when the uvs leave [0,1] and the sprite can't use the atlas.
+u64 SpriteTextureKey(const Sprite2D& sprite)
+{
+	const SpriteTransform& t = sprite.transform;
+	const bool wraps = std::min({ t.uv0.x, t.uv0.y, t.uv1.x, t.uv1.y }) < 0.0f || std::max({ t.uv0.x, t.uv0.y, t.uv1.x, t.uv1.y }) > 1.0f;
+	return (static_cast<u64>(wraps) << 32) | sprite.texture.handle;
+}
+
+void ClassifySpriteChunk(SpriteChunk& chunk)
+{
+	chunk.textureKeys.clear();
+	chunk.textureCounts.clear();
+	chunk.textureLookup.clear();
+	chunk.spriteTextures.resize(chunk.numSprites);
 
-			if (texIt == gSpriteTextureParameterBlocks.end())
+	u64 lastKey = UINT64_MAX;
+	u32 lastIndex = 0;
+
+	for (u32 i = 0; i < chunk.numSprites; ++i)
+	{
+		const u64 key = SpriteTextureKey(chunk.sprites[i]);
+
+		IF_UNLIKELY (key != lastKey)
+		{
+			auto [it, inserted] = chunk.textureLookup.try_emplace(key, static_cast<u32>(chunk.textureKeys.size()));
+			if (inserted)
 			{
-				gSpriteTextureParameterBlocks[sprite.texture.handle] = ll::graphics::gDevice->CreateParameterBlock(gCanvasSpriteTextureParameterBlockLayout);
-				ll::graphics::ParameterBlockDescriptor pbDesc = {};
-				pbDesc.AddSampledTexture2D(sprite.texture);
-				ll::graphics::gDevice->UpdateParameterBlock(gSpriteTextureParameterBlocks[sprite.texture.handle], pbDesc);
-				texIt = gSpriteTextureParameterBlocks.find(sprite.texture.handle);
+				chunk.textureKeys.push_back(key);
+				chunk.textureCounts.push_back(0);
 			}
 
-			cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, texIt->second);
+			lastKey = key;
+			lastIndex = it->second;
 		}
-		else
-		{
-			cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, gWhiteTexturePlaceholder);
-		}
-		
-		cl.PushConstants(sprite.transform);
-		cl.Draw(4); // Sprite is a triangle strip
-	}
 
-	gSpritesToDraw.clear();
+		chunk.spriteTextures[i] = lastIndex;
+		chunk.textureCounts[lastIndex]++;
+	}
 }
 
-void canvas::DrawSprite(glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color)
+// Maps the distinct chunk textures to gSpriteTargets, swapping atlas images for their page.
+void ResolveSpriteTargets()
 {
-	gSpritesToDraw.push_back({ { position, size, uv0, uv1, angle, color }, gWhiteTextureHandle });
+	gSpriteTargets.clear();
+	gSpriteTargetByKey.clear();
+
+	for (u32 c = 0; c < gNumSpriteChunks; ++c)
+	{
+		SpriteChunk& chunk = gSpriteChunks[c];
+		chunk.textureTargets.resize(chunk.textureKeys.size());
+
+		for (size_t l = 0; l < chunk.textureKeys.size(); ++l)
+		{
+			const u64 key = chunk.textureKeys[l];
+			auto [it, inserted] = gSpriteTargetByKey.try_emplace(key, static_cast<u32>(gSpriteTargets.size()));
+
+			if (inserted)
+			{
+				SpriteTarget& target = gSpriteTargets.emplace_back();
+				target.texture.handle = static_cast<u32>(key);
+				if (!target.texture.isValid())
+					target.texture = gWhiteTextureHandle;
+
+				CanvasAtlasRegion region;
+				if ((key >> 32) == 0 && MercuryCanvasAtlasFind(target.texture, region))
+				{
+					target.texture = region.page;
+					target.uvOffset = region.uvOffset;
+					target.uvScale = region.uvScale;
+				}
+			}
+
+			chunk.textureTargets[l] = it->second;
+		}
+	}
 }
 
-void canvas::DrawSprite(ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color)
+// Bindless path, every target gets the stable texture table slot of its texture.
+// Fails when the tables run out of free entries.
+bool AssignSpriteTextureTableSlots()
 {
-	gSpritesToDraw.push_back({ { position, size, uv0, uv1, angle, color }, texture });
+	for (auto& target : gSpriteTargets)
+	{
+		auto [it, inserted] = gSpriteTextureIndices.try_emplace(target.texture.handle, static_cast<u32>(gSpriteTextures.size()));
+		if (inserted)
+		{
+			IF_UNLIKELY (gSpriteTextures.size() == gSpriteTextureTableSize)
+			{
+				gSpriteTextureIndices.erase(it);
+				return false;
+			}
+			gSpriteTextures.push_back(target.texture);
+		}
+
+		target.slot = it->second;
+	}
+
+	return true;
+}
+
+bool BuildSpriteTextureTableSlots()
+{
+	IF_LIKELY (AssignSpriteTextureTableSlots())
+		return true;
+
+	// tables are full of textures from earlier frames, start over with this frame's ones only.
+	// Every frame in flight rewrites its own table the next time it is recorded.
+	gSpriteTextures.clear();
+	gSpriteTextureIndices.clear();
+	for (auto& frame : gCanvasFrameResources)
+		frame.spriteTextureTableEntries = 0;
+
+	// more distinct textures in a single frame than a table holds, caller draws per texture
+	return AssignSpriteTextureTableSlots();
+}
+
+// Groups the targets by texture into gSpriteBatches, textures in order of first use, and gives every chunk its
+// write position inside each batch. Counting sort, so sprites sharing a texture keep their submission order.
+void BuildSpriteBatches()
+{
+	gSpriteBatches.clear();
+	gSpriteBatchByTexture.clear();
+
+	for (auto& target : gSpriteTargets)
+	{
+		auto [it, inserted] = gSpriteBatchByTexture.try_emplace(target.texture.handle, static_cast<u32>(gSpriteBatches.size()));
+		if (inserted)
+			gSpriteBatches.push_back({ target.texture, 0, 0 });
+
+		target.slot = it->second;
+	}
+
+	for (u32 c = 0; c < gNumSpriteChunks; ++c)
+	{
+		const SpriteChunk& chunk = gSpriteChunks[c];
+		for (size_t l = 0; l < chunk.textureKeys.size(); ++l)
+			gSpriteBatches[gSpriteTargets[chunk.textureTargets[l]].slot].numSprites += chunk.textureCounts[l];
+	}
+
+	gSpriteBatchFill.resize(gSpriteBatches.size());
+
+	u32 firstSprite = 0;
+	for (size_t b = 0; b < gSpriteBatches.size(); ++b)
+	{
+		gSpriteBatches[b].firstSprite = firstSprite;
+		gSpriteBatchFill[b] = firstSprite;
+		firstSprite += gSpriteBatches[b].numSprites;
+	}
+
+	for (u32 c = 0; c < gNumSpriteChunks; ++c)
+	{
+		SpriteChunk& chunk = gSpriteChunks[c];
+		chunk.batchCursors = gSpriteBatchFill;
+
+		for (size_t l = 0; l < chunk.textureKeys.size(); ++l)
+			gSpriteBatchFill[gSpriteTargets[chunk.textureTargets[l]].slot] += chunk.textureCounts[l];
+	}
+}
+
+// Bindless instances stay in submission order, batched ones go to their batch range.
+template<bool Bindless>
+void FillSpriteChunkInstances(SpriteChunk& chunk)
+{
+	for (u32 i = 0; i < chunk.numSprites; ++i)
+	{
+		const SpriteTarget& target = gSpriteTargets[chunk.textureTargets[chunk.spriteTextures[i]]];
+
+		SpriteInstance& instance = Bindless ? gSpriteInstances[chunk.firstSprite + i] : gSpriteInstances[chunk.batchCursors[target.slot]++];
+		instance.transform = chunk.sprites[i].transform;
+		instance.transform.uv0 = target.uvOffset + instance.transform.uv0 * target.uvScale;
+		instance.transform.uv1 = target.uvOffset + instance.transform.uv1 * target.uvScale;
+		instance.textureIndex = Bindless ? target.slot : 0;
+		instance.batchIndex = Bindless ? 0 : target.slot;
+	}
+}
+
+// Writes the textures appended since this frame in flight was last recorded, earlier entries never move.
+// The constants go through the device upload ring. The per-frame block points at the start of the ring once and every
+// frame moves it with a dynamic offset, so the descriptors are written a single time.
+void UploadScene2DConstants(CanvasFrameResources& frame, const Scene2DConstants& constants)
+{
+	ll::graphics::UploadAllocation upload = gDevice->Upload(&constants, sizeof(Scene2DConstants));
+
+	ll::graphics::BufferHandle buffer = frame.scene2DConstantBuffer;
+	frame.scene2DDynamicOffset = 0;
+	if (upload.IsValid())
+	{
+		buffer = upload.buffer;
+		frame.scene2DDynamicOffset = static_cast<u32>(upload.offset);
+	}
+	else
+	{
+		gDevice->UpdateBuffer(frame.scene2DConstantBuffer, &constants, sizeof(Scene2DConstants));
+	}
+
+	if (buffer == frame.scene2DBoundBuffer)
+		return;
+
+	// this frame slot's previous submission is complete, nothing reads the block anymore
+	ll::graphics::ParameterBlockDescriptor pbDesc = {};
+	pbDesc.AddBuffer(buffer, 0, sizeof(Scene2DConstants));
+	gDevice->UpdateParameterBlock(frame.scene2DParameterBlock, pbDesc);
+
+	frame.scene2DBoundBuffer = buffer;
+}
+
+void BindScene2DConstants(mercury::ll::graphics::CommandList& cl, const CanvasFrameResources& frame)
+{
+	cl.SetParameterBlock(CANVAS_PER_FRAME_SET_INDEX, frame.scene2DParameterBlock, std::span<const u32>(&frame.scene2DDynamicOffset, 1));
+}
+
+void UpdateSpriteTextureTable(CanvasFrameResources& frame)
+{
+	const u32 numTextures = static_cast<u32>(gSpriteTextures.size());
+
+	if (frame.spriteTextureTableEntries == numTextures)
+		return;
+
+	ll::graphics::ParameterBlockDescriptor pbDesc = {};
+	pbDesc.AddTextureTable(std::span(gSpriteTextures).subspan(frame.spriteTextureTableEntries), frame.spriteTextureTableEntries);
+	gDevice->UpdateParameterBlock(frame.spriteTextureTable, pbDesc);
+
+	frame.spriteTextureTableEntries = numTextures;
+}
+
+void UploadSpriteInstances(CanvasFrameResources& frame)
+{
+	const u32 numSprites = static_cast<u32>(gSpriteInstances.size());
+
+	// this frame in flight is done on the GPU, its buffer can be replaced right away
+	ReserveSpriteInstanceBuffer(frame.spriteInstances, numSprites, CANVAS_MIN_SPRITE_INSTANCES);
+
+	gDevice->UpdateBuffer(frame.spriteInstances.spriteInstanceBuffer, gSpriteInstances.data(), numSprites * sizeof(SpriteInstance));
+}
+
+// Compacts the uploaded instances that overlap the canvas into visibleSpriteBuffer, one gSpriteDrawRecords entry per
+// draw. Recorded into the frame command list ahead of the final pass.
+void CullSpritesOnGpu(mercury::ll::graphics::CommandList& cl, CanvasFrameResources& frame)
+{
+	const u32 numSprites = static_cast<u32>(gSpriteInstances.size());
+	const u32 numRecords = static_cast<u32>(gSpriteDrawRecords.size());
+	bool rebuildCullParameterBlock = !frame.spriteCullParameterBlock.isValid();
+
+	if (!frame.spriteCullConstantBuffer.isValid())
+	{
+		BufferDescriptor bdesc = {};
+		bdesc.size = sizeof(SpriteCullConstants);
+		bdesc.type = BufferType::UniformBuffer;
+		frame.spriteCullConstantBuffer = gDevice->CreateBuffer(bdesc);
+	}
+
+	// spriteInstances was just grown to this capacity, follow it
+	if (frame.visibleSpriteCapacity != frame.spriteInstances.spriteInstanceCapacity)
+	{
+		if (frame.visibleSpriteBuffer.isValid())
+		{
+			gDevice->DestroyParameterBlock(frame.visibleSpriteParameterBlock);
+			gDevice->DestroyBuffer(frame.visibleSpriteBuffer);
+		}
+
+		frame.visibleSpriteCapacity = frame.spriteInstances.spriteInstanceCapacity;
+
+		BufferDescriptor bdesc = {};
+		bdesc.size = frame.visibleSpriteCapacity * sizeof(SpriteInstance);
+		bdesc.type = BufferType::StorageBuffer;
+		frame.visibleSpriteBuffer = gDevice->CreateBuffer(bdesc);
+
+		frame.visibleSpriteParameterBlock = gDevice->CreateParameterBlock(gCanvasSpriteInstancesParameterBlockLayout);
+
+		ll::graphics::ParameterBlockDescriptor pbDesc = {};
+		pbDesc.AddBuffer(frame.visibleSpriteBuffer);
+		gDevice->UpdateParameterBlock(frame.visibleSpriteParameterBlock, pbDesc);
+
+		rebuildCullParameterBlock = true;
+	}
+
+	if (numRecords > frame.spriteDrawRecordCapacity)
+	{
+		if (frame.spriteDrawRecordBuffer.isValid())
+			gDevice->DestroyBuffer(frame.spriteDrawRecordBuffer);
+
+		frame.spriteDrawRecordCapacity = std::max(CANVAS_MIN_SPRITE_DRAW_RECORDS, std::bit_ceil(numRecords));
+
+		BufferDescriptor bdesc = {};
+		bdesc.size = frame.spriteDrawRecordCapacity * sizeof(SpriteDrawRecord);
+		bdesc.type = BufferType::IndirectBuffer;
+		frame.spriteDrawRecordBuffer = gDevice->CreateBuffer(bdesc);
+
+		rebuildCullParameterBlock = true;
+	}
+
+	if (rebuildCullParameterBlock)
+	{
+		if (frame.spriteCullParameterBlock.isValid())
+			gDevice->DestroyParameterBlock(frame.spriteCullParameterBlock);
+
+		frame.spriteCullParameterBlock = gDevice->CreateParameterBlock(gCanvasSpriteCullParameterBlockLayout);
+
+		ll::graphics::ParameterBlockDescriptor pbDesc = {};
+		pbDesc.AddBuffer(frame.spriteCullConstantBuffer);
+		pbDesc.AddBuffer(frame.spriteInstances.spriteInstanceBuffer);
+		pbDesc.AddBuffer(frame.visibleSpriteBuffer);
+		pbDesc.AddBuffer(frame.spriteDrawRecordBuffer);
+		gDevice->UpdateParameterBlock(frame.spriteCullParameterBlock, pbDesc);
+	}
+
+	SpriteCullConstants cullConstants = {};
+	cullConstants.numSprites = numSprites;
+	gDevice->UpdateBuffer(frame.spriteCullConstantBuffer, &cullConstants, sizeof(SpriteCullConstants));
+	gDevice->UpdateBuffer(frame.spriteDrawRecordBuffer, gSpriteDrawRecords.data(), numRecords * sizeof(SpriteDrawRecord));
+
+	cl.SetPSO(gSpriteCullPSO);
+	BindScene2DConstants(cl, frame);
+	cl.SetParameterBlock(CANVAS_SPRITE_CULL_SET_INDEX, frame.spriteCullParameterBlock);
+	cl.Dispatch((numSprites + CANVAS_SPRITE_CULL_GROUP_SIZE - 1) / CANVAS_SPRITE_CULL_GROUP_SIZE);
+	cl.DispatchBarrier();
+}
+
+// Draw record of a batch before culling, the culling pass counts the visible sprites into instanceCount.
+SpriteDrawRecord MakeSpriteDrawRecord(u32 firstSprite)
+{
+	SpriteDrawRecord record;
+	record.arguments.vertexCount = 4; // Sprite is a triangle strip
+	record.firstSprite = firstSprite;
+	return record;
+}
+
+// Splits the layer into runs of consecutive instances sharing a texture, one draw each.
+void BuildCanvasLayerBatches(CanvasLayer& layer)
+{
+	layer.batches.clear();
+
+	for (u32 i = 0; i < static_cast<u32>(layer.textures.size()); ++i)
+	{
+		if (layer.batches.empty() || !(layer.batches.back().texture == layer.textures[i]))
+			layer.batches.push_back({ layer.textures[i], i, 0 });
+
+		layer.batches.back().numSprites++;
+	}
+
+	layer.batchesDirty = false;
+}
+
+// Uploads what changed since this frame in flight last drew the layer, nothing for a layer left untouched.
+void UploadCanvasLayerInstances(CanvasLayer& layer, int frameInFlightIndex)
+{
+	// a layer created before MercuryCanvasInitialize has no frame state yet, a fresh one uploads everything
+	if (layer.frames.size() < gCanvasFrameResources.size())
+		layer.frames.resize(gCanvasFrameResources.size());
+
+	CanvasLayer::FrameState& state = layer.frames[frameInFlightIndex];
+	SpriteInstanceBufferResources& resources = state.resources;
+	const u32 numSprites = static_cast<u32>(layer.instances.size());
+
+	// this frame in flight is done on the GPU, its buffer can be replaced right away
+	if (ReserveSpriteInstanceBuffer(resources, numSprites, CANVAS_MIN_LAYER_SPRITE_INSTANCES))
+	{
+		state.dirtyBegin = 0;
+		state.dirtyEnd = numSprites;
+	}
+
+	const u32 dirtyEnd = std::min(state.dirtyEnd, numSprites);
+
+	if (state.dirtyBegin < dirtyEnd)
+	{
+		gDevice->UpdateBuffer(resources.spriteInstanceBuffer, layer.instances.data() + state.dirtyBegin,
+			(dirtyEnd - state.dirtyBegin) * sizeof(SpriteInstance), state.dirtyBegin * sizeof(SpriteInstance));
+	}
+
+	state.dirtyBegin = state.dirtyEnd = 0;
+}
+
+// Draws the visible layers with order in [minOrder, maxOrder].
+void DrawCanvasLayers(mercury::ll::graphics::CommandList& cl, CanvasFrameResources& frame, int frameInFlightIndex, i32 minOrder, i32 maxOrder)
+{
+	bool pipelineBound = false;
+
+	for (const auto& layerHandle : gCanvasLayerOrder)
+	{
+		CanvasLayer& layer = gCanvasLayers[layerHandle.handle];
+
+		if (layer.order < minOrder || layer.order > maxOrder || !layer.visible || layer.instances.empty())
+			continue;
+
+		if (layer.batchesDirty)
+			BuildCanvasLayerBatches(layer);
+
+		if (!pipelineBound)
+		{
+			cl.SetPSO(gSpriteInstancingSupported ? gInstancedSpritePSO : testDedicatedSpritePSO);
+			BindScene2DConstants(cl, frame);
+			pipelineBound = true;
+		}
+
+		if (gSpriteInstancingSupported)
+		{
+			UploadCanvasLayerInstances(layer, frameInFlightIndex);
+			cl.SetParameterBlock(CANVAS_SPRITE_INSTANCES_SET_INDEX, layer.frames[frameInFlightIndex].resources.spriteInstanceParameterBlock);
+		}
+
+		for (const auto& batch : layer.batches)
+		{
+			cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, GetSpriteTextureParameterBlock(batch.texture));
+
+			if (gSpriteInstancingSupported)
+			{
+				cl.PushConstants(SpriteBatchConstants{ batch.firstSprite });
+				cl.Draw(4, batch.numSprites); // Sprite is a triangle strip
+				continue;
+			}
+
+			for (u32 i = batch.firstSprite; i < batch.firstSprite + batch.numSprites; ++i)
+			{
+				cl.PushConstants(layer.instances[i].transform);
+				cl.Draw(4); // Sprite is a triangle strip
+			}
+		}
+	}
+}
+
+// Fills and uploads the queued sprites and records their culling pass, the frame command list isn't in a pass yet.
+void PrepareQueuedSprites(mercury::ll::graphics::CommandList& cl, CanvasFrameResources& frame)
+{
+	gSpriteDrawPath = SpriteDrawPath::None;
+	gSpriteDrawCulled = false;
+
+	u32 numThreads = 1;
+	const u32 numSprites = GatherSpriteChunks(numThreads);
+
+	if (numSprites == 0)
+	{
+		ClearSpriteQueues();
+		return;
+	}
+
+	ForEachSpriteChunk(numThreads, ClassifySpriteChunk);
+	ResolveSpriteTargets();
+
+	gSpriteInstances.resize(numSprites);
+
+	if (gSpriteTextureTablesSupported && BuildSpriteTextureTableSlots())
+	{
+		ForEachSpriteChunk(numThreads, FillSpriteChunkInstances<true>);
+		ClearSpriteQueues();
+
+		UploadSpriteInstances(frame);
+		UpdateSpriteTextureTable(frame);
+
+		if (gSpriteGpuCullingEnabled)
+		{
+			gSpriteDrawRecords.assign(1, MakeSpriteDrawRecord(0));
+			CullSpritesOnGpu(cl, frame);
+			gSpriteDrawCulled = true;
+		}
+
+		gSpriteDrawPath = SpriteDrawPath::Bindless;
+		return;
+	}
+
+	BuildSpriteBatches();
+	ForEachSpriteChunk(numThreads, FillSpriteChunkInstances<false>);
+	ClearSpriteQueues();
+
+	if (gSpriteInstancingSupported)
+	{
+		UploadSpriteInstances(frame);
+
+		if (gSpriteGpuCullingEnabled)
+		{
+			gSpriteDrawRecords.clear();
+			for (const auto& batch : gSpriteBatches)
+				gSpriteDrawRecords.push_back(MakeSpriteDrawRecord(batch.firstSprite));
+
+			CullSpritesOnGpu(cl, frame);
+			gSpriteDrawCulled = true;
+		}
+
+		gSpriteDrawPath = SpriteDrawPath::Instanced;
+		return;
+	}
+
+	gSpriteDrawPath = SpriteDrawPath::Dedicated;
+}
+
+void DrawQueuedSprites(mercury::ll::graphics::CommandList& cl, CanvasFrameResources& frame)
+{
+	if (gSpriteDrawPath == SpriteDrawPath::None)
+		return;
+
+	if (gSpriteDrawPath == SpriteDrawPath::Bindless)
+	{
+		cl.SetPSO(gBindlessSpritePSO);
+		BindScene2DConstants(cl, frame);
+		cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, frame.spriteTextureTable);
+		cl.PushConstants(SpriteBatchConstants{ 0 });
+
+		if (gSpriteDrawCulled)
+		{
+			cl.SetParameterBlock(CANVAS_SPRITE_INSTANCES_SET_INDEX, frame.visibleSpriteParameterBlock);
+			cl.DrawIndirect(frame.spriteDrawRecordBuffer);
+			return;
+		}
+
+		cl.SetParameterBlock(CANVAS_SPRITE_INSTANCES_SET_INDEX, frame.spriteInstances.spriteInstanceParameterBlock);
+		cl.Draw(4, static_cast<u32>(gSpriteInstances.size())); // Sprite is a triangle strip
+		return;
+	}
+
+	if (gSpriteDrawPath == SpriteDrawPath::Instanced)
+	{
+		cl.SetPSO(gInstancedSpritePSO);
+		BindScene2DConstants(cl, frame);
+		cl.SetParameterBlock(CANVAS_SPRITE_INSTANCES_SET_INDEX, gSpriteDrawCulled ? frame.visibleSpriteParameterBlock : frame.spriteInstances.spriteInstanceParameterBlock);
+
+		for (size_t b = 0; b < gSpriteBatches.size(); ++b)
+		{
+			const SpriteBatch& batch = gSpriteBatches[b];
+
+			cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, GetSpriteTextureParameterBlock(batch.texture));
+			cl.PushConstants(SpriteBatchConstants{ batch.firstSprite });
+
+			if (gSpriteDrawCulled)
+				cl.DrawIndirect(frame.spriteDrawRecordBuffer, b * sizeof(SpriteDrawRecord));
+			else
+				cl.Draw(4, batch.numSprites); // Sprite is a triangle strip
+		}
+		return;
+	}
+
+	cl.SetPSO(testDedicatedSpritePSO);
+	BindScene2DConstants(cl, frame);
+
+	for (const auto& batch : gSpriteBatches)
+	{
+		cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, GetSpriteTextureParameterBlock(batch.texture));
+
+		for (u32 i = batch.firstSprite; i < batch.firstSprite + batch.numSprites; ++i)
+		{
+			cl.PushConstants(gSpriteInstances[i].transform);
+			cl.Draw(4); // Sprite is a triangle strip
+		}
+	}
+}
+
+// Text queued with canvas::DrawText, one draw per glyph page.
+void DrawQueuedText(mercury::ll::graphics::CommandList& cl, CanvasFrameResources& frame)
+{
+	// copied out under the text lock, DrawText from other threads meanwhile goes to the next frame
+	gTextInstances.clear();
+	gTextPageRanges.clear();
+	MercuryCanvasTextEndFrame([](std::span<const CanvasTextBatch> batches)
+		{
+			for (const auto& batch : batches)
+			{
+				gTextPageRanges.push_back({ batch.page, static_cast<u32>(batch.glyphs.size()) });
+				for (const auto& glyph : batch.glyphs)
+					gTextInstances.push_back({ glyph, 0, 0 });
+			}
+		});
+
+	if (!gTextInstances.empty())
+	{
+		cl.SetPSO(gTextPSO);
+		BindScene2DConstants(cl, frame);
+
+		if (gSpriteInstancingSupported)
+		{
+			const u32 numGlyphs = static_cast<u32>(gTextInstances.size());
+			ReserveSpriteInstanceBuffer(frame.textInstances, numGlyphs, CANVAS_MIN_TEXT_GLYPH_INSTANCES);
+			gDevice->UpdateBuffer(frame.textInstances.spriteInstanceBuffer, gTextInstances.data(), numGlyphs * sizeof(SpriteInstance));
+			cl.SetParameterBlock(CANVAS_SPRITE_INSTANCES_SET_INDEX, frame.textInstances.spriteInstanceParameterBlock);
+		}
+
+		u32 firstGlyph = 0;
+		for (const auto& range : gTextPageRanges)
+		{
+			cl.SetParameterBlock(CANVAS_SPRITE_TEXTURE_SET_INDEX, GetSpriteTextureParameterBlock(range.page));
+
+			if (gSpriteInstancingSupported)
+			{
+				cl.PushConstants(SpriteBatchConstants{ firstGlyph });
+				cl.Draw(4, range.numGlyphs); // Sprite is a triangle strip
+			}
+			else
+			{
+				for (u32 i = firstGlyph; i < firstGlyph + range.numGlyphs; ++i)
+				{
+					cl.PushConstants(gTextInstances[i].transform);
+					cl.Draw(4); // Sprite is a triangle strip
+				}
+			}
+
+			firstGlyph += range.numGlyphs;
+		}
+	}
+}
+
+void MercuryCanvasPrepare(mercury::ll::graphics::CommandList& cl, int frameInFlightIndex)
+{
+	const auto& timing = clock::GetFrameTiming();
+
+	Scene2DConstants scene2DConstants = {};
+	scene2DConstants.canvasSize = glm::vec4((float)gSwapchain->GetWidth(), (float)gSwapchain->GetHeight(), 2.0f / (float)gSwapchain->GetWidth(), (ll::graphics::IsYFlipped() ? -2.0f : 2.0f) / (float)gSwapchain->GetHeight());
+	scene2DConstants.time = (float)timing.time;
+	scene2DConstants.deltaTime = timing.deltaTime;
+	scene2DConstants.prerptationMatrix = glm::mat2x2(1.0f); // Identity matrix for now
+
+	CanvasFrameResources& frame = gCanvasFrameResources[frameInFlightIndex];
+
+	MercuryCanvasAtlasBeginFrame();
+	SwapSpriteQueues();
+
+	for (auto& resources : frame.retiredLayerResources)
+		DestroySpriteInstanceBuffer(resources);
+	frame.retiredLayerResources.clear();
+
+	UploadScene2DConstants(frame, scene2DConstants);
+
+	PrepareQueuedSprites(cl, frame);
+}
+
+void MercuryCanvasTick(mercury::ll::graphics::CommandList& cl, int frameInFlightIndex)
+{
+	CanvasFrameResources& frame = gCanvasFrameResources[frameInFlightIndex];
+
+	DrawCanvasLayers(cl, frame, frameInFlightIndex, INT32_MIN, -1);
+	DrawQueuedSprites(cl, frame);
+	DrawQueuedText(cl, frame);
+	DrawCanvasLayers(cl, frame, frameInFlightIndex, 0, INT32_MAX);
+}
+
+canvas::LayerHandle canvas::CreateLayer(i32 order)
+{
+	CanvasLayer layer;
+	layer.order = order;
+	layer.frames.resize(gCanvasFrameResources.size()); // empty before MercuryCanvasInitialize, sized on first upload then
+
+	canvas::LayerHandle result;
+	result.handle = gCanvasLayers.Emplace(std::move(layer));
+
+	auto insertAt = std::upper_bound(gCanvasLayerOrder.begin(), gCanvasLayerOrder.end(), order,
+		[](i32 value, const canvas::LayerHandle& other) { return value < gCanvasLayers[other.handle].order; });
+	gCanvasLayerOrder.insert(insertAt, result);
+
+	return result;
+}
+
+void canvas::DestroyLayer(LayerHandle layer)
+{
+	CanvasLayer* canvasLayer = gCanvasLayers.Get(layer.handle);
+	if (canvasLayer == nullptr)
+	{
+		MLOG_WARNING(u8"canvas::DestroyLayer - invalid layer handle");
+		return;
+	}
+
+	// earlier frames in flight may still read the buffers
+	for (size_t i = 0; i < canvasLayer->frames.size(); ++i)
+		gCanvasFrameResources[i].retiredLayerResources.push_back(canvasLayer->frames[i].resources);
+
+	gCanvasLayers.Remove(layer.handle);
+	std::erase(gCanvasLayerOrder, layer);
+}
+
+void canvas::SetLayerVisible(LayerHandle layer, bool visible)
+{
+	CanvasLayer* canvasLayer = gCanvasLayers.Get(layer.handle);
+	MERCURY_ASSERT(canvasLayer != nullptr);
+
+	canvasLayer->visible = visible;
+}
+
+void canvas::ClearLayer(LayerHandle layer)
+{
+	CanvasLayer* canvasLayer = gCanvasLayers.Get(layer.handle);
+	MERCURY_ASSERT(canvasLayer != nullptr);
+
+	canvasLayer->instances.clear();
+	canvasLayer->textures.clear();
+	canvasLayer->batches.clear();
+	canvasLayer->batchesDirty = false;
+
+	for (auto& frame : canvasLayer->frames)
+		frame.dirtyBegin = frame.dirtyEnd = 0;
+}
+
+u32 canvas::AddLayerSprite(LayerHandle layer, ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color)
+{
+	CanvasLayer* canvasLayer = gCanvasLayers.Get(layer.handle);
+	MERCURY_ASSERT(canvasLayer != nullptr);
+
+	const u32 spriteIndex = static_cast<u32>(canvasLayer->instances.size());
+
+	canvasLayer->instances.push_back({ { position, size, uv0, uv1, angle, color }, 0, 0 });
+	canvasLayer->textures.push_back(texture.isValid() ? texture : gWhiteTextureHandle);
+	canvasLayer->batchesDirty = true;
+	canvasLayer->MarkDirty(spriteIndex, spriteIndex + 1);
+
+	return spriteIndex;
+}
+
+void canvas::UpdateLayerSprite(LayerHandle layer, u32 spriteIndex, ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color)
+{
+	CanvasLayer* canvasLayer = gCanvasLayers.Get(layer.handle);
+	MERCURY_ASSERT(canvasLayer != nullptr);
+	MERCURY_ASSERT(spriteIndex < canvasLayer->instances.size());
+
+	if (!texture.isValid())
+		texture = gWhiteTextureHandle;
+
+	if (!(canvasLayer->textures[spriteIndex] == texture))
+	{
+		canvasLayer->textures[spriteIndex] = texture;
+		canvasLayer->batchesDirty = true;
+	}
+
+	canvasLayer->instances[spriteIndex].transform = { position, size, uv0, uv1, angle, color };
+	canvasLayer->MarkDirty(spriteIndex, spriteIndex + 1);
+}
+
+bool canvas::SetGpuCulling(bool enabled)
+{
+	gSpriteGpuCullingEnabled = enabled && gSpriteGpuCullingSupported;
+	return gSpriteGpuCullingSupported;
+}
+
+void canvas::DrawSprite(glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color)
+{
+	DrawSprite(gWhiteTextureHandle, position, size, uv0, uv1, angle, color);
+}
+
+void canvas::DrawSprite(ll::graphics::TextureHandle texture, glm::vec2 position, glm::vec2 size, glm::vec2 uv0, glm::vec2 uv1, float angle, PackedColor color)
+{
+	CanvasSpriteQueue& queue = GetThreadSpriteQueue();
+
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	queue.pending.push_back({ { position, size, uv0, uv1, angle, color }, texture });
 }
\ No newline at end of file
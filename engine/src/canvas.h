@@ -1,11 +1,42 @@
 #pragma once
 #include <mercury_canvas.h>
 #include <ll/graphics.h>
+#include <functional>
 
 void MercuryCanvasInitialize(int numFramesInFlight);
 void MercuryCanvasShutdown();
+// uploads the frame's sprites and records their compute work, before Swapchain::BeginFinalPass
+void MercuryCanvasPrepare(mercury::ll::graphics::CommandList& cl, int frameInFlightIndex);
+// draws into the final pass
 void MercuryCanvasTick(mercury::ll::graphics::CommandList& cl, int frameInFlightIndex);
 
+// matches DedicatedSpriteParameters in mercury_base.slang, size holds the half extents
+struct SpriteTransform
+{
+    glm::vec2 position;
+    glm::vec2 size;
+    glm::vec2 uv0;
+    glm::vec2 uv1;
+
+    float angle;
+    mercury::PackedColor color;
+};
+
+void MercuryCanvasAtlasInitialize(int numFramesInFlight);
+void MercuryCanvasAtlasShutdown();
+void MercuryCanvasAtlasBeginFrame();
+
+struct CanvasAtlasRegion
+{
+    mercury::ll::graphics::TextureHandle page;
+    glm::vec2 uvOffset;
+    glm::vec2 uvScale;
+};
+
+/// @brief Finds the atlas region of texture, packing the image first if needed. Tick thread only.
+/// @returns false when texture is not registered in the atlas or can't be made resident
+bool MercuryCanvasAtlasFind(mercury::ll::graphics::TextureHandle texture, CanvasAtlasRegion& outRegion);
+
 struct Scene2DConstants
 {
     glm::mat2x2 prerptationMatrix;
@@ -14,4 +45,23 @@ struct Scene2DConstants
     float time;
     float deltaTime;
     float padding[2];
-};
\ No newline at end of file
+};
+
+/// @brief Glyph pages hold signed distance fields when distanceFieldGlyphs is set, antialiased coverage otherwise.
+void MercuryCanvasTextInitialize(int numFramesInFlight, bool distanceFieldGlyphs);
+void MercuryCanvasTextShutdown();
+
+struct CanvasTextBatch
+{
+    mercury::ll::graphics::TextureHandle page;
+    std::vector<SpriteTransform> glyphs;
+};
+
+/// @brief Hands the glyph quads queued with canvas::DrawText this frame to consume, one batch per glyph page, then drops them,
+/// trims the text layout cache and destroys pages of unloaded fonts no frame in flight reads. Tick thread only.
+/// Runs under the text lock, so consume must copy what it needs; text queued meanwhile lands in the next frame.
+void MercuryCanvasTextEndFrame(const std::function<void(std::span<const CanvasTextBatch>)>& consume);
+
+/// @brief Destroys the sprite descriptor set cached for the texture and drops it from the bindless tables.
+/// Call it before destroying the texture, a new texture reusing the handle would otherwise sample the stale view. Tick thread only.
+void MercuryCanvasForgetSpriteTexture(mercury::ll::graphics::TextureHandle texture);
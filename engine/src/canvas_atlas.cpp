@@ -0,0 +1,348 @@
+#include "canvas.h"
+#include <mercury_log.h>
+#include <ll/graphics.h>
+#include <algorithm>
+#include <unordered_map>
+
+using namespace mercury;
+using namespace ll::graphics;
+
+constexpr u32 CANVAS_ATLAS_PAGE_SIZE = 2048;
+constexpr u32 CANVAS_ATLAS_MAX_PAGES = 4;
+constexpr u32 CANVAS_ATLAS_MAX_IMAGE_SIZE = 256;
+constexpr u32 CANVAS_ATLAS_PADDING = 1; // edge texels are repeated into the padding so linear filtering doesn't bleed
+
+void canvas::AtlasPacker::Reset(u32 width, u32 height)
+{
+	atlasWidth = width;
+	atlasHeight = height;
+	usedArea = 0;
+
+	skyline.clear();
+	skyline.push_back({ 0, 0, width });
+}
+
+bool canvas::AtlasPacker::Fits(size_t nodeIndex, u32 width, u32 height, u32& outY) const
+{
+	u32 x = skyline[nodeIndex].x;
+	if (x + width > atlasWidth)
+		return false;
+
+	u32 y = 0;
+	i64 widthLeft = width;
+
+	for (size_t i = nodeIndex; widthLeft > 0; ++i)
+	{
+		y = std::max(y, skyline[i].y);
+		if (y + height > atlasHeight)
+			return false;
+
+		widthLeft -= skyline[i].width;
+	}
+
+	outY = y;
+	return true;
+}
+
+bool canvas::AtlasPacker::Pack(u32 width, u32 height, u32& outX, u32& outY)
+{
+	if (width == 0 || height == 0)
+		return false;
+
+	size_t bestIndex = skyline.size();
+	u32 bestTop = UINT32_MAX;
+	u32 bestWidth = UINT32_MAX;
+
+	for (size_t i = 0; i < skyline.size(); ++i)
+	{
+		u32 y = 0;
+		if (!Fits(i, width, height, y))
+			continue;
+
+		if (y + height < bestTop || (y + height == bestTop && skyline[i].width < bestWidth))
+		{
+			bestIndex = i;
+			bestTop = y + height;
+			bestWidth = skyline[i].width;
+			outX = skyline[i].x;
+			outY = y;
+		}
+	}
+
+	if (bestIndex == skyline.size())
+		return false;
+
+	skyline.insert(skyline.begin() + bestIndex, { outX, outY + height, width });
+
+	// trim the segments now covered by the new one
+	for (size_t i = bestIndex + 1; i < skyline.size(); )
+	{
+		const SkylineNode& prev = skyline[i - 1];
+		SkylineNode& node = skyline[i];
+
+		if (node.x >= prev.x + prev.width)
+			break;
+
+		u32 shrink = prev.x + prev.width - node.x;
+		if (node.width > shrink)
+		{
+			node.x += shrink;
+			node.width -= shrink;
+			break;
+		}
+
+		skyline.erase(skyline.begin() + i);
+	}
+
+	// merge neighbours of equal height
+	for (size_t i = 0; i + 1 < skyline.size(); )
+	{
+		if (skyline[i].y == skyline[i + 1].y)
+		{
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	usedArea += static_cast<u64>(width) * height;
+	return true;
+}
+
+float canvas::AtlasPacker::GetOccupancy() const
+{
+	u64 totalArea = static_cast<u64>(atlasWidth) * atlasHeight;
+	return totalArea > 0 ? static_cast<float>(static_cast<double>(usedArea) / static_cast<double>(totalArea)) : 0.0f;
+}
+
+struct CanvasAtlasPage
+{
+	TextureHandle texture;
+	canvas::AtlasPacker packer;
+	u64 lastUsedFrame = 0;
+	std::vector<u32> images; // source texture handles resident in this page
+};
+
+struct CanvasAtlasImage
+{
+	u32 width = 0;
+	u32 height = 0;
+	std::vector<u8> paddedPixels; // (width + 2 * padding) x (height + 2 * padding), uploaded as is
+
+	static constexpr u32 NotResident = UINT32_MAX;
+	u32 page = NotResident;
+	glm::vec2 uvOffset = glm::vec2(0.0f);
+	glm::vec2 uvScale = glm::vec2(1.0f);
+};
+
+std::unordered_map<u32, CanvasAtlasImage> gAtlasImages;
+std::vector<CanvasAtlasPage> gAtlasPages;
+
+u64 gAtlasFrame = 0;
+u32 gAtlasFramesInFlight = 1;
+canvas::Atlas::Stats gAtlasStats = {};
+
+bool canvas::Atlas::AddImage(TextureHandle texture, u32 width, u32 height, const void* rgba8Pixels)
+{
+	IF_UNLIKELY (!texture.isValid() || rgba8Pixels == nullptr || width == 0 || height == 0)
+		return false;
+
+	if (width > CANVAS_ATLAS_MAX_IMAGE_SIZE || height > CANVAS_ATLAS_MAX_IMAGE_SIZE)
+		return false;
+
+	RemoveImage(texture);
+
+	CanvasAtlasImage& image = gAtlasImages[texture.handle];
+	image.width = width;
+	image.height = height;
+
+	const u32 paddedWidth = width + 2 * CANVAS_ATLAS_PADDING;
+	const u32 paddedHeight = height + 2 * CANVAS_ATLAS_PADDING;
+	image.paddedPixels.resize(static_cast<size_t>(paddedWidth) * paddedHeight * 4);
+
+	const u32* src = static_cast<const u32*>(rgba8Pixels);
+	u32* dst = reinterpret_cast<u32*>(image.paddedPixels.data());
+
+	for (u32 y = 0; y < paddedHeight; ++y)
+	{
+		u32 srcY = std::clamp<i32>(static_cast<i32>(y) - static_cast<i32>(CANVAS_ATLAS_PADDING), 0, static_cast<i32>(height) - 1);
+		for (u32 x = 0; x < paddedWidth; ++x)
+		{
+			u32 srcX = std::clamp<i32>(static_cast<i32>(x) - static_cast<i32>(CANVAS_ATLAS_PADDING), 0, static_cast<i32>(width) - 1);
+			dst[y * paddedWidth + x] = src[srcY * width + srcX];
+		}
+	}
+
+	return true;
+}
+
+void canvas::Atlas::RemoveImage(TextureHandle texture)
+{
+	auto it = gAtlasImages.find(texture.handle);
+	if (it == gAtlasImages.end())
+		return;
+
+	if (it->second.page != CanvasAtlasImage::NotResident)
+	{
+		auto& pageImages = gAtlasPages[it->second.page].images;
+		pageImages.erase(std::find(pageImages.begin(), pageImages.end(), texture.handle));
+	}
+
+	gAtlasImages.erase(it);
+}
+
+canvas::Atlas::Stats canvas::Atlas::GetStats()
+{
+	Stats stats = gAtlasStats;
+	stats.numPages = static_cast<u32>(gAtlasPages.size());
+	stats.numImages = static_cast<u32>(gAtlasImages.size());
+	stats.numResidentImages = 0;
+
+	for (const auto& page : gAtlasPages)
+		stats.numResidentImages += static_cast<u32>(page.images.size());
+
+	return stats;
+}
+
+static bool CreateAtlasPage()
+{
+	// pages start cleared so the backends can keep them in their sampled state between subregion updates
+	std::vector<u8> clearPixels(static_cast<size_t>(CANVAS_ATLAS_PAGE_SIZE) * CANVAS_ATLAS_PAGE_SIZE * 4, 0);
+
+	TextureDescriptor desc = {};
+	desc.width = CANVAS_ATLAS_PAGE_SIZE;
+	desc.height = CANVAS_ATLAS_PAGE_SIZE;
+	desc.initialData = clearPixels.data();
+
+	TextureHandle texture = gDevice->CreateTexture(desc);
+	IF_UNLIKELY (!texture.isValid())
+	{
+		MLOG_ERROR(u8"Canvas atlas: failed to create page %u", static_cast<u32>(gAtlasPages.size()));
+		return false;
+	}
+
+	CanvasAtlasPage& page = gAtlasPages.emplace_back();
+	page.texture = texture;
+	page.packer.Reset(CANVAS_ATLAS_PAGE_SIZE, CANVAS_ATLAS_PAGE_SIZE);
+	return true;
+}
+
+// Evicts the least recently used page that no frame in flight samples anymore.
+static bool EvictAtlasPage(u32& outPage)
+{
+	u32 lruPage = CanvasAtlasImage::NotResident;
+
+	for (u32 i = 0; i < static_cast<u32>(gAtlasPages.size()); ++i)
+	{
+		if (gAtlasPages[i].lastUsedFrame + gAtlasFramesInFlight > gAtlasFrame)
+			continue;
+
+		if (lruPage == CanvasAtlasImage::NotResident || gAtlasPages[i].lastUsedFrame < gAtlasPages[lruPage].lastUsedFrame)
+			lruPage = i;
+	}
+
+	if (lruPage == CanvasAtlasImage::NotResident)
+		return false;
+
+	CanvasAtlasPage& page = gAtlasPages[lruPage];
+	for (u32 imageHandle : page.images)
+		gAtlasImages[imageHandle].page = CanvasAtlasImage::NotResident;
+
+	MLOG_DEBUG(u8"Canvas atlas: evicting page %u (%u images, %.1f%% used)", lruPage, static_cast<u32>(page.images.size()), page.packer.GetOccupancy() * 100.0f);
+
+	page.images.clear();
+	page.packer.Reset(CANVAS_ATLAS_PAGE_SIZE, CANVAS_ATLAS_PAGE_SIZE);
+	gAtlasStats.numEvictions++;
+
+	outPage = lruPage;
+	return true;
+}
+
+static bool MakeAtlasImageResident(u32 imageHandle, CanvasAtlasImage& image)
+{
+	const u32 paddedWidth = image.width + 2 * CANVAS_ATLAS_PADDING;
+	const u32 paddedHeight = image.height + 2 * CANVAS_ATLAS_PADDING;
+
+	u32 x = 0, y = 0;
+	u32 pageIndex = CanvasAtlasImage::NotResident;
+
+	for (u32 i = 0; i < static_cast<u32>(gAtlasPages.size()); ++i)
+	{
+		if (gAtlasPages[i].packer.Pack(paddedWidth, paddedHeight, x, y))
+		{
+			pageIndex = i;
+			break;
+		}
+	}
+
+	if (pageIndex == CanvasAtlasImage::NotResident && gAtlasPages.size() < CANVAS_ATLAS_MAX_PAGES && CreateAtlasPage())
+	{
+		pageIndex = static_cast<u32>(gAtlasPages.size() - 1);
+		if (!gAtlasPages[pageIndex].packer.Pack(paddedWidth, paddedHeight, x, y))
+			pageIndex = CanvasAtlasImage::NotResident;
+	}
+
+	if (pageIndex == CanvasAtlasImage::NotResident)
+	{
+		u32 evictedPage = 0;
+		if (!EvictAtlasPage(evictedPage) || !gAtlasPages[evictedPage].packer.Pack(paddedWidth, paddedHeight, x, y))
+			return false;
+
+		pageIndex = evictedPage;
+	}
+
+	CanvasAtlasPage& page = gAtlasPages[pageIndex];
+	gDevice->UpdateSubregionTexture(page.texture, x, y, 0, paddedWidth, paddedHeight, 1, image.paddedPixels.data(), image.paddedPixels.size());
+	gAtlasStats.numUploads++;
+
+	page.images.push_back(imageHandle);
+
+	const float invPageSize = 1.0f / static_cast<float>(CANVAS_ATLAS_PAGE_SIZE);
+	image.page = pageIndex;
+	image.uvOffset = glm::vec2(static_cast<float>(x + CANVAS_ATLAS_PADDING), static_cast<float>(y + CANVAS_ATLAS_PADDING)) * invPageSize;
+	image.uvScale = glm::vec2(static_cast<float>(image.width), static_cast<float>(image.height)) * invPageSize;
+	return true;
+}
+
+bool MercuryCanvasAtlasFind(TextureHandle texture, CanvasAtlasRegion& outRegion)
+{
+	auto it = gAtlasImages.find(texture.handle);
+	if (it == gAtlasImages.end())
+		return false;
+
+	CanvasAtlasImage& image = it->second;
+	if (image.page == CanvasAtlasImage::NotResident && !MakeAtlasImageResident(it->first, image))
+		return false;
+
+	CanvasAtlasPage& page = gAtlasPages[image.page];
+	page.lastUsedFrame = gAtlasFrame;
+
+	outRegion.page = page.texture;
+	outRegion.uvOffset = image.uvOffset;
+	outRegion.uvScale = image.uvScale;
+	return true;
+}
+
+void MercuryCanvasAtlasInitialize(int numFramesInFlight)
+{
+	gAtlasFramesInFlight = static_cast<u32>(std::max(numFramesInFlight, 1));
+	gAtlasFrame = gAtlasFramesInFlight; // fresh pages are evictable right away
+	gAtlasStats = {};
+}
+
+void MercuryCanvasAtlasBeginFrame()
+{
+	gAtlasFrame++;
+}
+
+void MercuryCanvasAtlasShutdown()
+{
+	for (auto& page : gAtlasPages)
+		gDevice->DestroyTexture(page.texture);
+
+	gAtlasPages.clear();
+	gAtlasImages.clear();
+}
@@ -0,0 +1,490 @@
+#include "canvas.h"
+#include <mercury_log.h>
+#include <ll/graphics.h>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// own copy of the ImGui truetype rasterizer, static so it can't clash with imgui_draw.cpp
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <imstb_truetype.h>
+
+using namespace mercury;
+using namespace ll::graphics;
+
+constexpr u32 CANVAS_FONT_PAGE_SIZE = 1024;
+constexpr float CANVAS_FONT_RASTER_HEIGHT = 48.0f; // glyphs are rendered once at this pixel height and scaled from there
+constexpr int CANVAS_FONT_SDF_PADDING = 6; // texels of distance around every glyph
+constexpr u8 CANVAS_FONT_SDF_ON_EDGE = 128;
+constexpr u32 CANVAS_FONT_GLYPH_SPACING = 1; // empty texels between glyphs so linear filtering doesn't bleed
+constexpr char32_t CANVAS_FONT_FALLBACK_CODEPOINT = U'?';
+constexpr size_t CANVAS_TEXT_MAX_CACHED_RUNS = 4096; // per font, runs not drawn last frame are dropped above this
+
+struct CanvasFontGlyph
+{
+	glm::vec2 offset = glm::vec2(0.0f); // top left corner relative to the pen on the baseline, in font sizes
+	glm::vec2 size = glm::vec2(0.0f);
+	glm::vec2 uv0 = glm::vec2(0.0f); // top left texel corner in the page
+	glm::vec2 uv1 = glm::vec2(0.0f);
+	float advance = 0.0f;
+	int glyphIndex = 0;
+	u32 page = 0;
+	bool visible = false; // whitespace only advances the pen
+};
+
+// glyph quad of a laid out string, relative to the top left corner of its first line, in font sizes
+struct CanvasTextGlyphQuad
+{
+	glm::vec2 center;
+	glm::vec2 halfSize;
+	glm::vec2 uv0;
+	glm::vec2 uv1;
+	u32 page;
+};
+
+struct CanvasTextRun
+{
+	std::vector<CanvasTextGlyphQuad> quads;
+	glm::vec2 extent = glm::vec2(0.0f);
+	u64 lastUsedFrame = 0;
+};
+
+struct CanvasFontPage
+{
+	TextureHandle texture;
+	canvas::AtlasPacker packer;
+	u32 batch = 0; // gTextBatches index while batchFrame is the current frame
+	u64 batchFrame = UINT64_MAX;
+};
+
+struct CanvasTextRunHash
+{
+	using is_transparent = void;
+	size_t operator()(std::u8string_view text) const { return std::hash<std::u8string_view>{}(text); }
+};
+
+struct CanvasFont
+{
+	std::vector<u8> ttfData; // info points into it
+	stbtt_fontinfo info = {};
+	float rasterScale = 0.0f; // font units to raster pixels
+	float ascent = 0.0f; // in font sizes
+	float lineHeight = 0.0f;
+
+	std::unordered_map<char32_t, CanvasFontGlyph> glyphs;
+	std::unordered_set<char32_t> missingCodepoints; // already warned about
+	std::vector<CanvasFontPage> pages;
+	std::unordered_map<std::u8string, CanvasTextRun, CanvasTextRunHash, std::equal_to<>> runs;
+};
+
+struct CanvasRetiredFontPage
+{
+	TextureHandle texture;
+	u64 retiredFrame = 0;
+};
+
+std::mutex gTextMutex;
+SlotMap<CanvasFont> gCanvasFonts;
+std::vector<CanvasRetiredFontPage> gRetiredFontPages;
+
+std::vector<CanvasTextBatch> gTextBatches; // only grows, so the glyph vectors keep their capacity
+u32 gNumTextBatches = 0;
+
+u64 gTextFrame = 0;
+u32 gTextFramesInFlight = 1;
+bool gDistanceFieldGlyphs = false;
+
+// Decodes the code point starting at text[i] and moves i past it, malformed bytes decode as U+FFFD one by one.
+static char32_t DecodeUtf8(std::u8string_view text, size_t& i)
+{
+	const u8 lead = static_cast<u8>(text[i++]);
+	if (lead < 0x80)
+		return lead;
+
+	const int length = (lead & 0xE0) == 0xC0 ? 2 : (lead & 0xF0) == 0xE0 ? 3 : (lead & 0xF8) == 0xF0 ? 4 : 0;
+	if (length == 0 || i + length - 1 > text.size())
+		return U'\uFFFD';
+
+	char32_t codepoint = lead & (0x7F >> length);
+	for (int k = 1; k < length; ++k)
+	{
+		const u8 next = static_cast<u8>(text[i]);
+		if ((next & 0xC0) != 0x80)
+			return U'\uFFFD';
+
+		codepoint = (codepoint << 6) | (next & 0x3F);
+		++i;
+	}
+
+	return codepoint;
+}
+
+// Alpha the fallback sprite shader blends with, the distance field resolved at the raster size.
+static u8 CoverageFromDistance(u8 distance)
+{
+	const float pixelDistance = (static_cast<float>(distance) - CANVAS_FONT_SDF_ON_EDGE) * CANVAS_FONT_SDF_PADDING / CANVAS_FONT_SDF_ON_EDGE;
+	return static_cast<u8>(std::clamp(pixelDistance + 0.5f, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static bool CreateFontPage(CanvasFont& font)
+{
+	// pages start cleared so the backends can keep them in their sampled state between subregion updates
+	std::vector<u8> clearPixels(static_cast<size_t>(CANVAS_FONT_PAGE_SIZE) * CANVAS_FONT_PAGE_SIZE * 4, 0);
+
+	TextureDescriptor desc = {};
+	desc.width = CANVAS_FONT_PAGE_SIZE;
+	desc.height = CANVAS_FONT_PAGE_SIZE;
+	desc.initialData = clearPixels.data();
+
+	TextureHandle texture = gDevice->CreateTexture(desc);
+	IF_UNLIKELY (!texture.isValid())
+	{
+		MLOG_ERROR(u8"Canvas text: failed to create glyph page %u", static_cast<u32>(font.pages.size()));
+		return false;
+	}
+
+	CanvasFontPage& page = font.pages.emplace_back();
+	page.texture = texture;
+	page.packer.Reset(CANVAS_FONT_PAGE_SIZE, CANVAS_FONT_PAGE_SIZE);
+	return true;
+}
+
+static bool PackFontGlyph(CanvasFont& font, u32 width, u32 height, u32& outX, u32& outY, u32& outPage)
+{
+	for (u32 i = 0; i < static_cast<u32>(font.pages.size()); ++i)
+	{
+		if (font.pages[i].packer.Pack(width, height, outX, outY))
+		{
+			outPage = i;
+			return true;
+		}
+	}
+
+	if (!CreateFontPage(font))
+		return false;
+
+	outPage = static_cast<u32>(font.pages.size() - 1);
+	return font.pages[outPage].packer.Pack(width, height, outX, outY);
+}
+
+// Renders the glyph of codepoint into the font pages.
+// Returns false when the font has no glyph for it or the glyph can't be stored.
+static bool RasterizeGlyph(CanvasFont& font, char32_t codepoint)
+{
+	CanvasFontGlyph glyph;
+	glyph.glyphIndex = stbtt_FindGlyphIndex(&font.info, static_cast<int>(codepoint));
+	if (glyph.glyphIndex == 0)
+		return false;
+
+	int advanceWidth = 0, leftSideBearing = 0;
+	stbtt_GetGlyphHMetrics(&font.info, glyph.glyphIndex, &advanceWidth, &leftSideBearing);
+	glyph.advance = advanceWidth * font.rasterScale / CANVAS_FONT_RASTER_HEIGHT;
+
+	int width = 0, height = 0, xoff = 0, yoff = 0;
+	u8* distance = stbtt_GetGlyphSDF(&font.info, font.rasterScale, glyph.glyphIndex, CANVAS_FONT_SDF_PADDING, CANVAS_FONT_SDF_ON_EDGE,
+		static_cast<float>(CANVAS_FONT_SDF_ON_EDGE) / CANVAS_FONT_SDF_PADDING, &width, &height, &xoff, &yoff);
+
+	if (distance != nullptr)
+	{
+		u32 x = 0, y = 0;
+		if (!PackFontGlyph(font, width + CANVAS_FONT_GLYPH_SPACING, height + CANVAS_FONT_GLYPH_SPACING, x, y, glyph.page))
+		{
+			stbtt_FreeSDF(distance, nullptr);
+			return false;
+		}
+
+		// white texels, the distance or coverage goes to alpha so both sprite shaders can sample the page
+		std::vector<u32> pixels(static_cast<size_t>(width) * height);
+		for (size_t i = 0; i < pixels.size(); ++i)
+		{
+			const u8 alpha = gDistanceFieldGlyphs ? distance[i] : CoverageFromDistance(distance[i]);
+			pixels[i] = 0x00FFFFFFu | (static_cast<u32>(alpha) << 24);
+		}
+		stbtt_FreeSDF(distance, nullptr);
+
+		gDevice->UpdateSubregionTexture(font.pages[glyph.page].texture, x, y, 0, width, height, 1, pixels.data(), pixels.size() * sizeof(u32));
+
+		const float invRasterHeight = 1.0f / CANVAS_FONT_RASTER_HEIGHT;
+		const float invPageSize = 1.0f / static_cast<float>(CANVAS_FONT_PAGE_SIZE);
+
+		glyph.visible = true;
+		glyph.offset = glm::vec2(static_cast<float>(xoff), static_cast<float>(yoff)) * invRasterHeight;
+		glyph.size = glm::vec2(static_cast<float>(width), static_cast<float>(height)) * invRasterHeight;
+		glyph.uv0 = glm::vec2(static_cast<float>(x), static_cast<float>(y)) * invPageSize;
+		glyph.uv1 = glm::vec2(static_cast<float>(x + width), static_cast<float>(y + height)) * invPageSize;
+	}
+
+	font.glyphs.emplace(codepoint, glyph);
+	return true;
+}
+
+// Renders the glyphs of text the font doesn't have yet. Returns the number of glyphs added.
+static u32 RasterizeMissingGlyphs(CanvasFont& font, std::u8string_view text)
+{
+	u32 numAdded = 0;
+
+	for (size_t i = 0; i < text.size(); )
+	{
+		const char32_t codepoint = DecodeUtf8(text, i);
+		if (codepoint == U'\n' || font.glyphs.contains(codepoint))
+			continue;
+
+		if (RasterizeGlyph(font, codepoint))
+		{
+			font.missingCodepoints.erase(codepoint);
+			numAdded++;
+		}
+	}
+
+	return numAdded;
+}
+
+// Glyph drawn for codepoint, the fallback glyph when it was never rasterized. Never rasterizes.
+static const CanvasFontGlyph* FindGlyph(CanvasFont& font, char32_t codepoint)
+{
+	auto it = font.glyphs.find(codepoint);
+	if (it != font.glyphs.end())
+		return &it->second;
+
+	if (font.missingCodepoints.insert(codepoint).second)
+		MLOG_WARNING(u8"canvas::DrawText - no glyph for U+%04X, add it with canvas::PreloadGlyphs", static_cast<u32>(codepoint));
+
+	it = font.glyphs.find(CANVAS_FONT_FALLBACK_CODEPOINT);
+	return it != font.glyphs.end() ? &it->second : nullptr;
+}
+
+// Lays text out once, later draws of the same string reuse the cached quads.
+static const CanvasTextRun& GetTextRun(CanvasFont& font, std::u8string_view text)
+{
+	auto it = font.runs.find(text);
+	if (it != font.runs.end())
+	{
+		it->second.lastUsedFrame = gTextFrame;
+		return it->second;
+	}
+
+	CanvasTextRun run;
+	run.lastUsedFrame = gTextFrame;
+
+	const float kernScale = font.rasterScale / CANVAS_FONT_RASTER_HEIGHT;
+	glm::vec2 pen = glm::vec2(0.0f, font.ascent);
+	int prevGlyphIndex = 0;
+
+	for (size_t i = 0; i < text.size(); )
+	{
+		const char32_t codepoint = DecodeUtf8(text, i);
+
+		if (codepoint == U'\n')
+		{
+			run.extent.x = std::max(run.extent.x, pen.x);
+			pen = glm::vec2(0.0f, pen.y + font.lineHeight);
+			prevGlyphIndex = 0;
+			continue;
+		}
+
+		const CanvasFontGlyph* glyph = FindGlyph(font, codepoint);
+		if (glyph == nullptr)
+			continue;
+
+		if (prevGlyphIndex != 0)
+			pen.x += stbtt_GetGlyphKernAdvance(&font.info, prevGlyphIndex, glyph->glyphIndex) * kernScale;
+
+		if (glyph->visible)
+		{
+			// sprites map uv0 to the corner with the larger y, so the glyph rows are flipped
+			CanvasTextGlyphQuad& quad = run.quads.emplace_back();
+			quad.halfSize = glyph->size * 0.5f;
+			quad.center = pen + glyph->offset + quad.halfSize;
+			quad.uv0 = glm::vec2(glyph->uv0.x, glyph->uv1.y);
+			quad.uv1 = glm::vec2(glyph->uv1.x, glyph->uv0.y);
+			quad.page = glyph->page;
+		}
+
+		pen.x += glyph->advance;
+		prevGlyphIndex = glyph->glyphIndex;
+	}
+
+	run.extent.x = std::max(run.extent.x, pen.x);
+	run.extent.y = pen.y - font.ascent + font.lineHeight;
+
+	return font.runs.emplace(std::u8string(text), std::move(run)).first->second;
+}
+
+static u32 AcquireTextBatch(TextureHandle page)
+{
+	if (gNumTextBatches == gTextBatches.size())
+		gTextBatches.emplace_back();
+
+	gTextBatches[gNumTextBatches].page = page;
+	return gNumTextBatches++;
+}
+
+static void RetireFontPages(CanvasFont& font)
+{
+	// earlier frames in flight may still sample the pages
+	for (const auto& page : font.pages)
+		gRetiredFontPages.push_back({ page.texture, gTextFrame });
+
+	font.pages.clear();
+}
+
+canvas::FontHandle canvas::LoadFont(const void* ttfData, size_t ttfSize, std::u8string_view extraCharacters)
+{
+	FontHandle result;
+
+	CanvasFont font;
+	font.ttfData.assign(static_cast<const u8*>(ttfData), static_cast<const u8*>(ttfData) + ttfSize);
+
+	const int fontOffset = stbtt_GetFontOffsetForIndex(font.ttfData.data(), 0);
+	if (fontOffset < 0 || !stbtt_InitFont(&font.info, font.ttfData.data(), fontOffset))
+	{
+		MLOG_ERROR(u8"canvas::LoadFont - not a TrueType font (%u bytes)", static_cast<u32>(ttfSize));
+		return result;
+	}
+
+	int ascent = 0, descent = 0, lineGap = 0;
+	stbtt_GetFontVMetrics(&font.info, &ascent, &descent, &lineGap);
+
+	font.rasterScale = stbtt_ScaleForPixelHeight(&font.info, CANVAS_FONT_RASTER_HEIGHT);
+	font.ascent = ascent * font.rasterScale / CANVAS_FONT_RASTER_HEIGHT;
+	font.lineHeight = (ascent - descent + lineGap) * font.rasterScale / CANVAS_FONT_RASTER_HEIGHT;
+
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	result.handle = gCanvasFonts.Emplace(std::move(font));
+	CanvasFont& canvasFont = gCanvasFonts[result.handle];
+
+	for (char32_t codepoint = U' '; codepoint <= U'~'; ++codepoint)
+		RasterizeGlyph(canvasFont, codepoint);
+
+	RasterizeMissingGlyphs(canvasFont, extraCharacters);
+
+	MLOG_DEBUG(u8"canvas::LoadFont - %u glyphs on %u pages", static_cast<u32>(canvasFont.glyphs.size()), static_cast<u32>(canvasFont.pages.size()));
+	return result;
+}
+
+void canvas::UnloadFont(FontHandle font)
+{
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	CanvasFont* canvasFont = gCanvasFonts.Get(font.handle);
+	if (canvasFont == nullptr)
+	{
+		MLOG_WARNING(u8"canvas::UnloadFont - invalid font handle");
+		return;
+	}
+
+	RetireFontPages(*canvasFont);
+	gCanvasFonts.Remove(font.handle);
+}
+
+void canvas::PreloadGlyphs(FontHandle font, std::u8string_view text)
+{
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	CanvasFont* canvasFont = gCanvasFonts.Get(font.handle);
+	if (canvasFont == nullptr)
+	{
+		MLOG_WARNING(u8"canvas::PreloadGlyphs - invalid font handle");
+		return;
+	}
+
+	// cached layouts may have used the fallback glyph for the new ones
+	if (RasterizeMissingGlyphs(*canvasFont, text) > 0)
+		canvasFont->runs.clear();
+}
+
+void canvas::DrawText(FontHandle font, std::u8string_view text, glm::vec2 position, float size, PackedColor color)
+{
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	CanvasFont* canvasFont = gCanvasFonts.Get(font.handle);
+	IF_UNLIKELY (canvasFont == nullptr)
+	{
+		MLOG_WARNING(u8"canvas::DrawText - invalid font handle");
+		return;
+	}
+
+	const CanvasTextRun& run = GetTextRun(*canvasFont, text);
+
+	for (const auto& quad : run.quads)
+	{
+		CanvasFontPage& page = canvasFont->pages[quad.page];
+		if (page.batchFrame != gTextFrame)
+		{
+			page.batchFrame = gTextFrame;
+			page.batch = AcquireTextBatch(page.texture);
+		}
+
+		gTextBatches[page.batch].glyphs.push_back({ position + quad.center * size, quad.halfSize * size, quad.uv0, quad.uv1, 0.0f, color });
+	}
+}
+
+glm::vec2 canvas::MeasureText(FontHandle font, std::u8string_view text, float size)
+{
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	CanvasFont* canvasFont = gCanvasFonts.Get(font.handle);
+	if (canvasFont == nullptr)
+		return glm::vec2(0.0f);
+
+	return GetTextRun(*canvasFont, text).extent * size;
+}
+
+void MercuryCanvasTextInitialize(int numFramesInFlight, bool distanceFieldGlyphs)
+{
+	gTextFramesInFlight = static_cast<u32>(numFramesInFlight);
+	gDistanceFieldGlyphs = distanceFieldGlyphs;
+	gTextFrame = 0;
+}
+
+void MercuryCanvasTextShutdown()
+{
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	for (auto& font : gCanvasFonts)
+		RetireFontPages(font);
+
+	for (const auto& retired : gRetiredFontPages)
+	{
+		MercuryCanvasForgetSpriteTexture(retired.texture);
+		gDevice->DestroyTexture(retired.texture);
+	}
+
+	gCanvasFonts.clear();
+	gRetiredFontPages.clear();
+	gTextBatches.clear();
+	gNumTextBatches = 0;
+}
+
+void MercuryCanvasTextEndFrame(const std::function<void(std::span<const CanvasTextBatch>)>& consume)
+{
+	std::lock_guard<std::mutex> lock(gTextMutex);
+
+	consume(std::span<const CanvasTextBatch>(gTextBatches.data(), gNumTextBatches));
+
+	for (u32 i = 0; i < gNumTextBatches; ++i)
+		gTextBatches[i].glyphs.clear();
+	gNumTextBatches = 0;
+
+	for (auto& font : gCanvasFonts)
+	{
+		if (font.runs.size() > CANVAS_TEXT_MAX_CACHED_RUNS)
+			std::erase_if(font.runs, [](const auto& entry) { return entry.second.lastUsedFrame < gTextFrame; });
+	}
+
+	gTextFrame++;
+
+	std::erase_if(gRetiredFontPages, [](const CanvasRetiredFontPage& retired)
+		{
+			if (retired.retiredFrame + gTextFramesInFlight >= gTextFrame)
+				return false;
+
+			MercuryCanvasForgetSpriteTexture(retired.texture);
+			gDevice->DestroyTexture(retired.texture);
+			return true;
+		});
+}
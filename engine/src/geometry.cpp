@@ -1,14 +1,338 @@
 #include "mercury_geometry.h"
+#include "mercury_log.h"
+#include "mercury_simd_math.h"
+#include "worker_pool.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
 
 using namespace mercury;
 using namespace geometry;
 using namespace glm;
 
-void StaticMeshData::RecomputeTangents()
+namespace
+{
+    // below this many items per thread waking a worker costs more than it saves
+    constexpr size_t MinItemsPerThread = 8192;
+
+    // Worker count for count items, numThreads = 0 means every pool worker plus the caller
+    u32 ResolveThreadCount(size_t count, u32 numThreads)
+    {
+#if defined(MERCURY_LL_OS_EMSCRIPTEN)
+        numThreads = 1;
+#endif
+        if (numThreads == 0)
+            numThreads = workers::GetNumWorkers() + 1;
+
+        return static_cast<u32>(std::min<size_t>(numThreads, std::max<size_t>(1, count / MinItemsPerThread)));
+    }
+
+    // Splits [0, count) into numThreads ranges, multiples of 4 so SIMD blocks never straddle two threads.
+    // The ranges run on the shared worker pool, the calling thread takes part.
+    template<typename Fn>
+    void ParallelRanges(size_t count, u32 numThreads, Fn&& fn)
+    {
+        if (numThreads <= 1)
+        {
+            fn(size_t(0), count);
+            return;
+        }
+
+        const size_t chunk = std::max<size_t>(4, (count / numThreads + 3) & ~size_t(3));
+        const u32 numRanges = static_cast<u32>((count + chunk - 1) / chunk);
+
+        workers::ParallelFor(numRanges, numThreads, [&](u32 range)
+        {
+            const size_t begin = range * chunk;
+            fn(begin, std::min(begin + chunk, count));
+        });
+    }
+
+    // 4 vertices, 4 consecutive floats starting at the given field, transposed to lanes. Every field read here is
+    // followed by at least one more float inside the vertex (position -> normal, normal -> tangent, uv0 -> uv1).
+    template<size_t FieldOffset>
+    simd::vec3x4 LoadVec3(const DedicatedStaticMeshVertex* v, u32 i0, u32 i1, u32 i2, u32 i3)
+    {
+        static_assert(FieldOffset + 4 * sizeof(f32) <= sizeof(DedicatedStaticMeshVertex));
+
+        const u8* base = reinterpret_cast<const u8*>(v) + FieldOffset;
+        f32x4 x = simd::load_f32x4(reinterpret_cast<const f32*>(base + i0 * sizeof(DedicatedStaticMeshVertex)));
+        f32x4 y = simd::load_f32x4(reinterpret_cast<const f32*>(base + i1 * sizeof(DedicatedStaticMeshVertex)));
+        f32x4 z = simd::load_f32x4(reinterpret_cast<const f32*>(base + i2 * sizeof(DedicatedStaticMeshVertex)));
+        f32x4 w = simd::load_f32x4(reinterpret_cast<const f32*>(base + i3 * sizeof(DedicatedStaticMeshVertex)));
+        simd::transpose_f32x4(x, y, z, w);
+        return { x, y, z };
+    }
+
+    // Rows of (x, y, z, w) vectors -> lanes, w dropped
+    simd::vec3x4 LoadRows(const f32x4* in, size_t stride)
+    {
+        f32x4 r0 = in[0], r1 = in[stride], r2 = in[stride * 2], r3 = in[stride * 3];
+        simd::transpose_f32x4(r0, r1, r2, r3);
+        return { r0, r1, r2 };
+    }
+
+    // Face values are (x, y, z, unused) vectors, faceValues per face, faces[0] belongs to faceBegin. Scattering stays
+    // in face order, whole vectors are added so neighbouring faces do not stall on partial store forwarding.
+    void AccumulateFaces(const u16* indices, size_t faceBegin, size_t faceEnd, const f32x4* faces, u32 faceValues, f32x4* accum)
+    {
+        faces -= faceBegin * faceValues;
+
+        for (size_t f = faceBegin; f < faceEnd; ++f)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                f32x4* target = accum + size_t(indices[f * 3 + corner]) * faceValues;
+
+                for (u32 k = 0; k < faceValues; ++k)
+                    target[k] = simd::add_f32x4(target[k], faces[f * faceValues + k]);
+            }
+        }
+    }
+
+    // Same as AccumulateFaces over all faces, but only the corners of vertices in [vertexBegin, vertexEnd) are added.
+    // Every thread owns a vertex range, so no two threads write the same sum and each sum keeps the serial face order:
+    // the threaded result is bit identical to the single threaded one.
+    void AccumulateFacesForVertices(const u16* indices, size_t faceCount, const f32x4* faces, u32 faceValues,
+        size_t vertexBegin, size_t vertexEnd, f32x4* accum)
+    {
+        const size_t rangeSize = vertexEnd - vertexBegin;
+
+        for (size_t f = 0; f < faceCount; ++f)
+        {
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                const size_t vertex = indices[f * 3 + corner];
+                if (vertex - vertexBegin >= rangeSize) // wraps for vertices below the range
+                    continue;
+
+                f32x4* target = accum + vertex * faceValues;
+
+                for (u32 k = 0; k < faceValues; ++k)
+                    target[k] = simd::add_f32x4(target[k], faces[f * faceValues + k]);
+            }
+        }
+    }
+
+    // Positions and uv0 are loaded as whole vectors, the lane past the field belongs to the next one
+    // (position -> normal.x, uv0 -> uv1) and only ever ends up in the unused w of the results.
+    f32x4 LoadField(const glm::vec3& v) { return simd::load_f32x4(&v.x); }
+    f32x4 LoadField(const glm::vec2& v) { return simd::load_f32x4(&v.x); }
+
+    // Degenerate UV mappings contribute zero, like RecomputeTangentsScalar skipping them.
+    // Output: tangent and bitangent per face (w unused), out[0] belongs to faceBegin.
+    void ComputeFaceTangents(const StaticMeshData& mesh, size_t faceBegin, size_t faceEnd, f32x4* out)
+    {
+        static_assert(offsetof(DedicatedStaticMeshVertex, position) + 4 * sizeof(f32) <= sizeof(DedicatedStaticMeshVertex));
+        static_assert(offsetof(DedicatedStaticMeshVertex, uv0) + 4 * sizeof(f32) <= sizeof(DedicatedStaticMeshVertex));
+
+        out -= faceBegin * 2;
+
+        const DedicatedStaticMeshVertex* vertices = mesh.vertices.data();
+        const u16* indices = mesh.indices.data();
+
+        for (size_t f = faceBegin; f < faceEnd; ++f)
+        {
+            const auto& a = vertices[indices[f * 3]];
+            const auto& b = vertices[indices[f * 3 + 1]];
+            const auto& c = vertices[indices[f * 3 + 2]];
+
+            const f32x4 pa = LoadField(a.position);
+            const f32x4 e1 = simd::sub_f32x4(LoadField(b.position), pa);
+            const f32x4 e2 = simd::sub_f32x4(LoadField(c.position), pa);
+
+            const f32x4 uva = LoadField(a.uv0);
+            // du1, dv1, du2, dv2
+            const f32x4 duv = simd::shuffle_f32x4<0, 1, 0, 1>(simd::sub_f32x4(LoadField(b.uv0), uva), simd::sub_f32x4(LoadField(c.uv0), uva));
+
+            // du1 * dv2, dv1 * du2, ...
+            const f32x4 cross = simd::mul_f32x4(duv, simd::swizzle_f32x4<3, 2, 1, 0>(duv));
+            const f32 det = simd::extract_lane_f32x4<0>(cross) - simd::extract_lane_f32x4<1>(cross);
+            const f32 invDet = fabsf(det) < 1e-6f ? 0.0f : 1.0f / det;
+
+            const f32x4 scaled = simd::mul_f32x4(duv, simd::splat_f32x4(invDet));
+
+            // (e1 * dv2 - e2 * dv1) / det, (e2 * du1 - e1 * du2) / det
+            out[f * 2] = simd::fnmadd_f32x4(e2, simd::swizzle_f32x4<1, 1, 1, 1>(scaled), simd::mul_f32x4(e1, simd::swizzle_f32x4<3, 3, 3, 3>(scaled)));
+            out[f * 2 + 1] = simd::fnmadd_f32x4(e1, simd::swizzle_f32x4<2, 2, 2, 2>(scaled), simd::mul_f32x4(e2, simd::swizzle_f32x4<0, 0, 0, 0>(scaled)));
+        }
+    }
+
+    // Area weighted face normals (unnormalized cross product, w unused), out[0] belongs to faceBegin
+    void ComputeFaceNormals(const StaticMeshData& mesh, size_t faceBegin, size_t faceEnd, f32x4* out)
+    {
+        out -= faceBegin;
+
+        const DedicatedStaticMeshVertex* vertices = mesh.vertices.data();
+        const u16* indices = mesh.indices.data();
+
+        for (size_t f = faceBegin; f < faceEnd; ++f)
+        {
+            const f32x4 p1 = LoadField(vertices[indices[f * 3]].position);
+            const f32x4 e1 = simd::sub_f32x4(LoadField(vertices[indices[f * 3 + 1]].position), p1);
+            const f32x4 e2 = simd::sub_f32x4(LoadField(vertices[indices[f * 3 + 2]].position), p1);
+
+            // e1.yzx * e2.zxy - e1.zxy * e2.yzx
+            out[f] = simd::fnmadd_f32x4(simd::swizzle_f32x4<2, 0, 1, 3>(e1), simd::swizzle_f32x4<1, 2, 0, 3>(e2),
+                simd::mul_f32x4(simd::swizzle_f32x4<1, 2, 0, 3>(e1), simd::swizzle_f32x4<2, 0, 1, 3>(e2)));
+        }
+    }
+
+    // Single threaded, face values go through a small buffer that stays in L1 and are scattered right away.
+    // With workers all faces are computed in parallel first, then every worker gathers them into its own vertex range.
+    template<typename ComputeFn>
+    void ComputeAndAccumulate(const StaticMeshData& mesh, u32 numThreads, u32 faceValues, memory::ScratchAllocator* scratch,
+        f32x4* accum, ComputeFn&& compute)
+    {
+        constexpr size_t FacesPerChunk = 256;
+
+        const size_t faceCount = mesh.indices.size() / 3;
+        const u16* indices = mesh.indices.data();
+
+        if (numThreads <= 1)
+        {
+            f32x4* faces = scratch->AllocateArray<f32x4>(FacesPerChunk * faceValues);
+
+            for (size_t begin = 0; begin < faceCount; begin += FacesPerChunk)
+            {
+                const size_t end = std::min(begin + FacesPerChunk, faceCount);
+                compute(mesh, begin, end, faces);
+                AccumulateFaces(indices, begin, end, faces, faceValues, accum);
+            }
+            return;
+        }
+
+        f32x4* faces = scratch->AllocateArray<f32x4>(faceCount * faceValues);
+
+        ParallelRanges(faceCount, numThreads, [&](size_t begin, size_t end) { compute(mesh, begin, end, faces + begin * faceValues); });
+
+        ParallelRanges(mesh.vertices.size(), numThreads, [&](size_t begin, size_t end)
+        {
+            AccumulateFacesForVertices(indices, faceCount, faces, faceValues, begin, end, accum);
+        });
+    }
+
+    f32x4* AllocateZeroed(memory::ScratchAllocator* scratch, size_t count)
+    {
+        f32x4* data = scratch->AllocateArray<f32x4>(count);
+        const f32x4 zero = simd::splat_f32x4(0.0f);
+        for (size_t i = 0; i < count; ++i)
+            data[i] = zero;
+        return data;
+    }
+}
+
+void StaticMeshData::RecomputeTangents(u32 numThreads)
+{
+    const size_t vertexCount = vertices.size();
+    const size_t faceCount = indices.size() / 3;
+
+    if (vertexCount == 0)
+        return;
+
+    memory::ScratchScope scratch;
+
+    // tangent and bitangent sums, interleaved per vertex
+    f32x4* accum = AllocateZeroed(scratch.allocator, vertexCount * 2);
+
+    ComputeAndAccumulate(*this, ResolveThreadCount(faceCount, numThreads), 2, scratch.allocator, accum, ComputeFaceTangents);
+
+    ParallelRanges(vertexCount, ResolveThreadCount(vertexCount, numThreads), [&](size_t begin, size_t end)
+    {
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const u32 v = static_cast<u32>(i);
+            const simd::vec3x4 n = simd::normalize(LoadVec3<offsetof(DedicatedStaticMeshVertex, normal)>(vertices.data(), v, v + 1, v + 2, v + 3));
+            const simd::vec3x4 b = LoadRows(accum + i * 2 + 1, 2);
+            simd::vec3x4 t = LoadRows(accum + i * 2, 2);
+
+            // Gram-Schmidt orthogonalize, then fix handedness and rebuild a clean bitangent
+            t = simd::normalize(t - n * simd::dot(n, t));
+            t = simd::select(simd::cmplt_f32x4(simd::dot(simd::cross(n, t), b), simd::splat_f32x4(0.0f)), -t, t);
+
+            vec3 tangents[4], binormals[4];
+            simd::store_vec3x4(tangents, t);
+            simd::store_vec3x4(binormals, simd::cross(n, t));
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                vertices[i + lane].tangent = tangents[lane];
+                vertices[i + lane].binormal = binormals[lane];
+            }
+        }
+
+        for (; i < end; ++i)
+        {
+            f32 sums[8];
+            simd::store_f32x4(sums, accum[i * 2]);
+            simd::store_f32x4(sums + 4, accum[i * 2 + 1]);
+
+            vec3 n = normalize(vertices[i].normal);
+            vec3 t(sums[0], sums[1], sums[2]);
+            vec3 b(sums[4], sums[5], sums[6]);
+
+            t = normalize(t - n * dot(n, t));
+            if (dot(cross(n, t), b) < 0.0f)
+                t = -t;
+
+            vertices[i].tangent = t;
+            vertices[i].binormal = cross(n, t);
+        }
+    });
+}
+
+void StaticMeshData::RecomputeNormals(u32 numThreads)
 {
     const size_t vertexCount = vertices.size();
-    std::vector<vec3> tan1(vertexCount, glm::vec3(0.0f));
-    std::vector<vec3> tan2(vertexCount, glm::vec3(0.0f));
+    const size_t faceCount = indices.size() / 3;
+
+    if (vertexCount == 0)
+        return;
+
+    memory::ScratchScope scratch;
+
+    f32x4* accum = AllocateZeroed(scratch.allocator, vertexCount);
+
+    ComputeAndAccumulate(*this, ResolveThreadCount(faceCount, numThreads), 1, scratch.allocator, accum, ComputeFaceNormals);
+
+    ParallelRanges(vertexCount, ResolveThreadCount(vertexCount, numThreads), [&](size_t begin, size_t end)
+    {
+        size_t i = begin;
+        for (; i + 4 <= end; i += 4)
+        {
+            const simd::vec3x4 n = LoadRows(accum + i, 1);
+            const u32 used = simd::movemask_u32x4(simd::cmpgt_f32x4(simd::dot(n, n), simd::splat_f32x4(0.0f)));
+
+            vec3 normals[4];
+            simd::store_vec3x4(normals, simd::normalize(n));
+
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                if (used & (1u << lane))
+                    vertices[i + lane].normal = normals[lane];
+            }
+        }
+
+        for (; i < end; ++i)
+        {
+            f32 sum[4];
+            simd::store_f32x4(sum, accum[i]);
+
+            vec3 n(sum[0], sum[1], sum[2]);
+            if (dot(n, n) > 0.0f)
+                vertices[i].normal = normalize(n);
+        }
+    });
+}
+
+void StaticMeshData::RecomputeTangentsScalar()
+{
+    memory::ScratchScope scratch;
+
+    const size_t vertexCount = vertices.size();
+    memory::ArenaVector<vec3> tan1(vertexCount, glm::vec3(0.0f), memory::ArenaRef::Scratch(scratch.allocator));
+    memory::ArenaVector<vec3> tan2(vertexCount, glm::vec3(0.0f), memory::ArenaRef::Scratch(scratch.allocator));
 
     for (size_t i = 0; i < indices.size(); i += 3)
     {
@@ -35,8 +359,8 @@ void StaticMeshData::RecomputeTangents()
 
         float invDet = 1.0f / det;
 
-        vec3 tangent = (e1 * duv2.y - e2 * duv2.x) * invDet;
-        vec3 bitangent = (e2 * duv1.x - e1 * duv1.y) * invDet;
+        vec3 tangent = (e1 * duv2.y - e2 * duv1.y) * invDet;
+        vec3 bitangent = (e2 * duv1.x - e1 * duv2.x) * invDet;
 
         tan1[i1] += tangent;   tan1[i2] += tangent;   tan1[i3] += tangent;
         tan2[i1] += bitangent; tan2[i2] += bitangent; tan2[i3] += bitangent;
@@ -67,15 +391,16 @@ void StaticMeshData::RecomputeTangents()
 // =============================================================================
 // Plane (XZ plane, Y up)
 // =============================================================================
-StaticMeshData geometry::CreatePlaneMesh(float width, float height, u16 subdivisionsWidth, u16 subdivisionsHeight)
+StaticMeshData geometry::CreatePlaneMesh(float width, float height, u16 subdivisionsWidth, u16 subdivisionsHeight, memory::ArenaRef arena)
 {
     
-    StaticMeshData mesh;
+    StaticMeshData mesh(arena);
 
     uint32_t w = subdivisionsWidth + 1;
     uint32_t h = subdivisionsHeight + 1;
 
     mesh.vertices.resize(w * h);
+    mesh.indices.reserve(subdivisionsWidth * subdivisionsHeight * 6);
 
     for (uint32_t z = 0; z < h; ++z)
     {
@@ -118,11 +443,14 @@ StaticMeshData geometry::CreatePlaneMesh(float width, float height, u16 subdivis
 // =============================================================================
 // Cube (centered at origin, flat shaded)
 // =============================================================================
-StaticMeshData geometry::CreateCubeMesh(float size)   // size = edge length, cube from -size/2 to +size/2
+StaticMeshData geometry::CreateCubeMesh(float size, memory::ArenaRef arena)   // size = edge length, cube from -size/2 to +size/2
 {
-    StaticMeshData mesh;
+    StaticMeshData mesh(arena);
     float h = size * 0.5f;
 
+    mesh.vertices.reserve(6 * 4);
+    mesh.indices.reserve(6 * 6);
+
     auto addFace = [&](vec3 c, vec3 r, vec3 u, vec3 n, bool flipU = false)
         {
             vec2 uvBase = flipU ? vec2(1.0f, 0.0f) : vec2(0.0f, 0.0f);
@@ -170,13 +498,21 @@ StaticMeshData geometry::CreateCubeMesh(float size)   // size = edge length, cub
 // =============================================================================
 // Geosphere (subdivided icosahedron -> very even triangle distribution)
 // =============================================================================
-StaticMeshData geometry::CreateGeoSphereMesh(float radius, u8 subdivisions)
+StaticMeshData geometry::CreateGeoSphereMesh(float radius, u8 subdivisions, memory::ArenaRef arena)
 {
-    StaticMeshData mesh;
+    // indices are u16, level 7 would already need 163842 vertices
+    constexpr u8 MaxSubdivisions = 6;
+    if (subdivisions > MaxSubdivisions)
+    {
+        MLOG_WARNING(u8"CreateGeoSphereMesh: %u subdivisions do not fit 16 bit indices, clamping to %u", subdivisions, MaxSubdivisions);
+        subdivisions = MaxSubdivisions;
+    }
+
+    StaticMeshData mesh(arena);
 
     const float phi = (1.0f + sqrtf(5.0f)) / 2.0f;
 
-    std::vector<vec3> baseVerts = {
+    const vec3 baseVerts[] = {
         vec3(-1,  phi,  0), vec3(1,  phi,  0),
         vec3(-1, -phi,  0), vec3(1, -phi,  0),
         vec3(0, -1,  phi), vec3(0,  1,  phi),
@@ -185,10 +521,22 @@ StaticMeshData geometry::CreateGeoSphereMesh(float radius, u8 subdivisions)
         vec3(-phi,  0, -1), vec3(-phi,  0,  1),
     };
 
-    mesh.vertices.reserve(10000); // rough guess
-    for (auto& v : baseVerts)
+    const uint16_t baseIndices[] = {
+        0,11,5,  0,5,1,  0,1,7,  0,7,10, 0,10,11,
+        1,5,9,   5,11,4,  11,10,2, 10,7,6,  7,1,8,
+        3,9,4,   3,4,2,   3,2,6,   3,6,8,   3,8,9,
+        4,9,5,   2,4,11,  6,2,10,  8,6,7,   9,8,1
+    };
+
+    // every level splits each triangle in four and adds one vertex per edge: V = 10 * 4^n + 2, I = 60 * 4^n
+    const size_t finalTriangleCount = size_t(20) << (2 * subdivisions);
+    // reserve the mesh before opening the scratch scope, the mesh itself may live in the scratch allocator
+    mesh.vertices.reserve(finalTriangleCount / 2 + 2);
+    mesh.indices.reserve(finalTriangleCount * 3);
+
+    for (const auto& base : baseVerts)
     {
-        v = normalize(v) * radius;
+        vec3 v = normalize(base) * radius;
         DedicatedStaticMeshVertex vert;
         vert.position = v;
         vert.normal = v / radius;
@@ -196,23 +544,35 @@ StaticMeshData geometry::CreateGeoSphereMesh(float radius, u8 subdivisions)
         mesh.vertices.push_back(vert);
     }
 
-    mesh.indices = {
-        0,11,5,  0,5,1,  0,1,7,  0,7,10, 0,10,11,
-        1,5,9,   5,11,4,  11,10,2, 10,7,6,  7,1,8,
-        3,9,4,   3,4,2,   3,2,6,   3,6,8,   3,8,9,
-        4,9,5,   2,4,11,  6,2,10,  8,6,7,   9,8,1
-    };
+    memory::ScratchScope scratch;
+    auto scratchArena = memory::ArenaRef::Scratch(scratch.allocator);
+
+    // the index list ping-pongs between two scratch buffers, only the final level is copied into the mesh
+    memory::ArenaVector<uint16_t> indices(scratchArena);
+    memory::ArenaVector<uint16_t> newIndices(scratchArena);
+    indices.reserve(finalTriangleCount * 3);
+    newIndices.reserve(finalTriangleCount * 3);
+    indices.assign(std::begin(baseIndices), std::end(baseIndices));
 
-    std::unordered_map<uint64_t, uint16_t> midCache;
+    // edge -> mid point vertex, open addressing table sized for the edges of the last level (E = 3/2 * F)
+    constexpr uint32_t EmptyKey = 0xFFFFFFFFu;
+    const size_t midCacheCapacity = std::bit_ceil(finalTriangleCount * 2);
+    const size_t midCacheMask = midCacheCapacity - 1;
+    uint32_t* midCacheKeys = scratch.allocator->AllocateArray<uint32_t>(midCacheCapacity);
+    uint16_t* midCacheValues = scratch.allocator->AllocateArray<uint16_t>(midCacheCapacity);
 
     auto getMidPoint = [&](uint16_t i1, uint16_t i2) -> uint16_t
         {
-            uint64_t a = i1, b = i2;
+            uint32_t a = i1, b = i2;
             if (a > b) std::swap(a, b);
-            uint64_t key = (a << 32) | b;
+            uint32_t key = (a << 16) | b;
 
-            auto found = midCache.find(key);
-            if (found != midCache.end()) return found->second;
+            size_t slot = (key * 0x9E3779B1u) & midCacheMask;
+            while (midCacheKeys[slot] != EmptyKey)
+            {
+                if (midCacheKeys[slot] == key) return midCacheValues[slot];
+                slot = (slot + 1) & midCacheMask;
+            }
 
             vec3 mid = normalize(mesh.vertices[i1].position + mesh.vertices[i2].position) * radius;
 
@@ -223,21 +583,21 @@ StaticMeshData geometry::CreateGeoSphereMesh(float radius, u8 subdivisions)
             v.color = vec4(1.0f);
             mesh.vertices.push_back(v);
 
-            midCache[key] = idx;
+            midCacheKeys[slot] = key;
+            midCacheValues[slot] = idx;
             return idx;
         };
 
     for (uint32_t level = 0; level < subdivisions; ++level)
     {
-        std::vector<uint16_t> newIndices;
-        newIndices.reserve(mesh.indices.size() * 4);
-        midCache.clear();
+        newIndices.clear();
+        std::fill_n(midCacheKeys, midCacheCapacity, EmptyKey);
 
-        for (size_t i = 0; i < mesh.indices.size(); i += 3)
+        for (size_t i = 0; i < indices.size(); i += 3)
         {
-            uint16_t v1 = mesh.indices[i];
-            uint16_t v2 = mesh.indices[i + 1];
-            uint16_t v3 = mesh.indices[i + 2];
+            uint16_t v1 = indices[i];
+            uint16_t v2 = indices[i + 1];
+            uint16_t v3 = indices[i + 2];
 
             uint16_t m12 = getMidPoint(v1, v2);
             uint16_t m23 = getMidPoint(v2, v3);
@@ -251,9 +611,11 @@ StaticMeshData geometry::CreateGeoSphereMesh(float radius, u8 subdivisions)
                 });
         }
 
-        mesh.indices = std::move(newIndices);
+        std::swap(indices, newIndices);
     }
 
+    mesh.indices.assign(indices.begin(), indices.end());
+
     // Spherical UVs
     for (auto& vtx : mesh.vertices)
     {
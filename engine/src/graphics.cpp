@@ -5,6 +5,11 @@
 #include "ll/graphics/mercury_swapchain.h"
 #include "imgui/mercury_imgui.h"
 #include "canvas.h"
+#include "mercury_memory.h"
+#include "mercury_utils.h"
+#include <atomic>
+#include <bit>
+#include <cstring>
 
 using namespace mercury;
 using namespace ll::graphics;
@@ -19,16 +24,142 @@ struct FrameResources
 {
 };
 
-constexpr int gNumFramesInFlight = 2;
+// the backend frame rings have the same length, so AcquireNextImage has waited for the previous use of this slot
+constexpr int gNumFramesInFlight = Swapchain::NumFramesInFlight;
+static_assert(gNumFramesInFlight <= memory::FrameAllocator::MaxFramesInFlight);
 std::array<FrameResources, gNumFramesInFlight> gPerFrameResources;
 int gCurrentFrameInFlightIndex = 0;
 
+// One buffer split into a region per frame in flight. A region is bump allocated during its frame and rewound once
+// AcquireNextImage has waited for the GPU to finish the previous use of that frame slot.
+struct UploadRing
+{
+    BufferHandle buffer;
+    u8* mapped = nullptr; // persistent map, or shadow.data() when the backend can't keep buffers mapped
+    std::vector<u8> shadow; // copied with one UpdateBuffer per frame
+    size_t regionSize = 0;
+    size_t regionBegin = 0;
+    std::atomic<size_t> head = 0; // bytes used in the current region
+    size_t flushed = 0; // leading bytes of the current region already published to the GPU
+    std::atomic<bool> overflowReported = false;
+};
+
+UploadRing gUploadRing;
+
+void InitializeUploadRing(size_t regionSize)
+{
+    auto& ring = gUploadRing;
+    ring.regionSize = utils::math::alignUp(regionSize, Device::UploadRingAlignment);
+    if (ring.regionSize == 0)
+        return;
+
+    BufferDescriptor desc;
+    desc.size = ring.regionSize * gNumFramesInFlight;
+    desc.type = BufferType::UniformBuffer;
+    ring.buffer = gDevice->CreateBuffer(desc);
+
+    IF_UNLIKELY(!ring.buffer.isValid())
+    {
+        MLOG_WARNING(u8"Upload ring is not available on this backend, AllocateUpload will fail");
+        return;
+    }
+
+    ring.mapped = static_cast<u8*>(gDevice->GetMappedBufferPointer(ring.buffer));
+    if (ring.mapped == nullptr)
+    {
+        ring.shadow.resize(desc.size);
+        ring.mapped = ring.shadow.data();
+    }
+}
+
+void ShutdownUploadRing()
+{
+    auto& ring = gUploadRing;
+    if (ring.buffer.isValid())
+        gDevice->DestroyBuffer(ring.buffer);
+
+    ring.buffer.Invalidate();
+    ring.mapped = nullptr;
+    ring.shadow = {};
+}
+
+void BeginUploadRingFrame(int frameInFlightIndex)
+{
+    gUploadRing.regionBegin = gUploadRing.regionSize * frameInFlightIndex;
+    gUploadRing.head.store(0, std::memory_order_relaxed);
+    gUploadRing.flushed = 0;
+}
+
+void Device::FlushUploads()
+{
+    auto& ring = gUploadRing;
+    size_t used = std::min(ring.head.load(std::memory_order_acquire), ring.regionSize);
+    if (used <= ring.flushed)
+        return;
+
+    size_t begin = ring.regionBegin + ring.flushed;
+    if (ring.shadow.empty())
+        FlushBuffer(ring.buffer, begin, used - ring.flushed);
+    else
+        UpdateBuffer(ring.buffer, ring.mapped + begin, used - ring.flushed, begin);
+
+    ring.flushed = used;
+}
+
+UploadAllocation Device::AllocateUpload(size_t size, size_t alignment)
+{
+    auto& ring = gUploadRing;
+    if (alignment == 0)
+        alignment = UploadRingAlignment;
+
+    MERCURY_ASSERT(std::has_single_bit(alignment));
+
+    IF_UNLIKELY(ring.mapped == nullptr)
+        return {};
+
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    size_t offset = 0;
+    do
+    {
+        offset = utils::math::alignUp(head, alignment);
+        IF_UNLIKELY(offset + size > ring.regionSize)
+        {
+            if (!ring.overflowReported.exchange(true, std::memory_order_relaxed))
+                MLOG_ERROR(u8"Upload ring exhausted (%zu bytes per frame), raise Config::Graphics::uploadRingSize", ring.regionSize);
+            return {};
+        }
+    } while (!ring.head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+    UploadAllocation result;
+    result.buffer = ring.buffer;
+    result.offset = ring.regionBegin + offset;
+    result.size = size;
+    result.cpuAddress = ring.mapped + result.offset;
+    return result;
+}
+
+UploadAllocation Device::Upload(const void* data, size_t size, size_t alignment)
+{
+    UploadAllocation result = AllocateUpload(size, alignment);
+    if (result.IsValid())
+        std::memcpy(result.cpuAddress, data, size);
+
+    return result;
+}
+
 void MercuryGraphicsInitialize()
 {
     auto &appCfg = Application::GetCurrentApplication()->GetConfig();
     auto &graphicsCfg = appCfg.graphics;
 
     mercurySwapchainConfigure(appCfg.swapchain);
+
+    memory::FrameAllocator::InitDesc frameAllocatorDesc;
+    frameAllocatorDesc.numFramesInFlight = gNumFramesInFlight;
+    // the arenas are rewritten every frame, so fault their pages in once at commit instead of on first touch
+    frameAllocatorDesc.memoryPolicy.flags = ll::os::MemoryPolicy::Prefault;
+    memory::gFrameAllocator = new memory::FrameAllocator(frameAllocatorDesc);
+
     gInstance = new Instance();
     gInstance->Initialize();
 
@@ -42,6 +173,8 @@ void MercuryGraphicsInitialize()
     gAdapter->CreateDevice();
     gDevice->Initialize();
 
+    InitializeUploadRing(graphicsCfg.uploadRingSize);
+
     //TODO: think about waiting the surface to ready
     if (gSwapchain == nullptr )
     {
@@ -62,12 +195,18 @@ void MercuryGraphicsInitialize()
 void MercuryGraphicsShutdown()
 {
     MLOG_DEBUG(u8"MercuryGraphicsShutdown - Starting");
-    
+
+    // the last frames may still read canvas buffers, descriptor sets and glyph pages destroyed below
+    if (gDevice)
+        gDevice->WaitIdle();
+
     MercuryCanvasShutdown();
 
     mercury_imgui::Shutdown();
     
     if (gDevice) {
+        ShutdownUploadRing();
+
         MLOG_DEBUG(u8"MercuryGraphicsShutdown - Shutting down device");
         gDevice->Shutdown();
         delete gDevice;
@@ -87,6 +226,9 @@ void MercuryGraphicsShutdown()
         delete gInstance;
         gInstance = nullptr;
     }
+
+    delete memory::gFrameAllocator;
+    memory::gFrameAllocator = nullptr;
     
     MLOG_DEBUG(u8"MercuryGraphicsShutdown - Complete");
 
@@ -126,6 +268,14 @@ void MercuryGraphicsTick()
             // Swapchain available, acquiring next image
             auto finalCmdList = gSwapchain->AcquireNextImage();
 
+            // AcquireNextImage waited for the timeline value of this frame slot, its transient data is free to reuse
+            memory::gFrameAllocator->BeginFrame((u8)gCurrentFrameInFlightIndex);
+            BeginUploadRingFrame(gCurrentFrameInFlightIndex);
+
+            // compute has to be recorded outside the final pass
+            MercuryCanvasPrepare(finalCmdList, gCurrentFrameInFlightIndex);
+            gSwapchain->BeginFinalPass(finalCmdList);
+
 			finalCmdList.SetViewport(0, 0, (float)gSwapchain->GetWidth(), (float)gSwapchain->GetHeight());
 			finalCmdList.SetScissor(0, 0, (u32)gSwapchain->GetWidth(), (u32)gSwapchain->GetHeight());
 
@@ -137,6 +287,7 @@ void MercuryGraphicsTick()
             mercury::Application::GetCurrentApplication()->OnImgui();
             mercury_imgui::EndFrame(finalCmdList);
             // do all graphics job here
+            gDevice->FlushUploads();
             gSwapchain->Present();
         }
         else
@@ -166,3 +166,13 @@ const FormatInfo& ll::graphics::GetFormatInfo(Format format)
     // Safe guard against out-of-range enum values
     return formatInfos[index];
 }
+
+size_t ll::graphics::GetFormatDataSize(Format format, size_t width, size_t height, size_t depth)
+{
+    const FormatInfo& info = GetFormatInfo(format);
+
+    size_t blocksX = (width + info.blockWidth - 1) / info.blockWidth;
+    size_t blocksY = (height + info.blockHeight - 1) / info.blockHeight;
+
+    return blocksX * blocksY * depth * info.blockSize;
+}
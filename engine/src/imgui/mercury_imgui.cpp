@@ -5,6 +5,8 @@
 #include <ll/os.h>
 #include <ll/graphics.h>
 #include "mercury_log.h"
+#include "mercury_memory.h"
+#include "mercury_utils.h"
 
 #include "../application.h"
 #include <mercury_input.h>
@@ -276,6 +278,137 @@ void DrawStatisticsWindow()
 	ImGui::End();
 }
 
+// committed/used/waste of every bucket over the last minute, sampled 4 times per second
+struct AllocatorHistory
+{
+	static constexpr int NumSamples = 240;
+	static constexpr double SampleInterval = 0.25;
+
+	struct BucketHistory
+	{
+		float committed[NumSamples] = {};
+		float used[NumSamples] = {};
+		float waste[NumSamples] = {};
+	};
+
+	std::vector<BucketHistory> buckets;
+	int offset = 0;
+	double lastSampleTime = -SampleInterval;
+};
+
+AllocatorHistory gGraphicsAllocatorHistory;
+
+void DrawAllocatorWindow(const char* title, mercury::memory::ReservedAllocator* allocator, AllocatorHistory& history)
+{
+	using mercury::utils::string::format_size;
+	using Snapshot = mercury::memory::ReservedAllocator::Snapshot;
+
+	if (allocator == nullptr)
+		return;
+
+	Snapshot snapshot;
+	allocator->GetSnapshot(snapshot);
+
+	if (history.buckets.size() != snapshot.buckets.size())
+		history.buckets.resize(snapshot.buckets.size());
+
+	double time = ImGui::GetTime();
+	if (time - history.lastSampleTime >= AllocatorHistory::SampleInterval)
+	{
+		history.lastSampleTime = time;
+		history.offset = (history.offset + 1) % AllocatorHistory::NumSamples;
+
+		for (size_t i = 0; i < snapshot.buckets.size(); ++i)
+		{
+			auto& bucket = snapshot.buckets[i];
+			auto& bucketHistory = history.buckets[i];
+
+			// plotted in KB
+			bucketHistory.committed[history.offset] = bucket.committedSize / 1024.0f;
+			bucketHistory.used[history.offset] = bucket.usedSize / 1024.0f;
+			bucketHistory.waste[history.offset] = (bucket.usedSize - bucket.userSize) / 1024.0f;
+		}
+	}
+
+	ImGui::Begin(title);
+
+	ImGui::Text("Reserved: %s", format_size(snapshot.reservedSize).c_str());
+	ImGui::SameLine();
+	ImGui::Text("Committed: %s", format_size(snapshot.committedSize).c_str());
+	ImGui::SameLine();
+	ImGui::Text("Trimmed: %s", format_size(snapshot.totalTrimmedSize).c_str());
+
+#ifdef MERCURY_USE_MEMORY_STAT
+	ImGui::Text("Allocations: %llu  Mallocs: %llu  Reallocs: %llu (in place %llu)", snapshot.totalAllocationsCount,
+		snapshot.totalMallocAllocations, snapshot.totalReallocsCount, snapshot.totalReallocsSaveBySameBucket);
+#else
+	ImGui::Text("Define MERCURY_USE_MEMORY_STAT for allocation counters");
+#endif
+	ImGui::Separator();
+
+	// history starts right after the newest sample
+	int plotOffset = (history.offset + 1) % AllocatorHistory::NumSamples;
+
+	for (size_t i = 0; i < snapshot.buckets.size(); ++i)
+	{
+		auto& bucket = snapshot.buckets[i];
+		auto& bucketHistory = history.buckets[i];
+
+		if (!ImGui::TreeNode((void*)(intptr_t)i, "%u B: committed %s, used %s, waste %s", bucket.elementSize, format_size(bucket.committedSize).c_str(),
+			format_size(bucket.usedSize).c_str(), format_size(bucket.usedSize - bucket.userSize).c_str()))
+			continue;
+
+		float scaleMax = bucket.reservedSize / 1024.0f;
+		ImVec2 plotSize(ImGui::GetContentRegionAvail().x, 40.0f);
+
+		ImGui::PlotLines("##committed", bucketHistory.committed, AllocatorHistory::NumSamples, plotOffset, "committed, KB", 0.0f, scaleMax, plotSize);
+		ImGui::PlotLines("##used", bucketHistory.used, AllocatorHistory::NumSamples, plotOffset, "used, KB", 0.0f, scaleMax, plotSize);
+		ImGui::PlotLines("##waste", bucketHistory.waste, AllocatorHistory::NumSamples, plotOffset, "waste, KB", 0.0f, FLT_MAX, plotSize);
+
+		float histogram[mercury::memory::ReservedAllocator::NumSizeHistogramBins];
+		for (int bin = 0; bin < mercury::memory::ReservedAllocator::NumSizeHistogramBins; ++bin)
+			histogram[bin] = (float)bucket.sizeHistogram[bin];
+
+		ImGui::PlotHistogram("##sizes", histogram, mercury::memory::ReservedAllocator::NumSizeHistogramBins, 0, "requested size / element size", 0.0f, FLT_MAX, plotSize);
+		ImGui::Text("Live: %llu  Total: %llu  Decommitted by trim: %s", bucket.allocationsCount, bucket.totalAllocationsCount,
+			format_size(bucket.totalDecommittedSize).c_str());
+
+		ImGui::TreePop();
+	}
+
+	ImGui::End();
+}
+
+void DrawFrameTimingWindow()
+{
+	namespace clock = mercury::clock;
+
+	static clock::FrameTimingStats stats;
+	clock::GetFrameTimingStats(stats);
+
+	const auto& timing = clock::GetFrameTiming();
+
+	ImGui::Begin("Frame Timing");
+
+	ImGui::Text("Frame: %llu  Time: %.2f s  Unscaled: %.2f s", timing.frameIndex, timing.time, timing.unscaledTime);
+	ImGui::Text("Smoothed: %.2f ms (%.1f fps)", timing.smoothedDeltaTime * 1000.0f,
+		timing.smoothedDeltaTime > 0.0f ? 1.0f / timing.smoothedDeltaTime : 0.0f);
+	ImGui::Text("Min: %.2f ms  Avg: %.2f ms  Max: %.2f ms  99%%: %.2f ms", stats.minMs, stats.avgMs, stats.maxMs, stats.p99Ms);
+
+	ImGui::PlotLines("##frametimes", stats.samples, (int)stats.count, 0, "ms", 0.0f, stats.maxMs * 1.1f, ImVec2(0, 80));
+
+	bool paused = clock::IsPaused();
+	if (ImGui::Checkbox("Pause", &paused))
+		clock::SetPaused(paused);
+
+	ImGui::SameLine();
+	float timeScale = clock::GetTimeScale();
+	if (ImGui::SliderFloat("Time scale", &timeScale, 0.0f, 4.0f))
+		clock::SetTimeScale(timeScale);
+
+	ImGui::End();
+}
+
 void mercury_imgui::EndFrame(mercury::ll::graphics::CommandList cmdList)
 {
 	auto &io = ImGui::GetIO();
@@ -283,6 +416,12 @@ void mercury_imgui::EndFrame(mercury::ll::graphics::CommandList cmdList)
 	ImGui::ShowDemoWindow(); // Show demo window! :)
 	//DrawStatisticsWindow();
 
+	if (mercury::Application::GetCurrentApplication()->GetConfig().imgui.showMemoryStats)
+		DrawAllocatorWindow("Graphics Memory", mercury::memory::gGraphicsMemoryAllocator, gGraphicsAllocatorHistory);
+
+	if (mercury::Application::GetCurrentApplication()->GetConfig().imgui.showFrameTiming)
+		DrawFrameTimingWindow();
+
 	   // Optional: Draw a marker at the reported position for visual verification
     // You can add this to your ImGui rendering code
     ImGui::GetForegroundDrawList()->AddCircle(io.MousePos, 3, IM_COL32(255, 0, 0, 255));
@@ -40,6 +40,13 @@ void CommandList::SetPSO(PsoHandle psoID)
 	auto const& p = gAllPSOs[psoID.handle];
 
 	cmdListD3D12->SetPipelineState(p.pso);
+
+	if (p.isCompute)
+	{
+		cmdListD3D12->SetComputeRootSignature(p.rootSignature);
+		return;
+	}
+
 	cmdListD3D12->SetGraphicsRootSignature(p.rootSignature);
 	cmdListD3D12->IASetPrimitiveTopology(p.primitiveTopology);
 }
@@ -50,6 +57,50 @@ void CommandList::Draw(u32 vertexCount, u32 instanceCount, u32 firstVertex, u32
 	cmdListD3D12->DrawInstanced(vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+ID3D12CommandSignature* gDrawIndirectSignature = nullptr;
+
+void CommandList::DrawIndirect(BufferHandle bufferID, size_t offset)
+{
+	static_assert(sizeof(DrawIndirectArguments) == sizeof(D3D12_DRAW_ARGUMENTS));
+
+	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
+
+	if (gDrawIndirectSignature == nullptr)
+	{
+		D3D12_INDIRECT_ARGUMENT_DESC argumentDesc = {};
+		argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+		D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+		signatureDesc.ByteStride = sizeof(D3D12_DRAW_ARGUMENTS);
+		signatureDesc.NumArgumentDescs = 1;
+		signatureDesc.pArgumentDescs = &argumentDesc;
+
+		D3D_CALL(gD3DDevice->CreateCommandSignature(&signatureDesc, nullptr, IID_PPV_ARGS(&gDrawIndirectSignature)));
+	}
+
+	auto& bufferInfo = gAllBuffers[bufferID.handle];
+	TransitionD3DBuffer(cmdListD3D12, bufferInfo, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+	cmdListD3D12->ExecuteIndirect(gDrawIndirectSignature, 1, bufferInfo.resource, offset, nullptr, 0);
+}
+
+void CommandList::Dispatch(u32 groupCountX, u32 groupCountY, u32 groupCountZ)
+{
+	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
+	cmdListD3D12->Dispatch(groupCountX, groupCountY, groupCountZ);
+}
+
+void CommandList::DispatchBarrier()
+{
+	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
+
+	// all UAV accesses, later submissions are ordered by ExecuteCommandLists
+	D3D12_RESOURCE_BARRIER barrier = {};
+	barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+	barrier.UAV.pResource = nullptr;
+	cmdListD3D12->ResourceBarrier(1, &barrier);
+}
+
 void CommandList::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
 {
 	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
@@ -83,7 +134,7 @@ void CommandList::SetIndexBuffer(BufferHandle bufferID)
 	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
 
 	D3D12_INDEX_BUFFER_VIEW view = {};
-	const auto& bmeta = gAllBuffersMeta[bufferID.handle];
+	const auto& bmeta = gAllBuffers[bufferID.handle];
 	view.Format = DXGI_FORMAT_R16_UINT;
 	view.SizeInBytes = static_cast<UINT>(bmeta.size);
 	view.BufferLocation = bmeta.gpuAddress;
@@ -96,7 +147,7 @@ void CommandList::SetVertexBuffer(BufferHandle bufferID, u8 stride, u8 slot, siz
 	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
 
 	D3D12_VERTEX_BUFFER_VIEW view = {};
-	const auto& bmeta = gAllBuffersMeta[bufferID.handle];
+	const auto& bmeta = gAllBuffers[bufferID.handle];
 
 	view.StrideInBytes = stride;
 	view.SizeInBytes = static_cast<UINT>(bmeta.size);
@@ -115,7 +166,12 @@ void CommandList::PushConstants(const void* data, size_t size)
 {
 	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
 
-	cmdListD3D12->SetGraphicsRoot32BitConstants(gAllPSOs[currentPsoID.handle].rootParameterRootConstantIndex, static_cast<UINT>(size / 4), data, 0);
+	const auto& p = gAllPSOs[currentPsoID.handle];
+
+	if (p.isCompute)
+		cmdListD3D12->SetComputeRoot32BitConstants(p.rootParameterRootConstantIndex, static_cast<UINT>(size / 4), data, 0);
+	else
+		cmdListD3D12->SetGraphicsRoot32BitConstants(p.rootParameterRootConstantIndex, static_cast<UINT>(size / 4), data, 0);
 }
 
 void  CommandList::SetParameterBlockLayout(u8 set_index, ParameterBlockLayoutHandle layoutID)
@@ -126,17 +182,26 @@ void  CommandList::SetParameterBlockLayout(u8 set_index, ParameterBlockLayoutHan
 
 
 void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID)
+{
+	// dynamic slots keep the offsets they were written with
+	SetParameterBlock(setIndex, parameterBlockID, {});
+}
+
+void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID, std::span<const u32> dynamicOffsets)
 {
 	u32 slotIndex = 0;
+	size_t nextDynamicOffset = 0;
 	auto cmdListD3D12 = static_cast<ID3D12GraphicsCommandList*>(nativePtr);
-	const auto& pbDesc = gAllParameterBlocks[parameterBlockID.handle];
-	int slotStartIndex = gAllPSOs[currentPsoID.handle].setOffsets[setIndex];
+	const auto& pbInfo = gAllParameterBlocks[parameterBlockID.handle];
+	const auto& pbDesc = pbInfo.desc;
+	const auto& pso = gAllPSOs[currentPsoID.handle];
+	int slotStartIndex = pso.setOffsets[setIndex];
 
 	// Set descriptor heap if there are textures
 	bool hasTextures = false;
 	for (const auto& res : pbDesc.resources)
 	{
-		if (std::holds_alternative<ParameterResourceTexture>(res))
+		if (std::holds_alternative<ParameterResourceTexture>(res) || std::holds_alternative<ParameterResourceTextureTable>(res))
 		{
 			hasTextures = true;
 			break;
@@ -155,11 +220,51 @@ void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterB
 
 				if constexpr (std::is_same_v<T, ParameterResourceBuffer>)
 				{
-					cmdListD3D12->SetGraphicsRootConstantBufferView(slotStartIndex + slotIndex, gAllBuffers[arg.buffer.handle]->GetGPUVirtualAddress());
+					auto& bmeta = gAllBuffers[arg.buffer.handle];
+					const UINT rootIndex = slotStartIndex + slotIndex;
+
+					D3D12_GPU_VIRTUAL_ADDRESS address = bmeta.gpuAddress + arg.offset;
+					if (((pbInfo.dynamicSlots >> slotIndex) & 1) && nextDynamicOffset < dynamicOffsets.size())
+						address += dynamicOffsets[nextDynamicOffset++];
+
+					// the pipeline decides the view, the same buffer can be read in one pipeline and written in another
+					switch (pso.rootParameterTypes[rootIndex])
+					{
+					case D3D12_ROOT_PARAMETER_TYPE_SRV:
+						TransitionD3DBuffer(cmdListD3D12, bmeta, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+						if (pso.isCompute)
+							cmdListD3D12->SetComputeRootShaderResourceView(rootIndex, address);
+						else
+							cmdListD3D12->SetGraphicsRootShaderResourceView(rootIndex, address);
+						break;
+					case D3D12_ROOT_PARAMETER_TYPE_UAV:
+						TransitionD3DBuffer(cmdListD3D12, bmeta, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+						if (pso.isCompute)
+							cmdListD3D12->SetComputeRootUnorderedAccessView(rootIndex, address);
+						else
+							cmdListD3D12->SetGraphicsRootUnorderedAccessView(rootIndex, address);
+						break;
+					default:
+						if (pso.isCompute)
+							cmdListD3D12->SetComputeRootConstantBufferView(rootIndex, address);
+						else
+							cmdListD3D12->SetGraphicsRootConstantBufferView(rootIndex, address);
+						break;
+					}
 				}
 				else if constexpr (std::is_same_v<T, ParameterResourceTexture>)
 				{
-					cmdListD3D12->SetGraphicsRootDescriptorTable(slotStartIndex + slotIndex, gAllTextures[arg.texture.handle].srvGpuHandle);
+					if (pso.isCompute)
+						cmdListD3D12->SetComputeRootDescriptorTable(slotStartIndex + slotIndex, gAllTextures[arg.texture.handle].srvGpuHandle);
+					else
+						cmdListD3D12->SetGraphicsRootDescriptorTable(slotStartIndex + slotIndex, gAllTextures[arg.texture.handle].srvGpuHandle);
+				}
+				else if constexpr (std::is_same_v<T, ParameterResourceTextureTable>)
+				{
+					if (pso.isCompute)
+						cmdListD3D12->SetComputeRootDescriptorTable(slotStartIndex + slotIndex, pbInfo.textureTableGpuHandle);
+					else
+						cmdListD3D12->SetGraphicsRootDescriptorTable(slotStartIndex + slotIndex, pbInfo.textureTableGpuHandle);
 				}
 				else if constexpr (std::is_same_v<T, ParameterResourceRWImage>)
 				{
@@ -32,6 +32,8 @@ bool mercury::ll::graphics::IsYFlipped()
 #include <d3d12shader.h>
 
 #include <wrl/client.h>
+#include <deque>
+#include <unordered_map>
 #include "d3d12_graphics.h"
 #include "d3d12_render_target.h"
 // Include D3D12 Memory Allocator implementation in this translation unit
@@ -48,22 +50,27 @@ ID3D12DescriptorHeap* gDescriptorsHeapRTV = nullptr;
 ID3D12DescriptorHeap* gDescriptorsHeapDSV = nullptr;
 ID3D12DescriptorHeap* gDescriptorsHeapSRV = nullptr;
 UINT gCurrentSRVOffset = 0;
+std::vector<UINT> gFreeSRVSlots; // single descriptors released by DestroyTexture and imgui
+
+constexpr UINT D3D12_SRV_HEAP_SIZE = 16384;
+constexpr UINT D3D12_INVALID_SRV_SLOT = UINT_MAX;
+constexpr UINT D3D12_MAX_TEXTURE_TABLE_SIZE = 2048;
+constexpr size_t D3D12_STAGING_PAGE_SIZE = 1 << 20;
 
 D3D12MA::Allocator* gAllocator = nullptr;
 DXGI_FORMAT gD3DSwapChainFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
 DXGI_FORMAT gD3DSwapChainDepthFormat = DXGI_FORMAT_D32_FLOAT;
 
 // Global storage for shaders, signatures, and PSOs
-std::vector<CD3DX12_SHADER_BYTECODE> gAllShaders;
+SlotMap<ShaderInfo> gAllShaders;
 
-std::vector<PSOInfo> gAllPSOs;
+SlotMap<PSOInfo> gAllPSOs;
 
-std::vector<ID3D12Resource*> gAllBuffers;
-std::vector<BufferInfo> gAllBuffersMeta;
+SlotMap<BufferInfo> gAllBuffers;
 
-std::vector<ParameterBlockDescriptor> gAllParameterBlocks;
+SlotMap<ParameterBlockInfo> gAllParameterBlocks;
 
-std::vector<TextureInfo> gAllTextures;
+SlotMap<TextureInfo> gAllTextures;
 
 Device* gDevice = nullptr;
 Instance* gInstance = nullptr;
@@ -76,6 +83,214 @@ std::vector<FrameData> gFrames;
 
 u32 gFrameRingCurrent = 0;
 
+struct DeferredRelease
+{
+	u64 frameID = 0;
+	std::function<void()> release;
+};
+
+std::deque<DeferredRelease> gDeferredReleases;
+
+void DeferD3DRelease(std::function<void()> release)
+{
+	if (gFrames.empty())
+	{
+		// no swapchain, its shutdown already flushed the frames
+		release();
+		return;
+	}
+
+	gDeferredReleases.push_back({ gFrameID, std::move(release) });
+}
+
+void ReleaseDeferredD3DObjects(bool all)
+{
+	// AcquireNextImage waits on a slot before reusing it, once the frame counter moved a full ring past the
+	// release point every frame that could reference the object has completed
+	while (!gDeferredReleases.empty() && (all || gDeferredReleases.front().frameID + gFrames.size() <= gFrameID))
+	{
+		gDeferredReleases.front().release();
+		gDeferredReleases.pop_front();
+	}
+}
+
+std::unordered_map<ID3D12GraphicsCommandList*, u64> gCommandListRecordings;
+u64 gNextCommandListRecording = 1;
+
+void BeginD3DCommandListRecording(ID3D12GraphicsCommandList* commandList)
+{
+	gCommandListRecordings[commandList] = gNextCommandListRecording++;
+}
+
+void TransitionD3DBuffer(ID3D12GraphicsCommandList* commandList, BufferInfo& buffer, D3D12_RESOURCE_STATES state)
+{
+	if (!buffer.defaultHeap)
+		return;
+
+	const u64 recording = gCommandListRecordings[commandList];
+
+	D3D12_RESOURCE_STATES before = D3D12_RESOURCE_STATE_COMMON;
+	if (buffer.trackedCommandList == commandList && buffer.trackedRecording == recording)
+		before = buffer.trackedState;
+
+	buffer.trackedState = state;
+	buffer.trackedCommandList = commandList;
+	buffer.trackedRecording = recording;
+
+	if (before == state)
+		return;
+
+	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(buffer.resource, before, state);
+	commandList->ResourceBarrier(1, &barrier);
+}
+
+struct StagingPage
+{
+	ID3D12Resource* resource = nullptr;
+	D3D12MA::Allocation* allocation = nullptr;
+	u8* mapped = nullptr;
+	size_t size = 0;
+};
+
+// SubmitOneTimeCommandsList records into a pooled allocator and list, Device::Tick retires the ones the GPU finished
+struct OneTimeSubmitContext
+{
+	ID3D12CommandAllocator* commandAllocator = nullptr;
+	ID3D12GraphicsCommandList* commandList = nullptr;
+	u64 fenceValue = 0; // gOneTimeSubmitFence value signaled after the list, UINT64_MAX while recording
+	bool inUse = false;
+	std::function<void()> onFinish = nullptr;
+
+	// upload heap memory the UpdateBuffer copies read from, reused once the list retires
+	std::vector<StagingPage> stagingPages;
+	size_t stagingPageIndex = 0;
+	size_t stagingPageUsed = 0;
+};
+
+std::vector<OneTimeSubmitContext> gOneTimeSubmitContexts;
+ID3D12Fence* gOneTimeSubmitFence = nullptr;
+HANDLE gOneTimeSubmitFenceEvent = nullptr;
+u64 gOneTimeSubmitFenceValue = 0;
+
+static void RetireOneTimeSubmitContexts()
+{
+	if (!gOneTimeSubmitFence)
+		return;
+
+	const u64 completedValue = gOneTimeSubmitFence->GetCompletedValue();
+
+	// onFinish may submit again and grow the pool, index instead of holding references
+	for (size_t i = 0; i < gOneTimeSubmitContexts.size(); i++)
+	{
+		if (!gOneTimeSubmitContexts[i].inUse || gOneTimeSubmitContexts[i].fenceValue > completedValue)
+			continue;
+
+		auto onFinish = std::move(gOneTimeSubmitContexts[i].onFinish);
+		gOneTimeSubmitContexts[i].onFinish = nullptr;
+		gOneTimeSubmitContexts[i].inUse = false;
+
+		if (onFinish)
+			onFinish();
+	}
+}
+
+static size_t BeginOneTimeSubmitContext()
+{
+	size_t index = 0;
+	while (index < gOneTimeSubmitContexts.size() && gOneTimeSubmitContexts[index].inUse)
+		index++;
+
+	if (index == gOneTimeSubmitContexts.size())
+	{
+		// every list is still in flight, grow the pool instead of waiting for the GPU
+		OneTimeSubmitContext context;
+		D3D_CALL(gD3DDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&context.commandAllocator)));
+		D3D_CALL(gD3DDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, context.commandAllocator, nullptr, IID_PPV_ARGS(&context.commandList)));
+		D3D_CALL(context.commandList->Close());
+		gOneTimeSubmitContexts.push_back(context);
+	}
+
+	auto& context = gOneTimeSubmitContexts[index];
+	context.inUse = true;
+	context.fenceValue = UINT64_MAX;
+	context.stagingPageIndex = 0;
+	context.stagingPageUsed = 0;
+
+	D3D_CALL(context.commandAllocator->Reset());
+	D3D_CALL(context.commandList->Reset(context.commandAllocator, nullptr));
+	BeginD3DCommandListRecording(context.commandList);
+
+	return index;
+}
+
+static void ExecuteOneTimeSubmitContext(size_t index, std::function<void()> onFinish)
+{
+	auto& context = gOneTimeSubmitContexts[index];
+
+	D3D_CALL(context.commandList->Close());
+	ID3D12CommandList* cmdLists[] = { context.commandList };
+	gD3DCommandQueue->ExecuteCommandLists(1, cmdLists);
+
+	context.fenceValue = Signal(gD3DCommandQueue, gOneTimeSubmitFence, gOneTimeSubmitFenceValue);
+	context.onFinish = std::move(onFinish);
+}
+
+static u8* AllocateStaging(OneTimeSubmitContext& context, size_t size, ID3D12Resource*& resource, u64& offset)
+{
+	while (context.stagingPageIndex < context.stagingPages.size())
+	{
+		auto& page = context.stagingPages[context.stagingPageIndex];
+		const size_t pageOffset = mercury::utils::math::alignUp(context.stagingPageUsed, 16);
+		if (pageOffset + size <= page.size)
+		{
+			context.stagingPageUsed = pageOffset + size;
+			resource = page.resource;
+			offset = pageOffset;
+			return page.mapped + pageOffset;
+		}
+
+		context.stagingPageIndex++;
+		context.stagingPageUsed = 0;
+	}
+
+	StagingPage page;
+	page.size = std::max(size, D3D12_STAGING_PAGE_SIZE);
+
+	D3D12MA::ALLOCATION_DESC allocDesc = {};
+	allocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(page.size);
+
+	HRESULT hr = gAllocator->CreateResource(&allocDesc, &bufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+		&page.allocation, IID_PPV_ARGS(&page.resource));
+	if (FAILED(hr))
+	{
+		MLOG_ERROR(u8"Failed to create D3D12 staging page of size %zu bytes: HRESULT=0x%08X", page.size, hr);
+		return nullptr;
+	}
+
+	D3D12_RANGE readRange = { 0, 0 };
+	D3D_CALL(page.resource->Map(0, &readRange, (void**)&page.mapped));
+
+	context.stagingPages.push_back(page);
+	context.stagingPageIndex = context.stagingPages.size() - 1;
+	context.stagingPageUsed = size;
+	resource = page.resource;
+	offset = 0;
+	return page.mapped;
+}
+
+// UpdateBuffer of a default heap buffer copies through here, the list runs before the next frame or one-time submission
+size_t gPendingUploadContext = SIZE_MAX;
+
+void FlushPendingD3DBufferUploads()
+{
+	if (gPendingUploadContext == SIZE_MAX)
+		return;
+
+	ExecuteOneTimeSubmitContext(gPendingUploadContext, nullptr);
+	gPendingUploadContext = SIZE_MAX;
+}
+
 // Add after the global swapchain variables (around line 58)
 UINT gMSAASampleCount = 4; // Default to 4x MSAA
 UINT gMSAAQuality = 0;
@@ -208,8 +423,11 @@ void Device::Initialize()
 
 	D3D_CALL(gD3DDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&gD3DCommandAllocator)));
 
+	D3D_CALL(gD3DDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&gOneTimeSubmitFence)));
+	gOneTimeSubmitFenceEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+
 	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-	desc.NumDescriptors = 4096;
+	desc.NumDescriptors = D3D12_SRV_HEAP_SIZE;
 	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	D3D_CALL(gD3DDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&gDescriptorsHeapSRV)));
@@ -240,12 +458,37 @@ void Device::Shutdown()
 {
 	MLOG_DEBUG(u8"Shutdown Device (D3D12)");
 
+	WaitIdle();
+	RetireOneTimeSubmitContexts();
+	ReleaseDeferredD3DObjects(true);
+
+	for (auto& context : gOneTimeSubmitContexts)
+	{
+		for (auto& page : context.stagingPages)
+		{
+			page.resource->Unmap(0, nullptr);
+			page.resource->Release();
+			page.allocation->Release();
+		}
+
+		context.commandList->Release();
+		context.commandAllocator->Release();
+	}
+	gOneTimeSubmitContexts.clear();
+
+	if (gOneTimeSubmitFence) gOneTimeSubmitFence->Release();
+	gOneTimeSubmitFence = nullptr;
+	if (gOneTimeSubmitFenceEvent) ::CloseHandle(gOneTimeSubmitFenceEvent);
+	gOneTimeSubmitFenceEvent = nullptr;
+
 	if (gDescriptorsHeapSRV) gDescriptorsHeapSRV->Release();
 	gDescriptorsHeapSRV = nullptr;
 }
 
 void Device::Tick()
 {
+	RetireOneTimeSubmitContexts();
+	ReleaseDeferredD3DObjects(false);
 }
 
 void Device::InitializeSwapchain()
@@ -261,24 +504,53 @@ void Device::InitializeSwapchain()
 }
 
 
+/// @brief Takes one descriptor of gDescriptorsHeapSRV, recycled slots first.
+/// @returns D3D12_INVALID_SRV_SLOT when the heap is exhausted
+UINT AllocateSrvSlot()
+{
+	if (!gFreeSRVSlots.empty())
+	{
+		UINT slot = gFreeSRVSlots.back();
+		gFreeSRVSlots.pop_back();
+		return slot;
+	}
+
+	IF_UNLIKELY (gCurrentSRVOffset >= D3D12_SRV_HEAP_SIZE)
+		return D3D12_INVALID_SRV_SLOT;
+
+	return gCurrentSRVOffset++;
+}
+
+/// @brief The caller makes sure no frame in flight still reads the descriptor
+void FreeSrvSlot(UINT slot)
+{
+	MERCURY_ASSERT(slot < gCurrentSRVOffset);
+	gFreeSRVSlots.push_back(slot);
+}
+
 void AllocateSrvDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle)
 {
 	static UINT descriptorSize = gD3DDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
 
+	UINT slot = AllocateSrvSlot();
+	MERCURY_ASSERT(slot != D3D12_INVALID_SRV_SLOT);
+
 	*out_cpu_desc_handle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
 		gDescriptorsHeapSRV->GetCPUDescriptorHandleForHeapStart(),
-		gCurrentSRVOffset,
+		slot,
 		descriptorSize);
 	*out_gpu_desc_handle = CD3DX12_GPU_DESCRIPTOR_HANDLE(
 		gDescriptorsHeapSRV->GetGPUDescriptorHandleForHeapStart(),
-		gCurrentSRVOffset,
+		slot,
 		descriptorSize);
-	gCurrentSRVOffset++;
 }
 
 void FreeSrvDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_desc_handle)
 {
-	// No-op for now
+	static UINT descriptorSize = gD3DDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	UINT slot = static_cast<UINT>((cpu_desc_handle.ptr - gDescriptorsHeapSRV->GetCPUDescriptorHandleForHeapStart().ptr) / descriptorSize);
+	DeferD3DRelease([slot]() { FreeSrvSlot(slot); });
 }
 
 void AllocateSrvDescriptorImgui(ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIPTOR_HANDLE* out_cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE* out_gpu_desc_handle)
@@ -288,7 +560,7 @@ void AllocateSrvDescriptorImgui(ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIP
 
 void FreeSrvDescriptorImgui(ImGui_ImplDX12_InitInfo* info, D3D12_CPU_DESCRIPTOR_HANDLE cpu_desc_handle, D3D12_GPU_DESCRIPTOR_HANDLE gpu_desc_handle)
 {
-	// No-op for now
+	FreeSrvDescriptor(cpu_desc_handle, gpu_desc_handle);
 }
 
 void Device::ImguiInitialize()
@@ -297,7 +569,7 @@ void Device::ImguiInitialize()
 	init_info.CommandQueue = gD3DCommandQueue;
 	init_info.Device = gD3DDevice;
 	init_info.SrvDescriptorHeap = gDescriptorsHeapSRV;
-	init_info.NumFramesInFlight = 3;
+	init_info.NumFramesInFlight = Swapchain::NumFramesInFlight;
 	init_info.RTVFormat = gD3DSwapChainFormat;
 	init_info.DSVFormat = gD3DSwapChainDepthFormat;
 	init_info.SrvDescriptorAllocFn = &AllocateSrvDescriptorImgui;
@@ -386,69 +658,59 @@ void CommandPool::Reset()
 ShaderHandle Device::CreateShaderModule(const ShaderBytecodeView& bytecode)
 {
 	ShaderHandle result;
-	result.handle = static_cast<u32>(gAllShaders.size());
-	gAllShaders.emplace_back(bytecode.data, bytecode.size);
+	result.handle = gAllShaders.Emplace(ShaderInfo{ CD3DX12_SHADER_BYTECODE(bytecode.data, bytecode.size) });
 	return result;
 }
 
 void Device::UpdateShaderModule(ShaderHandle shaderModuleID, const ShaderBytecodeView& bytecode)
 {
-	gAllShaders[shaderModuleID.handle] = CD3DX12_SHADER_BYTECODE(bytecode.data, bytecode.size);
-}
+	auto& shader = gAllShaders[shaderModuleID.handle];
 
-void Device::DestroyShaderModule(ShaderHandle shaderModuleID)
-{
-	// In D3D12, shader bytecode is just data, no explicit cleanup needed
-}
+	if (shader.compiled)
+	{
+		shader.compiled->Release();
+		shader.compiled = nullptr;
+	}
 
-void DebugShaderReflection(const mercury::ll::graphics::RasterizePipelineDescriptor& desc);
+	shader.bytecode = CD3DX12_SHADER_BYTECODE(bytecode.data, bytecode.size);
+}
 
-PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::RasterizePipelineDescriptor& desc)
+void Device::DestroyShaderModule(ShaderHandle shaderModuleID)
 {
-	// TODO: Implement full D3D12 rasterize pipeline creation
-	PsoHandle result;
-	result.handle = static_cast<u32>(gAllPSOs.size());
+	// In D3D12, shader bytecode is just data, only shaders compiled from source own a blob
+	auto& shader = gAllShaders[shaderModuleID.handle];
 
-	auto& pso = gAllPSOs.emplace_back();
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+	if (shader.compiled)
+		shader.compiled->Release();
 
-	D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+	gAllShaders.Remove(shaderModuleID.handle);
+}
 
-	if (!desc.verticesInputInfo.empty())
-	{
-		rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-	}
+// Embedded shaders the engine ships as HLSL source are compiled here, the stage is only known once a pipeline uses them.
+const D3D12_SHADER_BYTECODE& GetShaderBytecode(ShaderHandle shaderModuleID, const wchar_t* profile)
+{
+	auto& shader = gAllShaders[shaderModuleID.handle];
 
-	if (desc.vertexShader.isValid())
-	{
-		psoDesc.VS = gAllShaders[desc.vertexShader.handle];
-	}
+	if (shader.compiled || IsShaderBytecodeContainer(shader.bytecode))
+		return shader.bytecode;
 
-	if (desc.tessControlShader.isValid())
-	{
-		psoDesc.HS = gAllShaders[desc.tessControlShader.handle];
-	}
+	shader.compiled = CompileHlslShader(shader.bytecode, profile);
 
-	if (desc.tessEvalShader.isValid())
-	{
-		psoDesc.DS = gAllShaders[desc.tessEvalShader.handle];
-	}
+	if (shader.compiled)
+		shader.bytecode = CD3DX12_SHADER_BYTECODE(shader.compiled->GetBufferPointer(), shader.compiled->GetBufferSize());
+	else
+		shader.bytecode = CD3DX12_SHADER_BYTECODE(nullptr, 0);
 
-	if (desc.geometryShader.isValid())
-	{
-		psoDesc.GS = gAllShaders[desc.geometryShader.handle];
-	}
+	return shader.bytecode;
+}
 
-	if (desc.fragmentShader.isValid())
-	{
-		psoDesc.PS = gAllShaders[desc.fragmentShader.handle];
-	}
+void DebugShaderReflection(const mercury::ll::graphics::RasterizePipelineDescriptor& desc);
 
+void CreatePipelineRootSignature(const PipelineBindingLayoutDescriptor& desc, D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags, PSOInfo& pso)
+{
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
 
 	std::vector<CD3DX12_ROOT_PARAMETER> rootParameters;
-	
-	DebugShaderReflection(desc);
 
 	if (desc.pushConstantSize > 0)
 	{
@@ -461,6 +723,9 @@ PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::Rasterize
 
 	std::vector<D3D12_STATIC_SAMPLER_DESC> staticSamplers;
 
+	// referenced by the descriptor table root parameters until the root signature is serialized
+	std::deque<CD3DX12_DESCRIPTOR_RANGE> descriptorRanges;
+
 	for (int i = 0; i < 3; ++i)
 	{
 		auto& bs_layout = desc.bindingSetLayouts[i];
@@ -471,21 +736,45 @@ PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::Rasterize
 		{
 			const auto& slot = bs_layout.allSlots[j];
 
-			if (slot.resourceType == ShaderResourceType::UniformBuffer)
+			// dynamic offsets are applied to the root CBV address at bind time
+			if (slot.resourceType == ShaderResourceType::UniformBuffer || slot.resourceType == ShaderResourceType::DynamicUniformBuffer)
 			{
 				CD3DX12_ROOT_PARAMETER rootParam;
 				rootParam.InitAsConstantBufferView(j, i + (desc.pushConstantSize > 0), D3D12_SHADER_VISIBILITY_ALL);
 				rootParameters.push_back(rootParam);
 			}
 
+			if (slot.resourceType == ShaderResourceType::ReadOnlyBuffer)
+			{
+				CD3DX12_ROOT_PARAMETER rootParam;
+				rootParam.InitAsShaderResourceView(j, i + (desc.pushConstantSize > 0), D3D12_SHADER_VISIBILITY_ALL);
+				rootParameters.push_back(rootParam);
+			}
+
+			if (slot.resourceType == ShaderResourceType::RWBuffer)
+			{
+				CD3DX12_ROOT_PARAMETER rootParam;
+				rootParam.InitAsUnorderedAccessView(j, i + (desc.pushConstantSize > 0), D3D12_SHADER_VISIBILITY_ALL);
+				rootParameters.push_back(rootParam);
+			}
+
 			if (slot.resourceType == ShaderResourceType::SampledImage2D)
 			{
-				CD3DX12_DESCRIPTOR_RANGE srvRange;
+				auto& srvRange = descriptorRanges.emplace_back();
 				srvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, j, i + (desc.pushConstantSize > 0));
 				CD3DX12_ROOT_PARAMETER rootParam;
 				rootParam.InitAsDescriptorTable(1, &srvRange);
 				rootParameters.push_back(rootParam);
 			}
+
+			if (slot.resourceType == ShaderResourceType::SampledImage2DTable)
+			{
+				auto& srvRange = descriptorRanges.emplace_back();
+				srvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, j, i + (desc.pushConstantSize > 0)); // unbounded, shaders declare Texture2D[]
+				CD3DX12_ROOT_PARAMETER rootParam;
+				rootParam.InitAsDescriptorTable(1, &srvRange);
+				rootParameters.push_back(rootParam);
+			}
 		}
 	}
 
@@ -495,7 +784,7 @@ PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::Rasterize
 	{
 		for (const auto& slot : desc.bindingSetLayouts[i].allSlots)
 		{
-			if (slot.resourceType == ShaderResourceType::SampledImage2D)
+			if (slot.resourceType == ShaderResourceType::SampledImage2D || slot.resourceType == ShaderResourceType::SampledImage2DTable)
 			{
 				hasTextures = true;
 				break;
@@ -521,6 +810,11 @@ PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::Rasterize
 		sdesc.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 	}
 
+	for (const auto& rootParam : rootParameters)
+	{
+		pso.rootParameterTypes.push_back(rootParam.ParameterType);
+	}
+
 	rootSignatureDesc.Init(static_cast<UINT>(rootParameters.size()), rootParameters.data(), staticSamplers.size(), staticSamplers.data(), rootSignatureFlags);
 
 	ID3DBlob* signature = nullptr;
@@ -530,11 +824,57 @@ PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::Rasterize
 
 	D3D_CALL(gD3DDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&pso.rootSignature)));
 
-	psoDesc.pRootSignature = pso.rootSignature;
-
 	// Release the blob as it's no longer needed
 	signature->Release();
 	if (error) error->Release();
+}
+
+PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::RasterizePipelineDescriptor& desc)
+{
+	// TODO: Implement full D3D12 rasterize pipeline creation
+	PsoHandle result;
+	result.handle = gAllPSOs.Emplace();
+
+	auto& pso = gAllPSOs[result.handle];
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
+
+	D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+
+	if (!desc.verticesInputInfo.empty())
+	{
+		rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+	}
+
+	if (desc.vertexShader.isValid())
+	{
+		psoDesc.VS = GetShaderBytecode(desc.vertexShader, L"vs_6_0");
+	}
+
+	if (desc.tessControlShader.isValid())
+	{
+		psoDesc.HS = GetShaderBytecode(desc.tessControlShader, L"hs_6_0");
+	}
+
+	if (desc.tessEvalShader.isValid())
+	{
+		psoDesc.DS = GetShaderBytecode(desc.tessEvalShader, L"ds_6_0");
+	}
+
+	if (desc.geometryShader.isValid())
+	{
+		psoDesc.GS = GetShaderBytecode(desc.geometryShader, L"gs_6_0");
+	}
+
+	if (desc.fragmentShader.isValid())
+	{
+		psoDesc.PS = GetShaderBytecode(desc.fragmentShader, L"ps_6_0");
+	}
+
+	DebugShaderReflection(desc);
+
+	CreatePipelineRootSignature(desc, rootSignatureFlags, pso);
+
+	psoDesc.pRootSignature = pso.rootSignature;
 	
 	std::vector<D3D12_INPUT_ELEMENT_DESC> vtxInputElements;
 	u32 vertexAttribOffset = 0;
@@ -569,6 +909,17 @@ PsoHandle Device::CreateRasterizePipeline(const mercury::ll::graphics::Rasterize
 	psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
 
 	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	if (desc.blendMode == BlendMode::AlphaBlend)
+	{
+		D3D12_RENDER_TARGET_BLEND_DESC& rtBlend = psoDesc.BlendState.RenderTarget[0];
+		rtBlend.BlendEnable = TRUE;
+		rtBlend.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+		rtBlend.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+		rtBlend.BlendOp = D3D12_BLEND_OP_ADD;
+		rtBlend.SrcBlendAlpha = D3D12_BLEND_ONE;
+		rtBlend.DestBlendAlpha = D3D12_BLEND_INV_SRC_ALPHA;
+		rtBlend.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+	}
 	//psoDesc.DepthStencilState.DepthEnable = FALSE;
 	//psoDesc.DepthStencilState.StencilEnable = FALSE;
 	psoDesc.SampleMask = UINT_MAX;
@@ -601,6 +952,33 @@ void Device::DestroyRasterizePipeline(PsoHandle psoID)
 
 	gAllPSOs[psoID.handle].rootSignature->Release();
 	gAllPSOs[psoID.handle].rootSignature = nullptr;
+
+	gAllPSOs.Remove(psoID.handle);
+}
+
+PsoHandle Device::CreateComputePipeline(const ComputePipelineDescriptor& desc)
+{
+	PsoHandle result;
+	result.handle = gAllPSOs.Emplace();
+
+	auto& pso = gAllPSOs[result.handle];
+	pso.isCompute = true;
+
+	CreatePipelineRootSignature(desc, D3D12_ROOT_SIGNATURE_FLAG_NONE, pso);
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
+	psoDesc.pRootSignature = pso.rootSignature;
+	psoDesc.CS = GetShaderBytecode(desc.computeShader, L"cs_6_0");
+
+	D3D_CALL(gD3DDevice->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&pso.pso)));
+
+	return result;
+}
+
+void Device::DestroyComputePipeline(PsoHandle psoID)
+{
+	// compute and graphics pipelines share gAllPSOs
+	DestroyRasterizePipeline(psoID);
 }
 
 CommandPool Device::CreateCommandPool(QueueType queue_type)
@@ -622,10 +1000,16 @@ TimelineSemaphore Device::CreateTimelineSemaphore(mercury::u64 initial_value)
 
 void Device::WaitIdle()
 {
+	FlushPendingD3DBufferUploads();
+
 	for (auto& frame : gFrames)
 	{
 		Flush(gD3DCommandQueue, frame.fence, frame.fenceValue, frame.fenceEvent);
 	}
+
+	// one-time submissions can be in flight without a swapchain
+	if (gOneTimeSubmitFence)
+		Flush(gD3DCommandQueue, gOneTimeSubmitFence, gOneTimeSubmitFenceValue, gOneTimeSubmitFenceEvent);
 }
 
 void Device::WaitQueueIdle(QueueType queue_type)
@@ -646,7 +1030,6 @@ void Device::SetDebugName(const char* utf8_name)
 BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 {
 	BufferHandle result;
-	result.handle = static_cast<u32>(gAllBuffers.size());
 
 	auto size = desc.size;
 
@@ -666,8 +1049,6 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	{
 		MLOG_ERROR(u8"D3D12MA::Allocator is not initialized!");
 		result.handle = BufferHandle::InvalidValue;
-		gAllBuffersMeta.push_back(BufferInfo{});
-		gAllBuffers.push_back(nullptr);
 		return result;
 	}
 
@@ -676,8 +1057,6 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	{
 		MLOG_ERROR(u8"Cannot create buffer with size 0");
 		result.handle = BufferHandle::InvalidValue;
-		gAllBuffersMeta.push_back(BufferInfo{});
-		gAllBuffers.push_back(nullptr);
 		return result;
 	}
 
@@ -698,6 +1077,14 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	allocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
 	allocDesc.Flags = D3D12MA::ALLOCATION_FLAG_NONE;
 
+	// compute writes storage and indirect buffers, which needs UAV access the upload heap can't give
+	const bool defaultHeap = desc.type == BufferType::StorageBuffer || desc.type == BufferType::IndirectBuffer;
+	if (defaultHeap)
+	{
+		allocDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+		bufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	}
+
 	BufferInfo bufferInfo = {};
 	ID3D12Resource* bufferResource = nullptr;
 	bufferInfo.size = size;
@@ -713,6 +1100,11 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	{
 		initialState = D3D12_RESOURCE_STATE_INDEX_BUFFER;
 	}
+	else if (defaultHeap)
+	{
+		// promoted implicitly by the first copy or view, TransitionD3DBuffer takes over inside a recording
+		initialState = D3D12_RESOURCE_STATE_COMMON;
+	}
 
 	HRESULT hr = gAllocator->CreateResource(
 		&allocDesc,
@@ -727,12 +1119,10 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	{
 		MLOG_ERROR(u8"Failed to create D3D12 buffer of size %zu bytes: HRESULT=0x%08X", size, hr);
 		result.handle = BufferHandle::InvalidValue;
-		gAllBuffersMeta.push_back(BufferInfo{});
-		gAllBuffers.push_back(nullptr);
 		return result;
 	}
 
-	if (desc.initialData)
+	if (desc.initialData && !defaultHeap)
 	{
 		void* mappedData = nullptr;
 		D3D12_RANGE readRange = { 0, 0 };
@@ -742,51 +1132,59 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 		bufferResource->Unmap(0, &writtenRange);
 	}
 
-	MLOG_DEBUG(u8"Created D3D12 buffer: handle=%u, size=%zu bytes", result.handle, size);
+	bufferInfo.resource = bufferResource;
 	bufferInfo.gpuAddress = bufferResource->GetGPUVirtualAddress();
-	gAllBuffersMeta.push_back(bufferInfo);
-	gAllBuffers.push_back(bufferResource);
+	bufferInfo.type = desc.type;
+	bufferInfo.defaultHeap = defaultHeap;
+	result.handle = gAllBuffers.Emplace(bufferInfo);
+
+	if (desc.initialData && defaultHeap)
+		UpdateBuffer(result, desc.initialData, desc.size, 0);
+
+	MLOG_DEBUG(u8"Created D3D12 buffer: handle=%u, size=%zu bytes", result.handle, size);
 
 	return result;
 }
 
 void Device::DestroyBuffer(BufferHandle bufferID)
 {
-	if (!bufferID.isValid() || bufferID.handle >= gAllBuffers.size())
+	if (!gAllBuffers.Contains(bufferID.handle))
 	{
 		MLOG_WARNING(u8"Attempting to destroy invalid buffer handle: %u", bufferID.handle);
 		return;
 	}
 
-	BufferInfo& bufferInfo = gAllBuffersMeta[bufferID.handle];
-	ID3D12Resource* bufferResource = gAllBuffers[bufferID.handle];
+	BufferInfo& bufferInfo = gAllBuffers[bufferID.handle];
 
-	if (bufferResource)
-	{
-		bufferResource->Release();
-	}
+	DeferD3DRelease([resource = bufferInfo.resource, allocation = bufferInfo.allocation, mapped = bufferInfo.persistentMappedPtr != nullptr]()
+		{
+			if (resource)
+			{
+				if (mapped)
+					resource->Unmap(0, nullptr);
 
-	if (bufferInfo.allocation)
-	{
-		bufferInfo.allocation->Release();
-		bufferInfo.allocation = nullptr;
-	}
+				resource->Release();
+			}
+
+			if (allocation)
+				allocation->Release();
+		});
 
-	bufferInfo.size = 0;
+	gAllBuffers.Remove(bufferID.handle);
 
 	MLOG_DEBUG(u8"Destroyed D3D12 buffer: handle=%u", bufferID.handle);
 }
 
 void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size, size_t offset)
 {
-	if (!bufferID.isValid() || bufferID.handle >= gAllBuffers.size())
+	if (!gAllBuffers.Contains(bufferID.handle))
 	{
 		MLOG_ERROR(u8"Attempting to update invalid buffer handle: %u", bufferID.handle);
 		return;
 	}
 
-	BufferInfo& bufferInfo = gAllBuffersMeta[bufferID.handle];
-	ID3D12Resource* bufferResource = gAllBuffers[bufferID.handle];
+	BufferInfo& bufferInfo = gAllBuffers[bufferID.handle];
+	ID3D12Resource* bufferResource = bufferInfo.resource;
 
 	if (!bufferResource)
 	{
@@ -802,6 +1200,25 @@ void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size,
 		return;
 	}
 
+	if (bufferInfo.defaultHeap)
+	{
+		// the copy lands before the next frame or one-time submission, like a queue write on the other backends
+		if (gPendingUploadContext == SIZE_MAX)
+			gPendingUploadContext = BeginOneTimeSubmitContext();
+
+		auto& context = gOneTimeSubmitContexts[gPendingUploadContext];
+
+		ID3D12Resource* stagingResource = nullptr;
+		u64 stagingOffset = 0;
+		u8* staging = AllocateStaging(context, size, stagingResource, stagingOffset);
+		if (staging == nullptr)
+			return;
+
+		memcpy(staging, data, size);
+		context.commandList->CopyBufferRegion(bufferResource, offset, stagingResource, stagingOffset, size);
+		return;
+	}
+
 	void* mappedData = nullptr;
 	D3D12_RANGE readRange = { 0, 0 };
 	HRESULT hr = bufferResource->Map(0, &readRange, &mappedData);
@@ -810,14 +1227,78 @@ void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size,
 	bufferResource->Unmap(0, &writtenRange);
 }
 
+void* Device::GetMappedBufferPointer(BufferHandle bufferID)
+{
+	if (!gAllBuffers.Contains(bufferID.handle))
+	{
+		MLOG_ERROR(u8"GetMappedBufferPointer: invalid buffer handle: %u", bufferID.handle);
+		return nullptr;
+	}
+
+	BufferInfo& bufferInfo = gAllBuffers[bufferID.handle];
+
+	// default heap memory isn't CPU visible, callers fall back to UpdateBuffer
+	if (bufferInfo.defaultHeap)
+		return nullptr;
+
+	if (bufferInfo.persistentMappedPtr == nullptr)
+	{
+		// the remaining buffers live on the upload heap, which may stay mapped while the GPU reads it
+		D3D12_RANGE readRange = { 0, 0 };
+		HRESULT hr = bufferInfo.resource->Map(0, &readRange, &bufferInfo.persistentMappedPtr);
+		if (FAILED(hr))
+		{
+			MLOG_ERROR(u8"Failed to map D3D12 buffer %u: HRESULT=0x%08X", bufferID.handle, hr);
+			bufferInfo.persistentMappedPtr = nullptr;
+		}
+	}
+
+	return bufferInfo.persistentMappedPtr;
+}
+
+void Device::FlushBuffer(BufferHandle bufferID, size_t offset, size_t size)
+{
+	// upload heap memory is write combined and coherent, nothing to flush
+}
+
 ParameterBlockLayoutHandle Device::CreateParameterBlockLayout(const BindingSetLayoutDescriptor& layoutDesc, int setIndex)
 {
 	std::vector<CD3DX12_ROOT_PARAMETER> rootParameters;
+	std::deque<CD3DX12_DESCRIPTOR_RANGE> descriptorRanges;
+	u32 textureTableSize = 0;
+	u64 dynamicSlots = 0;
 
 	for (int i = 0; i < layoutDesc.allSlots.size(); ++i)
 	{
+		const auto& slot = layoutDesc.allSlots[i];
 		CD3DX12_ROOT_PARAMETER rootParam2;
-		rootParam2.InitAsConstantBufferView(i, setIndex, D3D12_SHADER_VISIBILITY_ALL);
+		if (slot.resourceType == ShaderResourceType::DynamicUniformBuffer)
+		{
+			MERCURY_ASSERT(i < 64);
+			dynamicSlots |= 1ull << i;
+		}
+
+		if (slot.resourceType == ShaderResourceType::ReadOnlyBuffer)
+		{
+			rootParam2.InitAsShaderResourceView(i, setIndex, D3D12_SHADER_VISIBILITY_ALL);
+		}
+		else if (slot.resourceType == ShaderResourceType::RWBuffer)
+		{
+			rootParam2.InitAsUnorderedAccessView(i, setIndex, D3D12_SHADER_VISIBILITY_ALL);
+		}
+		else if (slot.resourceType == ShaderResourceType::SampledImage2DTable)
+		{
+			MERCURY_ASSERT(textureTableSize == 0); // one table per parameter block
+			textureTableSize = slot.arraySize;
+
+			auto& srvRange = descriptorRanges.emplace_back();
+			srvRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, i, setIndex); // unbounded, shaders declare Texture2D[]
+			rootParam2.InitAsDescriptorTable(1, &srvRange);
+		}
+		else
+		{
+			rootParam2.InitAsConstantBufferView(i, setIndex, D3D12_SHADER_VISIBILITY_ALL);
+		}
 		rootParameters.push_back(rootParam2);
 	}
 
@@ -838,37 +1319,105 @@ ParameterBlockLayoutHandle Device::CreateParameterBlockLayout(const BindingSetLa
 	signature->Release();
 	if (error) error->Release();
 
-	auto &pso = gAllPSOs.emplace_back();
+	PSOInfo pso = {};
 	pso.rootSignature = rootSignature;
+	pso.textureTableSize = textureTableSize;
+	pso.dynamicSlots = dynamicSlots;
 
 	ParameterBlockLayoutHandle result;
-	result.handle = static_cast<u32>(gAllPSOs.size() - 1);
+	result.handle = gAllPSOs.Emplace(pso);
 	return result;
 }
 
 void Device::DestroyParameterBlockLayout(ParameterBlockLayoutHandle layoutID)
 {
 	gAllPSOs[layoutID.handle].rootSignature->Release();	
+	gAllPSOs.Remove(layoutID.handle);
 }
 
 
 
+u32 Device::GetMaxTextureTableSize()
+{
+	// tier 1 caps a stage at 128 SRVs in total, not worth a table
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	if (FAILED(gD3DDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))))
+		return 0;
+
+	return options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2 ? D3D12_MAX_TEXTURE_TABLE_SIZE : 0;
+}
+
 ParameterBlockHandle Device::CreateParameterBlock(const ParameterBlockLayoutHandle& layoutID)
 {
-	auto& ds = gAllParameterBlocks.emplace_back();
+	ParameterBlockInfo info = {};
+	info.textureTableSize = gAllPSOs[layoutID.handle].textureTableSize;
+	info.dynamicSlots = gAllPSOs[layoutID.handle].dynamicSlots;
 
-	return ParameterBlockHandle{ static_cast<u32>(gAllParameterBlocks.size() - 1) };
+	if (info.textureTableSize > 0)
+	{
+		IF_UNLIKELY (gCurrentSRVOffset + info.textureTableSize > D3D12_SRV_HEAP_SIZE)
+		{
+			MLOG_ERROR(u8"SRV heap exhausted, cannot reserve a texture table of %u entries", info.textureTableSize);
+			return ParameterBlockHandle{ ParameterBlockHandle::InvalidValue };
+		}
+
+		auto descriptorSize = gD3DDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+		info.textureTableCpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
+			gDescriptorsHeapSRV->GetCPUDescriptorHandleForHeapStart(),
+			gCurrentSRVOffset,
+			descriptorSize);
+		info.textureTableGpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(
+			gDescriptorsHeapSRV->GetGPUDescriptorHandleForHeapStart(),
+			gCurrentSRVOffset,
+			descriptorSize);
+
+		// tables need a contiguous range, they are carved from the linear end and are not recycled yet
+		gCurrentSRVOffset += info.textureTableSize;
+	}
+
+	return ParameterBlockHandle{ gAllParameterBlocks.Emplace(info) };
 }
 
 void Device::UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const ParameterBlockDescriptor& pbDesc)
 {
-	gAllParameterBlocks[parameterBlockID.handle] = pbDesc;
+	ParameterBlockInfo& info = gAllParameterBlocks[parameterBlockID.handle];
+	info.desc = pbDesc;
+
+	auto descriptorSize = gD3DDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	for (const auto& res : pbDesc.resources)
+	{
+		const auto* table = std::get_if<ParameterResourceTextureTable>(&res);
+		if (table == nullptr)
+			continue;
+
+		MERCURY_ASSERT(table->firstElement + table->textures.size() <= info.textureTableSize);
+
+		// shader visible heaps are slow to read back, so views are recreated instead of copied
+		for (size_t t = 0; t < table->textures.size(); ++t)
+		{
+			auto dstHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
+				info.textureTableCpuHandle,
+				static_cast<INT>(table->firstElement + t),
+				descriptorSize);
+
+			gD3DDevice->CreateShaderResourceView(gAllTextures[table->textures[t].handle].resource, nullptr, dstHandle);
+		}
+	}
 }
 
 TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 {
 	TextureInfo texInfo = {};
 
+	texInfo.srvSlot = AllocateSrvSlot();
+	IF_UNLIKELY (texInfo.srvSlot == D3D12_INVALID_SRV_SLOT)
+	{
+		MLOG_ERROR(u8"SRV heap exhausted, cannot create a %ux%u texture", desc.width, desc.height);
+		return TextureHandle{};
+	}
+
 	D3D12_RESOURCE_DESC textureDesc = {};
 	textureDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 	textureDesc.Alignment = 0;
@@ -1023,11 +1572,11 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 
 	auto srvCpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(
 		gDescriptorsHeapSRV->GetCPUDescriptorHandleForHeapStart(),
-		gCurrentSRVOffset,
+		texInfo.srvSlot,
 		descriptorSize);
 	auto srvGpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(
 		gDescriptorsHeapSRV->GetGPUDescriptorHandleForHeapStart(),
-		gCurrentSRVOffset,
+		texInfo.srvSlot,
 		descriptorSize);
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
@@ -1043,18 +1592,188 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 	texInfo.srvHandle = srvCpuHandle;
 	texInfo.srvGpuHandle = srvGpuHandle;
 
-	gAllTextures.push_back(texInfo);
-
-	gCurrentSRVOffset++;
-
 	TextureHandle result;
-	result.handle = static_cast<u32>(gAllTextures.size() - 1);
+	result.handle = gAllTextures.Emplace(texInfo);
 	return result;
 }
 
+void Device::DestroyTexture(TextureHandle textureID)
+{
+	auto* texInfo = gAllTextures.Get(textureID.handle);
+	if (texInfo == nullptr)
+	{
+		MLOG_WARNING(u8"Attempting to destroy invalid texture handle: %u", textureID.handle);
+		return;
+	}
+
+	// the descriptor goes back to the free list with the resource, once no frame in flight can sample it
+	DeferD3DRelease([resource = texInfo->resource, allocation = texInfo->allocation, srvSlot = texInfo->srvSlot]()
+		{
+			if (resource)
+				resource->Release();
+
+			if (allocation)
+				allocation->Release();
+
+			FreeSrvSlot(srvSlot);
+		});
+
+	gAllTextures.Remove(textureID.handle);
+}
+
+void Device::UpdateSubregionTexture(
+	TextureHandle textureID,
+	size_t x,
+	size_t y,
+	size_t z,
+	size_t width,
+	size_t height,
+	size_t depth,
+	const void* data,
+	size_t dataSize)
+{
+	auto* texInfo = gAllTextures.Get(textureID.handle);
+	if (texInfo == nullptr)
+	{
+		MLOG_WARNING(u8"Attempting to update invalid texture handle: %u", textureID.handle);
+		return;
+	}
+
+	// Assuming RGBA8, copy footprints need 256 byte aligned rows
+	const size_t srcRowPitch = width * 4;
+	const size_t rowPitch = (srcRowPitch + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~size_t(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+	const size_t stagingSize = rowPitch * height * depth;
+
+	MERCURY_ASSERT(dataSize >= srcRowPitch * height * depth);
+
+	D3D12_RESOURCE_DESC stagingDesc = {};
+	stagingDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	stagingDesc.Alignment = 0;
+	stagingDesc.Width = stagingSize;
+	stagingDesc.Height = 1;
+	stagingDesc.DepthOrArraySize = 1;
+	stagingDesc.MipLevels = 1;
+	stagingDesc.Format = DXGI_FORMAT_UNKNOWN;
+	stagingDesc.SampleDesc.Count = 1;
+	stagingDesc.SampleDesc.Quality = 0;
+	stagingDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	stagingDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+	D3D12MA::ALLOCATION_DESC stagingAllocDesc = {};
+	stagingAllocDesc.HeapType = D3D12_HEAP_TYPE_UPLOAD;
+	stagingAllocDesc.Flags = D3D12MA::ALLOCATION_FLAG_NONE;
+
+	D3D12MA::Allocation* stagingAllocation = nullptr;
+	ID3D12Resource* stagingBuffer = nullptr;
+	HRESULT hr = gAllocator->CreateResource(
+		&stagingAllocDesc,
+		&stagingDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		&stagingAllocation,
+		IID_PPV_ARGS(&stagingBuffer)
+	);
+	if (FAILED(hr))
+	{
+		MLOG_ERROR(u8"Failed to create staging buffer for texture subregion upload: HRESULT=0x%08X", hr);
+		return;
+	}
+
+	void* mappedData = nullptr;
+	D3D12_RANGE readRange = { 0, 0 };
+	hr = stagingBuffer->Map(0, &readRange, &mappedData);
+	if (SUCCEEDED(hr))
+	{
+		const u8* srcRows = static_cast<const u8*>(data);
+		u8* dstRows = static_cast<u8*>(mappedData);
+		for (size_t row = 0; row < height * depth; ++row)
+			memcpy(dstRows + row * rowPitch, srcRows + row * srcRowPitch, srcRowPitch);
+
+		D3D12_RANGE writtenRange = { 0, stagingSize };
+		stagingBuffer->Unmap(0, &writtenRange);
+
+		ID3D12CommandAllocator* tempAllocator = nullptr;
+		ID3D12GraphicsCommandList* tempCmdList = nullptr;
+		hr = gD3DDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&tempAllocator));
+		if (SUCCEEDED(hr))
+		{
+			hr = gD3DDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, tempAllocator, nullptr, IID_PPV_ARGS(&tempCmdList));
+			if (SUCCEEDED(hr))
+			{
+				D3D12_RESOURCE_BARRIER barrier = {};
+				barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+				barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				barrier.Transition.pResource = texInfo->resource;
+				barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+				barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COMMON;
+				barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
+				tempCmdList->ResourceBarrier(1, &barrier);
+
+				D3D12_TEXTURE_COPY_LOCATION src = {};
+				src.pResource = stagingBuffer;
+				src.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+				src.PlacedFootprint.Offset = 0;
+				src.PlacedFootprint.Footprint.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+				src.PlacedFootprint.Footprint.Width = static_cast<UINT>(width);
+				src.PlacedFootprint.Footprint.Height = static_cast<UINT>(height);
+				src.PlacedFootprint.Footprint.Depth = static_cast<UINT>(depth);
+				src.PlacedFootprint.Footprint.RowPitch = static_cast<UINT>(rowPitch);
+
+				D3D12_TEXTURE_COPY_LOCATION dst = {};
+				dst.pResource = texInfo->resource;
+				dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+				dst.SubresourceIndex = 0;
+
+				tempCmdList->CopyTextureRegion(&dst, static_cast<UINT>(x), static_cast<UINT>(y), static_cast<UINT>(z), &src, nullptr);
+
+				barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+				barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_COMMON;
+				tempCmdList->ResourceBarrier(1, &barrier);
+
+				tempCmdList->Close();
+				ID3D12CommandList* cmdLists[] = { tempCmdList };
+				gD3DCommandQueue->ExecuteCommandLists(1, cmdLists);
+
+				// Wait for completion, the staging buffer is released right after
+				ID3D12Fence* tempFence = nullptr;
+				gD3DDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&tempFence));
+				gD3DCommandQueue->Signal(tempFence, 1);
+				if (tempFence->GetCompletedValue() < 1)
+				{
+					HANDLE event = CreateEvent(NULL, FALSE, FALSE, NULL);
+					tempFence->SetEventOnCompletion(1, event);
+					WaitForSingleObject(event, INFINITE);
+					CloseHandle(event);
+				}
+				tempFence->Release();
+				tempCmdList->Release();
+			}
+			tempAllocator->Release();
+		}
+	}
+	stagingBuffer->Release();
+	stagingAllocation->Release();
+}
+
 void Device::DestroyParameterBlock(ParameterBlockHandle parameterBlockID)
 {
+	gAllParameterBlocks.Remove(parameterBlockID.handle);
+}
+
+void Device::SubmitOneTimeCommandsList(std::function<void(CommandList& cmdList)> recordCommands, std::function<void()> onFinish)
+{
+	// the commands may read upload ring ranges and buffer copies written earlier this frame
+	FlushUploads();
+	FlushPendingD3DBufferUploads();
+
+	const size_t contextIndex = BeginOneTimeSubmitContext();
+
+	CommandList cmdList;
+	cmdList.nativePtr = gOneTimeSubmitContexts[contextIndex].commandList;
+	recordCommands(cmdList);
 
+	// onFinish runs from Device::Tick once the GPU passed the signaled value
+	ExecuteOneTimeSubmitContext(contextIndex, std::move(onFinish));
 }
 
 u64 TextureHandle::CreateImguiTextureOpaqueHandle() const
@@ -1068,12 +1787,12 @@ void DebugShaderReflection(const mercury::ll::graphics::RasterizePipelineDescrip
 {
 	if (desc.vertexShader.isValid())
 	{
-		auto& vsBytecode = gAllShaders[desc.vertexShader.handle];
+		auto& vsBytecode = gAllShaders[desc.vertexShader.handle].bytecode;
 		PrintShaderBytecodeInputs(vsBytecode);
 	}
 	if (desc.fragmentShader.isValid())
 	{
-		auto& fsBytecode = gAllShaders[desc.fragmentShader.handle];
+		auto& fsBytecode = gAllShaders[desc.fragmentShader.handle].bytecode;
 		PrintShaderBytecodeInputs(fsBytecode);
 	}
 }
@@ -12,12 +12,22 @@
 #include <system_error>
 #include <ll/os.h>
 #include <variant>
+#include <functional>
 
 struct BufferInfo
 {
+	ID3D12Resource* resource = nullptr;
 	D3D12MA::Allocation* allocation = nullptr;
 	size_t size = 0;
 	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+	void* persistentMappedPtr = nullptr; // mapped on the first GetMappedBufferPointer, upload heap stays mapped until destroyed
+	mercury::ll::graphics::BufferType type = mercury::ll::graphics::BufferType::StagingBuffer;
+	bool defaultHeap = false; // storage and indirect buffers, writable by compute and filled through copies
+
+	// default heap buffers decay to COMMON after every ExecuteCommandLists, the state only holds in the recording it was set in
+	D3D12_RESOURCE_STATES trackedState = D3D12_RESOURCE_STATE_COMMON;
+	ID3D12GraphicsCommandList* trackedCommandList = nullptr;
+	mercury::u64 trackedRecording = 0;
 };
 
 struct TextureInfo
@@ -26,6 +36,7 @@ struct TextureInfo
 	D3D12MA::Allocation* allocation = nullptr;
 	D3D12_CPU_DESCRIPTOR_HANDLE srvHandle = {};
 	D3D12_GPU_DESCRIPTOR_HANDLE srvGpuHandle = {};
+	UINT srvSlot = 0; // index in gDescriptorsHeapSRV, recycled by DestroyTexture
 };
 
 
@@ -42,7 +53,15 @@ extern ID3D12DescriptorHeap* gDescriptorsHeapDSV;
 extern ID3D12DescriptorHeap* gDescriptorsHeapSRV;
 extern UINT gCurrentSRVOffset;
 
-extern std::vector<CD3DX12_SHADER_BYTECODE> gAllShaders;
+struct IDxcBlob;
+
+struct ShaderInfo
+{
+	CD3DX12_SHADER_BYTECODE bytecode;
+	IDxcBlob* compiled = nullptr; // HLSL source compiled on the first pipeline that uses it, bytecode then points here
+};
+
+extern mercury::SlotMap<ShaderInfo> gAllShaders;
 
 struct PSOInfo
 {
@@ -51,19 +70,33 @@ struct PSOInfo
 	D3D_PRIMITIVE_TOPOLOGY primitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	mercury::i8 rootParameterRootConstantIndex = -1;
 	mercury::i8 setOffsets[4] = { 0,0,0,0 };
+	mercury::u32 textureTableSize = 0; // parameter block layouts only, SRVs reserved per block
+	mercury::u64 dynamicSlots = 0; // parameter block layouts only, bit per DynamicUniformBuffer slot
+	bool isCompute = false;
+	std::vector<D3D12_ROOT_PARAMETER_TYPE> rootParameterTypes; // decides how SetParameterBlock binds each resource
 };
 
-extern std::vector<PSOInfo> gAllPSOs;
+extern mercury::SlotMap<PSOInfo> gAllPSOs;
 
-extern std::vector<ID3D12Resource*> gAllBuffers;
-extern std::vector<BufferInfo> gAllBuffersMeta;
+extern mercury::SlotMap<BufferInfo> gAllBuffers;
 
 extern D3D12MA::Allocator* gAllocator;
 extern DXGI_FORMAT gD3DSwapChainFormat;
 
-extern std::vector<mercury::ll::graphics::ParameterBlockDescriptor> gAllParameterBlocks;
+struct ParameterBlockInfo
+{
+	mercury::ll::graphics::ParameterBlockDescriptor desc;
+
+	// contiguous range in gDescriptorsHeapSRV backing a texture table slot
+	D3D12_CPU_DESCRIPTOR_HANDLE textureTableCpuHandle = {};
+	D3D12_GPU_DESCRIPTOR_HANDLE textureTableGpuHandle = {};
+	mercury::u32 textureTableSize = 0;
+	mercury::u64 dynamicSlots = 0; // root CBVs moved by the SetParameterBlock dynamic offsets
+};
+
+extern mercury::SlotMap<ParameterBlockInfo> gAllParameterBlocks;
 
-extern std::vector<TextureInfo> gAllTextures;
+extern mercury::SlotMap<TextureInfo> gAllTextures;
 
 struct FrameData
 {
@@ -81,6 +114,18 @@ extern UINT gMSAASampleCount;
 extern UINT gMSAAQuality;
 
 extern mercury::u32 gFrameRingCurrent;
+extern mercury::u64 gFrameID;
+
+// called after every command list Reset, buffer states tracked in an earlier recording of the list are stale
+void BeginD3DCommandListRecording(ID3D12GraphicsCommandList* commandList);
+// records the barrier moving a default heap buffer into state, upload heap buffers keep GENERIC_READ
+void TransitionD3DBuffer(ID3D12GraphicsCommandList* commandList, BufferInfo& buffer, D3D12_RESOURCE_STATES state);
+// executes the copies UpdateBuffer recorded into default heap buffers, every submission runs it first
+void FlushPendingD3DBufferUploads();
+
+// Destroy* calls park native objects until every frame in flight at that point has been waited on
+void DeferD3DRelease(std::function<void()> release);
+void ReleaseDeferredD3DObjects(bool all);
 
 #define D3D_CALL(func) {HRESULT res = (func); if(res < 0){ mercury::ll::os::gOS->FatalFail( std::system_category().message(res).c_str() ); } }
 
@@ -7,7 +7,7 @@
 using namespace mercury;
 using namespace mercury::ll::graphics;
 
-std::vector<RenderTargetInfo> gAllRenderTargets;
+SlotMap<RenderTargetInfo, u16, 10> gAllRenderTargets;
 
 CD3DX12_CPU_DESCRIPTOR_HANDLE gRTVHeapStartCPU;
 CD3DX12_CPU_DESCRIPTOR_HANDLE gDSVHeapStartCPU;
@@ -94,7 +94,8 @@ void InitRenderTargetHeaps()
 
 RenderTargetHandle CreateRenderTarget(const RenderTargetCreateDescriptor& desc)
 {
-	auto& rtt =  gAllRenderTargets.emplace_back();
+	const u16 rttHandle = gAllRenderTargets.Emplace();
+	auto& rtt = gAllRenderTargets[rttHandle];
 
 	rtt.useStaticClear = (desc.staticClear != nullptr);
 	if (desc.staticClear)
@@ -238,7 +239,7 @@ RenderTargetHandle CreateRenderTarget(const RenderTargetCreateDescriptor& desc)
 	}
 	
 
-	return RenderTargetHandle{ (u16)(gAllRenderTargets.size() - 1)};
+	return RenderTargetHandle{ rttHandle };
 }
 
 TargetInfo RenderTargetHandle::GetTargetInfo()
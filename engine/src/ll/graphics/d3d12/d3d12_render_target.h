@@ -45,7 +45,7 @@ struct RenderTargetInfo
 	CD3DX12_CPU_DESCRIPTOR_HANDLE DepthStencilView = {};
 };
 
-extern std::vector<RenderTargetInfo> gAllRenderTargets;
+extern mercury::SlotMap<RenderTargetInfo, mercury::u16, 10> gAllRenderTargets;
 
 void InitRenderTargetHeaps();
 #endif
\ No newline at end of file
@@ -94,9 +94,9 @@ void Swapchain::Initialize()
 
 	gSwapchainRenderTargetHandle.SetFramebuffers((void**)backbufferResources.data(), (u8)backbufferResources.size());
 	
-	// Initialize frame data for CPU-GPU synchronization
-	gFrames.resize(gNumFrames);
-	for (uint32_t i = 0; i < gNumFrames; ++i)
+	// Initialize frame data for CPU-GPU synchronization, one per engine frame in flight (gNumFrames counts back buffers)
+	gFrames.resize(Swapchain::NumFramesInFlight);
+	for (uint32_t i = 0; i < Swapchain::NumFramesInFlight; ++i)
 	{
 		FrameData& frame = gFrames[i];
 		D3D_CALL(gD3DDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&frame.fence)));
@@ -126,6 +126,9 @@ void Swapchain::Shutdown()
 	}
 	gFrames.clear();
 
+	// every frame was flushed above
+	ReleaseDeferredD3DObjects(true);
+
 	// Release MSAA resources
 	if (gMSAARenderTarget)
 	{
@@ -262,11 +265,20 @@ ll:os::gOS->GetActualWindowSize((unsigned int&)gNewWidth, (unsigned int&)gNewHei
 	// Reset command allocator and list
 	frame.commandAllocator->Reset();
 	frame.commandList->Reset(frame.commandAllocator, nullptr);
+	BeginD3DCommandListRecording(frame.commandList);
 
 	// Get current backbuffer index
 	gCurrentBBResourceIndex = gSwapChain->GetCurrentBackBufferIndex();
 	gFrameID++;
 
+	CommandList result;
+	result.nativePtr = frame.commandList;
+	return result;
+}
+
+void Swapchain::BeginFinalPass(CommandList& commandList)
+{
+	auto& frame = gFrames[gFrameRingCurrent];
 	auto& bbResource = GetCurrentBackbufferResourceInfo();
 
 	// Transition to render target
@@ -298,10 +310,6 @@ ll:os::gOS->GetActualWindowSize((unsigned int&)gNewWidth, (unsigned int&)gNewHei
 	D3D12_RECT scissorRect = { 0, 0, (LONG)gCurWidth, (LONG)gCurHeight };
 	frame.commandList->RSSetViewports(1, &viewport);
 	frame.commandList->RSSetScissorRects(1, &scissorRect);
-
-	CommandList result;
-	result.nativePtr = frame.commandList;
-	return result;
 }
 
 void Swapchain::Present()
@@ -356,8 +364,9 @@ void Swapchain::Present()
 		frame.commandList->ResourceBarrier(1, &barrier);
 	}
 
-	// Close and execute command list
+	// Close and execute command list, after the buffer copies it reads
 	D3D_CALL(frame.commandList->Close());
+	FlushPendingD3DBufferUploads();
 
 	ID3D12CommandList* const commandLists[] = { frame.commandList };
 	gD3DCommandQueue->ExecuteCommandLists(1, commandLists);
@@ -369,7 +378,7 @@ void Swapchain::Present()
 	frame.fenceValue = Signal(gD3DCommandQueue, frame.fence, frame.fenceValue);
 
 	// Move to next frame
-	gFrameRingCurrent = (gFrameRingCurrent + 1) % gNumFrames;
+	gFrameRingCurrent = (gFrameRingCurrent + 1) % Swapchain::NumFramesInFlight;
 }
 
 void Swapchain::SetFullscreen(bool fullscreen)
@@ -3,6 +3,7 @@
 #if defined(MERCURY_LL_GRAPHICS_D3D12)
 
 #include "mercury_log.h"
+#include <cstring>
 using namespace mercury;
 
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
@@ -352,4 +353,58 @@ void PrintShaderBytecodeInputs(CD3DX12_SHADER_BYTECODE& bytecode)
 #endif
 }
 
+bool IsShaderBytecodeContainer(const D3D12_SHADER_BYTECODE& bytecode)
+{
+    return bytecode.BytecodeLength >= 4 && memcmp(bytecode.pShaderBytecode, "DXBC", 4) == 0;
+}
+
+IDxcBlob* CompileHlslShader(const D3D12_SHADER_BYTECODE& source, const wchar_t* profile)
+{
+#if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
+    using Microsoft::WRL::ComPtr;
+
+    ComPtr<IDxcCompiler3> compiler;
+    HRESULT hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&compiler));
+
+    if (FAILED(hr))
+    {
+        MLOG_ERROR(u8"Failed to create DxcCompiler: 0x%08X", hr);
+        return nullptr;
+    }
+
+    DxcBuffer sourceBuffer = {};
+    sourceBuffer.Ptr = source.pShaderBytecode;
+    sourceBuffer.Size = source.BytecodeLength;
+    if (sourceBuffer.Size > 0 && static_cast<const char*>(sourceBuffer.Ptr)[sourceBuffer.Size - 1] == '\0')
+        sourceBuffer.Size--; // embedded sources keep the string terminator
+    sourceBuffer.Encoding = DXC_CP_UTF8;
+
+    LPCWSTR arguments[] = { L"-E", L"main", L"-T", profile, L"-O3" };
+
+    ComPtr<IDxcResult> result;
+    hr = compiler->Compile(&sourceBuffer, arguments, _countof(arguments), nullptr, IID_PPV_ARGS(&result));
+
+    if (SUCCEEDED(hr))
+        result->GetStatus(&hr);
+
+    if (FAILED(hr))
+    {
+        ComPtr<IDxcBlobUtf8> errors;
+        if (result && SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errors), nullptr)) && errors && errors->GetStringLength() > 0)
+            MLOG_ERROR(u8"Failed to compile HLSL shader: %s", errors->GetStringPointer());
+        else
+            MLOG_ERROR(u8"Failed to compile HLSL shader: 0x%08X", hr);
+
+        return nullptr;
+    }
+
+    IDxcBlob* object = nullptr;
+    result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&object), nullptr);
+    return object;
+#else
+    MLOG_ERROR(u8"HLSL shader source needs dxcompiler, ship DXIL for this platform");
+    return nullptr;
+#endif
+}
+
 #endif
\ No newline at end of file
@@ -10,6 +10,14 @@ DXGI_FORMAT ToDXGIFormat(mercury::ll::graphics::Format format);
 
 void PrintShaderBytecodeInputs(CD3DX12_SHADER_BYTECODE& bytecode);
 
+struct IDxcBlob;
+
+// DXBC and DXIL containers both start with the DXBC magic, anything else is HLSL source
+bool IsShaderBytecodeContainer(const D3D12_SHADER_BYTECODE& bytecode);
+
+// Compiles HLSL source with entry point main for the given profile, nullptr on failure, caller releases the blob
+IDxcBlob* CompileHlslShader(const D3D12_SHADER_BYTECODE& source, const wchar_t* profile);
+
 D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyTypeFromMercuryTopology(mercury::ll::graphics::PrimitiveTopology topology);
 D3D_PRIMITIVE_TOPOLOGY PrimitiveTopologyFromMercuryPrimitiveTopology(mercury::ll::graphics::PrimitiveTopology topology);
 
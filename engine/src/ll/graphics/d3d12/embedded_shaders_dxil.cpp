@@ -4,6 +4,107 @@
 
 namespace mercury::ll::graphics::embedded_shaders {
 
+mercury::ll::graphics::ShaderBytecodeView CanvasSpriteCullCS()
+{
+	// HLSL source, the D3D12 backend compiles it with dxcompiler when the first pipeline uses it
+	static const char data[] = R"(struct MercuryScene
+{
+    float4 prerptationMatrix;
+    float4 canvasSize; // xy = size, zw = 1/half_size
+    float time;
+    float deltaTime;
+};
+
+struct SpriteInstance
+{
+    float2 position;
+    float2 size;
+    float2 uv0;
+    float2 uv1;
+    float angle;
+    uint colorPacked;
+    uint textureIndex;
+    uint batchIndex;
+};
+
+// matches SpriteDrawRecord in canvas.cpp, the leading four fields are the DrawIndirect arguments of one batch
+struct SpriteDrawRecord
+{
+    uint vertexCount;
+    uint instanceCount; // reset to 0 on the CPU, counts the visible sprites of the batch
+    uint firstVertex;
+    uint firstInstance;
+    uint firstSprite;
+    uint padding0;
+    uint padding1;
+    uint padding2;
+};
+
+struct SpriteCullConstants
+{
+    uint numSprites;
+};
+
+// registers follow CreatePipelineRootSignature, no push constants so set N is space N and slot N is register N
+ConstantBuffer<MercuryScene> perFrame : register(b0, space0);
+ConstantBuffer<SpriteCullConstants> cull : register(b0, space1);
+StructuredBuffer<SpriteInstance> sprites : register(t1, space1);
+RWStructuredBuffer<SpriteInstance> visibleSprites : register(u2, space1);
+RWStructuredBuffer<SpriteDrawRecord> drawRecords : register(u3, space1);
+
+[numthreads(64, 1, 1)]
+void main(uint3 dispatchThreadID : SV_DispatchThreadID)
+{
+    uint spriteIndex = dispatchThreadID.x;
+    if (spriteIndex >= cull.numSprites)
+        return;
+
+    SpriteInstance sprite = sprites[spriteIndex];
+
+    // bounding circle of the rotated quad, size holds the half extents
+    float radius = length(sprite.size);
+    float2 minCorner = sprite.position - radius;
+    float2 maxCorner = sprite.position + radius;
+
+    if (any(maxCorner < 0.0) || any(minCorner > perFrame.canvasSize.xy))
+        return;
+
+    // compaction reorders sprites inside a batch
+    uint visibleIndex;
+    InterlockedAdd(drawRecords[sprite.batchIndex].instanceCount, 1, visibleIndex);
+    visibleSprites[drawRecords[sprite.batchIndex].firstSprite + visibleIndex] = sprite;
+}
+)";
+	return { data, sizeof(data) };
+}
+
+mercury::ll::graphics::ShaderBytecodeView CanvasTextPS()
+{
+	// HLSL source, the D3D12 backend compiles it with dxcompiler when the first pipeline uses it
+	static const char data[] = R"(struct BaseVertexOutput
+{
+    float4 position : SV_Position;
+    float2 texcoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+// registers follow CreatePipelineRootSignature, set 1 is space 2 behind the push constants, the sampler is static
+Texture2D<float4> distanceMap : register(t0, space2);
+SamplerState distanceSampler : register(s0, space2);
+
+float4 main(BaseVertexOutput input) : SV_Target
+{
+    // alpha holds the distance to the glyph outline, 0.5 on the edge, antialiased over about one pixel at any scale
+    float distance = distanceMap.Sample(distanceSampler, input.texcoord).a;
+    float width = max(fwidth(distance) * 0.5, 0.001);
+    float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+
+    return float4(input.color.rgb, input.color.a * coverage);
+}
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteVS()
 {
 	static const mercury::u8 data[] = {
@@ -373,6 +474,78 @@ mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteVS()
 	return { data, sizeof(data) };
 }
 
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteInstancedVS()
+{
+	// HLSL source, the D3D12 backend compiles it with dxcompiler when the first pipeline uses it
+	static const char data[] = R"(struct MercuryScene
+{
+    float4 prerptationMatrix;
+    float4 canvasSize; // xy = size, zw = 1/half_size
+    float time;
+    float deltaTime;
+};
+
+struct SpriteInstance
+{
+    float2 position;
+    float2 size;
+    float2 uv0;
+    float2 uv1;
+    float angle;
+    uint colorPacked;
+    uint textureIndex;
+    uint batchIndex;
+};
+
+struct DedicatedSpriteBatchParameters
+{
+    uint firstSprite;
+};
+
+// registers follow CreatePipelineRootSignature, set N is space N + 1 behind the push constants
+ConstantBuffer<DedicatedSpriteBatchParameters> batch : register(b0, space0);
+ConstantBuffer<MercuryScene> perFrame : register(b0, space1);
+StructuredBuffer<SpriteInstance> sprites : register(t0, space3);
+
+float4 UnpackColor(uint packed)
+{
+    return float4((packed >> 24) & 0xFF, (packed >> 16) & 0xFF, (packed >> 8) & 0xFF, packed & 0xFF) / 255.0;
+}
+
+struct BaseVertexOutput
+{
+    float4 position : SV_Position;
+    float2 texcoord : TEXCOORD0;
+    float4 color : COLOR0;
+};
+
+BaseVertexOutput main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
+{
+    BaseVertexOutput output;
+
+    const float2 positions_ndc[4] = { float2(-1.0, 1.0), float2(1.0, 1.0), float2(-1.0, -1.0), float2(1.0, -1.0) };
+    const float2 uvs[4] = { float2(0.0, 0.0), float2(1.0, 0.0), float2(0.0, 1.0), float2(1.0, 1.0) };
+
+    SpriteInstance sprite = sprites[batch.firstSprite + instanceID];
+
+    float cosAngle = cos(sprite.angle);
+    float sinAngle = sin(sprite.angle);
+    float2x2 rotationMatrix = float2x2(
+        cosAngle, -sinAngle,
+        sinAngle, cosAngle
+    );
+    float2 ndc = mul(rotationMatrix, positions_ndc[vertexID] * sprite.size) + sprite.position;
+
+    output.position = float4(ndc * perFrame.canvasSize.zw - float2(1.0, sign(perFrame.canvasSize.w)), 0.0, 1.0);
+    output.texcoord = lerp(sprite.uv0, sprite.uv1, uvs[vertexID]);
+    output.color = UnpackColor(sprite.colorPacked);
+
+    return output;
+}
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteColorPS()
 {
 	static const mercury::u8 data[] = {
@@ -862,6 +1035,105 @@ mercury::ll::graphics::ShaderBytecodeView DedicatedSpritePS()
 	return { data, sizeof(data) };
 }
 
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessVS()
+{
+	// HLSL source, the D3D12 backend compiles it with dxcompiler when the first pipeline uses it
+	static const char data[] = R"(struct MercuryScene
+{
+    float4 prerptationMatrix;
+    float4 canvasSize; // xy = size, zw = 1/half_size
+    float time;
+    float deltaTime;
+};
+
+struct SpriteInstance
+{
+    float2 position;
+    float2 size;
+    float2 uv0;
+    float2 uv1;
+    float angle;
+    uint colorPacked;
+    uint textureIndex;
+    uint batchIndex;
+};
+
+struct DedicatedSpriteBatchParameters
+{
+    uint firstSprite;
+};
+
+// registers follow CreatePipelineRootSignature, set N is space N + 1 behind the push constants
+ConstantBuffer<DedicatedSpriteBatchParameters> batch : register(b0, space0);
+ConstantBuffer<MercuryScene> perFrame : register(b0, space1);
+StructuredBuffer<SpriteInstance> sprites : register(t0, space3);
+
+float4 UnpackColor(uint packed)
+{
+    return float4((packed >> 24) & 0xFF, (packed >> 16) & 0xFF, (packed >> 8) & 0xFF, packed & 0xFF) / 255.0;
+}
+
+struct BindlessSpriteVertexOutput
+{
+    float4 position : SV_Position;
+    float2 texcoord : TEXCOORD0;
+    float4 color : COLOR0;
+    nointerpolation uint textureIndex : TEXCOORD1;
+};
+
+BindlessSpriteVertexOutput main(uint vertexID : SV_VertexID, uint instanceID : SV_InstanceID)
+{
+    BindlessSpriteVertexOutput output;
+
+    const float2 positions_ndc[4] = { float2(-1.0, 1.0), float2(1.0, 1.0), float2(-1.0, -1.0), float2(1.0, -1.0) };
+    const float2 uvs[4] = { float2(0.0, 0.0), float2(1.0, 0.0), float2(0.0, 1.0), float2(1.0, 1.0) };
+
+    SpriteInstance sprite = sprites[batch.firstSprite + instanceID];
+
+    float cosAngle = cos(sprite.angle);
+    float sinAngle = sin(sprite.angle);
+    float2x2 rotationMatrix = float2x2(
+        cosAngle, -sinAngle,
+        sinAngle, cosAngle
+    );
+    float2 ndc = mul(rotationMatrix, positions_ndc[vertexID] * sprite.size) + sprite.position;
+
+    output.position = float4(ndc * perFrame.canvasSize.zw - float2(1.0, sign(perFrame.canvasSize.w)), 0.0, 1.0);
+    output.texcoord = lerp(sprite.uv0, sprite.uv1, uvs[vertexID]);
+    output.color = UnpackColor(sprite.colorPacked);
+    output.textureIndex = sprite.textureIndex;
+
+    return output;
+}
+)";
+	return { data, sizeof(data) };
+}
+
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessPS()
+{
+	// HLSL source, the D3D12 backend compiles it with dxcompiler when the first pipeline uses it
+	static const char data[] = R"(struct BindlessSpriteVertexOutput
+{
+    float4 position : SV_Position;
+    float2 texcoord : TEXCOORD0;
+    float4 color : COLOR0;
+    nointerpolation uint textureIndex : TEXCOORD1;
+};
+
+// registers follow CreatePipelineRootSignature, set 1 is space 2 behind the push constants, the sampler is static
+Texture2D<float4> textures[] : register(t0, space2);
+SamplerState spriteSampler : register(s0, space2);
+
+float4 main(BindlessSpriteVertexOutput input) : SV_Target
+{
+    // neighbouring sprites in one draw sample different textures
+    Texture2D<float4> spriteTexture = textures[NonUniformResourceIndex(input.textureIndex)];
+    return input.color * spriteTexture.Sample(spriteSampler, input.texcoord);
+}
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedStaticMeshVS()
 {
 	static const mercury::u8 data[] = {
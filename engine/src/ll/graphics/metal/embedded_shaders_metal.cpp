@@ -4,6 +4,118 @@
 
 namespace mercury::ll::graphics::embedded_shaders {
 
+mercury::ll::graphics::ShaderBytecodeView CanvasSpriteCullCS()
+{
+	static const char data[] = R"(#include <metal_stdlib>
+#include <metal_math>
+#include <metal_atomic>
+using namespace metal;
+
+struct MercuryScene_0
+{
+    float4 prerptationMatrix_0;
+    float4 canvasSize_0;
+    float time_0;
+    float deltaTime_0;
+};
+
+struct SpriteInstance_0
+{
+    float2 position_0;
+    float2 size_0;
+    float2 uv0_0;
+    float2 uv1_0;
+    float angle_0;
+    uint colorPacked_0;
+    uint textureIndex_0;
+    uint batchIndex_0;
+};
+
+// matches SpriteDrawRecord in canvas.cpp, the leading four fields are the drawPrimitives indirect arguments of one batch
+struct SpriteDrawRecord_0
+{
+    uint vertexCount_0;
+    uint instanceCount_0; // reset to 0 on the CPU, counts the visible sprites of the batch
+    uint firstVertex_0;
+    uint firstInstance_0;
+    uint firstSprite_0;
+    uint padding0_0;
+    uint padding1_0;
+    uint padding2_0;
+};
+
+struct SpriteCullParameters_0
+{
+    uint numSprites_0;
+    SpriteInstance_0 device* sprites_0;
+    SpriteInstance_0 device* visibleSprites_0;
+    SpriteDrawRecord_0 device* drawRecords_0;
+};
+
+[[kernel]] void CanvasSpriteCullCS(uint3 dispatchThreadID_0 [[thread_position_in_grid]], MercuryScene_0 constant* perFrame_0 [[buffer(1)]], SpriteCullParameters_0 constant* cull_0 [[buffer(2)]])
+{
+    uint spriteIndex_0 = dispatchThreadID_0.x;
+    if (spriteIndex_0 >= cull_0->numSprites_0)
+        return;
+
+    SpriteInstance_0 sprite_0 = cull_0->sprites_0[spriteIndex_0];
+
+    // bounding circle of the rotated quad, size holds the half extents
+    float radius_0 = length(sprite_0.size_0);
+    float2 minCorner_0 = sprite_0.position_0 - radius_0;
+    float2 maxCorner_0 = sprite_0.position_0 + radius_0;
+
+    if (any(maxCorner_0 < 0.0) || any(minCorner_0 > perFrame_0->canvasSize_0.xy))
+        return;
+
+    // compaction reorders sprites inside a batch
+    device SpriteDrawRecord_0* record_0 = &cull_0->drawRecords_0[sprite_0.batchIndex_0];
+    uint visibleIndex_0 = atomic_fetch_add_explicit((device atomic_uint*)&record_0->instanceCount_0, 1U, memory_order_relaxed);
+    cull_0->visibleSprites_0[record_0->firstSprite_0 + visibleIndex_0] = sprite_0;
+}
+)";
+	return { data, sizeof(data) };
+}
+
+mercury::ll::graphics::ShaderBytecodeView CanvasTextPS()
+{
+	static const char data[] = R"(#include <metal_stdlib>
+#include <metal_math>
+#include <metal_texture>
+using namespace metal;
+
+struct pixelOutput_0
+{
+    float4 output_0 [[color(0)]];
+};
+
+struct pixelInput_0
+{
+    float2 texcoord_0 [[user(TEXCOORD)]];
+    float4 color_0 [[user(COLOR)]];
+};
+
+// set 1 holds the glyph page instead of the sprite texture
+struct GlyphPage_0
+{
+    texture2d<float, access::sample> distanceMap_0;
+    sampler distanceSampler_0;
+};
+
+[[fragment]] pixelOutput_0 CanvasTextPS(pixelInput_0 _S1 [[stage_in]], float4 position_0 [[position]], GlyphPage_0 constant* glyphPage_0 [[buffer(2)]])
+{
+    // alpha holds the distance to the glyph outline, 0.5 on the edge, antialiased over about one pixel at any scale
+    float distance_0 = glyphPage_0->distanceMap_0.sample(glyphPage_0->distanceSampler_0, _S1.texcoord_0).w;
+    float width_0 = max(fwidth(distance_0) * 0.5, 0.001);
+    float coverage_0 = smoothstep(0.5 - width_0, 0.5 + width_0, distance_0);
+
+    pixelOutput_0 _S2 = { float4(_S1.color_0.xyz, _S1.color_0.w * coverage_0) };
+    return _S2;
+}
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteVS()
 {
 	static const char data[] = R"(#include <metal_stdlib>
@@ -167,6 +279,88 @@ struct DedicatedSpriteVS_Result_0
 	return { data, sizeof(data) };
 }
 
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteInstancedVS()
+{
+	static const char data[] = R"(#include <metal_stdlib>
+#include <metal_math>
+#include <metal_texture>
+using namespace metal;
+
+struct MercuryScene_0
+{
+    float4 prerptationMatrix_0;
+    float4 canvasSize_0;
+    float time_0;
+    float deltaTime_0;
+};
+
+struct SpriteInstance_0
+{
+    float2 position_0;
+    float2 size_0;
+    float2 uv0_0;
+    float2 uv1_0;
+    float angle_0;
+    uint colorPacked_0;
+    uint textureIndex_0;
+    uint batchIndex_0;
+};
+
+struct SpriteInstances_0
+{
+    SpriteInstance_0 device* sprites_0;
+};
+
+struct EntryPointParams_0
+{
+    uint firstSprite_0;
+};
+
+float4 PackedColor_toFloat4_0(uint packed_0)
+{
+    return float4(float((packed_0 >> 24U) & 255U), float((packed_0 >> 16U) & 255U), float((packed_0 >> 8U) & 255U), float(packed_0 & 255U)) / 255.0;
+}
+
+float4 SpriteClipPosition_0(SpriteInstance_0 sprite_0, uint vertexID_0, MercuryScene_0 constant* perFrame_0)
+{
+    array<float2, int(4)> positions_ndc_0 = { float2(-1.0, 1.0), float2(1.0, 1.0), float2(-1.0, -1.0), float2(1.0, -1.0) };
+
+    float cosAngle_0 = cos(sprite_0.angle_0);
+    float sinAngle_0 = sin(sprite_0.angle_0);
+    float2 ndc_0 = (positions_ndc_0[vertexID_0] * sprite_0.size_0) * matrix<float,int(2),int(2)> (cosAngle_0, - sinAngle_0, sinAngle_0, cosAngle_0) + sprite_0.position_0;
+
+    return float4(ndc_0 * perFrame_0->canvasSize_0.zw - float2(1.0, float(int(sign(perFrame_0->canvasSize_0.w)))), 0.0, 1.0);
+}
+
+float2 SpriteTexcoord_0(SpriteInstance_0 sprite_0, uint vertexID_0)
+{
+    array<float2, int(4)> uvs_0 = { float2(0.0, 0.0), float2(1.0, 0.0), float2(0.0, 1.0), float2(1.0, 1.0) };
+    return mix(sprite_0.uv0_0, sprite_0.uv1_0, uvs_0[vertexID_0]);
+}
+
+struct DedicatedSpriteInstancedVS_Result_0
+{
+    float4 position_1 [[position]];
+    float2 texcoord_0 [[user(TEXCOORD)]];
+    float4 color_0 [[user(COLOR)]];
+};
+
+// set N is [[buffer(N + 1)]], the batch constants are the entry point parameters in [[buffer(0)]]
+[[vertex]] DedicatedSpriteInstancedVS_Result_0 DedicatedSpriteInstancedVS(uint vertexID_1 [[vertex_id]], uint instanceID_0 [[instance_id]], uint baseInstance_0 [[base_instance]], EntryPointParams_0 constant* entryPointParams_0 [[buffer(0)]], MercuryScene_0 constant* perFrame_1 [[buffer(1)]], SpriteInstances_0 constant* spriteInstances_0 [[buffer(3)]])
+{
+    SpriteInstance_0 sprite_1 = spriteInstances_0->sprites_0[entryPointParams_0->firstSprite_0 + (instanceID_0 - baseInstance_0)];
+
+    DedicatedSpriteInstancedVS_Result_0 output_0;
+    output_0.position_1 = SpriteClipPosition_0(sprite_1, vertexID_1, perFrame_1);
+    output_0.texcoord_0 = SpriteTexcoord_0(sprite_1, vertexID_1);
+    output_0.color_0 = PackedColor_toFloat4_0(sprite_1.colorPacked_0);
+
+    return output_0;
+}
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteColorPS()
 {
 	static const char data[] = R"(#include <metal_stdlib>
@@ -256,6 +450,18 @@ struct SpriteParameter_0
 	return { data, sizeof(data) };
 }
 
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessVS()
+{
+	// Metal has no texture tables yet, GetMaxTextureTableSize is 0 and canvas never builds the bindless pipeline
+	return {};
+}
+
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessPS()
+{
+	// Metal has no texture tables yet, GetMaxTextureTableSize is 0 and canvas never builds the bindless pipeline
+	return {};
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedStaticMeshVS()
 {
 	static const char data[] = R"(#include <metal_stdlib>
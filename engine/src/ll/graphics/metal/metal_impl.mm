@@ -24,6 +24,32 @@ static MTLRenderPassColorAttachmentDescriptor *gMetalRenderPassColorAttachment =
 static MTLRenderPassDescriptor *gMetalRenderPassDescriptor = nil;
 static CAMetalLayer* gMetalLayer = nil;
 static id<CAMetalDrawable> gMetalCurrentDrawable = nil;
+static id<MTLComputeCommandEncoder> gMetalComputeEncoder = nil; // compute recorded before the final pass
+
+// MSL kernels don't carry the HLSL numthreads, every engine kernel is this wide
+static constexpr NSUInteger MetalComputeThreadgroupSize = 64;
+
+struct MetalShaderInfo {
+    id<MTLLibrary> library = nil;
+    id<MTLFunction> function = nil; // the one entry point of the embedded source
+};
+
+struct MetalPSOInfo {
+    id<MTLComputePipelineState> computePipeline = nil;
+    MTLPrimitiveType primitiveType = MTLPrimitiveTypeTriangle;
+    bool isCompute = false;
+};
+
+static mercury::SlotMap<MetalShaderInfo> gMetalShaders;
+static mercury::SlotMap<MetalPSOInfo> gMetalPSOs;
+static mercury::SlotMap<id<MTLBuffer>> gMetalBuffers;
+
+static void EndMetalComputeEncoder() {
+    if (gMetalComputeEncoder) {
+        [gMetalComputeEncoder endEncoding];
+        gMetalComputeEncoder = nil;
+    }
+}
 
 // Metal format conversion utilities
 static MTLPixelFormat ConvertFormatToMetal(Format format) {
@@ -279,6 +305,11 @@ void Device::Initialize() {
 
 void Device::Shutdown() {
     MLOG_DEBUG(u8"Shutting down Metal Device");
+
+    EndMetalComputeEncoder();
+    gMetalPSOs.clear();
+    gMetalShaders.clear();
+    gMetalBuffers.clear();
     
     if (gMetalRenderEncoder) {
         [gMetalRenderEncoder endEncoding];
@@ -426,21 +457,146 @@ void Device::ImguiShutdown() {
 }
 
 ShaderHandle Device::CreateShaderModule(const ShaderBytecodeView& bytecode) {
-    MLOG_DEBUG(u8"Metal CreateShaderModule placeholder");
-    // TODO: Implement Metal shader module creation
     ShaderHandle handle;
-    handle.handle = 0;
+
+    if (bytecode.data == nullptr || bytecode.size == 0) {
+        MLOG_ERROR(u8"Metal CreateShaderModule - No shader source");
+        return handle;
+    }
+
+    // embedded Metal shaders are MSL source, the size counts the terminating nul
+    size_t length = bytecode.size;
+    if (static_cast<const char*>(bytecode.data)[length - 1] == '\0') {
+        length--;
+    }
+
+    NSString* source = [[NSString alloc] initWithBytes:bytecode.data length:length encoding:NSUTF8StringEncoding];
+    NSError* error = nil;
+    id<MTLLibrary> library = [gMetalDevice newLibraryWithSource:source options:nil error:&error];
+    if (!library) {
+        MLOG_ERROR(u8"Metal CreateShaderModule - Failed to compile MSL: %s", [[error localizedDescription] UTF8String]);
+        return handle;
+    }
+
+    MetalShaderInfo info;
+    info.library = library;
+    info.function = [library newFunctionWithName:library.functionNames.firstObject];
+    if (!info.function) {
+        MLOG_ERROR(u8"Metal CreateShaderModule - MSL source has no entry point");
+        return handle;
+    }
+
+    handle.handle = gMetalShaders.Emplace(info);
     return handle;
 }
 
+u32 Device::GetMaxTextureTableSize() {
+    // TODO: Implement Metal argument buffer texture tables
+    return 0;
+}
+
 PsoHandle Device::CreateRasterizePipeline(const RasterizePipelineDescriptor& desc) {
-    MLOG_DEBUG(u8"Metal CreateRasterizePipeline placeholder");
-    // TODO: Implement Metal pipeline state creation
+    // TODO: Implement Metal render pipeline state creation, only the topology Draw needs is kept for now
+    MetalPSOInfo info;
+    switch (desc.primitiveTopology) {
+        case PrimitiveTopology::TriangleStrip: info.primitiveType = MTLPrimitiveTypeTriangleStrip; break;
+        case PrimitiveTopology::LineList:      info.primitiveType = MTLPrimitiveTypeLine; break;
+        case PrimitiveTopology::LineStrip:     info.primitiveType = MTLPrimitiveTypeLineStrip; break;
+        case PrimitiveTopology::PointList:     info.primitiveType = MTLPrimitiveTypePoint; break;
+        default:                               info.primitiveType = MTLPrimitiveTypeTriangle; break;
+    }
+
+    PsoHandle handle;
+    handle.handle = gMetalPSOs.Emplace(info);
+    return handle;
+}
+
+PsoHandle Device::CreateComputePipeline(const ComputePipelineDescriptor& desc) {
     PsoHandle handle;
-    handle.handle = 0;
+
+    const MetalShaderInfo* shader = gMetalShaders.Get(desc.computeShader.handle);
+    if (!shader) {
+        MLOG_ERROR(u8"Metal CreateComputePipeline - Invalid compute shader handle: %u", desc.computeShader.handle);
+        return handle;
+    }
+
+    NSError* error = nil;
+    MetalPSOInfo info;
+    info.isCompute = true;
+    info.computePipeline = [gMetalDevice newComputePipelineStateWithFunction:shader->function error:&error];
+    if (!info.computePipeline) {
+        MLOG_ERROR(u8"Metal CreateComputePipeline - Failed to create pipeline: %s", [[error localizedDescription] UTF8String]);
+        return handle;
+    }
+
+    if (info.computePipeline.maxTotalThreadsPerThreadgroup < MetalComputeThreadgroupSize) {
+        MLOG_ERROR(u8"Metal CreateComputePipeline - Kernel allows %u threads per threadgroup, %u needed",
+            (u32)info.computePipeline.maxTotalThreadsPerThreadgroup, (u32)MetalComputeThreadgroupSize);
+        return handle;
+    }
+
+    handle.handle = gMetalPSOs.Emplace(info);
     return handle;
 }
 
+void Device::DestroyComputePipeline(PsoHandle psoID) {
+    // command buffers retain the pipeline state while they still use it
+    gMetalPSOs.Remove(psoID.handle);
+}
+
+BufferHandle Device::CreateBuffer(const BufferDescriptor& desc) {
+    BufferHandle handle;
+
+    if (desc.size == 0) {
+        MLOG_ERROR(u8"Metal CreateBuffer - Cannot create buffer with size 0");
+        return handle;
+    }
+
+    // shared storage, contents() stays mapped for the whole buffer lifetime
+    id<MTLBuffer> buffer = desc.initialData
+        ? [gMetalDevice newBufferWithBytes:desc.initialData length:desc.size options:MTLResourceStorageModeShared]
+        : [gMetalDevice newBufferWithLength:desc.size options:MTLResourceStorageModeShared];
+    if (!buffer) {
+        MLOG_ERROR(u8"Metal CreateBuffer - Failed to create buffer of size %zu bytes", desc.size);
+        return handle;
+    }
+
+    handle.handle = gMetalBuffers.Emplace(buffer);
+    return handle;
+}
+
+void Device::DestroyBuffer(BufferHandle bufferID) {
+    // command buffers retain the buffers they reference until they complete
+    if (!gMetalBuffers.Remove(bufferID.handle)) {
+        MLOG_WARNING(u8"Metal DestroyBuffer - Invalid buffer handle: %u", bufferID.handle);
+    }
+}
+
+void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size, size_t offset) {
+    id<MTLBuffer>* buffer = gMetalBuffers.Get(bufferID.handle);
+    if (!buffer) {
+        MLOG_ERROR(u8"Metal UpdateBuffer - Invalid buffer handle: %u", bufferID.handle);
+        return;
+    }
+
+    if (offset + size > (*buffer).length) {
+        MLOG_ERROR(u8"Metal UpdateBuffer - Out of bounds: handle=%u, offset=%zu, size=%zu, buffer_size=%zu",
+            bufferID.handle, offset, size, (size_t)(*buffer).length);
+        return;
+    }
+
+    memcpy(static_cast<u8*>((*buffer).contents) + offset, data, size);
+}
+
+void* Device::GetMappedBufferPointer(BufferHandle bufferID) {
+    id<MTLBuffer>* buffer = gMetalBuffers.Get(bufferID.handle);
+    return buffer ? (*buffer).contents : nullptr;
+}
+
+void Device::FlushBuffer(BufferHandle bufferID, size_t offset, size_t size) {
+    // shared storage is coherent, nothing to flush
+}
+
 // Swapchain implementation
 void Swapchain::Initialize() {
     MLOG_DEBUG(u8"Initializing Metal Swapchain");
@@ -547,12 +703,26 @@ CommandList Swapchain::AcquireNextImage() {
         MLOG_ERROR(u8"Metal AcquireNextImage - Failed to create command buffer");
         return cmdList;
     }
-    
+
+    // compute encoders recorded before BeginFinalPass come from the same command buffer
+    cmdList.nativePtr = (__bridge void*)gMetalCommandBuffer;
+
+    return cmdList;
+}
+
+void Swapchain::BeginFinalPass(CommandList& cmdList) {
+    if (!gMetalCommandBuffer || !gMetalCurrentDrawable) {
+        return;
+    }
+
+    // render and compute encoders of one command buffer can't overlap
+    EndMetalComputeEncoder();
+
     // Creating render pass descriptor
     gMetalRenderPassDescriptor = [MTLRenderPassDescriptor renderPassDescriptor];
     if (!gMetalRenderPassDescriptor) {
-        MLOG_ERROR(u8"Metal AcquireNextImage - Failed to create render pass descriptor");
-        return cmdList;
+        MLOG_ERROR(u8"Metal BeginFinalPass - Failed to create render pass descriptor");
+        return;
     }
     
     // Setting up color attachment
@@ -568,18 +738,17 @@ CommandList Swapchain::AcquireNextImage() {
     // Creating render pass encoder
     gMetalRenderPassEncoder = [gMetalCommandBuffer renderCommandEncoderWithDescriptor:gMetalRenderPassDescriptor];
     if (!gMetalRenderPassEncoder) {
-        MLOG_ERROR(u8"Metal AcquireNextImage - Failed to create render pass encoder");
-        return cmdList;     
+        MLOG_ERROR(u8"Metal BeginFinalPass - Failed to create render pass encoder");
+        return;
     }
     
     // Render pass encoder created
     cmdList.nativePtr = (__bridge void*)gMetalRenderPassEncoder;
-    
-    return cmdList;
 }
 
 void Swapchain::Present() {
-    
+    EndMetalComputeEncoder();
+
     // End any active render encoders. There are two encoder globals used in
     // the engine/renderer: gMetalRenderPassEncoder (primary frame encoder)
     // and gMetalRenderEncoder (legacy/auxiliary). Ensure both are ended
@@ -637,15 +806,68 @@ void CommandList::RenderImgui() {
 }
 
 void CommandList::SetPSO(Handle<u32> psoID) {
-    // Set PSO placeholder
-    // TODO: Implement Metal PSO setting
-    // This would set the render pipeline state on the render pass encoder
+    currentPsoID = psoID;
+
+    const MetalPSOInfo* pso = gMetalPSOs.Get(psoID.handle);
+    if (!pso || !pso->isCompute) {
+        // TODO: set the render pipeline state on the render pass encoder once CreateRasterizePipeline builds it
+        return;
+    }
+
+    // compute only runs before BeginFinalPass, the encoder lives until the final pass or Present ends it
+    if (!gMetalComputeEncoder && gMetalCommandBuffer) {
+        gMetalComputeEncoder = [gMetalCommandBuffer computeCommandEncoder];
+    }
+
+    [gMetalComputeEncoder setComputePipelineState:pso->computePipeline];
+}
+
+// triangles until the bound pipeline says otherwise
+static MTLPrimitiveType GetMetalPrimitiveType(PsoHandle psoID) {
+    const MetalPSOInfo* pso = gMetalPSOs.Get(psoID.handle);
+    return pso ? pso->primitiveType : MTLPrimitiveTypeTriangle;
 }
 
 void CommandList::Draw(u32 vertexCount, u32 instanceCount, u32 firstVertex, u32 firstInstance) {
-    // Draw placeholder
-    // TODO: Implement Metal draw calls
-    // This would call drawPrimitives on the render pass encoder
+    if (!gMetalRenderPassEncoder) {
+        return;
+    }
+
+    [gMetalRenderPassEncoder drawPrimitives:GetMetalPrimitiveType(currentPsoID)
+                                vertexStart:firstVertex
+                                vertexCount:vertexCount
+                              instanceCount:instanceCount
+                               baseInstance:firstInstance];
+}
+
+void CommandList::DrawIndirect(BufferHandle bufferID, size_t offset) {
+    // DrawIndirectArguments has the MTLDrawPrimitivesIndirectArguments layout
+    static_assert(sizeof(DrawIndirectArguments) == sizeof(MTLDrawPrimitivesIndirectArguments));
+
+    id<MTLBuffer>* buffer = gMetalBuffers.Get(bufferID.handle);
+    if (!gMetalRenderPassEncoder || !buffer) {
+        MLOG_ERROR(u8"Metal DrawIndirect - No render pass or invalid buffer handle: %u", bufferID.handle);
+        return;
+    }
+
+    [gMetalRenderPassEncoder drawPrimitives:GetMetalPrimitiveType(currentPsoID)
+                             indirectBuffer:*buffer
+                       indirectBufferOffset:offset];
+}
+
+void CommandList::Dispatch(u32 groupCountX, u32 groupCountY, u32 groupCountZ) {
+    if (!gMetalComputeEncoder) {
+        MLOG_ERROR(u8"Metal Dispatch - No compute pipeline bound before the final pass");
+        return;
+    }
+
+    [gMetalComputeEncoder dispatchThreadgroups:MTLSizeMake(groupCountX, groupCountY, groupCountZ)
+                         threadsPerThreadgroup:MTLSizeMake(MetalComputeThreadgroupSize, 1, 1)];
+}
+
+void CommandList::DispatchBarrier() {
+    // later dispatches of this encoder, the render encoder that follows waits for the compute encoder to finish
+    [gMetalComputeEncoder memoryBarrierWithScope:MTLBarrierScopeBuffers];
 }
 
 void CommandList::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth) {
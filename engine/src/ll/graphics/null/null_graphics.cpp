@@ -123,6 +123,10 @@ CommandList Swapchain::AcquireNextImage()
     return CommandList();
 }
 
+void Swapchain::BeginFinalPass(CommandList& commandList)
+{
+}
+
 void Swapchain::Present()
 {
 }
@@ -231,6 +235,48 @@ void Device::DestroyRasterizePipeline(PsoHandle psoID)
     // null implementation - do nothing
 }
 
+PsoHandle Device::CreateComputePipeline(const ComputePipelineDescriptor& desc)
+{
+    PsoHandle result;
+    result.handle = 0; // null implementation
+    return result;
+}
+
+void Device::DestroyComputePipeline(PsoHandle psoID)
+{
+    // null implementation - do nothing
+}
+
+u32 Device::GetMaxTextureTableSize()
+{
+    return 0; // null implementation
+}
+
+BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
+{
+    return BufferHandle{}; // null implementation
+}
+
+void Device::DestroyBuffer(BufferHandle bufferID)
+{
+    // null implementation - do nothing
+}
+
+void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size, size_t offset)
+{
+    // null implementation - do nothing
+}
+
+void* Device::GetMappedBufferPointer(BufferHandle bufferID)
+{
+    return nullptr; // null implementation
+}
+
+void Device::FlushBuffer(BufferHandle bufferID, size_t offset, size_t size)
+{
+    // null implementation - do nothing
+}
+
 void CommandList::SetPSO(Handle<u32> psoID)
 {
     // null implementation - do nothing
@@ -241,6 +287,21 @@ void CommandList::Draw(u32 vertexCount, u32 instanceCount, u32 firstVertex, u32
     // null implementation - do nothing
 }
 
+void CommandList::DrawIndirect(BufferHandle bufferID, size_t offset)
+{
+    // null implementation - do nothing
+}
+
+void CommandList::Dispatch(u32 groupCountX, u32 groupCountY, u32 groupCountZ)
+{
+    // null implementation - do nothing
+}
+
+void CommandList::DispatchBarrier()
+{
+    // null implementation - do nothing
+}
+
 void CommandList::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
 {
     // null implementation - do nothing
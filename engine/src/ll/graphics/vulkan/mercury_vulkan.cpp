@@ -45,6 +45,7 @@ VK_DEFINE_FUNCTION(vkGetPhysicalDeviceProperties2KHR);
 VK_DEFINE_FUNCTION(vkGetPhysicalDeviceQueueFamilyProperties);
 VK_DEFINE_FUNCTION(vkEnumerateDeviceExtensionProperties);
 VK_DEFINE_FUNCTION(vkGetPhysicalDeviceFeatures);
+VK_DEFINE_FUNCTION(vkGetPhysicalDeviceFeatures2);
 VK_DEFINE_FUNCTION(vkCreateDevice);
 VK_DEFINE_FUNCTION(vkGetDeviceProcAddr);
 VK_DEFINE_FUNCTION(vkCreateDebugUtilsMessengerEXT);
@@ -124,6 +125,9 @@ VK_DEFINE_FUNCTION(vkCreateShaderModule);
 VK_DEFINE_FUNCTION(vkDestroyShaderModule);
 VK_DEFINE_FUNCTION(vkCreateGraphicsPipelines);
 VK_DEFINE_FUNCTION(vkDestroyPipeline);
+VK_DEFINE_FUNCTION(vkCreatePipelineCache);
+VK_DEFINE_FUNCTION(vkDestroyPipelineCache);
+VK_DEFINE_FUNCTION(vkGetPipelineCacheData);
 VK_DEFINE_FUNCTION(vkCreatePipelineLayout);
 VK_DEFINE_FUNCTION(vkDestroyPipelineLayout);
 VK_DEFINE_FUNCTION(vkCmdBindPipeline);
@@ -190,6 +194,7 @@ VK_DEFINE_FUNCTION(vkCmdPipelineBarrier2);
 VK_DEFINE_FUNCTION(vkDestroyDescriptorSetLayout);
 VK_DEFINE_FUNCTION(vkFreeDescriptorSets);
 VK_DEFINE_FUNCTION(vkWaitSemaphores);
+VK_DEFINE_FUNCTION(vkGetSemaphoreCounterValue);
 VK_DEFINE_FUNCTION(vkQueueSubmit2);
 VK_DEFINE_FUNCTION(vkGetFenceStatus);
 VK_DEFINE_FUNCTION(vkResetCommandBuffer);
@@ -265,6 +270,7 @@ void LoadVkInstanceLevelFuncs(VkInstance instance)
 	VK_LOAD_INSTANCE_FUNC(vkGetPhysicalDeviceQueueFamilyProperties);
 	VK_LOAD_INSTANCE_FUNC(vkEnumerateDeviceExtensionProperties);
 	VK_LOAD_INSTANCE_FUNC(vkGetPhysicalDeviceFeatures);
+	VK_LOAD_INSTANCE_FUNC(vkGetPhysicalDeviceFeatures2);
 	VK_LOAD_INSTANCE_FUNC(vkCreateDevice);
 	VK_LOAD_INSTANCE_FUNC(vkGetDeviceProcAddr);
 	VK_LOAD_INSTANCE_FUNC(vkCreateDebugUtilsMessengerEXT);
@@ -348,6 +354,9 @@ void LoadVkDeviceLevelFuncs(VkDevice device)
 	VK_LOAD_DEVICE_FUNC(vkDestroyShaderModule);
 	VK_LOAD_DEVICE_FUNC(vkCreateGraphicsPipelines);
 	VK_LOAD_DEVICE_FUNC(vkDestroyPipeline);
+	VK_LOAD_DEVICE_FUNC(vkCreatePipelineCache);
+	VK_LOAD_DEVICE_FUNC(vkDestroyPipelineCache);
+	VK_LOAD_DEVICE_FUNC(vkGetPipelineCacheData);
 	VK_LOAD_DEVICE_FUNC(vkCreatePipelineLayout);
 	VK_LOAD_DEVICE_FUNC(vkDestroyPipelineLayout);
 	VK_LOAD_DEVICE_FUNC(vkCmdBindPipeline);
@@ -411,6 +420,7 @@ void LoadVkDeviceLevelFuncs(VkDevice device)
 	VK_LOAD_DEVICE_FUNC(vkGetImageMemoryRequirements2);
 	VK_LOAD_DEVICE_FUNC(vkCmdDecompressMemoryNV);
 	VK_LOAD_DEVICE_FUNC(vkWaitSemaphores);
+	VK_LOAD_DEVICE_FUNC(vkGetSemaphoreCounterValue);
 	VK_LOAD_DEVICE_FUNC(vkQueueSubmit2);
 	VK_LOAD_DEVICE_FUNC(vkCmdBeginRendering);
 	VK_LOAD_DEVICE_FUNC(vkCmdEndRendering);
@@ -72,6 +72,7 @@ VK_DECLARE_FUNCTION(vkGetPhysicalDeviceProperties2KHR);
 VK_DECLARE_FUNCTION(vkGetPhysicalDeviceQueueFamilyProperties);
 VK_DECLARE_FUNCTION(vkEnumerateDeviceExtensionProperties);
 VK_DECLARE_FUNCTION(vkGetPhysicalDeviceFeatures);
+VK_DECLARE_FUNCTION(vkGetPhysicalDeviceFeatures2);
 VK_DECLARE_FUNCTION(vkCreateDevice);
 VK_DECLARE_FUNCTION(vkGetDeviceProcAddr);
 VK_DECLARE_FUNCTION(vkCreateDebugUtilsMessengerEXT);
@@ -157,6 +158,9 @@ VK_DECLARE_FUNCTION(vkCreateShaderModule);
 VK_DECLARE_FUNCTION(vkDestroyShaderModule);
 VK_DECLARE_FUNCTION(vkCreateGraphicsPipelines);
 VK_DECLARE_FUNCTION(vkDestroyPipeline);
+VK_DECLARE_FUNCTION(vkCreatePipelineCache);
+VK_DECLARE_FUNCTION(vkDestroyPipelineCache);
+VK_DECLARE_FUNCTION(vkGetPipelineCacheData);
 VK_DECLARE_FUNCTION(vkCreatePipelineLayout);
 VK_DECLARE_FUNCTION(vkDestroyPipelineLayout);
 VK_DECLARE_FUNCTION(vkCmdBindPipeline);
@@ -221,6 +225,7 @@ VK_DECLARE_FUNCTION(vkGetBufferMemoryRequirements2);
 VK_DECLARE_FUNCTION(vkGetImageMemoryRequirements2);
 VK_DECLARE_FUNCTION(vkCmdDecompressMemoryNV);
 VK_DECLARE_FUNCTION(vkWaitSemaphores);
+VK_DECLARE_FUNCTION(vkGetSemaphoreCounterValue);
 VK_DECLARE_FUNCTION(vkQueueSubmit2);
 VK_DECLARE_FUNCTION(vkCmdBeginRendering);
 VK_DECLARE_FUNCTION(vkCmdEndRendering);
@@ -14,6 +14,15 @@ bool mercury::ll::graphics::IsYFlipped()
 #include "vk_swapchain.h"
 #include "vk_device.h"
 #include "vk_utils.h"
+#include "mercury_memory.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <string>
 
 #include "../../../imgui/imgui_impl.h"
 
@@ -25,10 +34,26 @@ VmaAllocator gVMA_Allocator = nullptr;
 VkDescriptorPool gVKGlobalDescriptorPool = VK_NULL_HANDLE;
 
 DeviceEnabledExtensions gVKDeviceEnabledExtensions;
-std::vector<PipelineObjects> gAllPSOs;
-std::vector<ShaderModuleCached> gAllShaderModules;
-std::vector<VkDescriptorSetLayout> gAllDSLayouts;
-std::vector<VkDescriptorSet> gAllDescriptorSets;
+SlotMap<PipelineObjects> gAllPSOs;
+SlotMap<ShaderModuleCached> gAllShaderModules;
+// dynamicBindings: bit per binding written with a *_DYNAMIC descriptor type.
+// slotBindings: binding of every layout slot, images and tables are followed by an extra sampler binding.
+struct DescriptorSetLayoutInfo
+{
+	VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+	u64 dynamicBindings = 0;
+	std::vector<u32> slotBindings;
+};
+
+struct DescriptorSetInfo
+{
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	u64 dynamicBindings = 0;
+	std::vector<u32> slotBindings;
+};
+
+SlotMap<DescriptorSetLayoutInfo> gAllDSLayouts;
+SlotMap<DescriptorSetInfo> gAllDescriptorSets;
 
 VkSampler gVKDefaultLinearSampler = VK_NULL_HANDLE;
 VkSampler gVKDefaultNearestSampler = VK_NULL_HANDLE;
@@ -37,13 +62,14 @@ VkSampler gVKDefaultAnisotropicSampler = VK_NULL_HANDLE;
 
 struct BufferInfo
 {
+	VkBuffer buffer = VK_NULL_HANDLE;
 	VmaAllocation allocation = nullptr;
 	size_t size = 0;
 	void* persistentMappedPtr = nullptr;
+	BufferType type = BufferType::StagingBuffer;
 };
 
-std::vector<VkBuffer> gAllBuffers;
-std::vector<BufferInfo> gAllBufferMetas;
+SlotMap<BufferInfo> gAllBuffers;
 
 struct TextureInfo
 {
@@ -52,9 +78,10 @@ struct TextureInfo
 	VkImageLayout currentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	VkImage image = VK_NULL_HANDLE;
 	VkImageView imageView = VK_NULL_HANDLE;
+	Format format = Format::RGBA8_UNORM;
 };
 
-std::vector<TextureInfo> gAllTextures;
+SlotMap<TextureInfo> gAllTextures;
 
 struct OneTimeSubmitContext
 {
@@ -67,6 +94,40 @@ struct OneTimeSubmitContext
 
 std::vector<OneTimeSubmitContext> gOneTimeSubmitContexts;
 
+// Destroy* calls park the native objects here until the frame timeline passes every frame that could still reference them
+struct DeferredRelease
+{
+	u64 retireValue = 0;
+	std::function<void()> release;
+};
+
+std::deque<DeferredRelease> gDeferredReleases;
+
+void DeferVkRelease(std::function<void()> release)
+{
+	// the frame being recorded signals this value, anything submitted earlier signals less
+	u64 retireValue = GetVkFrameTimelinePendingValue();
+	if (retireValue == 0)
+	{
+		// no swapchain, its shutdown already waited for the frames
+		release();
+		return;
+	}
+
+	gDeferredReleases.push_back({ retireValue, std::move(release) });
+}
+
+void ReleaseDeferredVkObjects(bool all)
+{
+	u64 completedValue = all ? ~0ull : GetVkFrameTimelineCompletedValue();
+
+	while (!gDeferredReleases.empty() && gDeferredReleases.front().retireValue <= completedValue)
+	{
+		gDeferredReleases.front().release();
+		gDeferredReleases.pop_front();
+	}
+}
+
 struct EnabledVKFeatures
 {
 	VkPhysicalDeviceVulkan11Features features11 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES, nullptr};
@@ -82,11 +143,16 @@ struct EnabledVKFeatures
 	VkPhysicalDeviceFragmentShaderBarycentricFeaturesKHR fragmentShaderBarycentricFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADER_BARYCENTRIC_FEATURES_KHR};
 	VkPhysicalDeviceFragmentShaderBarycentricFeaturesNV fragmentShaderBarycentricFeaturesNV = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADER_BARYCENTRIC_FEATURES_NV};
 
+	bool textureTables = false; // runtime sized, partially bound, non-uniformly indexed sampled image arrays
+
 	void *BuildPChains();
 	void *pchain = nullptr;
 
 } gEnabledFeatures;
 
+constexpr u32 VK_MAX_TEXTURE_TABLE_SIZE = 4096; // stays well inside the global descriptor pool
+u32 gVKMaxTextureTableSize = 0;
+
 void *EnabledVKFeatures::BuildPChains()
 {
 	features11.multiview = true;
@@ -102,6 +168,13 @@ void *EnabledVKFeatures::BuildPChains()
 	features12.bufferDeviceAddress = true;
 	features12.uniformAndStorageBuffer8BitAccess = true;
 
+	if (textureTables)
+	{
+		features12.runtimeDescriptorArray = true;
+		features12.descriptorBindingPartiallyBound = true;
+		features12.shaderSampledImageArrayNonUniformIndexing = true;
+	}
+
 	if (gVKConfig.useDynamicRendering)
 	{
 		features13.dynamicRendering = true;
@@ -179,6 +252,252 @@ VkSamplerCreateInfo createDefaultSampler()
 	return sampler_info;
 }
 
+// device-wide pipeline cache, persisted between runs so warm starts skip most shader compilation
+VkPipelineCache gVKPipelineCache = VK_NULL_HANDLE;
+
+// prepended to the driver blob, a file written by another GPU or driver is discarded instead of handed to the driver
+struct PipelineCacheFileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 vendorID;
+	u32 deviceID;
+	u32 driverVersion;
+	u8 pipelineCacheUUID[VK_UUID_SIZE];
+	u64 dataSize;
+	u64 dataHash;
+};
+
+constexpr u32 PipelineCacheFileMagic = 0x4350564D; // 'MVPC'
+constexpr u32 PipelineCacheFileVersion = 1;
+
+struct PipelineCacheStats
+{
+	u32 pipelinesCreated = 0;
+	u32 cacheHits = 0;
+	bool feedbackSupported = false;
+	bool startupReported = false;
+	double totalCreateMs = 0.0;
+	size_t loadedBytes = 0;
+};
+
+PipelineCacheStats gPipelineCacheStats;
+
+static u64 _hashPipelineCacheData(const u8* data, size_t size)
+{
+	// FNV-1a, only has to catch truncated or corrupted files
+	u64 hash = 0xcbf29ce484222325ull;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static void _fillPipelineCacheFileHeader(PipelineCacheFileHeader& header, const VkPhysicalDeviceProperties& props)
+{
+	header.magic = PipelineCacheFileMagic;
+	header.version = PipelineCacheFileVersion;
+	header.vendorID = props.vendorID;
+	header.deviceID = props.deviceID;
+	header.driverVersion = props.driverVersion;
+	memcpy(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static bool _readPipelineCacheFile(const char* path, const VkPhysicalDeviceProperties& props, std::vector<u8>& outData)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f)
+	{
+		MLOG_DEBUG(u8"Pipeline cache: no file at %s, starting cold", path);
+		return false;
+	}
+
+	PipelineCacheFileHeader header = {};
+	PipelineCacheFileHeader expected = {};
+	_fillPipelineCacheFileHeader(expected, props);
+
+	bool valid = fread(&header, sizeof(header), 1, f) == 1
+		&& header.magic == expected.magic
+		&& header.version == expected.version
+		&& header.vendorID == expected.vendorID
+		&& header.deviceID == expected.deviceID
+		&& header.driverVersion == expected.driverVersion
+		&& memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) == 0
+		&& header.dataSize >= sizeof(VkPipelineCacheHeaderVersionOne);
+
+	if (valid)
+	{
+		outData.resize(static_cast<size_t>(header.dataSize));
+		valid = fread(outData.data(), outData.size(), 1, f) == 1
+			&& _hashPipelineCacheData(outData.data(), outData.size()) == header.dataHash;
+	}
+
+	fclose(f);
+
+	if (valid)
+	{
+		// the driver validates its own header too, but a mismatch here is cheaper to report
+		VkPipelineCacheHeaderVersionOne driverHeader = {};
+		memcpy(&driverHeader, outData.data(), sizeof(driverHeader));
+		valid = driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& driverHeader.vendorID == props.vendorID
+			&& driverHeader.deviceID == props.deviceID
+			&& memcmp(driverHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	if (!valid)
+	{
+		MLOG_WARNING(u8"Pipeline cache: %s is stale or corrupted, starting cold", path);
+		outData.clear();
+	}
+
+	return valid;
+}
+
+static void _initializePipelineCache()
+{
+	VkPhysicalDeviceProperties props = {};
+	vkGetPhysicalDeviceProperties(gVKPhysicalDevice, &props);
+
+	std::vector<u8> initialData;
+	if (gVKConfig.pipelineCachePath)
+		_readPipelineCacheFile(gVKConfig.pipelineCachePath, props, initialData);
+
+	VkPipelineCacheCreateInfo create_info = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	create_info.initialDataSize = initialData.size();
+	create_info.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+	if (vkCreatePipelineCache(gVKDevice, &create_info, gVKGlobalAllocationsCallbacks, &gVKPipelineCache) != VK_SUCCESS && !initialData.empty())
+	{
+		MLOG_WARNING(u8"Pipeline cache: driver rejected cached data, starting cold");
+		initialData.clear();
+		create_info.initialDataSize = 0;
+		create_info.pInitialData = nullptr;
+		VK_CALL(vkCreatePipelineCache(gVKDevice, &create_info, gVKGlobalAllocationsCallbacks, &gVKPipelineCache));
+	}
+
+	gPipelineCacheStats = {};
+	gPipelineCacheStats.loadedBytes = initialData.size();
+	// creation feedback is core since 1.3, older devices only get timings
+	gPipelineCacheStats.feedbackSupported = gPhysicalDeviceAPIVersion >= VK_API_VERSION_1_3;
+
+	MLOG_DEBUG(u8"Pipeline cache: created with %zu bytes of initial data", initialData.size());
+}
+
+static void _reportPipelineCacheStats(const char8_t* when)
+{
+	const auto& stats = gPipelineCacheStats;
+	if (stats.feedbackSupported)
+	{
+		float hitRate = stats.pipelinesCreated > 0 ? 100.0f * stats.cacheHits / stats.pipelinesCreated : 0.0f;
+		MLOG_INFO(u8"Pipeline cache (%s): %u pipelines, %u cache hits (%.1f%%), %.2f ms creating, %zu bytes loaded",
+			when, stats.pipelinesCreated, stats.cacheHits, hitRate, stats.totalCreateMs, stats.loadedBytes);
+	}
+	else
+	{
+		MLOG_INFO(u8"Pipeline cache (%s): %u pipelines, %.2f ms creating, %zu bytes loaded (hit rate needs Vulkan 1.3)",
+			when, stats.pipelinesCreated, stats.totalCreateMs, stats.loadedBytes);
+	}
+}
+
+static void _shutdownPipelineCache()
+{
+	if (gVKPipelineCache == VK_NULL_HANDLE)
+		return;
+
+	_reportPipelineCacheStats(u8"shutdown");
+
+	const char* path = gVKConfig.pipelineCachePath;
+	size_t dataSize = 0;
+	std::vector<u8> data;
+
+	if (path && vkGetPipelineCacheData(gVKDevice, gVKPipelineCache, &dataSize, nullptr) == VK_SUCCESS && dataSize > 0)
+	{
+		data.resize(dataSize);
+		if (vkGetPipelineCacheData(gVKDevice, gVKPipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+			data.clear();
+		else
+			data.resize(dataSize);
+	}
+
+	if (!data.empty())
+	{
+		VkPhysicalDeviceProperties props = {};
+		vkGetPhysicalDeviceProperties(gVKPhysicalDevice, &props);
+
+		PipelineCacheFileHeader header = {};
+		_fillPipelineCacheFileHeader(header, props);
+		header.dataSize = data.size();
+		header.dataHash = _hashPipelineCacheData(data.data(), data.size());
+
+		// write next to the target and rename over it, a crash mid-write never leaves a torn cache behind
+		std::string tmpPath = std::string(path) + ".tmp";
+		bool written = false;
+		if (FILE* f = fopen(tmpPath.c_str(), "wb"))
+		{
+			written = fwrite(&header, sizeof(header), 1, f) == 1
+				&& fwrite(data.data(), data.size(), 1, f) == 1;
+			written = (fclose(f) == 0) && written;
+		}
+
+		std::error_code ec;
+		if (written)
+			std::filesystem::rename(tmpPath, path, ec);
+
+		if (!written || ec)
+		{
+			MLOG_WARNING(u8"Pipeline cache: failed to write %s", path);
+			std::filesystem::remove(tmpPath, ec);
+		}
+		else
+		{
+			MLOG_DEBUG(u8"Pipeline cache: saved %zu bytes to %s", data.size(), path);
+		}
+	}
+
+	vkDestroyPipelineCache(gVKDevice, gVKPipelineCache, gVKGlobalAllocationsCallbacks);
+	gVKPipelineCache = VK_NULL_HANDLE;
+}
+
+// wraps vkCreate*Pipelines, timing every creation and reading back whether the cache served it
+struct PipelineCreationScope
+{
+	VkPipelineCreationFeedback pipelineFeedback = {};
+	VkPipelineCreationFeedbackCreateInfo feedbackInfo = { VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO };
+	std::chrono::steady_clock::time_point start;
+
+	PipelineCreationScope()
+	{
+		feedbackInfo.pPipelineCreationFeedback = &pipelineFeedback;
+		start = std::chrono::steady_clock::now();
+	}
+
+	void Chain(const void*& pNext)
+	{
+		if (!gPipelineCacheStats.feedbackSupported)
+			return;
+
+		feedbackInfo.pNext = pNext;
+		pNext = &feedbackInfo;
+	}
+
+	~PipelineCreationScope()
+	{
+		auto& stats = gPipelineCacheStats;
+		stats.totalCreateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		stats.pipelinesCreated++;
+
+		if (stats.feedbackSupported
+			&& (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)
+			&& (pipelineFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT))
+		{
+			stats.cacheHits++;
+		}
+	}
+};
+
 void Device::Initialize()
 {
 	MLOG_DEBUG(u8"Initialize Device (Vulkan)");
@@ -343,6 +662,33 @@ void Device::Initialize()
 	// 	device_extender.TryAddExtension(VK_KHR_PORTABILITY_SUBSET_EXTENSION_NAME);
 	// #endif
 
+	if (gPhysicalDeviceAPIVersion >= Ver12)
+	{
+		VkPhysicalDeviceVulkan12Features supportedFeatures12 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES, nullptr };
+		VkPhysicalDeviceFeatures2 supportedFeatures2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &supportedFeatures12 };
+		vkGetPhysicalDeviceFeatures2(gVKPhysicalDevice, &supportedFeatures2);
+
+		gEnabledFeatures.textureTables = supportedFeatures12.runtimeDescriptorArray
+			&& supportedFeatures12.descriptorBindingPartiallyBound
+			&& supportedFeatures12.shaderSampledImageArrayNonUniformIndexing;
+	}
+
+	if (gEnabledFeatures.textureTables)
+	{
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(gVKPhysicalDevice, &properties);
+
+		gVKMaxTextureTableSize = std::min({ VK_MAX_TEXTURE_TABLE_SIZE,
+			properties.limits.maxPerStageDescriptorSampledImages,
+			properties.limits.maxDescriptorSetSampledImages });
+
+		MLOG_DEBUG(u8"Texture tables enabled, up to %u textures", gVKMaxTextureTableSize);
+	}
+	else
+	{
+		MLOG_DEBUG(u8"Texture tables not supported");
+	}
+
 	enabledFeatures10.imageCubeArray = supportedFeatures.imageCubeArray;
 	enabledFeatures10.fillModeNonSolid = supportedFeatures.fillModeNonSolid;
 	enabledFeatures10.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
@@ -505,16 +851,30 @@ void Device::Initialize()
 			vkCreateFence(gVKDevice, &fence_info, nullptr, &context.fence);
 		}
 	}
+
+	_initializePipelineCache();
 }
 
 void Device::Shutdown()
 {
 	MLOG_DEBUG(u8"Shutdown Device (Vulkan)");
+
+	vkDeviceWaitIdle(gVKDevice);
+	ReleaseDeferredVkObjects(true);
+
+	_shutdownPipelineCache();
 }
 
 void Device::Tick()
 {
-	// MLOG_DEBUG(u8"Tick Device (NULL)");
+	ReleaseDeferredVkObjects(false);
+
+	// everything created before the first frame is startup cost, report it once
+	if (!gPipelineCacheStats.startupReported)
+	{
+		gPipelineCacheStats.startupReported = true;
+		_reportPipelineCacheStats(u8"startup");
+	}
 }
 
 void Device::InitializeSwapchain()
@@ -615,7 +975,7 @@ void Device::ImguiInitialize()
 	init_info.Device = gVKDevice;
 	init_info.QueueFamily = 0;
 	init_info.Queue = gVKGraphicsQueue;
-	init_info.PipelineCache = VK_NULL_HANDLE; //TODO: implement pipeline cache
+	init_info.PipelineCache = gVKPipelineCache;
 	init_info.Allocator = nullptr;
 	init_info.MinImageCount = 3;
 	init_info.ImageCount = 3;
@@ -685,9 +1045,8 @@ void _createShaderModuleCache(const ShaderBytecodeView& bytecode, ShaderModuleCa
 ShaderHandle Device::CreateShaderModule(const ShaderBytecodeView& bytecode)
 {
 	ShaderHandle result;
-	auto& psoOut = gAllShaderModules.emplace_back();
-	result.handle = static_cast<u32>(gAllShaderModules.size() - 1);
-	_createShaderModuleCache(bytecode, psoOut);
+	result.handle = gAllShaderModules.Emplace();
+	_createShaderModuleCache(bytecode, gAllShaderModules[result.handle]);
 	return result;
 }
 
@@ -700,6 +1059,7 @@ void Device::UpdateShaderModule(ShaderHandle shaderModuleID, const ShaderBytecod
 void Device::DestroyShaderModule(ShaderHandle shaderModuleID)
 {
 	vkDestroyShaderModule(gVKDevice, gAllShaderModules[shaderModuleID.handle].module, gVKGlobalAllocationsCallbacks);
+	gAllShaderModules.Remove(shaderModuleID.handle);
 }
 
 VkPrimitiveTopology fromMercuryPrimitiveTopology(PrimitiveTopology topology)
@@ -724,7 +1084,7 @@ VkPrimitiveTopology fromMercuryPrimitiveTopology(PrimitiveTopology topology)
 	}
 }
 
-void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects& out)
+void _createPipelineLayout(const PipelineBindingLayoutDescriptor& desc, VkPipelineLayout& out)
 {
 	VkPipelineLayoutCreateInfo layoutCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};	
 
@@ -740,6 +1100,7 @@ void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects
 	}
 
 	std::vector<VkDescriptorSetLayout> setLayouts;
+	std::vector<ParameterBlockLayoutHandle> setLayoutHandles;
 
 	for (int i = 0; i < 4; ++i)
 	{
@@ -750,7 +1111,8 @@ void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects
 
 		IF_LIKELY (outLayout.isValid())
 		{
-			setLayouts.push_back(gAllDSLayouts[outLayout.handle]);
+			setLayouts.push_back(gAllDSLayouts[outLayout.handle].layout);
+			setLayoutHandles.push_back(outLayout);
 		}
 	}
 
@@ -761,8 +1123,18 @@ void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects
 	layoutCreateInfo.setLayoutCount = static_cast<u32>(setLayouts.size());
 	layoutCreateInfo.pSetLayouts = setLayouts.data();
 
-	vkCreatePipelineLayout(gVKDevice, &layoutCreateInfo, gVKGlobalAllocationsCallbacks, &out.pipelineLayout);
+	vkCreatePipelineLayout(gVKDevice, &layoutCreateInfo, gVKGlobalAllocationsCallbacks, &out);
 
+	// set layouts are only needed while creating the pipeline layout, release them right away
+	for (auto layoutHandle : setLayoutHandles)
+	{
+		gDevice->DestroyParameterBlockLayout(layoutHandle);
+	}
+}
+
+void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects& out)
+{
+	_createPipelineLayout(desc, out.pipelineLayout);
 
 	VkGraphicsPipelineCreateInfo psoCreateInfo = { VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
 	psoCreateInfo.layout = out.pipelineLayout;
@@ -828,7 +1200,13 @@ void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects
 	multisampleState.rasterizationSamples = gVKSurfaceSamples;
 
 	VkPipelineColorBlendAttachmentState attachment = {};
-	attachment.blendEnable = false;
+	attachment.blendEnable = desc.blendMode != BlendMode::Opaque;
+	attachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	attachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	attachment.colorBlendOp = VK_BLEND_OP_ADD;
+	attachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	attachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	attachment.alphaBlendOp = VK_BLEND_OP_ADD;
 	attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
 	colorBlendState.attachmentCount = 1;
 	colorBlendState.pAttachments = &attachment;
@@ -856,7 +1234,9 @@ void _createGraphicsPSO(const RasterizePipelineDescriptor& desc, PipelineObjects
 	psoCreateInfo.pColorBlendState =  &colorBlendState; // TODO: color blend state
 	psoCreateInfo.pDynamicState = &dynamicState; // TODO: dynamic state
 	
-	VK_CALL(vkCreateGraphicsPipelines(gVKDevice, VK_NULL_HANDLE, 1, &psoCreateInfo, gVKGlobalAllocationsCallbacks, &out.pipeline));
+	PipelineCreationScope creationScope;
+	creationScope.Chain(psoCreateInfo.pNext);
+	VK_CALL(vkCreateGraphicsPipelines(gVKDevice, gVKPipelineCache, 1, &psoCreateInfo, gVKGlobalAllocationsCallbacks, &out.pipeline));
 
 	//desc.fragmentShader.size
 	//psoCreateInfo.stageCount = 0; // TODO: shader stages
@@ -866,19 +1246,26 @@ PsoHandle Device::CreateRasterizePipeline(const RasterizePipelineDescriptor& des
 {	
 	PsoHandle result;
 
-	auto& psoOut = gAllPSOs.emplace_back();
-	result.handle = static_cast<u32>(gAllPSOs.size() - 1);
+	result.handle = gAllPSOs.Emplace();
 
-	_createGraphicsPSO(desc, psoOut);
+	_createGraphicsPSO(desc, gAllPSOs[result.handle]);
 	
 	return result;
 }
 
+static void _deferDestroyPipelineObjects(VkPipeline pipeline, VkPipelineLayout layout)
+{
+	DeferVkRelease([pipeline, layout]()
+		{
+			vkDestroyPipeline(gVKDevice, pipeline, gVKGlobalAllocationsCallbacks);
+			vkDestroyPipelineLayout(gVKDevice, layout, gVKGlobalAllocationsCallbacks);
+		});
+}
+
 void Device::DestroyRasterizePipeline(PsoHandle psoID)
 {
-	//TODO: Think about delayed descruction while GPU is using old PSO
-	vkDestroyPipeline(gVKDevice, gAllPSOs[psoID.handle].pipeline, gVKGlobalAllocationsCallbacks);
-	vkDestroyPipelineLayout(gVKDevice, gAllPSOs[psoID.handle].pipelineLayout, gVKGlobalAllocationsCallbacks);
+	_deferDestroyPipelineObjects(gAllPSOs[psoID.handle].pipeline, gAllPSOs[psoID.handle].pipelineLayout);
+	gAllPSOs.Remove(psoID.handle);
 }
 
 void Device::UpdatePipelineState(PsoHandle psoID, const RasterizePipelineDescriptor& desc)
@@ -888,9 +1275,42 @@ void Device::UpdatePipelineState(PsoHandle psoID, const RasterizePipelineDescrip
 
 	_createGraphicsPSO(desc, gAllPSOs[psoID.handle]);
 
-	//TODO: Think about delayed descruction while GPU is using old PSO
-	//vkDestroyPipeline(gVKDevice, oldPipeline, gVKGlobalAllocationsCallbacks);
-	//vkDestroyPipelineLayout(gVKDevice, oldLayout, gVKGlobalAllocationsCallbacks);
+	_deferDestroyPipelineObjects(oldPipeline, oldLayout);
+}
+
+void _createComputePSO(const ComputePipelineDescriptor& desc, PipelineObjects& out)
+{
+	_createPipelineLayout(desc, out.pipelineLayout);
+
+	VkComputePipelineCreateInfo psoCreateInfo = { VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO };
+	psoCreateInfo.layout = out.pipelineLayout;
+	psoCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	psoCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	psoCreateInfo.stage.module = gAllShaderModules[desc.computeShader.handle].module;
+	psoCreateInfo.stage.pName = "main";
+
+	PipelineCreationScope creationScope;
+	creationScope.Chain(psoCreateInfo.pNext);
+	VK_CALL(vkCreateComputePipelines(gVKDevice, gVKPipelineCache, 1, &psoCreateInfo, gVKGlobalAllocationsCallbacks, &out.pipeline));
+
+	out.bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+}
+
+PsoHandle Device::CreateComputePipeline(const ComputePipelineDescriptor& desc)
+{
+	PsoHandle result;
+
+	result.handle = gAllPSOs.Emplace();
+
+	_createComputePSO(desc, gAllPSOs[result.handle]);
+
+	return result;
+}
+
+void Device::DestroyComputePipeline(PsoHandle psoID)
+{
+	_deferDestroyPipelineObjects(gAllPSOs[psoID.handle].pipeline, gAllPSOs[psoID.handle].pipelineLayout);
+	gAllPSOs.Remove(psoID.handle);
 }
 
 void CommandList::RenderImgui()
@@ -900,7 +1320,7 @@ void CommandList::RenderImgui()
 
 void CommandList::SetPSO(PsoHandle psoID)
 {
-	vkCmdBindPipeline(static_cast<VkCommandBuffer>(nativePtr), VK_PIPELINE_BIND_POINT_GRAPHICS, gAllPSOs[psoID.handle].pipeline);
+	vkCmdBindPipeline(static_cast<VkCommandBuffer>(nativePtr), gAllPSOs[psoID.handle].bindPoint, gAllPSOs[psoID.handle].pipeline);
 
 	currentPsoID = psoID;
 	currentPSOnativePtr = gAllPSOs[psoID.handle].pipeline;
@@ -912,6 +1332,34 @@ void CommandList::Draw(u32 vertexCount, u32 instanceCount, u32 firstVertex, u32
 	vkCmdDraw(static_cast<VkCommandBuffer>(nativePtr), vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void CommandList::DrawIndirect(BufferHandle bufferID, size_t offset)
+{
+	static_assert(sizeof(DrawIndirectArguments) == sizeof(VkDrawIndirectCommand));
+
+	vkCmdDrawIndirect(static_cast<VkCommandBuffer>(nativePtr), gAllBuffers[bufferID.handle].buffer, static_cast<VkDeviceSize>(offset), 1, sizeof(VkDrawIndirectCommand));
+}
+
+void CommandList::Dispatch(u32 groupCountX, u32 groupCountY, u32 groupCountZ)
+{
+	vkCmdDispatch(static_cast<VkCommandBuffer>(nativePtr), groupCountX, groupCountY, groupCountZ);
+}
+
+void CommandList::DispatchBarrier()
+{
+	VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	// also orders against later submissions, so one time compute lists can feed the frame command list
+	vkCmdPipelineBarrier(static_cast<VkCommandBuffer>(nativePtr),
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+}
+
 void CommandList::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
 {
 	VkViewport viewport;
@@ -952,18 +1400,29 @@ void CommandList::PushConstants(const void* data, size_t size)
 
 void Device::DestroyBuffer(BufferHandle bufferID)
 {
-	// Implementation for destroying a buffer
+	auto* meta = gAllBuffers.Get(bufferID.handle);
+	if (meta == nullptr)
+	{
+		MLOG_WARNING(u8"DestroyBuffer: invalid buffer handle (%u)", bufferID.handle);
+		return;
+	}
+
+	DeferVkRelease([buffer = meta->buffer, allocation = meta->allocation]()
+		{
+			vmaDestroyBuffer(gVMA_Allocator, buffer, allocation);
+		});
+	gAllBuffers.Remove(bufferID.handle);
 }
 
 void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size, size_t offset)
 {
-	const u32 idx = bufferID.handle;
-	if (idx >= gAllBufferMetas.size())
+	auto* metaPtr = gAllBuffers.Get(bufferID.handle);
+	if (metaPtr == nullptr)
 	{
-		MLOG_WARNING(u8"UpdateBuffer: invalid buffer handle (%u)", idx);
+		MLOG_WARNING(u8"UpdateBuffer: invalid buffer handle (%u)", bufferID.handle);
 		return;
 	}
-	auto& meta = gAllBufferMetas[idx];
+	auto& meta = *metaPtr;
 
 	if ((offset + size) > meta.size)
 	{
@@ -987,6 +1446,32 @@ void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size,
 	vmaFlushAllocation(gVMA_Allocator, meta.allocation, static_cast<VkDeviceSize>(offset), static_cast<VkDeviceSize>(size));
 }
 
+void* Device::GetMappedBufferPointer(BufferHandle bufferID)
+{
+	auto* meta = gAllBuffers.Get(bufferID.handle);
+	if (meta == nullptr)
+	{
+		MLOG_WARNING(u8"GetMappedBufferPointer: invalid buffer handle (%u)", bufferID.handle);
+		return nullptr;
+	}
+
+	// every buffer is created with VMA_ALLOCATION_CREATE_MAPPED_BIT
+	return meta->persistentMappedPtr;
+}
+
+void Device::FlushBuffer(BufferHandle bufferID, size_t offset, size_t size)
+{
+	auto* meta = gAllBuffers.Get(bufferID.handle);
+	if (meta == nullptr)
+	{
+		MLOG_WARNING(u8"FlushBuffer: invalid buffer handle (%u)", bufferID.handle);
+		return;
+	}
+
+	// no-op if memory is HOST_COHERENT
+	vmaFlushAllocation(gVMA_Allocator, meta->allocation, static_cast<VkDeviceSize>(offset), static_cast<VkDeviceSize>(size));
+}
+
 BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 {
 	auto size = desc.size;
@@ -994,6 +1479,10 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	VkBufferCreateInfo bufCI{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
 	bufCI.size = static_cast<VkDeviceSize>(size);
 	bufCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT; // uniform buffer usage
+	if (desc.type == BufferType::StorageBuffer)
+		bufCI.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	if (desc.type == BufferType::IndirectBuffer)
+		bufCI.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
 	bufCI.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 	VmaAllocationCreateInfo allocCI{};
@@ -1012,9 +1501,11 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 	VK_CALL(vmaCreateBuffer(gVMA_Allocator, &bufCI, &allocCI, &vkBuf, &allocation, &allocInfo));
 
 	BufferInfo meta{};
+	meta.buffer = vkBuf;
 	meta.allocation = allocation;
 	meta.size = size;
 	meta.persistentMappedPtr = allocInfo.pMappedData; // persistent map
+	meta.type = desc.type;
 
 	if (desc.initialData != nullptr)
 	{
@@ -1024,11 +1515,8 @@ BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 		vmaFlushAllocation(gVMA_Allocator, meta.allocation, 0, static_cast<VkDeviceSize>(size));
 	}
 
-	gAllBuffers.push_back(vkBuf);
-	gAllBufferMetas.push_back(meta);
-
 	BufferHandle h;
-	h.handle = static_cast<u32>(gAllBuffers.size() - 1);
+	h.handle = gAllBuffers.Emplace(meta);
 	return h;
 }
 
@@ -1039,16 +1527,21 @@ ParameterBlockLayoutHandle Device::CreateParameterBlockLayout(const BindingSetLa
 		return ParameterBlockLayoutHandle{ ParameterBlockLayoutHandle::InvalidValue };
 	}
 
-	VkDescriptorSetLayout& outLayout = gAllDSLayouts.emplace_back();;
+	ParameterBlockLayoutHandle result;
+	result.handle = gAllDSLayouts.Emplace();
+	DescriptorSetLayoutInfo& outLayout = gAllDSLayouts[result.handle];
 
 	VkDescriptorSetLayoutCreateInfo createInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
+	std::vector<VkDescriptorBindingFlags> bindingFlags;
+	bool hasTextureTables = false;
 	u32 additionalSlots = 0;
 
 	for (int s = 0; s < layoutDesc.allSlots.size(); ++s)
 	{
 		VkDescriptorSetLayoutBinding bindingDesc = {};
 		const auto& slot = layoutDesc.allSlots[s];
+		outLayout.slotBindings.push_back(s + additionalSlots);
 
 		if (slot.resourceType == ShaderResourceType::UniformBuffer)
 		{
@@ -1059,6 +1552,27 @@ ParameterBlockLayoutHandle Device::CreateParameterBlockLayout(const BindingSetLa
 			bindingDesc.pImmutableSamplers = nullptr;
 		}
 
+		if (slot.resourceType == ShaderResourceType::DynamicUniformBuffer)
+		{
+			MERCURY_ASSERT(s + additionalSlots < 64);
+
+			bindingDesc.binding = s + additionalSlots;
+			bindingDesc.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			bindingDesc.descriptorCount = 1;
+			bindingDesc.stageFlags = VK_SHADER_STAGE_ALL; // TODO: specify stages
+			bindingDesc.pImmutableSamplers = nullptr;
+			outLayout.dynamicBindings |= 1ull << bindingDesc.binding;
+		}
+
+		if (slot.resourceType == ShaderResourceType::ReadOnlyBuffer || slot.resourceType == ShaderResourceType::RWBuffer)
+		{
+			bindingDesc.binding = s + additionalSlots;
+			bindingDesc.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			bindingDesc.descriptorCount = 1;
+			bindingDesc.stageFlags = VK_SHADER_STAGE_ALL; // TODO: specify stages
+			bindingDesc.pImmutableSamplers = nullptr;
+		}
+
 		if (slot.resourceType == ShaderResourceType::SampledImage2D)
 		{
 			bindingDesc.binding = s + additionalSlots;
@@ -1076,87 +1590,173 @@ ParameterBlockLayoutHandle Device::CreateParameterBlockLayout(const BindingSetLa
 			bindingDesc.pImmutableSamplers = &gVKDefaultLinearSampler;
 		}
 
+		if (slot.resourceType == ShaderResourceType::SampledImage2DTable)
+		{
+			MERCURY_ASSERT(slot.arraySize <= gVKMaxTextureTableSize);
+
+			bindingDesc.binding = s + additionalSlots;
+			bindingDesc.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+			bindingDesc.descriptorCount = slot.arraySize;
+			bindingDesc.stageFlags = VK_SHADER_STAGE_ALL; // TODO: specify stages
+			bindingDesc.pImmutableSamplers = nullptr;
+			bindings.push_back(bindingDesc);
+			bindingFlags.resize(bindings.size(), 0);
+			bindingFlags.back() = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+			hasTextureTables = true;
+
+			additionalSlots++;
+			bindingDesc.binding = s + additionalSlots;
+			bindingDesc.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+			bindingDesc.descriptorCount = 1;
+			bindingDesc.stageFlags = VK_SHADER_STAGE_ALL; // TODO: specify stages
+			bindingDesc.pImmutableSamplers = &gVKDefaultLinearSampler;
+		}
+
 		bindings.push_back(bindingDesc);
 	}
 
 	createInfo.bindingCount = static_cast<u32>(bindings.size());
 	createInfo.pBindings = bindings.data();
 
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+	if (hasTextureTables)
+	{
+		bindingFlags.resize(bindings.size(), 0);
+		bindingFlagsInfo.bindingCount = static_cast<u32>(bindingFlags.size());
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+		createInfo.pNext = &bindingFlagsInfo;
+	}
+
 	if (createInfo.bindingCount > 0)
 	{
-		vkCreateDescriptorSetLayout(gVKDevice, &createInfo, gVKGlobalAllocationsCallbacks, &outLayout);
+		vkCreateDescriptorSetLayout(gVKDevice, &createInfo, gVKGlobalAllocationsCallbacks, &outLayout.layout);
 	}
 
-	return ParameterBlockLayoutHandle{static_cast<u32>(gAllDSLayouts.size() - 1)};
+	return result;
 }
 
 void Device::DestroyParameterBlockLayout(ParameterBlockLayoutHandle layoutID)
 {
-	//vkAllocateDescriptorSets()
-	// Implementation for destroying a parameter block layout
+	auto* layout = gAllDSLayouts.Get(layoutID.handle);
+	if (layout == nullptr)
+		return;
+
+	if (layout->layout != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorSetLayout(gVKDevice, layout->layout, gVKGlobalAllocationsCallbacks);
+	}
+
+	gAllDSLayouts.Remove(layoutID.handle);
 }
 
 void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID)
 {
 	auto cmdBuff = static_cast<VkCommandBuffer>(nativePtr);
+	const DescriptorSetInfo& ds = gAllDescriptorSets[parameterBlockID.handle];
+
+	// every dynamic descriptor needs an offset, zero keeps the one the buffer was written with
+	static constexpr u32 zeroOffsets[64] = {};
 
 	vkCmdBindDescriptorSets(
 		cmdBuff,
-		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		gAllPSOs[currentPsoID.handle].bindPoint,
 		static_cast<VkPipelineLayout>(currentPSOLayoutNativePtr),
 		setIndex,
 		1,
-		&gAllDescriptorSets[parameterBlockID.handle],
-		0,
-		nullptr
+		&ds.set,
+		static_cast<u32>(std::popcount(ds.dynamicBindings)),
+		zeroOffsets
+	);
+}
+
+void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID, std::span<const u32> dynamicOffsets)
+{
+	auto cmdBuff = static_cast<VkCommandBuffer>(nativePtr);
+	const DescriptorSetInfo& ds = gAllDescriptorSets[parameterBlockID.handle];
+
+	MERCURY_ASSERT(dynamicOffsets.size() == static_cast<size_t>(std::popcount(ds.dynamicBindings)));
+
+	vkCmdBindDescriptorSets(
+		cmdBuff,
+		gAllPSOs[currentPsoID.handle].bindPoint,
+		static_cast<VkPipelineLayout>(currentPSOLayoutNativePtr),
+		setIndex,
+		1,
+		&ds.set,
+		static_cast<u32>(dynamicOffsets.size()),
+		dynamicOffsets.data()
 	);
 }
 
 ParameterBlockHandle Device::CreateParameterBlock(const ParameterBlockLayoutHandle& layoutID)
 {
-	auto& ds = gAllDescriptorSets.emplace_back();
+	ParameterBlockHandle result;
+	result.handle = gAllDescriptorSets.Emplace();
+	auto& ds = gAllDescriptorSets[result.handle];
+	const auto& layout = gAllDSLayouts[layoutID.handle];
+	ds.dynamicBindings = layout.dynamicBindings;
+	ds.slotBindings = layout.slotBindings;
 
 	VkDescriptorSetAllocateInfo cinfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
 	cinfo.descriptorPool = gVKGlobalDescriptorPool;
 	cinfo.descriptorSetCount = 1;
-	cinfo.pSetLayouts = &gAllDSLayouts[layoutID.handle];
+	cinfo.pSetLayouts = &layout.layout;
 
-	vkAllocateDescriptorSets(gVKDevice, &cinfo, &ds);
+	vkAllocateDescriptorSets(gVKDevice, &cinfo, &ds.set);
 
-	return ParameterBlockHandle{ static_cast<u32>(gAllDescriptorSets.size() - 1) };
+	return result;
 }
 
 void Device::UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const ParameterBlockDescriptor& pbDesc)
 {
-	std::vector<VkWriteDescriptorSet> writes;
-	std::vector<VkDescriptorBufferInfo> bufferInfos;
-	std::vector<VkDescriptorImageInfo>  imageInfos;
+	memory::FrameVector<VkWriteDescriptorSet> writes;
+	memory::FrameVector<VkDescriptorBufferInfo> bufferInfos;
+	memory::FrameVector<VkDescriptorImageInfo>  imageInfos;
+
+	const DescriptorSetInfo& ds = gAllDescriptorSets[parameterBlockID.handle];
+	MERCURY_ASSERT(pbDesc.resources.size() <= ds.slotBindings.size());
 
 	u32 slotIndex = 0;
+	size_t numImageInfos = 0;
+	for (const auto& res : pbDesc.resources)
+	{
+		const auto* table = std::get_if<ParameterResourceTextureTable>(&res);
+		numImageInfos += table ? table->textures.size() : 1;
+	}
+
+	// infos are referenced by pointer from the writes, no reallocation allowed
 	writes.reserve(pbDesc.resources.size());
 	bufferInfos.reserve(pbDesc.resources.size());
-	imageInfos.reserve(pbDesc.resources.size());
+	imageInfos.reserve(numImageInfos);
 
 	for (const auto& res : pbDesc.resources)
 	{
+		// resources follow the layout slots, which are not the bindings once an image added its sampler
+		const u32 binding = ds.slotBindings[slotIndex];
+
 		std::visit([&](auto&& arg)
 			{
 				using T = std::decay_t<decltype(arg)>;
 
 				if constexpr (std::is_same_v<T, ParameterResourceBuffer>)
 				{
+					const BufferInfo& meta = gAllBuffers[arg.buffer.handle];
+
 					VkDescriptorBufferInfo bi{};
-					bi.buffer = gAllBuffers[arg.buffer.handle];
+					bi.buffer = meta.buffer;
 					bi.offset = static_cast<VkDeviceSize>(arg.offset);
 					bi.range = (arg.size == SIZE_MAX) ? VK_WHOLE_SIZE : static_cast<VkDeviceSize>(arg.size);
 
 					bufferInfos.push_back(bi);
 
 					VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-					w.dstSet = gAllDescriptorSets[parameterBlockID.handle];
-					w.dstBinding = slotIndex;
+					w.dstSet = ds.set;
+					w.dstBinding = binding;
 					w.descriptorCount = 1;
-					w.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+					const bool isStorage = meta.type == BufferType::StorageBuffer || meta.type == BufferType::IndirectBuffer;
+					const bool isDynamic = (ds.dynamicBindings >> binding) & 1;
+					w.descriptorType = isDynamic ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+						: isStorage ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 					w.pBufferInfo = &bufferInfos.back();
 
 					writes.push_back(w);
@@ -1170,8 +1770,8 @@ void Device::UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const P
 					imageInfos.push_back(ii);
 
 					VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
-					w.dstSet = gAllDescriptorSets[parameterBlockID.handle];
-					w.dstBinding = slotIndex;
+					w.dstSet = ds.set;
+					w.dstBinding = binding;
 					w.descriptorCount = 1;
 					w.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
 					w.pImageInfo = &imageInfos.back();
@@ -1180,6 +1780,31 @@ void Device::UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const P
 
 					MLOG_WARNING(u8"ParameterResourceTexture not yet implemented in UpdateParameterBlock");
 				}
+				else if constexpr (std::is_same_v<T, ParameterResourceTextureTable>)
+				{
+					if (arg.textures.empty())
+						return;
+
+					const size_t firstInfo = imageInfos.size();
+					for (const auto& texture : arg.textures)
+					{
+						VkDescriptorImageInfo ii{};
+						ii.imageView = gAllTextures[texture.handle].imageView;
+						ii.sampler = VK_NULL_HANDLE;
+						ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+						imageInfos.push_back(ii);
+					}
+
+					VkWriteDescriptorSet w{ VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+					w.dstSet = ds.set;
+					w.dstBinding = binding;
+					w.dstArrayElement = arg.firstElement;
+					w.descriptorCount = static_cast<u32>(arg.textures.size());
+					w.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+					w.pImageInfo = &imageInfos[firstInfo];
+
+					writes.push_back(w);
+				}
 				else if constexpr (std::is_same_v<T, ParameterResourceRWImage>)
 				{
 					// TODO: Fill VkDescriptorImageInfo for storage image
@@ -1200,24 +1825,45 @@ void Device::UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const P
 	}
 }
 
+u32 Device::GetMaxTextureTableSize()
+{
+	return gVKMaxTextureTableSize;
+}
+
 void Device::DestroyParameterBlock(ParameterBlockHandle parameterBlockID)
 {
+	auto* ds = gAllDescriptorSets.Get(parameterBlockID.handle);
+	if (ds == nullptr)
+		return;
 
+	if (ds->set != VK_NULL_HANDLE)
+	{
+		DeferVkRelease([set = ds->set]()
+			{
+				vkFreeDescriptorSets(gVKDevice, gVKGlobalDescriptorPool, 1, &set);
+			});
+	}
+
+	gAllDescriptorSets.Remove(parameterBlockID.handle);
 }
 
 TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 {
 	TextureHandle result;
-	result.handle = static_cast<u32>(gAllTextures.size());
+	result.handle = gAllTextures.Emplace();
 
-	auto& texOut = gAllTextures.emplace_back();
+	auto& texOut = gAllTextures[result.handle];
+	texOut.format = desc.format;
+
+	VkFormat vkFormat = vk_utils::ToVkFormat(desc.format);
+	MERCURY_ASSERT(vkFormat != VK_FORMAT_UNDEFINED);
 
 	VmaAllocationCreateInfo vmaAllocCI{};
 	vmaAllocCI.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
 	VkImageCreateInfo imageCI{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
 	imageCI.imageType = VK_IMAGE_TYPE_2D;
-	imageCI.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageCI.format = vkFormat;
 	imageCI.extent.width = static_cast<u32>(desc.width);
 	imageCI.extent.height = static_cast<u32>(desc.height);
 	imageCI.extent.depth = 1;
@@ -1232,7 +1878,7 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 
 	VkImageViewCreateInfo imageViewCI{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
 
-	imageViewCI.format = VK_FORMAT_R8G8B8A8_UNORM;
+	imageViewCI.format = vkFormat;
 	imageViewCI.image = texOut.image;
 	imageViewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
 	imageViewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -1246,7 +1892,7 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 	if (desc.initialData != nullptr)
 	{
 		BufferDescriptor stagingDesc{};
-		stagingDesc.size = desc.width * desc.height * 4; // TODO: calculate proper size based on format
+		stagingDesc.size = GetFormatDataSize(desc.format, desc.width, desc.height);
 		stagingDesc.initialData = desc.initialData;
 
 		BufferHandle stagingBuffer = gDevice->CreateBuffer(stagingDesc);
@@ -1290,7 +1936,7 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 
 				vkCmdCopyBufferToImage(
 					static_cast<VkCommandBuffer>(cmdList.nativePtr),
-					gAllBuffers[stagingBuffer.handle],
+					gAllBuffers[stagingBuffer.handle].buffer,
 					texOut.image,
 					VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 					1,
@@ -1318,6 +1964,10 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 					0, nullptr,
 					0, nullptr,
 					1, &barrierToShaderRead);
+			},
+			[stagingBuffer]()
+			{
+				gDevice->DestroyBuffer(stagingBuffer);
 			});
 	}
 
@@ -1326,7 +1976,19 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 
 void Device::DestroyTexture(TextureHandle textureID)
 {
+	auto* tex = gAllTextures.Get(textureID.handle);
+	if (tex == nullptr)
+	{
+		MLOG_WARNING(u8"DestroyTexture: invalid texture handle (%u)", textureID.handle);
+		return;
+	}
 
+	DeferVkRelease([imageView = tex->imageView, image = tex->image, allocation = tex->allocation]()
+		{
+			vkDestroyImageView(gVKDevice, imageView, gVKGlobalAllocationsCallbacks);
+			vmaDestroyImage(gVMA_Allocator, image, allocation);
+		});
+	gAllTextures.Remove(textureID.handle);
 }
 
 void Device::UpdateTexture(TextureHandle textureID, const void* data, size_t size, size_t offset)
@@ -1345,7 +2007,80 @@ void Device::UpdateSubregionTexture(
 	const void* data,
 	size_t dataSize)
 {
-	//TODO: Implement subregion texture update
+	const TextureInfo& texInfo = gAllTextures[textureID.handle];
+	const size_t regionSize = GetFormatDataSize(texInfo.format, width, height, depth);
+	MERCURY_ASSERT(dataSize >= regionSize);
+
+	BufferDescriptor stagingDesc{};
+	stagingDesc.size = regionSize;
+	stagingDesc.initialData = const_cast<void*>(data);
+
+	VkImage image = texInfo.image;
+	BufferHandle stagingBuffer = gDevice->CreateBuffer(stagingDesc);
+
+	// the rest of the texture keeps its contents, so it has to be in its sampled layout already (created with initialData)
+	gDevice->SubmitOneTimeCommandsList(
+		[=](CommandList& cmdList)
+		{
+			VkImageMemoryBarrier barrierToTransfer{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+			barrierToTransfer.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrierToTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrierToTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrierToTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrierToTransfer.image = image;
+			barrierToTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrierToTransfer.subresourceRange.baseMipLevel = 0;
+			barrierToTransfer.subresourceRange.levelCount = 1;
+			barrierToTransfer.subresourceRange.baseArrayLayer = 0;
+			barrierToTransfer.subresourceRange.layerCount = 1;
+			barrierToTransfer.srcAccessMask = 0; // earlier frames only read the texture
+			barrierToTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(
+				static_cast<VkCommandBuffer>(cmdList.nativePtr),
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrierToTransfer);
+
+			VkBufferImageCopy copyRegion{};
+			copyRegion.bufferOffset = 0;
+			copyRegion.bufferRowLength = 0;
+			copyRegion.bufferImageHeight = 0;
+			copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copyRegion.imageSubresource.mipLevel = 0;
+			copyRegion.imageSubresource.baseArrayLayer = 0;
+			copyRegion.imageSubresource.layerCount = 1;
+			copyRegion.imageOffset = { static_cast<i32>(x), static_cast<i32>(y), static_cast<i32>(z) };
+			copyRegion.imageExtent = { static_cast<u32>(width), static_cast<u32>(height), static_cast<u32>(depth) };
+
+			vkCmdCopyBufferToImage(
+				static_cast<VkCommandBuffer>(cmdList.nativePtr),
+				gAllBuffers[stagingBuffer.handle].buffer,
+				image,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1,
+				&copyRegion);
+
+			VkImageMemoryBarrier barrierToShaderRead = barrierToTransfer;
+			barrierToShaderRead.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrierToShaderRead.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			barrierToShaderRead.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrierToShaderRead.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(
+				static_cast<VkCommandBuffer>(cmdList.nativePtr),
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0,
+				0, nullptr,
+				0, nullptr,
+				1, &barrierToShaderRead);
+		},
+		[stagingBuffer]()
+		{
+			gDevice->DestroyBuffer(stagingBuffer);
+		});
 }
 
 u64 TextureHandle::CreateImguiTextureOpaqueHandle() const
@@ -1358,6 +2093,9 @@ u64 TextureHandle::CreateImguiTextureOpaqueHandle() const
 
 void Device::SubmitOneTimeCommandsList(std::function<void(CommandList& cmdList)> recordCommands, std::function<void()> onFinish)
 {
+	// the commands may read upload ring ranges written earlier this frame
+	FlushUploads();
+
 	//get ready one time submit commands
 	while (true)
 	{
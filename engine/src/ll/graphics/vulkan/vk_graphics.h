@@ -5,6 +5,7 @@
 #include "ll/graphics.h"
 #include <vector>
 #include <unordered_map>
+#include <functional>
 #include "mercury_application.h"
 //constants
 constexpr mercury::u32 Ver11 = VK_MAKE_VERSION(1, 1, 0);
@@ -39,6 +40,7 @@ struct PipelineObjects
 {
 	VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
 	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 };
 
 struct ShaderModuleCached
@@ -46,6 +48,14 @@ struct ShaderModuleCached
 	VkShaderModule module = VK_NULL_HANDLE;
 };
 
-extern std::vector<PipelineObjects> gAllPSOs;
-extern std::vector<ShaderModuleCached> gAllShaderModules;
+extern mercury::SlotMap<PipelineObjects> gAllPSOs;
+extern mercury::SlotMap<ShaderModuleCached> gAllShaderModules;
+
+//frame timeline, both return 0 without a swapchain
+mercury::u64 GetVkFrameTimelinePendingValue();
+mercury::u64 GetVkFrameTimelineCompletedValue();
+
+//deferred destruction
+void DeferVkRelease(std::function<void()> release);
+void ReleaseDeferredVkObjects(bool all);
 #endif
@@ -279,6 +279,15 @@ void Instance::Initialize()
     initDesc.bucketsInfo.push_back({8192, 16_MB, 1_MB});
     initDesc.bucketsInfo.push_back({16384, 16_MB, 1_MB});
 
+    // vulkan may call the allocation callbacks from the tick thread and the OS thread
+    initDesc.threadSafe = true;
+
+    // pipeline and swapchain creation spike driver allocations, give the pages back once they are freed
+    initDesc.backgroundTrimIntervalMs = 10000;
+
+    // 176MB of buckets hit on every driver callback, huge pages keep them from thrashing the TLB
+    initDesc.memoryPolicy.flags = ll::os::MemoryPolicy::TransparentHugePages;
+
     memory::gGraphicsMemoryAllocator = new mercury::memory::ReservedAllocator(initDesc);
 
     //gVKGlobalAllocationsCallbacks = new AllocationsCallbacks();
@@ -130,6 +130,23 @@ struct FrameData
 
 std::vector<FrameData> gFrames;
 
+u64 GetVkFrameTimelinePendingValue()
+{
+	if (gFrameGraphSemaphore == VK_NULL_HANDLE || gFrames.empty())
+		return 0;
+
+	// Present stores the value it signalled, the next submit from this slot adds one ring length
+	return gFrames[gFrameRingCurrent].frameIndex + gFrames.size();
+}
+
+u64 GetVkFrameTimelineCompletedValue()
+{
+	u64 value = 0;
+	if (gFrameGraphSemaphore != VK_NULL_HANDLE)
+		vkGetSemaphoreCounterValue(gVKDevice, gFrameGraphSemaphore, &value);
+	return value;
+}
+
 void InitVkSwapchainResources()
 {
 	u32 imageCount = 0;
@@ -676,7 +693,7 @@ void Swapchain::Initialize()
 		InitVkSwapchain();
 		InitVkSwapchainResources();
 
-		const uint64_t initialValue = (gNumberOfSwapchainFrames - 1);
+		const uint64_t initialValue = (Swapchain::NumFramesInFlight - 1);
 
 		VkSemaphoreTypeCreateInfo timelineCreateInfo = {
 			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
@@ -690,14 +707,16 @@ void Swapchain::Initialize()
 
 		vk_utils::debug::SetName(gFrameGraphSemaphore, "FrameGraph semaphore");
 
-		gFrames.resize(gNumberOfSwapchainFrames);
+		// the CPU ring follows the engine frames in flight, not the image count: with triple buffering there are
+		// more images than frame slots, and a slot must only come back once its previous GPU work retired
+		gFrames.resize(Swapchain::NumFramesInFlight);
 
 		const VkCommandPoolCreateInfo cmdPoolCreateInfo{
 			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
 			.queueFamilyIndex = 0, // TODO: get from device
 		};
 
-		for (u8 i = 0; i < gNumberOfSwapchainFrames; ++i)
+		for (u8 i = 0; i < Swapchain::NumFramesInFlight; ++i)
 		{
 			auto &f = gFrames[i];
 			f.frameIndex = i; // Track frame index for synchronization
@@ -746,6 +765,10 @@ void Swapchain::Shutdown()
 {
 	MLOG_DEBUG(u8"Shutdown Swapchain (Vulkan)");
 
+	// pending releases are keyed to this timeline, it is recreated from scratch with the next swapchain
+	vkDeviceWaitIdle(gVKDevice);
+	ReleaseDeferredVkObjects(true);
+
 	ShutdownVkSwapchainResources();
 	ShutdownVkSwapchain();
 	ShutdownOldVkSwapchain();
@@ -791,6 +814,17 @@ CommandList Swapchain::AcquireNextImage()
 											 .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
 	VK_CALL(vkBeginCommandBuffer(cmd, &beginInfo));
 
+	return outCbuff;
+}
+
+void Swapchain::BeginFinalPass(CommandList& commandList)
+{
+	if (gFramesInFlight.empty())
+		return;
+
+	auto &frameCPU = gFrames[gFrameRingCurrent];
+	VkCommandBuffer cmd = frameCPU.cmdBuffer;
+
 	// IMPORTANT: operate on the acquired image/resources
 	auto &imageFrame = gFramesInFlight[gAcquiredNextImageIndex];
 
@@ -847,8 +881,6 @@ CommandList Swapchain::AcquireNextImage()
 
 		vkCmdBeginRenderPass(frameCPU.cmdBuffer, &rpass, VK_SUBPASS_CONTENTS_INLINE);
 	}
-
-	return outCbuff;
 }
 
 void Swapchain::Present()
@@ -897,7 +929,7 @@ void Swapchain::Present()
 	*   Frame 0 signals value 3 (allowing Frame 3 to start when complete)
 	*   Frame 1 signals value 4 (allowing Frame 4 to start when complete)
 	-*/
-	const uint64_t signalFrameValue = frameCPU.frameIndex + gNumberOfSwapchainFrames;
+	const uint64_t signalFrameValue = frameCPU.frameIndex + Swapchain::NumFramesInFlight;
 	frameCPU.frameIndex = signalFrameValue; // Store for next time this frame buffer is used
 
 	/*--
@@ -951,7 +983,7 @@ void Swapchain::Present()
 
 	imageFrame.imageLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 	gSwapchainCurrentFrame = (gSwapchainCurrentFrame + 1) % GetNumberOfFrames();
-	gFrameRingCurrent = (gFrameRingCurrent + 1) % gNumberOfSwapchainFrames;
+	gFrameRingCurrent = (gFrameRingCurrent + 1) % Swapchain::NumFramesInFlight;
 }
 
 u8 Swapchain::GetNumberOfFrames()
@@ -15,6 +15,9 @@ namespace vk_utils
 	void BufferMemoryBarrier(VkCommandBuffer cbuff, VkBuffer buffer, VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
 	VkBufferImageCopy MakeBufferImageCopy(VkExtent3D extent, VkImageAspectFlags aspectMask, int numMips = 1, int numLayers = 1);
 
+	/// @returns VK_FORMAT_UNDEFINED for formats without a Vulkan equivalent
+	VkFormat ToVkFormat(mercury::ll::graphics::Format format);
+
 
     namespace debug
     {
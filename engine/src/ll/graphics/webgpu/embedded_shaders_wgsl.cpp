@@ -4,6 +4,110 @@
 
 namespace mercury::ll::graphics::embedded_shaders {
 
+mercury::ll::graphics::ShaderBytecodeView CanvasSpriteCullCS()
+{
+	static const char data[] = R"(struct MercuryScene_std140_0
+{
+    @align(16) prerptationMatrix_0 : vec4<f32>,
+    @align(16) canvasSize_0 : vec4<f32>,
+    @align(16) time_0 : f32,
+    @align(4) deltaTime_0 : f32,
+};
+
+@binding(0) @group(0) var<uniform> perFrame_0 : MercuryScene_std140_0;
+struct SpriteCullParameters_std140_0
+{
+    @align(16) numSprites_0 : u32,
+};
+
+@binding(0) @group(1) var<uniform> cull_0 : SpriteCullParameters_std140_0;
+struct SpriteInstance_std430_0
+{
+    @align(8) position_0 : vec2<f32>,
+    @align(8) size_0 : vec2<f32>,
+    @align(8) uv0_0 : vec2<f32>,
+    @align(8) uv1_0 : vec2<f32>,
+    @align(4) angle_0 : f32,
+    @align(4) colorPacked_0 : u32,
+    @align(4) textureIndex_0 : u32,
+    @align(4) batchIndex_0 : u32,
+};
+
+@binding(1) @group(1) var<storage, read> cull_sprites_0 : array<SpriteInstance_std430_0>;
+
+@binding(2) @group(1) var<storage, read_write> cull_visibleSprites_0 : array<SpriteInstance_std430_0>;
+
+struct SpriteDrawRecord_std430_0
+{
+    @align(4) vertexCount_0 : u32,
+    @align(4) instanceCount_0 : atomic<u32>,
+    @align(4) firstVertex_0 : u32,
+    @align(4) firstInstance_0 : u32,
+    @align(4) firstSprite_0 : u32,
+    @align(4) padding0_0 : u32,
+    @align(4) padding1_0 : u32,
+    @align(4) padding2_0 : u32,
+};
+
+@binding(3) @group(1) var<storage, read_write> cull_drawRecords_0 : array<SpriteDrawRecord_std430_0>;
+
+@compute
+@workgroup_size(64, 1, 1)
+fn main(@builtin(global_invocation_id) dispatchThreadID_0 : vec3<u32>)
+{
+    var spriteIndex_0 : u32 = dispatchThreadID_0.x;
+    if(spriteIndex_0 >= (cull_0.numSprites_0))
+    {
+        return;
+    }
+    var sprite_0 : SpriteInstance_std430_0 = cull_sprites_0[spriteIndex_0];
+    var radius_0 : f32 = length(sprite_0.size_0);
+    var minCorner_0 : vec2<f32> = sprite_0.position_0 - vec2<f32>(radius_0);
+    var maxCorner_0 : vec2<f32> = sprite_0.position_0 + vec2<f32>(radius_0);
+    if((any((maxCorner_0 < vec2<f32>(0.0f)))) || (any((minCorner_0 > perFrame_0.canvasSize_0.xy))))
+    {
+        return;
+    }
+    var visibleIndex_0 : u32 = atomicAdd(&(cull_drawRecords_0[sprite_0.batchIndex_0].instanceCount_0), u32(1));
+    cull_visibleSprites_0[cull_drawRecords_0[sprite_0.batchIndex_0].firstSprite_0 + visibleIndex_0] = sprite_0;
+    return;
+}
+
+)";
+	return { data, sizeof(data) };
+}
+
+mercury::ll::graphics::ShaderBytecodeView CanvasTextPS()
+{
+	static const char data[] = R"(@binding(0) @group(2) var glyphPage_distanceMap_0 : texture_2d<f32>;
+
+@binding(1) @group(2) var glyphPage_distanceSampler_0 : sampler;
+
+struct pixelOutput_0
+{
+    @location(0) output_0 : vec4<f32>,
+};
+
+struct pixelInput_0
+{
+    @location(0) texcoord_0 : vec2<f32>,
+    @location(1) color_0 : vec4<f32>,
+};
+
+@fragment
+fn main( _S1 : pixelInput_0, @builtin(position) position_0 : vec4<f32>) -> pixelOutput_0
+{
+    var distance_0 : f32 = (textureSample((glyphPage_distanceMap_0), (glyphPage_distanceSampler_0), (_S1.texcoord_0))).w;
+    var width_0 : f32 = max(fwidth(distance_0) * 0.5f, 0.00100000004749745f);
+    var coverage_0 : f32 = smoothstep(0.5f - width_0, 0.5f + width_0, distance_0);
+    var _S2 : pixelOutput_0 = pixelOutput_0( vec4<f32>(_S1.color_0.xyz, _S1.color_0.w * coverage_0) );
+    return _S2;
+}
+
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteVS()
 {
 	static const char data[] = R"(struct MercuryScene_std140_0
@@ -78,6 +182,91 @@ fn main(@builtin(vertex_index) vertexID_0 : u32) -> BaseVertexOutput_0
 	return { data, sizeof(data) };
 }
 
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteInstancedVS()
+{
+	static const char data[] = R"(struct MercuryScene_std140_0
+{
+    @align(16) prerptationMatrix_0 : vec4<f32>,
+    @align(16) canvasSize_0 : vec4<f32>,
+    @align(16) time_0 : f32,
+    @align(4) deltaTime_0 : f32,
+};
+
+@binding(0) @group(1) var<uniform> perFrame_0 : MercuryScene_std140_0;
+struct SpriteInstance_std430_0
+{
+    @align(8) position_0 : vec2<f32>,
+    @align(8) size_0 : vec2<f32>,
+    @align(8) uv0_0 : vec2<f32>,
+    @align(8) uv1_0 : vec2<f32>,
+    @align(4) angle_0 : f32,
+    @align(4) colorPacked_0 : u32,
+    @align(4) textureIndex_0 : u32,
+    @align(4) padding_0 : f32,
+};
+
+@binding(0) @group(3) var<storage, read> spriteInstances_sprites_0 : array<SpriteInstance_std430_0>;
+
+struct DedicatedSpriteBatchParameters_std140_0
+{
+    @align(16) firstSprite_0 : u32,
+};
+
+struct EntryPointParams_std140_0
+{
+    @align(16) batch_0 : DedicatedSpriteBatchParameters_std140_0,
+};
+
+@binding(0) @group(0) var<uniform> entryPointParams_0 : EntryPointParams_std140_0;
+struct PackedColor_0
+{
+     packed_0 : u32,
+};
+
+fn PackedColor_x24init_0( packed_1 : u32) -> PackedColor_0
+{
+    var _S1 : PackedColor_0;
+    _S1.packed_0 = packed_1;
+    return _S1;
+}
+
+fn PackedColor_toFloat4_0( this_0 : PackedColor_0) -> vec4<f32>
+{
+    var color_0 : vec4<f32>;
+    color_0[i32(0)] = f32(((((this_0.packed_0) >> (u32(24)))) & (u32(255)))) / 255.0f;
+    color_0[i32(1)] = f32(((((this_0.packed_0) >> (u32(16)))) & (u32(255)))) / 255.0f;
+    color_0[i32(2)] = f32(((((this_0.packed_0) >> (u32(8)))) & (u32(255)))) / 255.0f;
+    color_0[i32(3)] = f32(((this_0.packed_0) & (u32(255)))) / 255.0f;
+    return color_0;
+}
+
+struct BaseVertexOutput_0
+{
+    @builtin(position) position_1 : vec4<f32>,
+    @location(0) texcoord_0 : vec2<f32>,
+    @location(1) color_1 : vec4<f32>,
+};
+
+@vertex
+fn main(@builtin(vertex_index) vertexID_0 : u32, @builtin(instance_index) instanceID_0 : u32) -> BaseVertexOutput_0
+{
+    const _S2 : vec2<f32> = vec2<f32>(1.0f, 1.0f);
+    var positions_ndc_0 : array<vec2<f32>, i32(4)> = array<vec2<f32>, i32(4)>( vec2<f32>(-1.0f, 1.0f), _S2, vec2<f32>(-1.0f, -1.0f), vec2<f32>(1.0f, -1.0f) );
+    var uvs_1 : array<vec2<f32>, i32(4)> = array<vec2<f32>, i32(4)>( vec2<f32>(0.0f, 0.0f), vec2<f32>(1.0f, 0.0f), vec2<f32>(0.0f, 1.0f), _S2 );
+    var sprite_0 : SpriteInstance_std430_0 = spriteInstances_sprites_0[entryPointParams_0.batch_0.firstSprite_0 + instanceID_0];
+    var cosAngle_0 : f32 = cos(sprite_0.angle_0);
+    var sinAngle_0 : f32 = sin(sprite_0.angle_0);
+    var output_0 : BaseVertexOutput_0;
+    output_0.position_1 = vec4<f32>(((((positions_ndc_0[vertexID_0] * sprite_0.size_0) * (mat2x2<f32>(cosAngle_0, - sinAngle_0, sinAngle_0, cosAngle_0)))) + sprite_0.position_0) * perFrame_0.canvasSize_0.zw - vec2<f32>(1.0f, f32((i32(sign((perFrame_0.canvasSize_0.w)))))), 0.0f, 1.0f);
+    output_0.texcoord_0 = mix(sprite_0.uv0_0, sprite_0.uv1_0, uvs_1[vertexID_0]);
+    output_0.color_1 = PackedColor_toFloat4_0(PackedColor_x24init_0(sprite_0.colorPacked_0));
+    return output_0;
+}
+
+)";
+	return { data, sizeof(data) };
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteColorPS()
 {
 	static const char data[] = R"(struct pixelOutput_0
@@ -135,6 +324,18 @@ fn main( _S1 : pixelInput_0, @builtin(position) position_0 : vec4<f32>) -> pixel
 	return { data, sizeof(data) };
 }
 
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessVS()
+{
+	// WGSL has no texture arrays of runtime size, canvas keeps one draw per texture
+	return {};
+}
+
+mercury::ll::graphics::ShaderBytecodeView DedicatedSpriteBindlessPS()
+{
+	// WGSL has no texture arrays of runtime size, canvas keeps one draw per texture
+	return {};
+}
+
 mercury::ll::graphics::ShaderBytecodeView DedicatedStaticMeshVS()
 {
 	static const char data[] = R"(struct _MatrixStorage_float4x4std140_0
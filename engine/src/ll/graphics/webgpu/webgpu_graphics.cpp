@@ -25,6 +25,7 @@ bool mercury::ll::graphics::IsYFlipped()
 #include "../../../imgui/imgui_impl.h"
 
 #include "mercury_log.h"
+#include "mercury_memory.h"
 
 #include "webgpu_utils.h"
 
@@ -38,6 +39,7 @@ Move to OS
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 // WebGPU objects
 wgpu::Instance wgpuInstance;
 wgpu::Adapter wgpuAdapter;
@@ -63,35 +65,42 @@ int gCurrentCanvasWidth = 0;
 int gCurrentCanvasHeight = 0;
 
 // Global storage for shaders and pipelines
-std::vector<wgpu::ShaderModule> gAllShaderModules;
+SlotMap<wgpu::ShaderModule> gAllShaderModules;
 
 struct PSOMeta
 {
+	wgpu::RenderPipeline pipeline;
+	wgpu::ComputePipeline computePipeline;
 	wgpu::PipelineLayout pipelineLayout;
     bool hasPushConstants = false;
 };
 
-std::vector<wgpu::RenderPipeline> gAllPSOs;
-std::vector<PSOMeta> gAllPSOMetas;
-std::vector<wgpu::BindGroupLayout> gAllPSOLayouts;
-std::vector<wgpu::Buffer> gAllBuffers;
-std::vector<wgpu::BindGroupLayout> gAllParameterBlockLayouts;
-std::vector<wgpu::BindGroup> gAllParameterBlocks;
+SlotMap<PSOMeta> gAllPSOs;
+SlotMap<wgpu::Buffer> gAllBuffers;
+struct ParameterBlockLayoutMeta
+{
+	wgpu::BindGroupLayout bindGroupLayout;
+	u32 dynamicOffsetCount = 0; // entries with hasDynamicOffset, SetBindGroup needs exactly this many offsets
+};
+
+SlotMap<ParameterBlockLayoutMeta> gAllParameterBlockLayouts;
 
 struct ParamaterBllockMeta
 {
 	ParameterBlockLayoutHandle layoutHandle;
+	wgpu::BindGroup bindGroup;
+	u32 dynamicOffsetCount = 0;
 };
 
-std::vector<ParamaterBllockMeta> gAllParameterBlockMetas;
+SlotMap<ParamaterBllockMeta> gAllParameterBlocks;
 
 struct TextureMeta
 {
+	wgpu::Texture texture;
 	wgpu::TextureView textureView;
 };
 
-std::vector<TextureMeta> gAllTextureMetas;
-std::vector<wgpu::Texture> gAllTextures;
+SlotMap<TextureMeta> gAllTextures;
 
 struct PerFrameData
 {
@@ -104,7 +113,7 @@ struct PerFrameData
 std::vector<PerFrameData> gPerFrameData;
 wgpu::BindGroupLayout gPushConstantBindGroupLayout;
 
-int gNumFramesInFlight = 2;
+int gNumFramesInFlight = Swapchain::NumFramesInFlight;
 int gCurrentFrameIndex = 0;
 
 void Instance::Initialize()
@@ -158,6 +167,10 @@ void Instance::Shutdown()
 
     gAllShaderModules.clear();
     gAllPSOs.clear();
+    gAllBuffers.clear();
+    gAllParameterBlockLayouts.clear();
+    gAllParameterBlocks.clear();
+    gAllTextures.clear();
     
     adapterRequested = false;
     adapterReady = false;
@@ -518,6 +531,8 @@ void Device::Shutdown()
 
 void Device::Tick()
 {
+    // runs the SubmitOneTimeCommandsList callbacks of finished submissions
+    wgpuInstance.ProcessEvents();
 }
 
 void Device::ImguiInitialize()
@@ -640,6 +655,9 @@ void *Swapchain::GetNativeHandle()
 wgpu::CommandEncoder gCurrentCommandEncoder;
 wgpu::RenderPassEncoder gCurrentFinalRenderPass;
 
+// compute pass of the one time command list being recorded, opened by the first compute SetPSO
+wgpu::ComputePassEncoder gCurrentComputePass;
+
 CommandList Swapchain::AcquireNextImage()
 {
     // Check if swapchain needs to be resized
@@ -649,6 +667,22 @@ CommandList Swapchain::AcquireNextImage()
 
     gCurrentCommandEncoder = wgpuDevice.CreateCommandEncoder();
 	gCurrentCommandEncoder.SetLabel("Final Render Pass Command Encoder");
+
+	gPerFrameData[gCurrentFrameIndex].pushConstantOffset = 0;
+
+    // compute recorded before BeginFinalPass goes to a compute pass of the same encoder
+    CommandList clist = { &gCurrentCommandEncoder };
+    return clist;
+}
+
+void Swapchain::BeginFinalPass(CommandList& commandList)
+{
+    if (gCurrentComputePass)
+    {
+        gCurrentComputePass.End();
+        gCurrentComputePass = nullptr;
+    }
+
     // Create a render pass descriptor
     wgpu::RenderPassColorAttachment colorAttachment = {};
     colorAttachment.view = wgpuCurrentSwapchainTexture.texture.CreateView();
@@ -663,11 +697,7 @@ CommandList Swapchain::AcquireNextImage()
     // Begin the render pass
     gCurrentFinalRenderPass = gCurrentCommandEncoder.BeginRenderPass(&renderPassDesc);
 
-	gPerFrameData[gCurrentFrameIndex].pushConstantOffset = 0;
-
-    CommandList clist = { &gCurrentCommandEncoder };
-	clist.currentRenderPassNativePtr = &gCurrentFinalRenderPass;
-    return clist;
+	commandList.currentRenderPassNativePtr = &gCurrentFinalRenderPass;
 }
 
 void Swapchain::Present()
@@ -729,7 +759,18 @@ void CommandList::SetPSO(PsoHandle psoID)
 
     currentPsoID = psoID;
 
-    gCurrentFinalRenderPass.SetPipeline(gAllPSOs[psoID.handle]); 
+    auto& psoMeta = gAllPSOs[psoID.handle];
+
+    if (psoMeta.computePipeline)
+    {
+        if (!gCurrentComputePass)
+            gCurrentComputePass = static_cast<wgpu::CommandEncoder*>(nativePtr)->BeginComputePass();
+
+        gCurrentComputePass.SetPipeline(psoMeta.computePipeline);
+        return;
+    }
+
+    gCurrentFinalRenderPass.SetPipeline(psoMeta.pipeline); 
 }
 
 void CommandList::Draw(u32 vertexCount, u32 instanceCount, u32 firstVertex, u32 firstInstance)
@@ -737,6 +778,21 @@ void CommandList::Draw(u32 vertexCount, u32 instanceCount, u32 firstVertex, u32
     gCurrentFinalRenderPass.Draw(vertexCount, instanceCount, firstVertex, firstInstance);
 }
 
+void CommandList::DrawIndirect(BufferHandle bufferID, size_t offset)
+{
+    gCurrentFinalRenderPass.DrawIndirect(gAllBuffers[bufferID.handle], static_cast<u64>(offset));
+}
+
+void CommandList::Dispatch(u32 groupCountX, u32 groupCountY, u32 groupCountZ)
+{
+    gCurrentComputePass.DispatchWorkgroups(groupCountX, groupCountY, groupCountZ);
+}
+
+void CommandList::DispatchBarrier()
+{
+    // WebGPU orders storage writes between dispatches and passes by itself
+}
+
 void CommandList::SetViewport(float x, float y, float width, float height, float minDepth, float maxDepth)
 {
     gCurrentFinalRenderPass.SetViewport(x, y, width, height, minDepth, maxDepth);
@@ -762,7 +818,6 @@ void Device::ImguiShutdown()
 ShaderHandle Device::CreateShaderModule(const ShaderBytecodeView& bytecode)
 {
     ShaderHandle result;
-    result.handle = static_cast<u32>(gAllShaderModules.size());
 
     wgpu::ShaderSourceWGSL wgslDesc{};
     wgslDesc.code = static_cast<const char*>(bytecode.data);
@@ -773,7 +828,7 @@ ShaderHandle Device::CreateShaderModule(const ShaderBytecodeView& bytecode)
     desc.nextInChain = &wgslDesc;
 
     auto module = wgpuDevice.CreateShaderModule(&desc);
-    gAllShaderModules.push_back(module);
+    result.handle = gAllShaderModules.Emplace(module);
 
     return result;
 }
@@ -797,7 +852,7 @@ void Device::UpdateShaderModule(ShaderHandle shaderModuleID, const ShaderBytecod
 
 void Device::DestroyShaderModule(ShaderHandle shaderModuleID)
 {
-    gAllShaderModules[shaderModuleID.handle] = nullptr;
+    gAllShaderModules.Remove(shaderModuleID.handle);
 }
 
 wgpu::PrimitiveTopology primitiveTopologyFromLLTopology(PrimitiveTopology topology)
@@ -819,11 +874,135 @@ wgpu::PrimitiveTopology primitiveTopologyFromLLTopology(PrimitiveTopology topolo
     }
 }
 
+// bind groups are only compatible with pipeline layouts built from identical entries, so parameter block layouts and
+// pipelines share this. Read-write storage is not allowed in vertex shaders.
+void FillBindGroupLayoutEntries(const BindingSetLayoutDescriptor& layoutDesc, std::vector<wgpu::BindGroupLayoutEntry>& entries)
+{
+    const wgpu::ShaderStage allStages = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment | wgpu::ShaderStage::Compute;
+    int bindingIndex = 0;
+
+    for (int i = 0; i < layoutDesc.allSlots.size(); ++i)
+    {
+        auto& slot = layoutDesc.allSlots[i];
+
+        if (slot.resourceType == ShaderResourceType::UniformBuffer)
+        {
+            wgpu::BindGroupLayoutEntry entry{};
+            entry.binding = static_cast<u32>(bindingIndex);
+            entry.visibility = allStages;
+            entry.buffer.hasDynamicOffset = false;
+            entry.buffer.type = wgpu::BufferBindingType::Uniform;
+            entries.push_back(entry);
+        }
+
+        if (slot.resourceType == ShaderResourceType::DynamicUniformBuffer)
+        {
+            wgpu::BindGroupLayoutEntry entry{};
+            entry.binding = static_cast<u32>(bindingIndex);
+            entry.visibility = allStages;
+            entry.buffer.hasDynamicOffset = true;
+            entry.buffer.type = wgpu::BufferBindingType::Uniform;
+            entries.push_back(entry);
+        }
+
+        if (slot.resourceType == ShaderResourceType::ReadOnlyBuffer)
+        {
+            wgpu::BindGroupLayoutEntry entry{};
+            entry.binding = static_cast<u32>(bindingIndex);
+            entry.visibility = allStages;
+            entry.buffer.hasDynamicOffset = false;
+            entry.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+            entries.push_back(entry);
+        }
+
+        if (slot.resourceType == ShaderResourceType::RWBuffer)
+        {
+            wgpu::BindGroupLayoutEntry entry{};
+            entry.binding = static_cast<u32>(bindingIndex);
+            entry.visibility = wgpu::ShaderStage::Fragment | wgpu::ShaderStage::Compute;
+            entry.buffer.hasDynamicOffset = false;
+            entry.buffer.type = wgpu::BufferBindingType::Storage;
+            entries.push_back(entry);
+        }
+
+        if (slot.resourceType == ShaderResourceType::SampledImage2D)
+        {
+            {
+                wgpu::BindGroupLayoutEntry entry{};
+                entry.binding = static_cast<u32>(bindingIndex);
+                entry.visibility = allStages;
+                entry.texture.sampleType = wgpu::TextureSampleType::Float;
+                entry.texture.viewDimension = wgpu::TextureViewDimension::e2D;
+                entries.push_back(entry);
+                ++bindingIndex;
+            }
+
+            {
+                wgpu::BindGroupLayoutEntry entry{};
+                entry.binding = static_cast<u32>(bindingIndex);
+                entry.visibility = allStages;
+                entry.sampler.type = wgpu::SamplerBindingType::Filtering;
+                entries.push_back(entry);
+            }
+        }
+
+        if (slot.resourceType == ShaderResourceType::SampledImage2DTable)
+        {
+            MLOG_ERROR(u8"Texture tables are not supported by WebGPU, check Device::GetMaxTextureTableSize first");
+        }
+
+        ++bindingIndex;
+    }
+}
+
+wgpu::PipelineLayout CreatePipelineLayout(const PipelineBindingLayoutDescriptor& desc, bool withPushConstants)
+{
+    std::vector<wgpu::BindGroupLayout> bgls;
+
+    if (withPushConstants)
+    {
+        bgls.push_back(gPushConstantBindGroupLayout);
+    }
+
+    for (auto& bg : desc.bindingSetLayouts)
+    {
+        if (bg.allSlots.empty())
+            continue;
+
+        std::vector<wgpu::BindGroupLayoutEntry> bglEntries;
+        FillBindGroupLayoutEntries(bg, bglEntries);
+
+        wgpu::BindGroupLayoutDescriptor bglDesc{};
+        bglDesc.entryCount = static_cast<uint32_t>(bglEntries.size());
+        bglDesc.entries = bglEntries.data();
+        bglDesc.label = "Scene Group Layout";
+
+        bgls.push_back(wgpuDevice.CreateBindGroupLayout(&bglDesc));
+    }
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.bindGroupLayouts = bgls.data();
+    pipelineLayoutDesc.bindGroupLayoutCount = static_cast<u32>(bgls.size());
+    return wgpuDevice.CreatePipelineLayout(&pipelineLayoutDesc);
+}
+
+wgpu::BlendState AlphaBlendState()
+{
+    wgpu::BlendState blendState{};
+    blendState.color.operation = wgpu::BlendOperation::Add;
+    blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+    blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blendState.alpha.operation = wgpu::BlendOperation::Add;
+    blendState.alpha.srcFactor = wgpu::BlendFactor::One;
+    blendState.alpha.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    return blendState;
+}
+
 PsoHandle Device::CreateRasterizePipeline(const RasterizePipelineDescriptor& desc)
 {
     MLOG_DEBUG(u8"Create Rasterize Pipeline (WEBGPU)");
     PsoHandle result;
-    result.handle = static_cast<u32>(gAllPSOs.size());
+    result.handle = gAllPSOs.Emplace();
 
     wgpu::RenderPipelineDescriptor pipelineDesc{};
     pipelineDesc.nextInChain = nullptr;
@@ -843,6 +1022,10 @@ PsoHandle Device::CreateRasterizePipeline(const RasterizePipelineDescriptor& des
     wgpu::ColorTargetState colorTarget{};
     colorTarget.format = wgpuSwapchainFormat;
 
+    wgpu::BlendState blendState = AlphaBlendState();
+    if (desc.blendMode == BlendMode::AlphaBlend)
+        colorTarget.blend = &blendState;
+
     if (desc.fragmentShader.isValid())
     {
         fragmentState.module = gAllShaderModules[desc.fragmentShader.handle];
@@ -865,81 +1048,12 @@ PsoHandle Device::CreateRasterizePipeline(const RasterizePipelineDescriptor& des
     pipelineDesc.multisample = multisampleState;
 
 	
-	auto& psoMeta = gAllPSOMetas.emplace_back();
-
-	std::vector<wgpu::BindGroupLayout> bgls;
-    
-    if (desc.pushConstantSize > 0)
-    {
-		psoMeta.hasPushConstants = true;
-		bgls.push_back(gPushConstantBindGroupLayout);
-    }
-
-    for (auto& bg : desc.bindingSetLayouts)
-    {
-		if (bg.allSlots.empty())
-            continue;
-
-        std::vector<wgpu::BindGroupLayoutEntry> bglEntries;
-        wgpu::BindGroupLayoutEntry pcEntry{};
-
-		u32 bindingIndex = 0;
-
-        for (int i = 0; i < bg.allSlots.size(); ++i)
-        {
-            auto& slot = bg.allSlots[i];
-
-            if (slot.resourceType == ShaderResourceType::UniformBuffer)
-            {
-                wgpu::BindGroupLayoutEntry entry{};
-                entry.binding = static_cast<u32>(bindingIndex);
-                entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
-                entry.buffer.hasDynamicOffset = false;
-                entry.buffer.type = wgpu::BufferBindingType::Uniform;
-                bglEntries.push_back(entry);
-                bindingIndex++;
-            }
+	auto& psoMeta = gAllPSOs[result.handle];
+	psoMeta.hasPushConstants = desc.pushConstantSize > 0;
 
-            if (slot.resourceType == ShaderResourceType::SampledImage2D)
-            {
-                {
-                    wgpu::BindGroupLayoutEntry entry{};
-                    entry.binding = static_cast<u32>(bindingIndex);
-                    entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
-                    entry.texture.sampleType = wgpu::TextureSampleType::Float;
-                    entry.texture.viewDimension = wgpu::TextureViewDimension::e2D;
-                    bglEntries.push_back(entry);
-                    ++bindingIndex;
-                }
-
-                {
-                    wgpu::BindGroupLayoutEntry entry{};
-                    entry.binding = static_cast<u32>(bindingIndex);
-                    entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
-                    entry.sampler.type = wgpu::SamplerBindingType::Filtering;
-                    bglEntries.push_back(entry);
-                }
-            }
-        }
-
-        wgpu::BindGroupLayoutDescriptor bglDesc{};
-        bglDesc.entryCount = static_cast<uint32_t>(bglEntries.size());
-        bglDesc.entries = bglEntries.data();
-        bglDesc.label = "Scene Group Layout";
-
-		auto bgl = wgpuDevice.CreateBindGroupLayout(&bglDesc);
-		bgls.push_back(bgl);
-    }
-
-
-    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
-
-    pipelineLayoutDesc.bindGroupLayouts = bgls.data();
-	pipelineLayoutDesc.bindGroupLayoutCount = static_cast<u32>(bgls.size());
-    psoMeta.pipelineLayout = wgpuDevice.CreatePipelineLayout(&pipelineLayoutDesc);
+    psoMeta.pipelineLayout = CreatePipelineLayout(desc, psoMeta.hasPushConstants);
     pipelineDesc.layout = psoMeta.pipelineLayout;
-    auto pipeline = wgpuDevice.CreateRenderPipeline(&pipelineDesc);
-    gAllPSOs.push_back(pipeline);
+    psoMeta.pipeline = wgpuDevice.CreateRenderPipeline(&pipelineDesc);
 
     return result;
 }
@@ -947,7 +1061,7 @@ PsoHandle Device::CreateRasterizePipeline(const RasterizePipelineDescriptor& des
 void Device::UpdatePipelineState(PsoHandle psoID, const RasterizePipelineDescriptor& desc)
 {
     // Release old pipeline
-    gAllPSOs[psoID.handle] = nullptr;
+    gAllPSOs[psoID.handle].pipeline = nullptr;
 
     wgpu::RenderPipelineDescriptor pipelineDesc{};
     pipelineDesc.nextInChain = nullptr;
@@ -963,13 +1077,17 @@ void Device::UpdatePipelineState(PsoHandle psoID, const RasterizePipelineDescrip
 
     // Fragment stage
     wgpu::FragmentState fragmentState{};
+    wgpu::ColorTargetState colorTarget{};
+    colorTarget.format = wgpuSwapchainFormat;
+
+    wgpu::BlendState blendState = AlphaBlendState();
+    if (desc.blendMode == BlendMode::AlphaBlend)
+        colorTarget.blend = &blendState;
+
     if (desc.fragmentShader.isValid())
     {
         fragmentState.module = gAllShaderModules[desc.fragmentShader.handle];
         fragmentState.entryPoint = "main";
-
-        wgpu::ColorTargetState colorTarget{};
-        colorTarget.format = wgpuSwapchainFormat;
         fragmentState.targets = &colorTarget;
         fragmentState.targetCount = 1;
     }
@@ -987,12 +1105,43 @@ void Device::UpdatePipelineState(PsoHandle psoID, const RasterizePipelineDescrip
     pipelineDesc.multisample = multisampleState;
 
     auto pipeline = wgpuDevice.CreateRenderPipeline(&pipelineDesc);
-    gAllPSOs[psoID.handle] = pipeline;
+    gAllPSOs[psoID.handle].pipeline = pipeline;
 }
 
 void Device::DestroyRasterizePipeline(PsoHandle psoID)
 {
-    gAllPSOs[psoID.handle] = nullptr;
+    gAllPSOs.Remove(psoID.handle);
+}
+
+PsoHandle Device::CreateComputePipeline(const ComputePipelineDescriptor& desc)
+{
+    MLOG_DEBUG(u8"Create Compute Pipeline (WEBGPU)");
+
+    // the push constant emulation is flushed at Present, after one time command lists were already submitted
+    if (desc.pushConstantSize > 0)
+    {
+        MLOG_WARNING(u8"Push constants are not supported by WebGPU compute pipelines, pass the data in a uniform buffer");
+    }
+
+    PsoHandle result;
+    result.handle = gAllPSOs.Emplace();
+
+    auto& psoMeta = gAllPSOs[result.handle];
+    psoMeta.pipelineLayout = CreatePipelineLayout(desc, false);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc{};
+    pipelineDesc.layout = psoMeta.pipelineLayout;
+    pipelineDesc.compute.module = gAllShaderModules[desc.computeShader.handle];
+    pipelineDesc.compute.entryPoint = "main";
+
+    psoMeta.computePipeline = wgpuDevice.CreateComputePipeline(&pipelineDesc);
+
+    return result;
+}
+
+void Device::DestroyComputePipeline(PsoHandle psoID)
+{
+    gAllPSOs.Remove(psoID.handle);
 }
 
 
@@ -1009,7 +1158,7 @@ int Swapchain::GetHeight() const
 
 void CommandList::PushConstants(const void* data, size_t size)
 {
-    auto& psoMeta = gAllPSOMetas[currentPsoID.handle];
+    auto& psoMeta = gAllPSOs[currentPsoID.handle];
 
     if (psoMeta.hasPushConstants)
     {
@@ -1025,7 +1174,15 @@ void CommandList::PushConstants(const void* data, size_t size)
 
 void Device::DestroyBuffer(BufferHandle bufferID)
 {
-    // Implementation for destroying a buffer
+    auto* buffer = gAllBuffers.Get(bufferID.handle);
+    if (buffer == nullptr)
+    {
+        MLOG_WARNING(u8"DestroyBuffer: invalid buffer handle (%u)", bufferID.handle);
+        return;
+    }
+
+    buffer->Destroy();
+    gAllBuffers.Remove(bufferID.handle);
 }
 
 void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size, size_t offset)
@@ -1037,17 +1194,30 @@ void Device::UpdateBuffer(BufferHandle bufferID, const void* data, size_t size,
 		static_cast<u64>(size));
 }
 
+void* Device::GetMappedBufferPointer(BufferHandle bufferID)
+{
+    // WebGPU only maps MapWrite|CopySrc buffers and never while the GPU uses them, writes go through Queue::WriteBuffer
+    return nullptr;
+}
+
+void Device::FlushBuffer(BufferHandle bufferID, size_t offset, size_t size)
+{
+}
+
 BufferHandle Device::CreateBuffer(const BufferDescriptor& desc)
 {
 	wgpu::BufferDescriptor bufferDesc{};
 	bufferDesc.size = static_cast<u64>(desc.size);
 	bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+	if (desc.type == BufferType::StorageBuffer)
+		bufferDesc.usage |= wgpu::BufferUsage::Storage;
+	if (desc.type == BufferType::IndirectBuffer)
+		bufferDesc.usage |= wgpu::BufferUsage::Storage | wgpu::BufferUsage::Indirect;
 	bufferDesc.mappedAtCreation = false;
 	auto buffer = wgpuDevice.CreateBuffer(&bufferDesc);
-	gAllBuffers.push_back(buffer);
 
     BufferHandle h;
-    h.handle = static_cast<u32>(gAllBuffers.size() - 1);
+    h.handle = gAllBuffers.Emplace(buffer);
     return h;
 }
 
@@ -1057,164 +1227,138 @@ ParameterBlockLayoutHandle Device::CreateParameterBlockLayout(const BindingSetLa
 	desc.label = "Parameter Block Layout";
 
 	std::vector<wgpu::BindGroupLayoutEntry> entries;
-	int bindingIndex = 0;
-
-	for (int i = 0; i < layoutDesc.allSlots.size(); ++i)
-    {
-		auto& slot = layoutDesc.allSlots[i];
-
-        if (slot.resourceType == ShaderResourceType::UniformBuffer)
-        {
-            wgpu::BindGroupLayoutEntry entry{};            
-            entry.binding = static_cast<u32>(bindingIndex);
-            entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
-            entry.buffer.hasDynamicOffset = false;
-            entry.buffer.type = wgpu::BufferBindingType::Uniform;
-            entries.push_back(entry);
-        }
-
-        if (slot.resourceType == ShaderResourceType::SampledImage2D)
-        {
-            {
-                wgpu::BindGroupLayoutEntry entry{};
-                entry.binding = static_cast<u32>(bindingIndex);
-                entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
-				entry.texture.sampleType = wgpu::TextureSampleType::Float;
-				entry.texture.viewDimension = wgpu::TextureViewDimension::e2D;            
-                entries.push_back(entry);
-                ++bindingIndex;
-            }            
-
-            {
-                wgpu::BindGroupLayoutEntry entry{};
-                entry.binding = static_cast<u32>(bindingIndex);
-                entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
-				entry.sampler.type = wgpu::SamplerBindingType::Filtering;
-                entries.push_back(entry);
-            }
-        }
-
-        ++bindingIndex;
-    }
+	FillBindGroupLayoutEntries(layoutDesc, entries);
 
 	desc.entryCount = static_cast<u32>(entries.size());
 	desc.entries = entries.data();
 
-	auto bgl = wgpuDevice.CreateBindGroupLayout(&desc);
+	ParameterBlockLayoutMeta meta;
+	meta.bindGroupLayout = wgpuDevice.CreateBindGroupLayout(&desc);
+	meta.dynamicOffsetCount = static_cast<u32>(std::count_if(entries.begin(), entries.end(),
+		[](const wgpu::BindGroupLayoutEntry& entry) { return entry.buffer.hasDynamicOffset; }));
 
-	gAllParameterBlockLayouts.push_back(bgl);
-
-    return ParameterBlockLayoutHandle{ static_cast<u32>(gAllParameterBlockLayouts.size() - 1) };
+    return ParameterBlockLayoutHandle{ gAllParameterBlockLayouts.Emplace(meta) };
 }
 
 void Device::DestroyParameterBlockLayout(ParameterBlockLayoutHandle layoutID)
 {
-    //vkAllocateDescriptorSets()
-    // Implementation for destroying a parameter block layout
+    gAllParameterBlockLayouts.Remove(layoutID.handle);
 }
 
 void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID)
+{
+    // every dynamic entry needs an offset, zero keeps the one the buffer was written with
+    static constexpr u32 zeroOffsets[64] = {};
+
+    SetParameterBlock(setIndex, parameterBlockID, std::span<const u32>(zeroOffsets, gAllParameterBlocks[parameterBlockID.handle].dynamicOffsetCount));
+}
+
+void CommandList::SetParameterBlock(u8 setIndex, ParameterBlockHandle parameterBlockID, std::span<const u32> dynamicOffsets)
 {
   //  auto cmdBuff = static_cast<VkCommandBuffer>(nativePtr);
-    PSOMeta& psoMeta = gAllPSOMetas[currentPsoID.handle];
+    PSOMeta& psoMeta = gAllPSOs[currentPsoID.handle];
+    const ParamaterBllockMeta& meta = gAllParameterBlocks[parameterBlockID.handle];
+
+    MERCURY_ASSERT(dynamicOffsets.size() == meta.dynamicOffsetCount);
 
     if(currentRenderPassNativePtr != nullptr)
     {
         auto rpassEnc = (wgpu::RenderPassEncoder*)currentRenderPassNativePtr;
         rpassEnc->SetBindGroup(setIndex + (psoMeta.hasPushConstants ? 1 : 0),
-            gAllParameterBlocks[parameterBlockID.handle],
-                               0,
-			nullptr);
+            meta.bindGroup,
+            dynamicOffsets.size(),
+			dynamicOffsets.data());
 	}
+    else if (gCurrentComputePass)
+    {
+        gCurrentComputePass.SetBindGroup(setIndex, meta.bindGroup, dynamicOffsets.size(), dynamicOffsets.data());
+    }
+}
+
+u32 Device::GetMaxTextureTableSize()
+{
+    return 0; // no binding arrays in WebGPU
 }
 
 ParameterBlockHandle Device::CreateParameterBlock(const ParameterBlockLayoutHandle& layoutID)
 {
     ParamaterBllockMeta meta;
     meta.layoutHandle = layoutID;
+    meta.dynamicOffsetCount = gAllParameterBlockLayouts[layoutID.handle].dynamicOffsetCount;
 
-	gAllParameterBlockMetas.push_back(meta);
-	gAllParameterBlocks.push_back(nullptr);
-
-    return ParameterBlockHandle{ static_cast<u32>(gAllParameterBlocks.size() - 1)};
+    return ParameterBlockHandle{ gAllParameterBlocks.Emplace(meta) };
 }
 
 void Device::UpdateParameterBlock(ParameterBlockHandle parameterBlockID, const ParameterBlockDescriptor& pbDesc)
 {
-	ParamaterBllockMeta& meta = gAllParameterBlockMetas[parameterBlockID.handle];
+	ParamaterBllockMeta& meta = gAllParameterBlocks[parameterBlockID.handle];
 
     wgpu::BindGroupDescriptor desc{};
 
-    std::vector<wgpu::BindGroupEntry> entries;
+    memory::FrameVector<wgpu::BindGroupEntry> entries;
     u32 slotIndex = 0;
 
-    for(int i= 0; i < pbDesc.resources.size(); ++i)
+    for (const auto& res : pbDesc.resources)
     {
-        const auto& binding = pbDesc.resources[i];
-        
-		wgpu::BindGroupEntry entry{};
-        for (const auto& res : pbDesc.resources)
-        {
-            std::visit([&](auto&& arg)
+        std::visit([&](auto&& arg)
+            {
+                using T = std::decay_t<decltype(arg)>;
+                wgpu::BindGroupEntry entry{};
+
+                if constexpr (std::is_same_v<T, ParameterResourceBuffer>)
                 {
-                    using T = std::decay_t<decltype(arg)>;
-
-                    if constexpr (std::is_same_v<T, ParameterResourceBuffer>)
-                    {
-						entry.binding = slotIndex;
-                        entry.buffer = gAllBuffers[arg.buffer.handle];
-                        entry.offset = arg.offset;
-                        entry.size = arg.size;
-						entries.push_back(entry);
-                    }
-                    else if constexpr (std::is_same_v<T, ParameterResourceTexture>)
-                    {
-                        entry.binding = slotIndex;
-						entry.textureView = gAllTextures[arg.texture.handle].CreateView();
-                        entries.push_back(entry);
-                        slotIndex++;
-
-                        wgpu::BindGroupEntry samplerEntry{};
-						samplerEntry.binding = slotIndex;
-						samplerEntry.sampler = wgpuDefaultLinearSampler;
-						entries.push_back(samplerEntry);
-
-                        MLOG_WARNING(u8"ParameterResourceTexture not yet implemented in UpdateParameterBlock");
-                    }
-                    else if constexpr (std::is_same_v<T, ParameterResourceRWImage>)
-                    {
-                        // TODO: Fill VkDescriptorImageInfo for storage image
-                        MLOG_WARNING(u8"ParameterResourceRWImage not yet implemented in UpdateParameterBlock");
-                    }
-                    else if constexpr (std::is_same_v<T, ParameterResourceEmpty>)
-                    {
-                        // Intentionally empty slot  skip writing
-                    }
-                }, res);
-
-            slotIndex++;
-        }
-	}
+                    entry.binding = slotIndex;
+                    entry.buffer = gAllBuffers[arg.buffer.handle];
+                    entry.offset = arg.offset;
+                    entry.size = arg.size;
+                    entries.push_back(entry);
+                }
+                else if constexpr (std::is_same_v<T, ParameterResourceTexture>)
+                {
+                    entry.binding = slotIndex;
+                    entry.textureView = gAllTextures[arg.texture.handle].textureView;
+                    entries.push_back(entry);
+                    slotIndex++;
+
+                    wgpu::BindGroupEntry samplerEntry{};
+                    samplerEntry.binding = slotIndex;
+                    samplerEntry.sampler = wgpuDefaultLinearSampler;
+                    entries.push_back(samplerEntry);
+
+                    MLOG_WARNING(u8"ParameterResourceTexture not yet implemented in UpdateParameterBlock");
+                }
+                else if constexpr (std::is_same_v<T, ParameterResourceRWImage>)
+                {
+                    // TODO: Fill VkDescriptorImageInfo for storage image
+                    MLOG_WARNING(u8"ParameterResourceRWImage not yet implemented in UpdateParameterBlock");
+                }
+                else if constexpr (std::is_same_v<T, ParameterResourceEmpty>)
+                {
+                    // Intentionally empty slot  skip writing
+                }
+            }, res);
 
-    desc.layout = gAllParameterBlockLayouts[meta.layoutHandle.handle];
+        slotIndex++;
+    }
+
+    desc.layout = gAllParameterBlockLayouts[meta.layoutHandle.handle].bindGroupLayout;
     desc.entryCount = static_cast<u32>(entries.size());
     desc.entries = entries.data();
     desc.label = "Parameter Block";
 
     auto bg = wgpuDevice.CreateBindGroup(&desc);
 	//DO i need to release old bind group? Probably not, WebGPU uses ref counting internally
-    gAllParameterBlocks[parameterBlockID.handle] = bg;
+    meta.bindGroup = bg;
 }
 
 void Device::DestroyParameterBlock(ParameterBlockHandle parameterBlockID)
 {
-
+    gAllParameterBlocks.Remove(parameterBlockID.handle);
 }
 
 TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 {
     TextureHandle result;
-    result.handle = static_cast<u32>(gAllTextures.size());
     wgpu::TextureDescriptor textureDesc{};
     textureDesc.size.width = desc.width;
     textureDesc.size.height = desc.height;
@@ -1225,7 +1369,6 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
     textureDesc.format = wgpu::TextureFormat::RGBA8Unorm;
     textureDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
     auto texture = wgpuDevice.CreateTexture(&textureDesc);
-    gAllTextures.push_back(texture);
         
     if (desc.initialData != nullptr)
     {
@@ -1251,14 +1394,23 @@ TextureHandle Device::CreateTexture(const TextureDescriptor& desc)
 
     TextureMeta meta;
 
+	meta.texture = texture;
 	meta.textureView = texture.CreateView();
-	gAllTextureMetas.push_back(meta);
+	result.handle = gAllTextures.Emplace(meta);
 	return result;
 }
 
 void Device::DestroyTexture(TextureHandle textureID)
 {
+    auto* meta = gAllTextures.Get(textureID.handle);
+    if (meta == nullptr)
+    {
+        MLOG_WARNING(u8"DestroyTexture: invalid texture handle (%u)", textureID.handle);
+        return;
+    }
 
+    meta->texture.Destroy();
+    gAllTextures.Remove(textureID.handle);
 }
 
 void Device::UpdateTexture(TextureHandle textureID, const void* data, size_t size, size_t offset)
@@ -1277,12 +1429,55 @@ void Device::UpdateSubregionTexture(
     const void* data,
     size_t dataSize)
 {
-	//TODO: Implement subregion texture update
+    wgpu::TexelCopyTextureInfo texInfo{};
+    texInfo.aspect = wgpu::TextureAspect::All;
+    texInfo.texture = gAllTextures[textureID.handle].texture;
+    texInfo.mipLevel = 0;
+    texInfo.origin = { static_cast<u32>(x), static_cast<u32>(y), static_cast<u32>(z) };
+
+    wgpu::TexelCopyBufferLayout layout{};
+    layout.offset = 0;
+    layout.bytesPerRow = static_cast<u32>(width * 4);
+    layout.rowsPerImage = static_cast<u32>(height);
+
+    wgpu::Extent3D size = { static_cast<u32>(width), static_cast<u32>(height), static_cast<u32>(depth) };
+
+    wgpuDevice.GetQueue().WriteTexture(&texInfo, data, dataSize, &layout, &size);
+}
+
+void Device::SubmitOneTimeCommandsList(std::function<void(CommandList& cmdList)> recordCommands, std::function<void()> onFinish)
+{
+    // the commands may read upload ring ranges written earlier this frame
+    FlushUploads();
+
+    wgpu::CommandEncoder encoder = wgpuDevice.CreateCommandEncoder();
+    encoder.SetLabel("One Time Command Encoder");
+
+    CommandList cmdList = { &encoder };
+    recordCommands(cmdList);
+
+    if (gCurrentComputePass)
+    {
+        gCurrentComputePass.End();
+        gCurrentComputePass = nullptr;
+    }
+
+    wgpu::CommandBuffer commandBuffer = encoder.Finish();
+    wgpuDevice.GetQueue().Submit(1, &commandBuffer);
+
+    if (onFinish)
+    {
+        wgpuDevice.GetQueue().OnSubmittedWorkDone(wgpu::CallbackMode::AllowProcessEvents,
+            [onFinish](wgpu::QueueWorkDoneStatus, wgpu::StringView)
+            {
+                onFinish();
+            });
+    }
 }
 
 u64 TextureHandle::CreateImguiTextureOpaqueHandle() const
 {
-	return (u64)(intptr_t)gAllTextureMetas[handle].textureView.Get();
+	return (u64)(intptr_t)gAllTextures[handle].textureView.Get();
 }
 
 #endif //MERCURY_LL_GRAPHICS_WEBGPU#endif //MERCURY_LL_GRAPHICS_WEBGPU#endif //MERCURY_LL_GRAPHICS_WEBGPU#endif //MERCURY_LL_GRAPHICS_WEBGPU
\ No newline at end of file
@@ -165,7 +165,7 @@ namespace mercury::ll::os
         return getpagesize();;
     }
 
-    void* OS::ReserveMemory(size_t size)
+    void* OS::ReserveMemory(size_t size, const MemoryPolicy& policy)
     {
         void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
         if (ptr == MAP_FAILED) {
@@ -174,13 +174,21 @@ namespace mercury::ll::os
         return ptr;
     }
 
-    void OS::CommitMemory(void* ptr, size_t size)
+    void OS::CommitMemory(void* ptr, size_t size, const MemoryPolicy& policy)
     {
         mprotect(ptr, size, PROT_READ | PROT_WRITE);
+
+        if (policy.flags & MemoryPolicy::Prefault)
+        {
+            size_t pageSize = GetPageSize();
+            for (size_t offset = 0; offset < size; offset += pageSize)
+                ((volatile u8*)ptr)[offset] = 0;
+        }
     }
 
     void OS::DecommitMemory(void* ptr, size_t size)
     {
+        madvise(ptr, size, MADV_DONTNEED);
         mprotect(ptr, size, PROT_NONE);
     }
 
@@ -12,10 +12,16 @@
 #include "linux_input.h"
 #include "mercury_log.h"
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <mutex>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
 
 #include "linux_display_server.h"
 
 #include <cstring>
+#include <algorithm>
 
 LinuxDisplayServer *gDisplayServer = nullptr;
 
@@ -172,31 +178,193 @@ namespace mercury::ll::os
     return sysconf(_SC_PAGESIZE);
   }
 
-  void* OS::ReserveMemory(size_t size)
+  static size_t GetHugePageSize()
+  {
+    static size_t hugePageSize = []() -> size_t {
+      size_t result = 2_MB;
+
+      if (FILE* meminfo = fopen("/proc/meminfo", "r"))
+      {
+        char line[256];
+        while (fgets(line, sizeof(line), meminfo))
+        {
+          size_t sizeKB = 0;
+          if (sscanf(line, "Hugepagesize: %zu kB", &sizeKB) == 1)
+          {
+            result = sizeKB * 1_KB;
+            break;
+          }
+        }
+        fclose(meminfo);
+      }
+
+      return result;
+    }();
+
+    return hugePageSize;
+  }
+
+  // hugetlb mappings can only change protection in whole huge pages, so commit/decommit must know about them
+  struct HugeTlbRange
+  {
+    u8* begin;
+    size_t size;
+  };
+
+  static std::mutex gHugeTlbRangesMutex;
+  static std::vector<HugeTlbRange> gHugeTlbRanges;
+
+  static bool FindHugeTlbRange(void* ptr, HugeTlbRange& rangeOut)
+  {
+    std::lock_guard<std::mutex> lock(gHugeTlbRangesMutex);
+
+    for (const auto& range : gHugeTlbRanges)
+    {
+      if ((u8*)ptr >= range.begin && (u8*)ptr < range.begin + range.size)
+      {
+        rangeOut = range;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  static void BindToNumaNode(void* ptr, size_t size, i32 numaNode)
+  {
+    // raw syscall, so we don't depend on libnuma
+    constexpr int MPOL_BIND_MODE = 2;
+    unsigned long nodeMask = 1ul << numaNode;
+
+    IF_UNLIKELY (numaNode >= (i32)(sizeof(nodeMask) * 8) ||
+                 syscall(SYS_mbind, ptr, size, MPOL_BIND_MODE, &nodeMask, sizeof(nodeMask) * 8, 0) != 0)
+    {
+      MLOG_WARNING(u8"Failed to bind memory to NUMA node %d: %s", numaNode, strerror(errno));
+    }
+  }
+
+  void* OS::ReserveMemory(size_t size, const MemoryPolicy& policy)
   {
     // On Linux, we can use mmap with PROT_NONE to reserve memory
-    void* ptr = mmap(nullptr, size, PROT_NONE, 
-                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    IF_UNLIKELY (ptr == MAP_FAILED) {
+    size = mercury::utils::math::alignUp(size, GetPageSize());
+    size_t hugePageSize = GetHugePageSize();
+    void* ptr = MAP_FAILED;
+
+    if ((policy.flags & MemoryPolicy::ExplicitHugePages) && size % hugePageSize == 0)
+    {
+      ptr = mmap(nullptr, size, PROT_NONE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+      if (ptr != MAP_FAILED)
+      {
+        std::lock_guard<std::mutex> lock(gHugeTlbRangesMutex);
+        gHugeTlbRanges.push_back({(u8*)ptr, size});
+      }
+      else
+      {
+        MLOG_WARNING(u8"hugetlb reservation of %zu bytes failed (%s), falling back to transparent huge pages", size, strerror(errno));
+      }
+    }
+
+    if (ptr == MAP_FAILED && (policy.flags & (MemoryPolicy::TransparentHugePages | MemoryPolicy::ExplicitHugePages)))
+    {
+      // over-reserve and trim, so the region starts on a huge page boundary and the kernel can back all of it
+      size_t paddedSize = size + hugePageSize;
+      u8* raw = (u8*)mmap(nullptr, paddedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      IF_UNLIKELY (raw == MAP_FAILED) {
         return nullptr;
+      }
+
+      u8* aligned = (u8*)mercury::utils::math::alignUp((u64)raw, hugePageSize);
+      size_t head = aligned - raw;
+      size_t tail = paddedSize - head - size;
+
+      if (head > 0)
+        munmap(raw, head);
+      if (tail > 0)
+        munmap(aligned + size, tail);
+
+      ptr = aligned;
+      madvise(ptr, size, MADV_HUGEPAGE);
+    }
+
+    if (ptr == MAP_FAILED)
+    {
+      ptr = mmap(nullptr, size, PROT_NONE, 
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      IF_UNLIKELY (ptr == MAP_FAILED) {
+          return nullptr;
+      }
     }
+
+    if (policy.numaNode >= 0)
+      BindToNumaNode(ptr, size, policy.numaNode);
+
     return ptr;
   }
 
-  void OS::CommitMemory(void* ptr, size_t size)
+  void OS::CommitMemory(void* ptr, size_t size, const MemoryPolicy& policy)
   {
+    HugeTlbRange hugeTlbRange;
+    if (FindHugeTlbRange(ptr, hugeTlbRange))
+    {
+      // widen to whole huge pages, never past the reservation
+      size_t hugePageSize = GetHugePageSize();
+      u8* begin = (u8*)((u64)ptr & ~(u64)(hugePageSize - 1));
+      u8* end = (u8*)mercury::utils::math::alignUp((u64)ptr + size, hugePageSize);
+      end = std::min(end, hugeTlbRange.begin + hugeTlbRange.size);
+
+      ptr = begin;
+      size = end - begin;
+    }
+
     // Change protection to read/write
     mprotect(ptr, size, PROT_READ | PROT_WRITE);
+
+    if (policy.flags & MemoryPolicy::Prefault)
+    {
+#ifdef MADV_POPULATE_WRITE
+      if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0)
+        return;
+#endif
+      // older kernels: touch every page, committed ranges hold no data yet
+      size_t pageSize = GetPageSize();
+      for (size_t offset = 0; offset < size; offset += pageSize)
+        ((volatile u8*)ptr)[offset] = 0;
+    }
   }
 
   void OS::DecommitMemory(void* ptr, size_t size)
   {
-    // Change protection to none
+    HugeTlbRange hugeTlbRange;
+    if (FindHugeTlbRange(ptr, hugeTlbRange))
+    {
+      // shrink to whole huge pages, partially used huge pages stay resident
+      size_t hugePageSize = GetHugePageSize();
+      u8* begin = (u8*)mercury::utils::math::alignUp((u64)ptr, hugePageSize);
+      u8* end = (u8*)(((u64)ptr + size) & ~(u64)(hugePageSize - 1));
+
+      if (end <= begin)
+        return;
+
+      ptr = begin;
+      size = end - begin;
+    }
+
+    // Give the pages back to the system, then change protection to none
+    madvise(ptr, size, MADV_DONTNEED);
     mprotect(ptr, size, PROT_NONE);
   }
 
   void OS::ReleaseMemory(void* ptr, size_t size)
   {
+    {
+      std::lock_guard<std::mutex> lock(gHugeTlbRangesMutex);
+      gHugeTlbRanges.erase(std::remove_if(gHugeTlbRanges.begin(), gHugeTlbRanges.end(),
+                                          [ptr](const HugeTlbRange& range) { return range.begin == ptr; }),
+                           gHugeTlbRanges.end());
+    }
+
     munmap(ptr, size);
   }
 
@@ -299,7 +299,7 @@ namespace mercury::ll::os
         return getpagesize();
     }
 
-    void* OS::ReserveMemory(size_t size) {
+    void* OS::ReserveMemory(size_t size, const MemoryPolicy& policy) {
         vm_address_t address = 0;
         kern_return_t result = vm_allocate(mach_task_self(), &address, size, VM_FLAGS_ANYWHERE);
         if (result != KERN_SUCCESS) {
@@ -309,14 +309,14 @@ namespace mercury::ll::os
         return (void*)address;
     }
 
-    void OS::CommitMemory(void* ptr, size_t size) {
+    void OS::CommitMemory(void* ptr, size_t size, const MemoryPolicy& policy) {
         // On macOS, vm_allocate already commits the memory
         // This is a no-op for compatibility
     }
 
     void OS::DecommitMemory(void* ptr, size_t size) {
-        // On macOS, we can decommit memory using vm_deallocate
-        vm_deallocate(mach_task_self(), (vm_address_t)ptr, size);
+        // vm_allocate'd memory stays mapped, so only drop the pages. vm_deallocate here would unmap the range
+        madvise(ptr, size, MADV_FREE);
     }
 
     void OS::ReleaseMemory(void* ptr, size_t size) {
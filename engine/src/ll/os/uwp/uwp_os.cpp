@@ -168,13 +168,13 @@ namespace mercury::ll::os
     return gSysInfo.dwAllocationGranularity;
   }
 
-  void* OS::ReserveMemory(size_t size)
+  void* OS::ReserveMemory(size_t size, const MemoryPolicy& policy)
   {
     void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
     return ptr;
   }
 
-  void OS::CommitMemory(void* ptr, size_t size)
+  void OS::CommitMemory(void* ptr, size_t size, const MemoryPolicy& policy)
   {
     VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
   }
@@ -321,15 +321,29 @@ namespace mercury::ll::os
     return gSysInfo.dwAllocationGranularity;
   }
 
-  void* OS::ReserveMemory(size_t size)
+  void* OS::ReserveMemory(size_t size, const MemoryPolicy& policy)
   {
+    // large pages need SeLockMemoryPrivilege and can't be committed lazily, huge page hints are ignored here
+    if (policy.numaNode >= 0)
+      return VirtualAllocExNuma(GetCurrentProcess(), nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, (DWORD)policy.numaNode);
+
     void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
     return ptr;
   }
 
-  void OS::CommitMemory(void* ptr, size_t size)
+  void OS::CommitMemory(void* ptr, size_t size, const MemoryPolicy& policy)
   {
-    VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
+    if (policy.numaNode >= 0)
+      VirtualAllocExNuma(GetCurrentProcess(), ptr, size, MEM_COMMIT, PAGE_READWRITE, (DWORD)policy.numaNode);
+    else
+      VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
+
+    if (policy.flags & MemoryPolicy::Prefault)
+    {
+      size_t pageSize = GetPageSize();
+      for (size_t offset = 0; offset < size; offset += pageSize)
+        ((volatile u8*)ptr)[offset] = 0;
+    }
   }
 
   void OS::DecommitMemory(void* ptr, size_t size)
@@ -3,88 +3,295 @@
 #include "ll/os.h"
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <chrono>
 
 using namespace mercury;
 using namespace mercury::memory;
 
+namespace
+{
+    std::atomic<ReservedAllocator *> gThreadSafeAllocators[ReservedAllocator::MaxThreadSafeAllocators] = {};
+
+    struct ThreadCache
+    {
+        ReservedAllocator *owner = nullptr;
+        u8 index = 0;
+
+        // loaded serves requests, previous is the spare magazine that absorbs alloc/free ping-pong at the boundary
+        ReservedAllocator::Magazine loaded[ReservedAllocator::MaxThreadCachedBuckets];
+        ReservedAllocator::Magazine previous[ReservedAllocator::MaxThreadCachedBuckets];
+
+        void Reset(ReservedAllocator *newOwner, u8 newIndex)
+        {
+            // slots cached for a destroyed allocator are simply dropped
+            for (u8 i = 0; i < ReservedAllocator::MaxThreadCachedBuckets; ++i)
+            {
+                loaded[i] = ReservedAllocator::Magazine();
+                previous[i] = ReservedAllocator::Magazine();
+            }
+
+            owner = newOwner;
+            index = newIndex;
+        }
+
+        ~ThreadCache()
+        {
+            // the allocator may be gone already, only flush into a live one
+            if (owner && gThreadSafeAllocators[index].load(std::memory_order_acquire) == owner)
+                owner->FlushThreadCache();
+        }
+    };
+
+    thread_local ThreadCache tThreadCaches[ReservedAllocator::MaxThreadSafeAllocators];
+
+#ifdef MERCURY_USE_MEMORY_STAT
+    std::atomic<u8> gNextStatShard{0};
+    thread_local u8 tStatShard = gNextStatShard.fetch_add(1, std::memory_order_relaxed) % ReservedAllocator::NumStatShards;
+
+    inline void StatAdd(std::atomic<u64> &counter, u64 value)
+    {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline u64 StatLoad(const std::atomic<u64> &counter)
+    {
+        return counter.load(std::memory_order_relaxed);
+    }
+#endif
+}
+
 ReservedAllocator::ReservedAllocator(const ReservedAllocator::InitDesc &desc)
 {
+    auto *os = ll::os::gOS;
+
     numBuckets = (u8)desc.bucketsInfo.size();
     buckets = (Bucket *)malloc(sizeof(Bucket) * numBuckets);
     bucketSizes = (u16 *)malloc(sizeof(u16) * numBuckets);
+
+    // every bucket gets a power of two slot, so pointer -> bucket is a single shift
+    size_t bucketSlotSize = os->GetPageSize();
+    for (size_t i = 0; i < numBuckets; ++i)
+    {
+        MERCURY_ASSERT(i == 0 || desc.bucketsInfo[i - 1].elementSize < desc.bucketsInfo[i].elementSize);
+
+        while (bucketSlotSize < desc.bucketsInfo[i].maximumReservedSize)
+            bucketSlotSize <<= 1;
+    }
+
+    while (((size_t)1 << bucketRegionShift) < bucketSlotSize)
+        bucketRegionShift++;
+
+    if (numBuckets > 0)
+    {
+        reservedRegionSize = (size_t)numBuckets << bucketRegionShift;
+        beginRegion = os->ReserveMemory(reservedRegionSize, desc.memoryPolicy);
+        MERCURY_ASSERT(beginRegion != nullptr);
+    }
+
     for (size_t i = 0; i < numBuckets; ++i)
     {
-        new (&buckets[i]) Bucket(desc.bucketsInfo[i].elementSize, desc.bucketsInfo[i].maximumReservedSize, desc.bucketsInfo[i].initialCommittedSize);
+        void *bucketRegion = (u8 *)beginRegion + (i << bucketRegionShift);
+        new (&buckets[i]) Bucket(bucketRegion, desc.bucketsInfo[i].elementSize, desc.bucketsInfo[i].maximumReservedSize, desc.bucketsInfo[i].initialCommittedSize, desc.freeListPolicy, desc.memoryPolicy);
         bucketSizes[i] = desc.bucketsInfo[i].elementSize;
     }
+
+    maxBucketElementSize = numBuckets > 0 ? bucketSizes[numBuckets - 1] : 0;
+
+    threadSafe = desc.threadSafe;
+    magazineSize = desc.magazineSize;
+
+    if (threadSafe)
+    {
+        // slots in a magazine need room for the next slot id and the next magazine id
+        MERCURY_ASSERT(numBuckets <= MaxThreadCachedBuckets);
+        MERCURY_ASSERT(numBuckets == 0 || bucketSizes[0] >= 2 * sizeof(u32));
+        MERCURY_ASSERT(magazineSize > 0);
+
+        bool registered = false;
+        for (u8 i = 0; i < MaxThreadSafeAllocators && !registered; ++i)
+        {
+            ReservedAllocator *expected = nullptr;
+            if (gThreadSafeAllocators[i].compare_exchange_strong(expected, this))
+            {
+                threadCacheIndex = i;
+                registered = true;
+            }
+        }
+        MERCURY_ASSERT(registered);
+    }
+
+    if (desc.traceFilePath != nullptr)
+    {
+        traceFile = fopen(desc.traceFilePath, "wb");
+
+        if (traceFile != nullptr)
+        {
+            trace::Header header;
+            fwrite(&header, sizeof(header), 1, traceFile);
+            traceBuffer.reserve(TraceBufferEvents);
+        }
+        else
+        {
+            MLOG_WARNING(u8"ReservedAllocator: can't open trace file %s", desc.traceFilePath);
+        }
+    }
+
+    if (desc.backgroundTrimIntervalMs > 0)
+    {
+        // a non thread safe allocator can not be touched from another thread
+        MERCURY_ASSERT(threadSafe);
+
+        std::chrono::milliseconds interval(desc.backgroundTrimIntervalMs);
+
+        trimThread = new std::thread([this, interval]()
+        {
+            std::unique_lock<std::mutex> lock(trimMutex);
+
+            while (!trimCondition.wait_for(lock, interval, [this]() { return trimThreadStop; }))
+            {
+                lock.unlock();
+
+                size_t trimmedSize = Trim();
+                if (trimmedSize > 0)
+                    MLOG_DEBUG(u8"ReservedAllocator: trimmed %s", mercury::utils::string::format_size(trimmedSize).c_str());
+
+                lock.lock();
+            }
+        });
+    }
+
+    // size class c holds sizes up to c * SizeClassGranularity bytes
+    u8 bucketIndex = 0;
+    for (u32 sizeClass = 0; sizeClass < NumSizeClasses; ++sizeClass)
+    {
+        u32 classMaxSize = sizeClass << SizeClassShift;
+
+        while (bucketIndex < numBuckets && bucketSizes[bucketIndex] < classMaxSize)
+            bucketIndex++;
+
+        sizeClassToBucket[sizeClass] = bucketIndex < numBuckets ? bucketIndex : InvalidBucket;
+    }
 }
 
 ReservedAllocator::~ReservedAllocator()
 {
+    if (trimThread)
+    {
+        {
+            std::lock_guard<std::mutex> lock(trimMutex);
+            trimThreadStop = true;
+        }
+
+        trimCondition.notify_one();
+        trimThread->join();
+        delete trimThread;
+    }
+
+    if (threadSafe)
+        gThreadSafeAllocators[threadCacheIndex].store(nullptr, std::memory_order_release);
+
+    if (traceFile != nullptr)
+    {
+        FlushTrace();
+        fclose(traceFile);
+    }
+
     for (int i = 0; i < numBuckets; ++i)
     {
         buckets[i].~Bucket();
     }
+
+    if (beginRegion)
+        ll::os::gOS->ReleaseMemory(beginRegion, reservedRegionSize);
+
     free(buckets);
     free(bucketSizes);
 }
 
 void *ReservedAllocator::Allocate(size_t size)
 {
-    totalAllocationsCount++;
-    totalAllocatedMemUser += size;
-
-    int bucketIndex = -1;
+    u8 bucketIndex = GetBucketIndexForSize(size);
 
-    for (size_t i = 0; i < numBuckets; ++i)
+    IF_LIKELY(bucketIndex != InvalidBucket)
     {
-        if (bucketSizes[i] >= size)
-        {
-            bucketIndex = i;
-            break;
-        }
-    }
+        void *result = threadSafe ? AllocateThreadCached(bucketIndex) : buckets[bucketIndex].Allocate((u16)size);
 
-    if (bucketIndex != -1)
-    {
-        totalAllocatedMemSystem += buckets[bucketIndex].elementSize;
-        return buckets[bucketIndex].Allocate(size);
+#ifdef MERCURY_USE_MEMORY_STAT
+        IF_LIKELY(result != nullptr)
+            RecordAllocation(bucketIndex, result, size);
+#endif
+        IF_UNLIKELY(traceFile != nullptr)
+            RecordTraceEvent(trace::EventType::Allocate, result, size);
+
+        return result;
     }
 
-    totalAllocatedMemSystem += size;
-    totalMallocAllocations++;
-    return malloc(size);
+#ifdef MERCURY_USE_MEMORY_STAT
+    StatShard &shard = stats[tStatShard];
+    StatAdd(shard.totalAllocationsCount, 1);
+    StatAdd(shard.totalAllocatedMemUser, size);
+    StatAdd(shard.totalAllocatedMemSystem, size);
+    StatAdd(shard.totalMallocAllocations, 1);
+#endif
+    void *result = malloc(size);
+
+    IF_UNLIKELY(traceFile != nullptr)
+        RecordTraceEvent(trace::EventType::Allocate, result, size);
+
+    return result;
 }
 
-void *ReservedAllocator::ReAllocate(void *ptr, u16 size)
+void *ReservedAllocator::ReAllocate(void *ptr, size_t size)
 {
-    int bucketIndexNew = -1;
-    int bucketIndexOld = -1;
+    if (ptr == nullptr)
+        return Allocate(size);
 
-    for (size_t i = 0; i < numBuckets; ++i)
+    u8 bucketIndexOld = GetBucketIndexForPtr(ptr);
+    u8 bucketIndexNew = GetBucketIndexForSize(size);
+
+#ifdef MERCURY_USE_MEMORY_STAT
+    StatAdd(stats[tStatShard].totalReallocsCount, 1);
+#endif
+
+    if (bucketIndexOld == InvalidBucket && bucketIndexNew == InvalidBucket) // reallocate to system memory
     {
-        if (buckets[i].IsPtrInBucketRange(ptr))
+        void *result = realloc(ptr, size);
+
+        IF_UNLIKELY(traceFile != nullptr)
         {
-            bucketIndexOld = i;
+            RecordTraceEvent(trace::EventType::Deallocate, ptr, 0);
+            RecordTraceEvent(trace::EventType::Allocate, result, size);
         }
 
-        if (bucketSizes[i] >= size)
+        return result;
+    }
+
+    if (bucketIndexOld != InvalidBucket && bucketIndexNew != InvalidBucket && bucketIndexNew <= bucketIndexOld) // do nothing
+    {
+#ifdef MERCURY_USE_MEMORY_STAT
+        // the slot stays, only its requested size changes
+        Bucket &bucket = buckets[bucketIndexOld];
+        u16 &userSize = bucket.userSizes[bucket.GetSlotId(ptr)];
+
+        StatAdd(stats[tStatShard].totalReallocsSaveBySameBucket, 1);
+        StatAdd(bucket.stats[tStatShard].allocatedMemUser, (u64)size - userSize);
+        userSize = (u16)size;
+#endif
+        IF_UNLIKELY(traceFile != nullptr)
         {
-            bucketIndexNew = i;
-            break;
+            RecordTraceEvent(trace::EventType::Deallocate, ptr, 0);
+            RecordTraceEvent(trace::EventType::Allocate, ptr, size);
         }
-    }
 
-    if (bucketIndexNew <= bucketIndexOld) // do nothing
         return ptr;
- 
-    if (bucketIndexNew == -1 && bucketIndexOld == -1) // reallocate to system memory
-    {
-        return realloc(ptr, size);
     }
 
+    // old system allocations only move to a bucket when shrinking, so size bytes are always readable
+    size_t copySize = bucketIndexOld != InvalidBucket ? std::min<size_t>(size, bucketSizes[bucketIndexOld]) : size;
+
     void *newPtr = Allocate(size);
-    memcpy(newPtr, ptr, size);
+    memcpy(newPtr, ptr, copySize);
     Deallocate(ptr);
 
     return newPtr;
@@ -95,102 +302,412 @@ void ReservedAllocator::Deallocate(void *ptr)
     if (ptr == nullptr)
         return;
 
-    for (size_t i = 0; i < numBuckets; ++i)
+    u8 bucketIndex = GetBucketIndexForPtr(ptr);
+
+    IF_UNLIKELY(traceFile != nullptr)
+        RecordTraceEvent(trace::EventType::Deallocate, ptr, 0);
+
+    IF_LIKELY(bucketIndex != InvalidBucket)
+    {
+#ifdef MERCURY_USE_MEMORY_STAT
+        RecordDeallocation(bucketIndex, ptr);
+#endif
+
+        if (threadSafe)
+            DeallocateThreadCached(bucketIndex, ptr);
+        else
+            buckets[bucketIndex].Deallocate(ptr);
+
+        return;
+    }
+
+    free(ptr);
+}
+
+#ifdef MERCURY_USE_MEMORY_STAT
+void ReservedAllocator::RecordAllocation(u8 bucketIndex, void *ptr, size_t size)
+{
+    Bucket &bucket = buckets[bucketIndex];
+
+    StatShard &shard = stats[tStatShard];
+    StatAdd(shard.totalAllocationsCount, 1);
+    StatAdd(shard.totalAllocatedMemUser, size);
+    StatAdd(shard.totalAllocatedMemSystem, bucket.elementSize);
+
+    BucketStatShard &bucketShard = bucket.stats[tStatShard];
+    StatAdd(bucketShard.allocationsCount, 1);
+    StatAdd(bucketShard.allocatedMemUser, size);
+    StatAdd(bucketShard.totalAllocationsCount, 1);
+    StatAdd(bucketShard.totalAllocatedMemUser, size);
+
+    u32 bin = size > 0 ? (u32)((size - 1) * NumSizeHistogramBins / bucket.elementSize) : 0;
+    StatAdd(bucketShard.sizeHistogram[bin], 1);
+
+    bucket.userSizes[bucket.GetSlotId(ptr)] = (u16)size;
+}
+
+void ReservedAllocator::RecordDeallocation(u8 bucketIndex, void *ptr)
+{
+    Bucket &bucket = buckets[bucketIndex];
+    u16 size = bucket.userSizes[bucket.GetSlotId(ptr)];
+
+    // unsigned wrap around, the sum over all shards is still exact
+    BucketStatShard &bucketShard = bucket.stats[tStatShard];
+    StatAdd(bucketShard.allocationsCount, ~0ull);
+    StatAdd(bucketShard.allocatedMemUser, 0ull - size);
+}
+#endif
+
+void ReservedAllocator::RecordTraceEvent(trace::EventType type, const void *ptr, size_t size)
+{
+    if (ptr == nullptr)
+        return;
+
+    trace::Event event;
+    event.address = (u64)(uintptr_t)ptr;
+    event.size = (u32)size;
+    event.type = type;
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+
+    traceBuffer.push_back(event);
+
+    if (traceBuffer.size() >= TraceBufferEvents)
+        FlushTrace();
+}
+
+void ReservedAllocator::FlushTrace()
+{
+    if (!traceBuffer.empty())
+        fwrite(traceBuffer.data(), sizeof(trace::Event), traceBuffer.size(), traceFile);
+
+    traceBuffer.clear();
+}
+
+void ReservedAllocator::GetSnapshot(Snapshot &snapshot)
+{
+    snapshot = Snapshot();
+    snapshot.reservedSize = reservedRegionSize;
+    snapshot.totalTrimmedSize = totalTrimmedSize.load(std::memory_order_relaxed);
+    snapshot.buckets.resize(numBuckets);
+
+#ifdef MERCURY_USE_MEMORY_STAT
+    for (const StatShard &shard : stats)
+    {
+        snapshot.totalAllocationsCount += StatLoad(shard.totalAllocationsCount);
+        snapshot.totalAllocatedMemUser += StatLoad(shard.totalAllocatedMemUser);
+        snapshot.totalAllocatedMemSystem += StatLoad(shard.totalAllocatedMemSystem);
+        snapshot.totalReallocsCount += StatLoad(shard.totalReallocsCount);
+        snapshot.totalReallocsSaveBySameBucket += StatLoad(shard.totalReallocsSaveBySameBucket);
+        snapshot.totalMallocAllocations += StatLoad(shard.totalMallocAllocations);
+    }
+#endif
+
+    for (u8 i = 0; i < numBuckets; ++i)
     {
-        if (buckets[i].IsPtrInBucketRange(ptr))
+        Bucket &bucket = buckets[i];
+        BucketSnapshot &bucketSnapshot = snapshot.buckets[i];
+
+        bucketSnapshot.elementSize = bucket.elementSize;
+        bucketSnapshot.reservedSize = bucket.maximumReservedSize;
+
         {
+            std::lock_guard<std::mutex> lock(bucket.mutex);
+            bucketSnapshot.committedSize = bucket.commitedSize;
+        }
+
+        snapshot.committedSize += bucketSnapshot.committedSize;
+
 #ifdef MERCURY_USE_MEMORY_STAT
-            buckets[i].DeallocateAndReturnUserSize(ptr);
-#else
-            buckets[i].Deallocate(ptr);
+        for (const BucketStatShard &shard : bucket.stats)
+        {
+            bucketSnapshot.allocationsCount += StatLoad(shard.allocationsCount);
+            bucketSnapshot.userSize += StatLoad(shard.allocatedMemUser);
+            bucketSnapshot.totalAllocationsCount += StatLoad(shard.totalAllocationsCount);
+            bucketSnapshot.totalAllocatedMemUser += StatLoad(shard.totalAllocatedMemUser);
+
+            for (u8 bin = 0; bin < NumSizeHistogramBins; ++bin)
+                bucketSnapshot.sizeHistogram[bin] += StatLoad(shard.sizeHistogram[bin]);
+        }
+
+        bucketSnapshot.usedSize = bucketSnapshot.allocationsCount * bucket.elementSize;
+        bucketSnapshot.totalSystemPagesCommitted = StatLoad(bucket.totalSystemPagesCommitted);
+        bucketSnapshot.totalDecommittedSize = StatLoad(bucket.totalDecommittedMem);
 #endif
+    }
+}
+
+void *ReservedAllocator::AllocateThreadCached(u8 bucketIndex)
+{
+    ThreadCache &cache = tThreadCaches[threadCacheIndex];
+
+    IF_UNLIKELY(cache.owner != this)
+        cache.Reset(this, threadCacheIndex);
+
+    Bucket &bucket = buckets[bucketIndex];
+    Magazine &loaded = cache.loaded[bucketIndex];
+
+    IF_UNLIKELY(loaded.count == 0)
+    {
+        Magazine &previous = cache.previous[bucketIndex];
+
+        if (previous.count > 0)
+            std::swap(loaded, previous);
+        else if (!bucket.RefillMagazine(loaded, magazineSize))
+            return nullptr;
+    }
+
+    void *result = bucket.GetSlotPtr(loaded.head);
+    loaded.head = *(u32 *)result;
+    loaded.count--;
 
-            return;
+    return result;
+}
+
+void ReservedAllocator::DeallocateThreadCached(u8 bucketIndex, void *ptr)
+{
+    ThreadCache &cache = tThreadCaches[threadCacheIndex];
+
+    IF_UNLIKELY(cache.owner != this)
+        cache.Reset(this, threadCacheIndex);
+
+    Bucket &bucket = buckets[bucketIndex];
+    Magazine &loaded = cache.loaded[bucketIndex];
+
+    IF_UNLIKELY(loaded.count == magazineSize)
+    {
+        Magazine &previous = cache.previous[bucketIndex];
+
+        if (previous.count == magazineSize)
+        {
+            bucket.PushMagazineToDepot(previous.head);
+            previous = Magazine();
         }
+
+        std::swap(loaded, previous);
     }
 
-    free(ptr);
+    *(u32 *)ptr = loaded.head;
+    loaded.head = bucket.GetSlotId(ptr);
+    loaded.count++;
 }
 
-ReservedAllocator::Bucket::Bucket(u16 elementSize, u32 maximumReservedSize, u32 initialCommitedSize)
+void ReservedAllocator::FlushThreadCache()
+{
+    if (!threadSafe)
+        return;
+
+    ThreadCache &cache = tThreadCaches[threadCacheIndex];
+
+    if (cache.owner != this)
+        return;
+
+    for (u8 i = 0; i < numBuckets; ++i)
+    {
+        for (Magazine *magazine : {&cache.loaded[i], &cache.previous[i]})
+        {
+            if (magazine->count == magazineSize)
+                buckets[i].PushMagazineToDepot(magazine->head);
+            else if (magazine->count > 0)
+                buckets[i].ReturnMagazine(*magazine);
+
+            *magazine = Magazine();
+        }
+    }
+}
+
+size_t ReservedAllocator::Trim()
+{
+    FlushThreadCache();
+
+    size_t trimmedSize = 0;
+    for (u8 i = 0; i < numBuckets; ++i)
+        trimmedSize += buckets[i].Trim(threadSafe ? magazineSize : 0);
+
+    totalTrimmedSize.fetch_add(trimmedSize, std::memory_order_relaxed);
+    return trimmedSize;
+}
+
+void ReservedAllocator::Bucket::PushMagazineToDepot(u32 head)
+{
+    u32 *headSlot = (u32 *)GetSlotPtr(head);
+    u64 oldTop = depotHead.load(std::memory_order_relaxed);
+    u64 newTop;
+
+    do
+    {
+        headSlot[1] = (u32)oldTop;
+        newTop = (((oldTop >> 32) + 1) << 32) | head;
+    } while (!depotHead.compare_exchange_weak(oldTop, newTop, std::memory_order_release, std::memory_order_relaxed));
+}
+
+u32 ReservedAllocator::Bucket::PopMagazineFromDepot()
+{
+    // announce the read before looking at the depot, so Trim does not decommit a slot we may still dereference
+    depotReaders.fetch_add(1);
+
+    u64 oldTop = depotHead.load();
+    u64 newTop;
+
+    do
+    {
+        u32 head = (u32)oldTop;
+        if (head == InvalidSlot)
+        {
+            depotReaders.fetch_sub(1, std::memory_order_release);
+            return InvalidSlot;
+        }
+
+        // the slot may be popped and reused concurrently, the tag makes the CAS fail in that case
+        u32 next = ((u32 *)GetSlotPtr(head))[1];
+        newTop = (((oldTop >> 32) + 1) << 32) | next;
+    } while (!depotHead.compare_exchange_weak(oldTop, newTop, std::memory_order_acquire, std::memory_order_acquire));
+
+    depotReaders.fetch_sub(1, std::memory_order_release);
+    return (u32)oldTop;
+}
+
+bool ReservedAllocator::Bucket::RefillMagazine(Magazine &magazine, u16 magazineSize)
+{
+    u32 head = PopMagazineFromDepot();
+
+    if (head != InvalidSlot)
+    {
+        magazine.head = head;
+        magazine.count = magazineSize;
+        return true;
+    }
+
+    // depot is empty, carve a batch from the bucket itself
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (u16 i = 0; i < magazineSize; ++i)
+    {
+        void *slot = Allocate(elementSize);
+        if (slot == nullptr)
+            break;
+
+        *(u32 *)slot = magazine.head;
+        magazine.head = GetSlotId(slot);
+        magazine.count++;
+    }
+
+    return magazine.count > 0;
+}
+
+void ReservedAllocator::Bucket::ReturnMagazine(Magazine &magazine)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    FreeMagazineSlots(magazine);
+}
+
+void ReservedAllocator::Bucket::FreeMagazineSlots(const Magazine &magazine)
+{
+    u32 id = magazine.head;
+    for (u32 i = 0; i < magazine.count; ++i)
+    {
+        void *slot = GetSlotPtr(id);
+        id = *(u32 *)slot;
+
+        Deallocate(slot);
+    }
+}
+
+ReservedAllocator::Bucket::Bucket(void *region, u16 elementSize, u32 maximumReservedSize, u32 initialCommitedSize, FreeListPolicy freeListPolicy, const ll::os::MemoryPolicy &memoryPolicy)
 {
     auto *os = ll::os::gOS;
     this->elementSize = elementSize; 
     this->maximumReservedSize = maximumReservedSize;
+    this->freeListPolicy = freeListPolicy;
+    this->memoryPolicy = memoryPolicy;
 
-    beginRegion = os->ReserveMemory(maximumReservedSize);
-    os->CommitMemory(beginRegion, initialCommitedSize);
+    // free slots keep the next free id inside themselves
+    MERCURY_ASSERT(elementSize >= sizeof(u32));
 
+    beginRegion = region;
+    os->CommitMemory(beginRegion, initialCommitedSize, memoryPolicy);
+
+    commitedSize = initialCommitedSize;
+    this->initialCommitedSize = initialCommitedSize;
     commitedElements = (u32)(initialCommitedSize / elementSize);
     maximumReservedElements = (u32)(maximumReservedSize / elementSize);
  
 #ifdef MERCURY_USE_MEMORY_STAT
-    totalCommittedMem = initialCommitedSize;
-    allocationUserSizes.reserve(std::min(4096u, initialCommitedSize / elementSize));
+    userSizesReservedSize = (u32)mercury::utils::math::alignUp((size_t)maximumReservedElements * sizeof(u16), os->GetPageSize());
+    userSizes = (u16 *)os->ReserveMemory(userSizesReservedSize, memoryPolicy);
+    MERCURY_ASSERT(userSizes != nullptr);
+
+    ResizeUserSizes(commitedElements);
 #endif
 }
 
 ReservedAllocator::Bucket::~Bucket()
 {
-    auto *os = ll::os::gOS;
-    os->DecommitMemory(beginRegion, commitedElements * elementSize);
-    os->ReleaseMemory(beginRegion, maximumReservedSize);
+    // the address range itself is released by the owning ReservedAllocator
+    ll::os::gOS->DecommitMemory(beginRegion, commitedSize);
+
+#ifdef MERCURY_USE_MEMORY_STAT
+    ll::os::gOS->ReleaseMemory(userSizes, userSizesReservedSize);
+#endif
 }
 
-void *ReservedAllocator::Bucket::Allocate(u16 size)
-{
 #ifdef MERCURY_USE_MEMORY_STAT
-    allocationsCount++;
-    allocatedMemUser += size;
-    allocatedMemSystem += elementSize;
+void ReservedAllocator::Bucket::ResizeUserSizes(u32 elements)
+{
+    auto *os = ll::os::gOS;
+    u32 newCommitedSize = (u32)mercury::utils::math::alignUp((size_t)elements * sizeof(u16), os->GetPageSize());
+
+    if (newCommitedSize > userSizesCommitedSize)
+        os->CommitMemory((u8 *)userSizes + userSizesCommitedSize, newCommitedSize - userSizesCommitedSize, memoryPolicy);
+    else if (newCommitedSize < userSizesCommitedSize)
+        os->DecommitMemory((u8 *)userSizes + newCommitedSize, userSizesCommitedSize - newCommitedSize);
+
+    userSizesCommitedSize = newCommitedSize;
+}
+#endif
 
-    totalAllocationsCount++;
-    totalAllocatedMemUser += size;
-    totalAllocatedMemSystem += elementSize;
+void *ReservedAllocator::Bucket::Allocate([[maybe_unused]] u16 size)
+{
+#ifdef MERCURY_DEBUG_BUILD
+    MERCURY_ASSERT(size <= elementSize);
 #endif
 
-    if (freeList.empty())
+    if (freeListHead == InvalidSlot)
     {
         if (lastAllocatedID >= maximumReservedElements)
             return nullptr;
 
         if (lastAllocatedID >= commitedElements)
         {
-            // reserve next page
+            // reserve next pages, never past the bucket slot: the neighbour bucket lives right after it
             auto *os = ll::os::gOS;
 
-            int numCommitedPages = mercury::utils::math::alignUp(256 * elementSize, os->GetPageSize());
+            u32 commitSize = (u32)mercury::utils::math::alignUp(256 * elementSize, os->GetPageSize());
+            commitSize = std::min(commitSize, maximumReservedSize - commitedSize);
 
-            os->CommitMemory((u8 *)beginRegion + (commitedElements * elementSize), numCommitedPages * os->GetPageSize());
-            commitedElements += (u32)(numCommitedPages / elementSize);
+            os->CommitMemory((u8 *)beginRegion + commitedSize, commitSize, memoryPolicy);
+            commitedSize += commitSize;
+            commitedElements = commitedSize / elementSize;
 
-            
 #ifdef MERCURY_USE_MEMORY_STAT
-            totalSystemPagesCommitted += numCommitedPages;
-            totalCommittedMem += os->GetPageSize() * numCommitedPages;
+            totalSystemPagesCommitted.fetch_add(commitSize / os->GetPageSize(), std::memory_order_relaxed);
+            ResizeUserSizes(commitedElements);
 #endif
         }
 
         void *result = (u8 *)beginRegion + (lastAllocatedID * elementSize);
-
-#ifdef MERCURY_USE_MEMORY_STAT
-        allocationUserSizes.push_back(size);
-#endif
-
         lastAllocatedID++;
 
         return result;
     }
     else
     {
-        u32 currentId = freeList.top();
-        freeList.pop();
-
+        u32 currentId = freeListHead;
         void *result = (u8 *)beginRegion + (currentId * elementSize);
 
-#ifdef MERCURY_USE_MEMORY_STAT
-        allocationUserSizes[currentId] = size;
-#endif
+        freeListHead = *(u32 *)result;
+        if (freeListHead == InvalidSlot)
+            freeListTail = InvalidSlot;
 
         return result;
     }
@@ -208,37 +725,110 @@ void ReservedAllocator::Bucket::Deallocate(void *ptr)
     u32 id = offset / elementSize;
     MERCURY_ASSERT(id < maximumReservedElements);
 
-    freeList.push(id);
+    u32 *slot = (u32 *)ptr;
 
-#ifdef MERCURY_USE_MEMORY_STAT
-    allocationUserSizes[id] = 0;
-#endif
+    if (freeListPolicy == FreeListPolicy::LIFO || freeListHead == InvalidSlot)
+    {
+        *slot = freeListHead;
+        freeListHead = id;
+
+        if (freeListTail == InvalidSlot)
+            freeListTail = id;
+    }
+    else
+    {
+        *slot = InvalidSlot;
+        *(u32 *)((u8 *)beginRegion + (freeListTail * elementSize)) = id;
+        freeListTail = id;
+    }
 }
 
-#ifdef MERCURY_USE_MEMORY_STAT
-u16 ReservedAllocator::Bucket::DeallocateAndReturnUserSize(void *ptr)
+size_t ReservedAllocator::Bucket::Trim(u16 magazineSize)
 {
-    if (ptr == nullptr)
+    auto *os = ll::os::gOS;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // idle magazines in the depot go back to the free list, so their slots can be trimmed as well
+    if (magazineSize > 0)
+    {
+        for (u32 head = PopMagazineFromDepot(); head != InvalidSlot; head = PopMagazineFromDepot())
+        {
+            Magazine magazine;
+            magazine.head = head;
+            magazine.count = magazineSize;
+            FreeMagazineSlots(magazine);
+        }
+    }
+
+    if (commitedSize <= initialCommitedSize || freeListHead == InvalidSlot)
         return 0;
 
-    u32 offset = (u32)((u8 *)ptr - (u8 *)beginRegion);
-    MERCURY_ASSERT(offset % elementSize == 0);
+    // mark free slots, the used part of the bucket ends right after the last slot that is not free
+    std::vector<u64> freeMask((lastAllocatedID + 63) / 64, 0);
 
-    u32 id = offset / elementSize;
-    MERCURY_ASSERT(id < maximumReservedElements);
+    for (u32 id = freeListHead; id != InvalidSlot; id = *(u32 *)GetSlotPtr(id))
+        freeMask[id >> 6] |= 1ull << (id & 63);
+
+    u32 newLastAllocatedID = lastAllocatedID;
+    while (newLastAllocatedID > 0)
+    {
+        u32 id = newLastAllocatedID - 1;
+
+        if ((id & 63) == 63 && freeMask[id >> 6] == ~0ull)
+            newLastAllocatedID -= 64;
+        else if (freeMask[id >> 6] & (1ull << (id & 63)))
+            newLastAllocatedID--;
+        else
+            break;
+    }
+
+    u32 newCommitedSize = (u32)mercury::utils::math::alignUp((size_t)newLastAllocatedID * elementSize, os->GetPageSize());
+    newCommitedSize = std::max(newCommitedSize, initialCommitedSize);
+
+    if (newCommitedSize >= commitedSize)
+        return 0;
+
+    // unlink the trimmed slots keeping the order of the remaining ones
+    u32 *link = &freeListHead;
+    freeListTail = InvalidSlot;
+
+    for (u32 id = freeListHead; id != InvalidSlot;)
+    {
+        u32 next = *(u32 *)GetSlotPtr(id);
+
+        if (id < newLastAllocatedID)
+        {
+            *link = id;
+            link = (u32 *)GetSlotPtr(id);
+            freeListTail = id;
+        }
+
+        id = next;
+    }
+    *link = InvalidSlot;
 
-    u16 result = allocationUserSizes[id];
+    // a thread that read a drained slot id from the depot may still dereference it, wait until it is done
+    if (magazineSize > 0)
+    {
+        while (depotReaders.load() != 0)
+            std::this_thread::yield();
+    }
+
+    u32 trimmedSize = commitedSize - newCommitedSize;
+    os->DecommitMemory((u8 *)beginRegion + newCommitedSize, trimmedSize);
+
+    commitedSize = newCommitedSize;
+    commitedElements = commitedSize / elementSize;
+    lastAllocatedID = newLastAllocatedID;
 
 #ifdef MERCURY_USE_MEMORY_STAT
-    allocationsCount--;
-    allocatedMemUser -= result;
-    allocatedMemSystem -= elementSize;
+    totalDecommittedMem.fetch_add(trimmedSize, std::memory_order_relaxed);
+    ResizeUserSizes(commitedElements);
 #endif
 
-    allocationUserSizes[id] = 0;
-    return result;
+    return trimmedSize;
 }
-#endif
 
 bool ReservedAllocator::Bucket::IsPtrInBucketRange(void *ptr)
 {
@@ -255,36 +845,180 @@ void ReservedAllocator::DumpStatsPerBucketTotal()
         return;
         
 #ifdef MERCURY_USE_MEMORY_STAT
-    std::cout << "Total Allocations: " << totalAllocationsCount << std::endl;
-    std::cout << "Total Mallocs: " << totalMallocAllocations << std::endl;
-    std::cout << "Total Allocated Memory (User): " << mercury::utils::string::format_size(totalAllocatedMemUser) << std::endl;
-    std::cout << "Total Allocated Memory (System): " << mercury::utils::string::format_size(totalAllocatedMemSystem) << std::endl;
+    using mercury::utils::string::format_size;
 
-    for (size_t i = 0; i < numBuckets; ++i)
+    Snapshot snapshot;
+    GetSnapshot(snapshot);
+
+    std::cout << "Total Allocations: " << snapshot.totalAllocationsCount << std::endl;
+    std::cout << "Total Mallocs: " << snapshot.totalMallocAllocations << std::endl;
+    std::cout << "Total Reallocs: " << snapshot.totalReallocsCount << " (in place: " << snapshot.totalReallocsSaveBySameBucket << ")" << std::endl;
+    std::cout << "Total Allocated Memory (User): " << format_size(snapshot.totalAllocatedMemUser) << std::endl;
+    std::cout << "Total Allocated Memory (System): " << format_size(snapshot.totalAllocatedMemSystem) << std::endl;
+    std::cout << "Total Trimmed Memory: " << format_size(snapshot.totalTrimmedSize) << std::endl;
+
+    for (const BucketSnapshot &bucket : snapshot.buckets)
     {
-        std::cout << "Bucket " << buckets[i].elementSize << std::endl;
-        buckets[i].DumpStatsTotal();
+        std::cout << "Bucket " << bucket.elementSize << std::endl;
+        std::cout << "  Total Reserved Virtual Memory: " << format_size(bucket.reservedSize) << std::endl;
+        std::cout << "  Committed Memory: " << format_size(bucket.committedSize) << std::endl;
+        std::cout << "  Total Committed Pages in Runtime: " << bucket.totalSystemPagesCommitted << std::endl;
+        std::cout << "  Total Decommitted Memory by Trim: " << format_size(bucket.totalDecommittedSize) << std::endl;
+        std::cout << std::endl;
+        std::cout << "  Allocated Elements: " << bucket.allocationsCount << std::endl;
+        std::cout << "  Allocated Memory (User): " << format_size(bucket.userSize) << std::endl;
+        std::cout << "  Allocated Memory (System): " << format_size(bucket.usedSize) << std::endl;
+        std::cout << std::endl;
+        std::cout << "  Total allocations count: " << bucket.totalAllocationsCount << std::endl;
+        std::cout << "  Total Allocated Memory (User): " << format_size(bucket.totalAllocatedMemUser) << std::endl;
+        std::cout << "  Total Allocated Memory (System): " << format_size(bucket.totalAllocationsCount * bucket.elementSize) << std::endl;
+        std::cout << "  Size histogram:";
+        for (u64 count : bucket.sizeHistogram)
+            std::cout << " " << count;
+        std::cout << std::endl;
     }
 #else
     std::cout << "Memory statistics are not available. Define MERCURY_USE_MEMORY_STAT" << std::endl;
 #endif
 }
 
-#ifdef MERCURY_USE_MEMORY_STAT
+FrameAllocator *memory::gFrameAllocator = nullptr;
+
+FrameAllocator::FrameAllocator(const FrameAllocator::InitDesc &desc)
+{
+    auto *os = ll::os::gOS;
+
+    MERCURY_ASSERT(desc.numFramesInFlight > 0 && desc.numFramesInFlight <= MaxFramesInFlight);
+    MERCURY_ASSERT(desc.commitGranularity % os->GetPageSize() == 0);
+
+    numFramesInFlight = desc.numFramesInFlight;
+    commitGranularity = desc.commitGranularity;
+    maximumReservedSizePerFrame = mercury::utils::math::alignUp(desc.maximumReservedSizePerFrame, commitGranularity);
+    memoryPolicy = desc.memoryPolicy;
+
+    beginRegion = os->ReserveMemory(maximumReservedSizePerFrame * numFramesInFlight, memoryPolicy);
+    MERCURY_ASSERT(beginRegion != nullptr);
+
+    for (u8 i = 0; i < numFramesInFlight; ++i)
+    {
+        arenas[i].beginRegion = (u8 *)beginRegion + maximumReservedSizePerFrame * i;
+    }
+}
+
+FrameAllocator::~FrameAllocator()
+{
+    auto *os = ll::os::gOS;
+
+    for (u8 i = 0; i < numFramesInFlight; ++i)
+    {
+        if (arenas[i].commitedSize > 0)
+            os->DecommitMemory(arenas[i].beginRegion, arenas[i].commitedSize);
+    }
+
+    os->ReleaseMemory(beginRegion, maximumReservedSizePerFrame * numFramesInFlight);
+}
+
+void FrameAllocator::BeginFrame(u8 frameInFlightIndex)
+{
+    MERCURY_ASSERT(frameInFlightIndex < numFramesInFlight);
 
-void ReservedAllocator::Bucket::DumpStatsTotal()
+    currentFrame = frameInFlightIndex;
+
+    Arena &arena = arenas[currentFrame];
+    arena.highWaterMark = std::max(arena.highWaterMark, arena.offset);
+    arena.offset = 0;
+}
+
+void *FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+    Arena &arena = arenas[currentFrame];
+
+    size_t begin = mercury::utils::math::alignUp(arena.offset, alignment);
+    size_t end = begin + size;
+
+    IF_UNLIKELY(end > arena.commitedSize)
+    {
+        IF_UNLIKELY(end > maximumReservedSizePerFrame)
+        {
+            MLOG_ERROR(u8"FrameAllocator: frame arena exhausted (%zu of %zu bytes)", end, maximumReservedSizePerFrame);
+            return nullptr;
+        }
+
+        // arenas keep their pages between frames, so this only happens while the high water mark grows
+        size_t newCommitedSize = mercury::utils::math::alignUp(end, commitGranularity);
+        ll::os::gOS->CommitMemory(arena.beginRegion + arena.commitedSize, newCommitedSize - arena.commitedSize, memoryPolicy);
+        arena.commitedSize = newCommitedSize;
+    }
+
+    arena.offset = end;
+    return arena.beginRegion + begin;
+}
+
+ScratchAllocator::ScratchAllocator(const ScratchAllocator::InitDesc &desc)
+{
+    auto *os = ll::os::gOS;
+
+    MERCURY_ASSERT(desc.commitGranularity % os->GetPageSize() == 0);
+
+    commitGranularity = desc.commitGranularity;
+    maximumReservedSize = mercury::utils::math::alignUp(desc.maximumReservedSize, commitGranularity);
+    memoryPolicy = desc.memoryPolicy;
+
+    beginRegion = (u8 *)os->ReserveMemory(maximumReservedSize, memoryPolicy);
+    MERCURY_ASSERT(beginRegion != nullptr);
+}
+
+ScratchAllocator::~ScratchAllocator()
+{
+    auto *os = ll::os::gOS;
+
+    if (commitedSize > 0)
+        os->DecommitMemory(beginRegion, commitedSize);
+
+    os->ReleaseMemory(beginRegion, maximumReservedSize);
+}
+
+void *ScratchAllocator::Allocate(size_t size, size_t alignment)
+{
+    size_t begin = mercury::utils::math::alignUp(offset, alignment);
+    size_t end = begin + size;
+
+    IF_UNLIKELY(end > commitedSize)
+    {
+        IF_UNLIKELY(end > maximumReservedSize)
+        {
+            MLOG_ERROR(u8"ScratchAllocator: arena exhausted (%zu of %zu bytes)", end, maximumReservedSize);
+            return nullptr;
+        }
+
+        size_t newCommitedSize = mercury::utils::math::alignUp(end, commitGranularity);
+        ll::os::gOS->CommitMemory(beginRegion + commitedSize, newCommitedSize - commitedSize, memoryPolicy);
+        commitedSize = newCommitedSize;
+    }
+
+    offset = end;
+    return beginRegion + begin;
+}
+
+void ScratchAllocator::Deallocate(void *ptr, size_t size)
+{
+    if ((u8 *)ptr + size == beginRegion + offset)
+    {
+        highWaterMark = std::max(highWaterMark, offset);
+        offset = (u8 *)ptr - beginRegion;
+    }
+}
+
+void ScratchAllocator::Rewind(size_t marker)
 {
-    std::cout << "  Total Reserved Virtual Memory: " << mercury::utils::string::format_size(maximumReservedSize) << std::endl;
-    std::cout << "  Total Committed Memory: " << mercury::utils::string::format_size(totalCommittedMem) << std::endl;
-    std::cout << "  Total Committed Pages in Runtime: " << totalSystemPagesCommitted << std::endl;
-    std::cout << std::endl;
-    std::cout << "  Allocated Elements: " << allocationsCount << std::endl;
-    std::cout << "  Allocated Memory (User): " << mercury::utils::string::format_size(allocatedMemUser) << std::endl;
-    std::cout << "  Allocated Memory (System): " << mercury::utils::string::format_size(allocatedMemSystem) << std::endl;
-    std::cout << std::endl;
-    std::cout << "  Total allocations count: " << totalAllocationsCount << std::endl;
-    std::cout << "  Total Allocated Memory (User): " << mercury::utils::string::format_size(totalAllocatedMemUser) << std::endl;
-    std::cout << "  Total Allocated Memory (System): " << mercury::utils::string::format_size(totalAllocatedMemSystem) << std::endl;
+    MERCURY_ASSERT(marker <= offset);
+
+    highWaterMark = std::max(highWaterMark, offset);
+    offset = marker;
 }
 
-#endif
\ No newline at end of file
+ScratchAllocator *memory::GetThreadScratchAllocator()
+{
+    static thread_local ScratchAllocator tScratchAllocator(ScratchAllocator::InitDesc{});
+    return &tScratchAllocator;
+}
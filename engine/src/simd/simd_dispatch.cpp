@@ -0,0 +1,235 @@
+#include "simd_kernels.h"
+#include "mercury_log.h"
+
+#include <atomic>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MERCURY_SIMD_X86
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define MERCURY_SIMD_X86
+#endif
+
+using namespace mercury;
+using namespace mercury::simd;
+
+namespace
+{
+#if defined(MERCURY_SIMD_X86)
+    void QueryCpuid(u32 leaf, u32 subleaf, u32 regs[4])
+    {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+            regs[i] = static_cast<u32>(r[i]);
+#else
+        if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+            regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+    }
+
+    u64 QueryXCR0()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        u32 eax = 0, edx = 0;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<u64>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    CpuFeatures DetectCpuFeatures()
+    {
+        CpuFeatures features;
+
+#if defined(MERCURY_SIMD_X86)
+        u32 regs[4] = {};
+        QueryCpuid(0, 0, regs);
+        const u32 maxLeaf = regs[0];
+
+        QueryCpuid(1, 0, regs);
+        const u32 ecx1 = regs[2];
+        features.sse41 = (ecx1 & (1u << 19)) != 0;
+        features.fma = (ecx1 & (1u << 12)) != 0;
+        features.avx = (ecx1 & (1u << 28)) != 0;
+
+        // the CPU bits alone are not enough, the OS has to save the wide registers on context switch
+        if (ecx1 & (1u << 27)) // OSXSAVE
+        {
+            const u64 xcr0 = QueryXCR0();
+            features.osSavesYmm = (xcr0 & 0x6) == 0x6;
+            features.osSavesZmm = (xcr0 & 0xE6) == 0xE6;
+        }
+
+        if (maxLeaf >= 7)
+        {
+            QueryCpuid(7, 0, regs);
+            const u32 ebx7 = regs[1];
+            features.avx2 = (ebx7 & (1u << 5)) != 0;
+            features.avx512f = (ebx7 & (1u << 16)) != 0;
+            features.avx512dq = (ebx7 & (1u << 17)) != 0;
+            features.avx512bw = (ebx7 & (1u << 30)) != 0;
+            features.avx512vl = (ebx7 & (1u << 31)) != 0;
+        }
+#endif
+        return features;
+    }
+
+    void ScalarAdd(f32* out, const f32* a, const f32* b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = a[i] + b[i];
+    }
+
+    void ScalarMul(f32* out, const f32* a, const f32* b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = a[i] * b[i];
+    }
+
+    void ScalarMulAdd(f32* out, const f32* a, const f32* b, const f32* c, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = a[i] * b[i] + c[i];
+    }
+
+    void ScalarScale(f32* out, const f32* in, f32 s, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = in[i] * s;
+    }
+
+    f32 ScalarDot(const f32* a, const f32* b, size_t count)
+    {
+        f32 result = 0.0f;
+        for (size_t i = 0; i < count; ++i)
+            result += a[i] * b[i];
+        return result;
+    }
+
+    void ScalarTransformPoints(const f32* m, const f32* inX, const f32* inY, const f32* inZ,
+        f32* outX, f32* outY, f32* outZ, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const f32 x = inX[i], y = inY[i], z = inZ[i];
+            outX[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+            outY[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+            outZ[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+        }
+    }
+
+    constexpr Kernels MakeScalarKernels()
+    {
+        Kernels kernels;
+        kernels.add = ScalarAdd;
+        kernels.mul = ScalarMul;
+        kernels.mulAdd = ScalarMulAdd;
+        kernels.scale = ScalarScale;
+        kernels.dot = ScalarDot;
+        kernels.transformPoints = ScalarTransformPoints;
+        return kernels;
+    }
+
+    constexpr Kernels gScalarKernels = MakeScalarKernels();
+
+    std::atomic<const Kernels*> gActiveKernels{ nullptr };
+}
+
+const char* simd::GetInstructionSetName(InstructionSet isa)
+{
+    switch (isa)
+    {
+    case InstructionSet::Scalar: return "Scalar";
+    case InstructionSet::SSE41: return "SSE4.1";
+    case InstructionSet::AVX2: return "AVX2";
+    case InstructionSet::AVX512: return "AVX-512";
+    case InstructionSet::NEON: return "NEON";
+    case InstructionSet::WASM128: return "WASM SIMD128";
+    }
+    return "Unknown";
+}
+
+const CpuFeatures& simd::GetCpuFeatures()
+{
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
+
+const Kernels* simd::GetKernels(InstructionSet isa)
+{
+    const CpuFeatures& cpu = GetCpuFeatures();
+
+    switch (isa)
+    {
+    case InstructionSet::Scalar:
+        return &gScalarKernels;
+    case InstructionSet::AVX2:
+        IF_LIKELY(cpu.avx2 && cpu.fma && cpu.osSavesYmm)
+            return detail::GetKernelsAVX2();
+        return nullptr;
+    case InstructionSet::AVX512:
+        IF_LIKELY(cpu.avx512f && cpu.osSavesZmm)
+            return detail::GetKernelsAVX512();
+        return nullptr;
+    default:
+        break;
+    }
+
+    // the 128-bit table is whatever the baseline of this target is (SSE4.1, NEON or WASM)
+    const Kernels* baseline = detail::GetKernels128();
+    return baseline->isa == isa ? baseline : nullptr;
+}
+
+InstructionSet simd::GetBestInstructionSet()
+{
+    for (InstructionSet isa : { InstructionSet::AVX512, InstructionSet::AVX2 })
+    {
+        if (GetKernels(isa))
+            return isa;
+    }
+
+    return detail::GetKernels128()->isa;
+}
+
+const Kernels& simd::GetKernels()
+{
+    const Kernels* active = gActiveKernels.load(std::memory_order_acquire);
+
+    IF_UNLIKELY(active == nullptr)
+    {
+        const Kernels* best = GetKernels(GetBestInstructionSet());
+        const Kernels* expected = nullptr;
+
+        if (gActiveKernels.compare_exchange_strong(expected, best, std::memory_order_acq_rel))
+        {
+            MLOG_INFO(u8"SIMD kernels: %s (%u lanes)", GetInstructionSetName(best->isa), best->width);
+            active = best;
+        }
+        else
+        {
+            active = expected;
+        }
+    }
+
+    return *active;
+}
+
+bool simd::SelectKernels(InstructionSet isa)
+{
+    const Kernels* kernels = GetKernels(isa);
+
+    IF_UNLIKELY(kernels == nullptr)
+    {
+        MLOG_WARNING(u8"SIMD kernels: %s is not available on this CPU/build", GetInstructionSetName(isa));
+        return false;
+    }
+
+    gActiveKernels.store(kernels, std::memory_order_release);
+    MLOG_INFO(u8"SIMD kernels: %s selected (%u lanes)", GetInstructionSetName(isa), kernels->width);
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "mercury_simd.h"
+
+// Per instruction set kernel tables. Every getter is always defined, it returns nullptr
+// when its translation unit was not compiled for that instruction set.
+namespace mercury::simd::detail
+{
+    const Kernels* GetKernels128();
+    const Kernels* GetKernelsAVX2();
+    const Kernels* GetKernelsAVX512();
+}
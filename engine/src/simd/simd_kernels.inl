@@ -0,0 +1,125 @@
+// Width generic kernel bodies, included by simd_kernels_*.cpp after defining `Lanes`:
+//   using type; static constexpr size_t Width; Load, Store, Splat, Add, Mul, MulAdd (a * b + c).
+// Every translation unit is compiled for a different instruction set, so everything here must have
+// internal linkage and must not call shared inline helpers (STL, glm): the linker is free to keep the copy
+// compiled with the widest instruction set. mercury_simd.h helpers are fine, they live in a per-ISA namespace.
+
+namespace
+{
+    using V = Lanes::type;
+
+    void KernelAdd(f32* out, const f32* a, const f32* b, size_t count)
+    {
+        size_t i = 0;
+        for (; i + Lanes::Width <= count; i += Lanes::Width)
+            Lanes::Store(out + i, Lanes::Add(Lanes::Load(a + i), Lanes::Load(b + i)));
+
+        for (; i < count; ++i)
+            out[i] = a[i] + b[i];
+    }
+
+    void KernelMul(f32* out, const f32* a, const f32* b, size_t count)
+    {
+        size_t i = 0;
+        for (; i + Lanes::Width <= count; i += Lanes::Width)
+            Lanes::Store(out + i, Lanes::Mul(Lanes::Load(a + i), Lanes::Load(b + i)));
+
+        for (; i < count; ++i)
+            out[i] = a[i] * b[i];
+    }
+
+    void KernelMulAdd(f32* out, const f32* a, const f32* b, const f32* c, size_t count)
+    {
+        size_t i = 0;
+        for (; i + Lanes::Width <= count; i += Lanes::Width)
+            Lanes::Store(out + i, Lanes::MulAdd(Lanes::Load(a + i), Lanes::Load(b + i), Lanes::Load(c + i)));
+
+        for (; i < count; ++i)
+            out[i] = a[i] * b[i] + c[i];
+    }
+
+    void KernelScale(f32* out, const f32* in, f32 s, size_t count)
+    {
+        const V vs = Lanes::Splat(s);
+
+        size_t i = 0;
+        for (; i + Lanes::Width <= count; i += Lanes::Width)
+            Lanes::Store(out + i, Lanes::Mul(Lanes::Load(in + i), vs));
+
+        for (; i < count; ++i)
+            out[i] = in[i] * s;
+    }
+
+    f32 KernelDot(const f32* a, const f32* b, size_t count)
+    {
+        // two accumulators hide the add latency
+        V acc0 = Lanes::Splat(0.0f);
+        V acc1 = Lanes::Splat(0.0f);
+
+        size_t i = 0;
+        for (; i + 2 * Lanes::Width <= count; i += 2 * Lanes::Width)
+        {
+            acc0 = Lanes::MulAdd(Lanes::Load(a + i), Lanes::Load(b + i), acc0);
+            acc1 = Lanes::MulAdd(Lanes::Load(a + i + Lanes::Width), Lanes::Load(b + i + Lanes::Width), acc1);
+        }
+
+        for (; i + Lanes::Width <= count; i += Lanes::Width)
+            acc0 = Lanes::MulAdd(Lanes::Load(a + i), Lanes::Load(b + i), acc0);
+
+        f32 lanes[Lanes::Width];
+        Lanes::Store(lanes, Lanes::Add(acc0, acc1));
+
+        f32 result = 0.0f;
+        for (size_t l = 0; l < Lanes::Width; ++l)
+            result += lanes[l];
+
+        for (; i < count; ++i)
+            result += a[i] * b[i];
+
+        return result;
+    }
+
+    void KernelTransformPoints(const f32* m, const f32* inX, const f32* inY, const f32* inZ,
+        f32* outX, f32* outY, f32* outZ, size_t count)
+    {
+        // column-major: m[column * 4 + row]
+        const V m00 = Lanes::Splat(m[0]), m10 = Lanes::Splat(m[1]), m20 = Lanes::Splat(m[2]);
+        const V m01 = Lanes::Splat(m[4]), m11 = Lanes::Splat(m[5]), m21 = Lanes::Splat(m[6]);
+        const V m02 = Lanes::Splat(m[8]), m12 = Lanes::Splat(m[9]), m22 = Lanes::Splat(m[10]);
+        const V m03 = Lanes::Splat(m[12]), m13 = Lanes::Splat(m[13]), m23 = Lanes::Splat(m[14]);
+
+        size_t i = 0;
+        for (; i + Lanes::Width <= count; i += Lanes::Width)
+        {
+            const V x = Lanes::Load(inX + i);
+            const V y = Lanes::Load(inY + i);
+            const V z = Lanes::Load(inZ + i);
+
+            Lanes::Store(outX + i, Lanes::MulAdd(m02, z, Lanes::MulAdd(m01, y, Lanes::MulAdd(m00, x, m03))));
+            Lanes::Store(outY + i, Lanes::MulAdd(m12, z, Lanes::MulAdd(m11, y, Lanes::MulAdd(m10, x, m13))));
+            Lanes::Store(outZ + i, Lanes::MulAdd(m22, z, Lanes::MulAdd(m21, y, Lanes::MulAdd(m20, x, m23))));
+        }
+
+        for (; i < count; ++i)
+        {
+            const f32 x = inX[i], y = inY[i], z = inZ[i];
+            outX[i] = m[0] * x + m[4] * y + m[8] * z + m[12];
+            outY[i] = m[1] * x + m[5] * y + m[9] * z + m[13];
+            outZ[i] = m[2] * x + m[6] * y + m[10] * z + m[14];
+        }
+    }
+
+    constexpr Kernels MakeKernels(InstructionSet isa)
+    {
+        Kernels kernels;
+        kernels.isa = isa;
+        kernels.width = static_cast<u32>(Lanes::Width);
+        kernels.add = KernelAdd;
+        kernels.mul = KernelMul;
+        kernels.mulAdd = KernelMulAdd;
+        kernels.scale = KernelScale;
+        kernels.dot = KernelDot;
+        kernels.transformPoints = KernelTransformPoints;
+        return kernels;
+    }
+}
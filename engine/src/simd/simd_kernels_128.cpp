@@ -0,0 +1,36 @@
+#include "simd_kernels.h"
+
+// Baseline 128-bit kernels: SSE4.1, NEON or WASM SIMD128 depending on the target
+
+using namespace mercury;
+using namespace mercury::simd;
+
+namespace
+{
+    struct Lanes
+    {
+        using type = f32x4;
+        static constexpr size_t Width = 4;
+
+        static type Load(const f32* ptr) { return load_f32x4(ptr); }
+        static void Store(f32* ptr, type v) { store_f32x4(ptr, v); }
+        static type Splat(f32 value) { return splat_f32x4(value); }
+        static type Add(type a, type b) { return add_f32x4(a, b); }
+        static type Mul(type a, type b) { return mul_f32x4(a, b); }
+        static type MulAdd(type a, type b, type c) { return fmadd_f32x4(a, b, c); }
+    };
+}
+
+#include "simd_kernels.inl"
+
+const Kernels* simd::detail::GetKernels128()
+{
+#if defined(__aarch64__)
+    static constexpr Kernels kernels = MakeKernels(InstructionSet::NEON);
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+    static constexpr Kernels kernels = MakeKernels(InstructionSet::WASM128);
+#else
+    static constexpr Kernels kernels = MakeKernels(InstructionSet::SSE41);
+#endif
+    return &kernels;
+}
@@ -0,0 +1,42 @@
+#include "simd_kernels.h"
+
+// Compiled with AVX2 + FMA (see engine/CMakeLists.txt and mercury_shared.vcxitems), only entered after the CPUID check
+
+using namespace mercury;
+using namespace mercury::simd;
+
+// MSVC has no separate FMA switch and never defines __FMA__, /arch:AVX2 already allows the FMA3 intrinsics
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+
+namespace
+{
+    struct Lanes
+    {
+        using type = f32x8;
+        static constexpr size_t Width = 8;
+
+        static type Load(const f32* ptr) { return load_f32x8(ptr); }
+        static void Store(f32* ptr, type v) { store_f32x8(ptr, v); }
+        static type Splat(f32 value) { return splat_f32x8(value); }
+        static type Add(type a, type b) { return add_f32x8(a, b); }
+        static type Mul(type a, type b) { return mul_f32x8(a, b); }
+        static type MulAdd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+    };
+}
+
+#include "simd_kernels.inl"
+
+const Kernels* simd::detail::GetKernelsAVX2()
+{
+    static constexpr Kernels kernels = MakeKernels(InstructionSet::AVX2);
+    return &kernels;
+}
+
+#else
+
+const Kernels* simd::detail::GetKernelsAVX2()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#include "simd_kernels.h"
+
+// Compiled with AVX-512F (see engine/CMakeLists.txt and mercury_shared.vcxitems), only entered after the CPUID check
+
+using namespace mercury;
+using namespace mercury::simd;
+
+#if defined(__AVX512F__)
+
+namespace
+{
+    struct Lanes
+    {
+        using type = f32x16;
+        static constexpr size_t Width = 16;
+
+        static type Load(const f32* ptr) { return load_f32x16(ptr); }
+        static void Store(f32* ptr, type v) { store_f32x16(ptr, v); }
+        static type Splat(f32 value) { return splat_f32x16(value); }
+        static type Add(type a, type b) { return add_f32x16(a, b); }
+        static type Mul(type a, type b) { return mul_f32x16(a, b); }
+        static type MulAdd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+    };
+}
+
+#include "simd_kernels.inl"
+
+const Kernels* simd::detail::GetKernelsAVX512()
+{
+    static constexpr Kernels kernels = MakeKernels(InstructionSet::AVX512);
+    return &kernels;
+}
+
+#else
+
+const Kernels* simd::detail::GetKernelsAVX512()
+{
+    return nullptr;
+}
+
+#endif
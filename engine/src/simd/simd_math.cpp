@@ -0,0 +1,131 @@
+#include "mercury_simd_math.h"
+#include "ll/os.h"
+#include <algorithm>
+
+using namespace mercury;
+using namespace mercury::simd;
+
+namespace
+{
+    // points per kernel call on the wide path, three SoA blocks of it live on the stack
+    constexpr size_t TransformBlockSize = 256;
+
+    // out = a * b for single column-major matrices, out may alias a or b
+    void MultiplyOne(const f32* a, const f32* b, f32* out)
+    {
+        const f32x4 a0 = load_f32x4(a);
+        const f32x4 a1 = load_f32x4(a + 4);
+        const f32x4 a2 = load_f32x4(a + 8);
+        const f32x4 a3 = load_f32x4(a + 12);
+
+        f32x4 columns[4];
+        for (int c = 0; c < 4; ++c)
+        {
+            const f32x4 bc = load_f32x4(b + c * 4);
+            f32x4 r = mul_f32x4(a0, swizzle_f32x4<0, 0, 0, 0>(bc));
+            r = fmadd_f32x4(a1, swizzle_f32x4<1, 1, 1, 1>(bc), r);
+            r = fmadd_f32x4(a2, swizzle_f32x4<2, 2, 2, 2>(bc), r);
+            columns[c] = fmadd_f32x4(a3, swizzle_f32x4<3, 3, 3, 3>(bc), r);
+        }
+
+        for (int c = 0; c < 4; ++c)
+            store_f32x4(out + c * 4, columns[c]);
+    }
+}
+
+void simd::transform_points(const glm::mat4& m, std::span<const glm::vec3> in, std::span<glm::vec3> out)
+{
+    MERCURY_ASSERT(out.size() >= in.size());
+
+    const size_t count = in.size();
+    const Kernels& kernels = GetKernels();
+
+    // 8/16 lane kernels only take SoA, so blocks are split into x/y/z, transformed in place and interleaved back
+    if (kernels.width > 4)
+    {
+        alignas(64) f32 x[TransformBlockSize], y[TransformBlockSize], z[TransformBlockSize];
+
+        for (size_t begin = 0; begin < count; begin += TransformBlockSize)
+        {
+            const size_t n = std::min(TransformBlockSize, count - begin);
+
+            for (size_t k = 0; k < n; ++k)
+            {
+                x[k] = in[begin + k].x;
+                y[k] = in[begin + k].y;
+                z[k] = in[begin + k].z;
+            }
+
+            kernels.transformPoints(&m[0][0], x, y, z, x, y, z, n);
+
+            for (size_t k = 0; k < n; ++k)
+                out[begin + k] = glm::vec3(x[k], y[k], z[k]);
+        }
+        return;
+    }
+
+    const mat4x4 sm = splat_mat4x4(m);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        store_vec3x4(&out[i], transform_point(sm, load_vec3x4(&in[i])));
+
+    for (; i < count; ++i)
+        out[i] = glm::vec3(m * glm::vec4(in[i], 1.0f));
+}
+
+void simd::transform_normals(const glm::mat3& normalMatrix, std::span<const glm::vec3> in, std::span<glm::vec3> out)
+{
+    MERCURY_ASSERT(out.size() >= in.size());
+
+    const vec3x4 c0 = splat_vec3x4(normalMatrix[0]);
+    const vec3x4 c1 = splat_vec3x4(normalMatrix[1]);
+    const vec3x4 c2 = splat_vec3x4(normalMatrix[2]);
+    const size_t count = in.size();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const vec3x4 n = load_vec3x4(&in[i]);
+        store_vec3x4(&out[i], normalize(fmadd(c2, n.z, fmadd(c1, n.y, c0 * n.x))));
+    }
+
+    for (; i < count; ++i)
+        out[i] = glm::normalize(normalMatrix * in[i]);
+}
+
+void simd::multiply_mat4(std::span<const glm::mat4> a, std::span<const glm::mat4> b, std::span<glm::mat4> out)
+{
+    MERCURY_ASSERT(a.size() == b.size() && out.size() >= a.size());
+
+    for (size_t i = 0; i < a.size(); ++i)
+        MultiplyOne(&a[i][0][0], &b[i][0][0], &out[i][0][0]);
+}
+
+void simd::multiply_mat4(const glm::mat4& parent, std::span<const glm::mat4> local, std::span<glm::mat4> out)
+{
+    MERCURY_ASSERT(out.size() >= local.size());
+
+    const glm::mat4 p = parent; // out may alias parent
+    for (size_t i = 0; i < local.size(); ++i)
+        MultiplyOne(&p[0][0], &local[i][0][0], &out[i][0][0]);
+}
+
+void simd::compose_trs(std::span<const glm::vec3> t, std::span<const glm::quat> r, std::span<const glm::vec3> s,
+    std::span<glm::mat4> out)
+{
+    MERCURY_ASSERT(t.size() == r.size() && t.size() == s.size() && out.size() >= t.size());
+
+    const size_t count = t.size();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        store_mat4x4(&out[i], compose_trs(load_vec3x4(&t[i]), load_quatx4(&r[i]), load_vec3x4(&s[i])));
+
+    for (; i < count; ++i)
+    {
+        glm::mat4 lanes[4];
+        store_mat4x4(lanes, compose_trs(splat_vec3x4(t[i]), splat_quatx4(r[i]), splat_vec3x4(s[i])));
+        out[i] = lanes[0];
+    }
+}
@@ -0,0 +1,156 @@
+#include "worker_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mercury;
+
+namespace
+{
+    struct WorkerPool
+    {
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        bool stop = false;
+
+        // current job, written under the mutex before generation moves
+        void (*task)(void*, u32) = nullptr;
+        void* context = nullptr;
+        u32 numTasks = 0;
+        std::atomic<u32> nextTask{0};
+        u32 numParticipants = 0; // workers with a lower index join the job
+        u32 numActive = 0; // participants that did not leave the job yet, the caller waits for 0
+        u64 generation = 0;
+
+        WorkerPool();
+        ~WorkerPool();
+
+        void RunTasks();
+        void WorkerMain(u32 index);
+    };
+
+    thread_local bool tInsideTask = false;
+
+    // serializes the callers, the pool runs one job at a time
+    std::mutex gDispatchMutex;
+
+    u32 ResolveNumWorkers()
+    {
+#if defined(MERCURY_LL_OS_EMSCRIPTEN)
+        return 0;
+#else
+        return std::max(1u, std::thread::hardware_concurrency()) - 1;
+#endif
+    }
+
+    WorkerPool::WorkerPool()
+    {
+        const u32 numWorkers = ResolveNumWorkers();
+        threads.reserve(numWorkers);
+
+        for (u32 i = 0; i < numWorkers; ++i)
+            threads.emplace_back([this, i]() { WorkerMain(i); });
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    void WorkerPool::RunTasks()
+    {
+        tInsideTask = true;
+
+        for (u32 i = nextTask.fetch_add(1, std::memory_order_relaxed); i < numTasks; i = nextTask.fetch_add(1, std::memory_order_relaxed))
+            task(context, i);
+
+        tInsideTask = false;
+    }
+
+    void WorkerPool::WorkerMain(u32 index)
+    {
+        u64 seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+
+        for (;;)
+        {
+            wake.wait(lock, [&]() { return stop || generation != seenGeneration; });
+            if (stop)
+                return;
+
+            seenGeneration = generation;
+            if (index >= numParticipants)
+                continue;
+
+            lock.unlock();
+            RunTasks();
+            lock.lock();
+
+            if (--numActive == 0)
+                done.notify_one();
+        }
+    }
+
+    WorkerPool& GetPool()
+    {
+        static WorkerPool pool;
+        return pool;
+    }
+}
+
+u32 workers::GetNumWorkers()
+{
+    static const u32 numWorkers = ResolveNumWorkers();
+    return numWorkers;
+}
+
+void workers::ParallelFor(u32 numTasks, u32 maxThreads, void (*task)(void* context, u32 taskIndex), void* context)
+{
+    if (numTasks == 0)
+        return;
+
+    const u32 numWorkers = std::min({ maxThreads > 0 ? maxThreads - 1 : 0u, numTasks - 1, GetNumWorkers() });
+
+    // nested calls run inline, their caller already holds the pool
+    if (numWorkers == 0 || tInsideTask)
+    {
+        for (u32 i = 0; i < numTasks; ++i)
+            task(context, i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> dispatch(gDispatchMutex);
+    WorkerPool& pool = GetPool();
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.task = task;
+        pool.context = context;
+        pool.numTasks = numTasks;
+        pool.nextTask.store(0, std::memory_order_relaxed);
+        pool.numParticipants = numWorkers;
+        pool.numActive = numWorkers;
+        pool.generation++;
+    }
+    pool.wake.notify_all();
+
+    pool.RunTasks();
+
+    // participants may still be inside their last task, the context lives on the caller's stack
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done.wait(lock, [&]() { return pool.numActive == 0; });
+    pool.task = nullptr;
+    pool.context = nullptr;
+}
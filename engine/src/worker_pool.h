@@ -0,0 +1,24 @@
+#pragma once
+
+#include "mercury_api.h"
+#include <type_traits>
+
+namespace mercury::workers
+{
+    /// @brief Threads of the shared pool, hardware concurrency - 1 (0 on Emscripten). They are started on first use and
+    /// sleep between jobs, so the short parallel passes of the canvas and the mesh tools do not pay for thread creation.
+    u32 GetNumWorkers();
+
+    /// @brief Runs task(context, i) for every i in [0, numTasks) and returns once all of them finished. The calling thread
+    /// works too, at most maxThreads threads take part. Tasks are handed out one at a time in index order.
+    /// One job runs at a time, concurrent callers wait for their turn. Calls made from inside a task run inline.
+    void ParallelFor(u32 numTasks, u32 maxThreads, void (*task)(void* context, u32 taskIndex), void* context);
+
+    template<typename Fn>
+    void ParallelFor(u32 numTasks, u32 maxThreads, Fn&& fn)
+    {
+        using FnType = std::remove_reference_t<Fn>;
+        ParallelFor(numTasks, maxThreads, [](void* context, u32 taskIndex) { (*static_cast<FnType*>(context))(taskIndex); },
+            const_cast<void*>(static_cast<const void*>(&fn)));
+    }
+}
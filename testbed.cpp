@@ -1,6 +1,12 @@
 ﻿#include "mercury.h"
 #include "mercury_entry_point.h"
 #include <stdio.h>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
 
 #include "ll/os.h"
 #include "ll/graphics.h"
@@ -207,6 +213,439 @@ using namespace mercury;
 //}
 
 
+// Checks every mercury::simd op against a scalar reference on the backend this build targets (SSE4.1, NEON or
+// WASM SIMD128), then every batch kernel table the CPU supports against the scalar table. Returns the failure count.
+int test_simd_reference()
+{
+       using namespace mercury::simd;
+
+       int failures = 0;
+
+       auto check = [&](bool ok, const char* op, int lane) {
+              if (!ok)
+              {
+                     printf("FAIL %-28s lane %d\n", op, lane);
+                     failures++;
+              }
+       };
+
+       auto near = [](f32 value, f32 expected, f32 tolerance) {
+              return std::fabs(value - expected) <= tolerance * std::max(1.0f, std::fabs(expected));
+       };
+
+       auto checkF = [&](const char* op, f32x4 v, const f32 (&expected)[4], f32 tolerance = 0.0f) {
+              f32 lanes[4];
+              store_f32x4(lanes, v);
+              for (int i = 0; i < 4; ++i)
+                     check(near(lanes[i], expected[i], tolerance), op, i);
+       };
+
+       auto checkI = [&](const char* op, i32x4 v, const i32 (&expected)[4]) {
+              i32 lanes[4];
+              store_i32x4(lanes, v);
+              for (int i = 0; i < 4; ++i)
+                     check(lanes[i] == expected[i], op, i);
+       };
+
+       auto checkMask = [&](const char* op, u32x4 mask, const bool (&expected)[4]) {
+              i32 lanes[4];
+              store_i32x4(lanes, cast_u32x4_to_i32x4(mask));
+              for (int i = 0; i < 4; ++i)
+                     check(lanes[i] == (expected[i] ? -1 : 0), op, i);
+       };
+
+       alignas(16) const f32 a[4] = { 1.5f, -2.25f, 3.0f, -0.5f };
+       alignas(16) const f32 b[4] = { 2.0f, -2.25f, -4.0f, 8.0f };
+       alignas(16) const f32 c[4] = { 0.25f, 10.0f, -1.0f, 3.5f };
+       const i32 ia[4] = { 7, -3, 0, 2147483647 };
+       const i32 ib[4] = { 7, 5, -9, -2147483647 - 1 };
+
+       const f32x4 va = load_f32x4(a), vb = load_f32x4(b), vc = load_f32x4(c);
+       const i32x4 via = load_i32x4(ia), vib = load_i32x4(ib);
+
+       // loads, stores, gathers
+       {
+              alignas(16) f32 out[4] = {};
+              store_aligned_f32x4(out, load_aligned_f32x4(a));
+              checkF("load/store_aligned_f32x4", load_f32x4(out), a);
+
+              stream_f32x4(out, vb);
+              stream_fence();
+              checkF("stream_f32x4", load_f32x4(out), b);
+
+              checkI("splat_i32x4", splat_i32x4(-42), { -42, -42, -42, -42 });
+
+              const f32 table[8] = { 10, 11, 12, 13, 14, 15, 16, 17 };
+              const i32 itable[8] = { -10, -11, -12, -13, -14, -15, -16, -17 };
+              const i32x4 indices = make_i32x4(7, 0, 3, 3);
+              checkF("gather_f32x4", gather_f32x4(table, indices), { 17, 10, 13, 13 });
+              checkI("gather_i32x4", gather_i32x4(itable, indices), { -17, -10, -13, -13 });
+       }
+
+       // conversions and bit casts
+       {
+              checkF("convert_i32x4_to_f32x4", convert_i32x4_to_f32x4(make_i32x4(-3, 0, 5, 16777216)), { -3, 0, 5, 16777216 });
+              checkI("truncate_f32x4_to_i32x4", truncate_f32x4_to_i32x4(make_f32x4(1.9f, -1.9f, 0.5f, -0.5f)), { 1, -1, 0, 0 });
+              checkI("round_f32x4_to_i32x4", round_f32x4_to_i32x4(make_f32x4(2.5f, -1.5f, 0.5f, 3.7f)), { 2, -2, 0, 4 });
+
+              i32 bits[4];
+              store_i32x4(bits, cast_f32x4_to_i32x4(va));
+              for (int i = 0; i < 4; ++i)
+              {
+                     i32 expected;
+                     memcpy(&expected, &a[i], sizeof(expected));
+                     check(bits[i] == expected, "cast_f32x4_to_i32x4", i);
+              }
+              checkF("cast_i32x4_to_f32x4", cast_i32x4_to_f32x4(cast_f32x4_to_i32x4(va)), a);
+              checkI("cast_i32x4/u32x4", cast_u32x4_to_i32x4(cast_i32x4_to_u32x4(via)), ia);
+       }
+
+       // comparisons and mask logic
+       {
+              checkMask("cmpeq_f32x4", cmpeq_f32x4(va, vb), { false, true, false, false });
+              checkMask("cmplt_f32x4", cmplt_f32x4(va, vb), { true, false, false, true });
+              checkMask("cmple_f32x4", cmple_f32x4(va, vb), { true, true, false, true });
+              checkMask("cmpgt_f32x4", cmpgt_f32x4(va, vb), { false, false, true, false });
+              checkMask("cmpge_f32x4", cmpge_f32x4(va, vb), { false, true, true, false });
+              checkMask("cmpeq_i32x4", cmpeq_i32x4(via, vib), { true, false, false, false });
+              checkMask("cmplt_i32x4", cmplt_i32x4(via, vib), { false, true, false, false });
+              checkMask("cmpgt_i32x4", cmpgt_i32x4(via, vib), { false, false, true, true });
+
+              const u32x4 m0 = cmplt_f32x4(va, vb); // 1 0 0 1
+              const u32x4 m1 = cmple_f32x4(va, vb); // 1 1 0 1
+              checkMask("and_u32x4", and_u32x4(m0, m1), { true, false, false, true });
+              checkMask("or_u32x4", or_u32x4(m0, cmpgt_f32x4(va, vb)), { true, false, true, true });
+              checkMask("xor_u32x4", xor_u32x4(m0, m1), { false, true, false, false });
+              checkMask("andnot_u32x4", andnot_u32x4(m1, m0), { false, true, false, false });
+
+              check(movemask_u32x4(m0) == 0b1001u, "movemask_u32x4", 0);
+              check(movemask_u32x4(m1) == 0b1011u, "movemask_u32x4", 1);
+              check(any_u32x4(m0) && !any_u32x4(cmpgt_f32x4(va, splat_f32x4(100.0f))), "any_u32x4", 0);
+              check(!all_u32x4(m1) && all_u32x4(cmplt_f32x4(va, splat_f32x4(100.0f))), "all_u32x4", 0);
+
+              checkF("select_f32x4", select_f32x4(m0, va, vb), { a[0], b[1], b[2], a[3] });
+              checkI("select_i32x4", select_i32x4(m0, via, vib), { ia[0], ib[1], ib[2], ia[3] });
+       }
+
+       // arithmetic
+       {
+              f32 expMinF[4], expMaxF[4], expAbs[4], expNeg[4], expSqrt[4], expRsqrt[4], expFloor[4], expCeil[4], expFma[4], expFnma[4];
+              i32 expMinI[4], expMaxI[4], expAbsI[4];
+              const f32 positive[4] = { 0.25f, 2.0f, 9.0f, 1000.0f };
+              const i32 ic[4] = { -5, 0, 12, -2147483647 };
+
+              for (int i = 0; i < 4; ++i)
+              {
+                     expMinF[i] = std::min(a[i], b[i]);
+                     expMaxF[i] = std::max(a[i], b[i]);
+                     expAbs[i] = std::fabs(a[i]);
+                     expNeg[i] = -a[i];
+                     expSqrt[i] = std::sqrt(positive[i]);
+                     expRsqrt[i] = 1.0f / std::sqrt(positive[i]);
+                     expFloor[i] = std::floor(a[i]);
+                     expCeil[i] = std::ceil(a[i]);
+                     expFma[i] = a[i] * b[i] + c[i];
+                     expFnma[i] = c[i] - a[i] * b[i];
+                     expMinI[i] = std::min(ia[i], ib[i]);
+                     expMaxI[i] = std::max(ia[i], ib[i]);
+                     expAbsI[i] = std::abs(ic[i]);
+              }
+
+              checkF("min_f32x4", min_f32x4(va, vb), expMinF);
+              checkF("max_f32x4", max_f32x4(va, vb), expMaxF);
+              checkI("min_i32x4", min_i32x4(via, vib), expMinI);
+              checkI("max_i32x4", max_i32x4(via, vib), expMaxI);
+              checkF("abs_f32x4", abs_f32x4(va), expAbs);
+              checkI("abs_i32x4", abs_i32x4(load_i32x4(ic)), expAbsI);
+              checkF("neg_f32x4", neg_f32x4(va), expNeg);
+              checkF("sqrt_f32x4", sqrt_f32x4(load_f32x4(positive)), expSqrt, 1e-6f);
+              checkF("rsqrt_f32x4", rsqrt_f32x4(load_f32x4(positive)), expRsqrt, 1e-5f);
+              checkF("floor_f32x4", floor_f32x4(va), expFloor);
+              checkF("ceil_f32x4", ceil_f32x4(va), expCeil);
+              checkF("fmadd_f32x4", fmadd_f32x4(va, vb, vc), expFma, 1e-6f);
+              checkF("fnmadd_f32x4", fnmadd_f32x4(va, vb, vc), expFnma, 1e-6f);
+       }
+
+       // shuffles
+       {
+              checkF("swizzle_f32x4", swizzle_f32x4<3, 0, 2, 2>(va), { a[3], a[0], a[2], a[2] });
+              checkF("shuffle_f32x4", shuffle_f32x4<1, 3, 0, 2>(va, vb), { a[1], a[3], b[0], b[2] });
+              checkF("unpacklo_f32x4", unpacklo_f32x4(va, vb), { a[0], b[0], a[1], b[1] });
+              checkF("unpackhi_f32x4", unpackhi_f32x4(va, vb), { a[2], b[2], a[3], b[3] });
+
+              f32x4 r0 = va, r1 = vb, r2 = vc, r3 = make_f32x4(9, 8, 7, 6);
+              transpose_f32x4(r0, r1, r2, r3);
+              checkF("transpose_f32x4", r0, { a[0], b[0], c[0], 9 });
+              checkF("transpose_f32x4", r1, { a[1], b[1], c[1], 8 });
+              checkF("transpose_f32x4", r2, { a[2], b[2], c[2], 7 });
+              checkF("transpose_f32x4", r3, { a[3], b[3], c[3], 6 });
+       }
+
+       // horizontal reductions
+       {
+              check(near(hsum_f32x4(va), a[0] + a[1] + a[2] + a[3], 1e-6f), "hsum_f32x4", 0);
+              check(hmin_f32x4(va) == -2.25f, "hmin_f32x4", 0);
+              check(hmax_f32x4(vb) == 8.0f, "hmax_f32x4", 0);
+              check(hsum_i32x4(make_i32x4(1, -20, 300, 4000)) == 4281, "hsum_i32x4", 0);
+              check(near(dot4_f32x4(va, vb), a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3], 1e-6f), "dot4_f32x4", 0);
+       }
+
+       // batch kernels, every table the CPU supports against the scalar one, counts cover every tail length
+       {
+              const Kernels* reference = GetKernels(InstructionSet::Scalar);
+
+              constexpr size_t maxCount = 67;
+              std::vector<f32> x(maxCount), y(maxCount), z(maxCount), expected(maxCount), out(maxCount);
+              std::vector<f32> outY(maxCount), outZ(maxCount), expectedY(maxCount), expectedZ(maxCount);
+              for (size_t i = 0; i < maxCount; ++i)
+              {
+                     x[i] = 0.5f * (f32)i - 7.0f;
+                     y[i] = 1.0f / (1.0f + (f32)i);
+                     z[i] = (f32)((i * 37) % 11) - 5.0f;
+              }
+
+              const f32 matrix[16] = { 0.8f, 0.1f, -0.6f, 0, -0.2f, 0.9f, 0.3f, 0, 0.5f, -0.4f, 0.7f, 0, 10, -20, 30, 1 };
+
+              for (InstructionSet isa : { InstructionSet::SSE41, InstructionSet::NEON, InstructionSet::WASM128, InstructionSet::AVX2, InstructionSet::AVX512 })
+              {
+                     const Kernels* kernels = GetKernels(isa);
+                     if (kernels == nullptr)
+                            continue;
+
+                     const char* name = GetInstructionSetName(isa);
+
+                     auto compare = [&](const std::vector<f32>& v, const std::vector<f32>& e, size_t count, const char* op) {
+                            for (size_t i = 0; i < count; ++i)
+                                   if (!near(v[i], e[i], 1e-5f))
+                                   {
+                                          printf("FAIL %s %s count %zu index %zu\n", name, op, count, i);
+                                          failures++;
+                                          return;
+                                   }
+                     };
+
+                     for (size_t count = 0; count <= maxCount; ++count)
+                     {
+                            kernels->add(out.data(), x.data(), y.data(), count);
+                            reference->add(expected.data(), x.data(), y.data(), count);
+                            compare(out, expected, count, "add");
+
+                            kernels->mul(out.data(), x.data(), y.data(), count);
+                            reference->mul(expected.data(), x.data(), y.data(), count);
+                            compare(out, expected, count, "mul");
+
+                            kernels->mulAdd(out.data(), x.data(), y.data(), z.data(), count);
+                            reference->mulAdd(expected.data(), x.data(), y.data(), z.data(), count);
+                            compare(out, expected, count, "mulAdd");
+
+                            kernels->scale(out.data(), x.data(), -1.75f, count);
+                            reference->scale(expected.data(), x.data(), -1.75f, count);
+                            compare(out, expected, count, "scale");
+
+                            if (!near(kernels->dot(x.data(), y.data(), count), reference->dot(x.data(), y.data(), count), 1e-5f))
+                            {
+                                   printf("FAIL %s dot count %zu\n", name, count);
+                                   failures++;
+                            }
+
+                            kernels->transformPoints(matrix, x.data(), y.data(), z.data(), out.data(), outY.data(), outZ.data(), count);
+                            reference->transformPoints(matrix, x.data(), y.data(), z.data(), expected.data(), expectedY.data(), expectedZ.data(), count);
+                            compare(out, expected, count, "transformPoints.x");
+                            compare(outY, expectedY, count, "transformPoints.y");
+                            compare(outZ, expectedZ, count, "transformPoints.z");
+                     }
+
+                     printf("SIMD kernels %-12s checked (%u lanes)\n", name, kernels->width);
+              }
+       }
+
+#if defined(__ARM_NEON)
+       const char* backend = "NEON";
+#elif defined(MERCURY_LL_OS_EMSCRIPTEN)
+       const char* backend = "WASM SIMD128";
+#else
+       const char* backend = "SSE4.1";
+#endif
+       printf("SIMD reference test (%s): %s, %d failures\n", backend, failures == 0 ? "PASSED" : "FAILED", failures);
+       return failures;
+}
+
+// Measures ns/op of the O(1) bucket lookups against the linear scan they replaced.
+void bench_memory()
+{
+       mercury::memory::ReservedAllocator::InitDesc initDesc;
+
+       for (u32 elementSize = 16; elementSize <= 16384; elementSize *= 2)
+              initDesc.bucketsInfo.push_back({(u16)elementSize, 16_MB, 1_MB});
+
+       mercury::memory::ReservedAllocator allocator(initDesc);
+
+       constexpr int numOps = 1 << 15;
+       std::vector<void*> ptrs(numOps);
+       std::vector<u16> sizes(numOps);
+
+       for (int i = 0; i < numOps; ++i)
+              sizes[i] = (u16)(1 + (i * 7919) % 512);
+
+       volatile u32 sink = 0;
+
+       auto scanForSize = [&](size_t size) -> int {
+              for (int i = 0; i < allocator.numBuckets; ++i)
+                     if (allocator.bucketSizes[i] >= size)
+                            return i;
+              return -1;
+       };
+
+       auto scanForPtr = [&](void* ptr) -> int {
+              for (int i = 0; i < allocator.numBuckets; ++i)
+                     if (allocator.buckets[i].IsPtrInBucketRange(ptr))
+                            return i;
+              return -1;
+       };
+
+       auto measure = [&](const char* name, auto&& op) {
+              auto start = std::chrono::high_resolution_clock::now();
+              for (int i = 0; i < numOps; ++i)
+                     op(i);
+              auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+              printf("%-32s %6.2f ns/op\n", name, (double)ns / numOps);
+       };
+
+       for (int i = 0; i < numOps; ++i)
+              ptrs[i] = allocator.Allocate(sizes[i]);
+
+       measure("size -> bucket (linear scan)", [&](int i) { sink = sink + scanForSize(sizes[i]); });
+       measure("size -> bucket (size class)", [&](int i) { sink = sink + allocator.GetBucketIndexForSize(sizes[i]); });
+       measure("ptr -> bucket (linear scan)", [&](int i) { sink = sink + scanForPtr(ptrs[i]); });
+       measure("ptr -> bucket (address shift)", [&](int i) { sink = sink + allocator.GetBucketIndexForPtr(ptrs[i]); });
+
+       measure("Deallocate", [&](int i) { allocator.Deallocate(ptrs[i]); });
+       measure("Allocate", [&](int i) { ptrs[i] = allocator.Allocate(sizes[i]); });
+       measure("ReAllocate", [&](int i) { ptrs[i] = allocator.ReAllocate(ptrs[i], sizes[numOps - 1 - i]); });
+
+       for (int i = 0; i < numOps; ++i)
+              allocator.Deallocate(ptrs[i]);
+}
+
+// Replays an allocation trace (ReservedAllocator::InitDesc::traceFilePath) against candidate bucket layouts.
+// layoutPath is a layout written by tools/allocator_tuner --layout-out, it is compared with the default layout.
+void bench_allocator_trace(const char* tracePath, const char* layoutPath = nullptr)
+{
+       std::vector<mercury::memory::trace::Event> events;
+
+       FILE* traceFile = fopen(tracePath, "rb");
+       mercury::memory::trace::Header header;
+
+       if (traceFile == nullptr || fread(&header, sizeof(header), 1, traceFile) != 1 || header.magic != mercury::memory::trace::Magic)
+       {
+              printf("can't read trace %s\n", tracePath);
+              if (traceFile)
+                     fclose(traceFile);
+              return;
+       }
+
+       mercury::memory::trace::Event event;
+       while (fread(&event, sizeof(event), 1, traceFile) == 1)
+              events.push_back(event);
+       fclose(traceFile);
+
+       std::vector<std::pair<const char*, mercury::memory::ReservedAllocator::InitDesc>> layouts;
+
+       mercury::memory::ReservedAllocator::InitDesc defaultDesc;
+       for (u32 elementSize = 16; elementSize <= 16384; elementSize *= 2)
+              defaultDesc.bucketsInfo.push_back({(u16)elementSize, 16_MB, 1_MB});
+       layouts.push_back({"default", defaultDesc});
+
+       if (FILE* layoutFile = layoutPath ? fopen(layoutPath, "r") : nullptr)
+       {
+              mercury::memory::ReservedAllocator::InitDesc tunedDesc;
+              unsigned int elementSize = 0, reservedSize = 0, initialSize = 0;
+
+              while (fscanf(layoutFile, "%u %u %u", &elementSize, &reservedSize, &initialSize) == 3)
+                     tunedDesc.bucketsInfo.push_back({(u16)elementSize, reservedSize, initialSize});
+              fclose(layoutFile);
+
+              layouts.push_back({layoutPath, tunedDesc});
+       }
+
+       for (auto& [name, desc] : layouts)
+       {
+              mercury::memory::ReservedAllocator allocator(desc);
+              std::unordered_map<u64, void*> live; // recorded address -> replayed pointer
+              live.reserve(events.size() / 2);
+
+              mercury::memory::ReservedAllocator::Snapshot peak;
+
+              auto start = std::chrono::high_resolution_clock::now();
+              for (const auto& e : events)
+              {
+                     if (e.type == mercury::memory::trace::EventType::Allocate)
+                     {
+                            live[e.address] = allocator.Allocate(e.size);
+                     }
+                     else if (auto it = live.find(e.address); it != live.end())
+                     {
+                            allocator.Deallocate(it->second);
+                            live.erase(it);
+                     }
+              }
+              auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+              // buckets never shrink without Trim, so the committed size now is the peak of the replay
+              allocator.GetSnapshot(peak);
+
+              printf("%-24s %6.2f ns/event, committed %s, mallocs %llu\n", name, (double)ns / events.size(),
+                     mercury::utils::string::format_size(peak.committedSize).c_str(), peak.totalMallocAllocations);
+
+              for (auto& [address, ptr] : live)
+                     allocator.Deallocate(ptr);
+       }
+}
+
+void bench_tangents()
+{
+       struct Case { const char* name; mercury::geometry::StaticMeshData mesh; };
+       Case cases[] = {
+              {"plane 32x32", mercury::geometry::CreatePlaneMesh(16.0f, 16.0f, 31, 31)},
+              {"plane 128x128", mercury::geometry::CreatePlaneMesh(16.0f, 16.0f, 127, 127)},
+              {"plane 256x256", mercury::geometry::CreatePlaneMesh(16.0f, 16.0f, 255, 255)},
+              {"geosphere 6", mercury::geometry::CreateGeoSphereMesh(1.0f, 6)},
+       };
+
+       const int iterations = 50;
+
+       for (auto& [name, mesh] : cases)
+       {
+              auto reference = mesh;
+              reference.RecomputeTangentsScalar();
+
+              auto time = [&](auto&& fn) {
+                     auto start = std::chrono::high_resolution_clock::now();
+                     for (int i = 0; i < iterations; ++i)
+                            fn();
+                     return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+              };
+
+              double scalarMs = time([&] { mesh.RecomputeTangentsScalar(); });
+              double simdMs = time([&] { mesh.RecomputeTangents(1); });
+              double threadedMs = time([&] { mesh.RecomputeTangents(0); });
+              double normalsMs = time([&] { mesh.RecomputeNormals(0); });
+
+              mesh = reference;
+              mesh.RecomputeTangents(0);
+
+              float maxError = 0.0f;
+              for (size_t i = 0; i < mesh.vertices.size(); ++i)
+              {
+                     glm::vec3 d = glm::abs(mesh.vertices[i].tangent - reference.vertices[i].tangent);
+                     maxError = std::max(maxError, std::max(d.x, std::max(d.y, d.z)));
+              }
+
+              printf("%-16s %6zu verts: scalar %.3f ms, simd %.3f ms, simd+threads %.3f ms, normals %.3f ms, max error %g\n", name,
+                     mesh.vertices.size(), scalarMs, simdMs, threadedMs, normalsMs, maxError);
+       }
+}
+
 class TestBedApplication : public Application {
 
        bool m_running = true;
@@ -258,7 +697,11 @@ TestBedApplication gApplication;
 void TestBedApplication::Initialize() {
        MLOG_DEBUG(u8"TestBedApplication::Initialize SOME CHANGES 2");
        //test_simd();
+       //test_simd_reference();
        //test_memory();
+       //bench_memory();
+       //bench_allocator_trace("allocations.trace", "allocations.layout");
+       //bench_tangents();
 
       // memory::gGraphicsMemoryAllocator->DumpStatsPerBucketTotal();
        testTriangleVS = ll::graphics::gDevice->CreateShaderModule(ll::graphics::embedded_shaders::TestTriangleRotatedVS());
@@ -0,0 +1,434 @@
+// Offline bucket layout tuner for mercury::memory::ReservedAllocator.
+//
+// Reads an allocation trace recorded with ReservedAllocator::InitDesc::traceFilePath, replays it per size class
+// and searches the bucket layout with the smallest committed footprint at peak. Committed memory already contains the
+// rounding waste of every live allocation, so minimizing it minimizes internal fragmentation and committed pages.
+//
+// usage: allocator_tuner <trace.bin> [--max-buckets N] [--max-element-size BYTES] [--alignment BYTES]
+//                                    [--page-size BYTES] [--reserve-factor N] [--layout-out FILE]
+//
+// Slots start at multiples of the element size, so element sizes are kept multiples of --alignment (16 by default,
+// what the engine's callers expect from malloc).
+//
+// Prints a comparison against the default power of two layout and an InitDesc snippet. --layout-out writes the same
+// layout as text lines "elementSize maximumReservedSize initialCommittedSize" for the testbed replay benchmark.
+
+#include "mercury_memory.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mercury;
+using namespace mercury::memory;
+
+namespace
+{
+    struct Options
+    {
+        const char* tracePath = nullptr;
+        const char* layoutOutPath = nullptr;
+        u32 maxBuckets = 16;
+        u32 maxElementSize = 16384;
+        u32 alignment = 16;
+        u32 pageSize = 4096;
+        u32 reserveFactor = 4;
+    };
+
+    // every live allocation is accounted in its size class, classes are granularity bytes wide
+    struct SizeClass
+    {
+        u32 size = 0; // largest size of the class
+        u64 allocations = 0;
+        u64 requestedBytes = 0;
+        u64 lifetimeSum = 0; // in events
+        std::vector<u32> windowPeak; // live allocations, maximum inside every time window
+    };
+
+    struct BucketLayout
+    {
+        u32 elementSize = 0;
+        u64 peakLive = 0;
+        u64 committedSize = 0;
+        u64 allocations = 0;
+        u64 wasteBytes = 0; // sum of (elementSize - requested size) over all allocations
+    };
+
+    constexpr u32 MaxWindows = 256;
+
+    u64 AlignUp(u64 value, u64 alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            auto nextValue = [&]() -> u32 { return i + 1 < argc ? (u32)strtoul(argv[++i], nullptr, 10) : 0; };
+
+            if (strcmp(argv[i], "--max-buckets") == 0)
+                options.maxBuckets = nextValue();
+            else if (strcmp(argv[i], "--max-element-size") == 0)
+                options.maxElementSize = nextValue();
+            else if (strcmp(argv[i], "--alignment") == 0)
+                options.alignment = nextValue();
+            else if (strcmp(argv[i], "--page-size") == 0)
+                options.pageSize = nextValue();
+            else if (strcmp(argv[i], "--reserve-factor") == 0)
+                options.reserveFactor = nextValue();
+            else if (strcmp(argv[i], "--layout-out") == 0 && i + 1 < argc)
+                options.layoutOutPath = argv[++i];
+            else if (argv[i][0] != '-' && options.tracePath == nullptr)
+                options.tracePath = argv[i];
+            else
+                return false;
+        }
+
+        // buckets are indexed by u8 and thread safe allocators cache at most MaxThreadCachedBuckets of them
+        return options.tracePath != nullptr && options.maxBuckets > 0 && options.maxBuckets <= ReservedAllocator::MaxThreadCachedBuckets &&
+               options.maxElementSize >= 16 && options.maxElementSize <= 0xFFFF && options.pageSize > 0 &&
+               options.alignment >= ReservedAllocator::SizeClassGranularity && (options.alignment & (options.alignment - 1)) == 0;
+    }
+
+    bool LoadTrace(const char* path, std::vector<trace::Event>& events)
+    {
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr)
+            return false;
+
+        trace::Header header;
+        bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == trace::Magic && header.version == trace::Version;
+
+        if (valid)
+        {
+            trace::Event block[4096];
+            size_t count = 0;
+
+            while ((count = fread(block, sizeof(trace::Event), 4096, file)) > 0)
+                events.insert(events.end(), block, block + count);
+        }
+
+        fclose(file);
+        return valid;
+    }
+
+    // replays the trace and fills the per class live counts; classes come out sorted by size
+    std::vector<SizeClass> BuildSizeClasses(const std::vector<trace::Event>& events, u32 maxElementSize, u32 granularity)
+    {
+        struct LiveAllocation
+        {
+            u32 classIndex;
+            u64 eventIndex;
+        };
+
+        u32 numClasses = maxElementSize / granularity + 1;
+        std::vector<SizeClass> classes(numClasses);
+        std::vector<u32> live(numClasses, 0);
+        std::unordered_map<u64, LiveAllocation> liveAllocations;
+
+        u32 numWindows = (u32)std::min<size_t>(MaxWindows, std::max<size_t>(events.size(), 1));
+        size_t eventsPerWindow = (events.size() + numWindows - 1) / numWindows;
+
+        // buckets are at least 16 bytes, smaller requests share the first class
+        u32 firstClass = (16 + granularity - 1) / granularity;
+
+        for (u32 i = 0; i < numClasses; ++i)
+        {
+            classes[i].size = i * granularity;
+            classes[i].windowPeak.resize(numWindows, 0);
+        }
+
+        auto release = [&](u64 address, u64 eventIndex) {
+            auto it = liveAllocations.find(address);
+            if (it == liveAllocations.end())
+                return;
+
+            SizeClass& sizeClass = classes[it->second.classIndex];
+            sizeClass.lifetimeSum += eventIndex - it->second.eventIndex;
+            live[it->second.classIndex]--;
+
+            liveAllocations.erase(it);
+        };
+
+        for (size_t i = 0; i < events.size(); ++i)
+        {
+            const trace::Event& event = events[i];
+            u32 window = (u32)(i / eventsPerWindow);
+
+            // an address allocated twice lost its free event, treat it as freed
+            release(event.address, i);
+
+            if (event.type == trace::EventType::Allocate && event.size <= maxElementSize)
+            {
+                u32 classIndex = std::max((event.size + granularity - 1) / granularity, firstClass);
+                SizeClass& sizeClass = classes[classIndex];
+
+                sizeClass.allocations++;
+                sizeClass.requestedBytes += event.size;
+
+                live[classIndex]++;
+                sizeClass.windowPeak[window] = std::max(sizeClass.windowPeak[window], live[classIndex]);
+                liveAllocations[event.address] = {classIndex, i};
+            }
+
+            if ((i + 1) % eventsPerWindow == 0 || i + 1 == events.size())
+            {
+                // the next window starts at the current level even if nothing of the class is allocated there
+                for (u32 c = 0; c < numClasses && window + 1 < numWindows; ++c)
+                    classes[c].windowPeak[window + 1] = live[c];
+            }
+        }
+
+        // still alive at the end of the trace
+        for (auto& [address, allocation] : liveAllocations)
+            classes[allocation.classIndex].lifetimeSum += events.size() - allocation.eventIndex;
+
+        classes.erase(std::remove_if(classes.begin(), classes.end(), [](const SizeClass& c) { return c.allocations == 0; }), classes.end());
+        return classes;
+    }
+
+    // prefix sums over classes of the per window peaks, so the peak of any class range is one pass over the windows.
+    // Summing per class maxima of a window over-estimates the peak of the range a little, never under-estimates it.
+    struct RangeEvaluator
+    {
+        const std::vector<SizeClass>& classes;
+        const Options& options;
+        u32 numWindows = 0;
+        std::vector<u64> prefixPeak; // (numClasses + 1) x numWindows
+        std::vector<u64> prefixAllocations;
+        std::vector<u64> prefixRequested;
+
+        RangeEvaluator(const std::vector<SizeClass>& sizeClasses, const Options& tunerOptions) : classes(sizeClasses), options(tunerOptions)
+        {
+            numWindows = classes.empty() ? 0 : (u32)classes[0].windowPeak.size();
+
+            size_t n = classes.size();
+            prefixPeak.assign((n + 1) * numWindows, 0);
+            prefixAllocations.assign(n + 1, 0);
+            prefixRequested.assign(n + 1, 0);
+
+            for (size_t c = 0; c < n; ++c)
+            {
+                for (u32 w = 0; w < numWindows; ++w)
+                    prefixPeak[(c + 1) * numWindows + w] = prefixPeak[c * numWindows + w] + classes[c].windowPeak[w];
+
+                prefixAllocations[c + 1] = prefixAllocations[c] + classes[c].allocations;
+                prefixRequested[c + 1] = prefixRequested[c] + classes[c].requestedBytes;
+            }
+        }
+
+        // bucket of elementSize serving classes [first, last]
+        BucketLayout Evaluate(size_t first, size_t last, u32 elementSize) const
+        {
+            BucketLayout bucket;
+            bucket.elementSize = elementSize;
+
+            for (u32 w = 0; w < numWindows; ++w)
+                bucket.peakLive = std::max(bucket.peakLive, prefixPeak[(last + 1) * numWindows + w] - prefixPeak[first * numWindows + w]);
+
+            bucket.allocations = prefixAllocations[last + 1] - prefixAllocations[first];
+            bucket.wasteBytes = bucket.allocations * elementSize - (prefixRequested[last + 1] - prefixRequested[first]);
+
+            // the emitted initialCommittedSize covers the peak, so the bucket never grows in 256 element steps
+            bucket.committedSize = AlignUp(std::max<u64>(bucket.peakLive * elementSize, 1), options.pageSize);
+
+            return bucket;
+        }
+    };
+
+    std::vector<BucketLayout> TuneLayout(const RangeEvaluator& evaluator, u32 maxBuckets)
+    {
+        const auto& classes = evaluator.classes;
+        size_t n = classes.size();
+        u32 numBuckets = (u32)std::min<size_t>(maxBuckets, n);
+
+        // cost[k][i]: smallest committed size serving classes [0, i) with k buckets, the last one ending at class i - 1
+        const u64 infinity = ~0ull;
+        std::vector<std::vector<u64>> cost(numBuckets + 1, std::vector<u64>(n + 1, infinity));
+        std::vector<std::vector<u32>> split(numBuckets + 1, std::vector<u32>(n + 1, 0));
+        cost[0][0] = 0;
+
+        std::vector<u64> rangeCost(n * n, 0);
+        for (size_t first = 0; first < n; ++first)
+            for (size_t last = first; last < n; ++last)
+                rangeCost[first * n + last] = evaluator.Evaluate(first, last, classes[last].size).committedSize;
+
+        for (u32 k = 1; k <= numBuckets; ++k)
+        {
+            for (size_t i = k; i <= n; ++i)
+            {
+                for (size_t j = k - 1; j < i; ++j)
+                {
+                    if (cost[k - 1][j] == infinity)
+                        continue;
+
+                    u64 candidate = cost[k - 1][j] + rangeCost[j * n + (i - 1)];
+
+                    if (candidate < cost[k][i])
+                    {
+                        cost[k][i] = candidate;
+                        split[k][i] = (u32)j;
+                    }
+                }
+            }
+        }
+
+        // prefer fewer buckets on ties
+        u32 bestK = 1;
+        for (u32 k = 1; k <= numBuckets; ++k)
+        {
+            if (cost[k][n] < cost[bestK][n])
+                bestK = k;
+        }
+
+        std::vector<BucketLayout> layout;
+        for (size_t i = n, k = bestK; k > 0; --k)
+        {
+            size_t j = split[k][i];
+            layout.push_back(evaluator.Evaluate(j, i - 1, classes[i - 1].size));
+            i = j;
+        }
+
+        std::reverse(layout.begin(), layout.end());
+        return layout;
+    }
+
+    // the layout the engine uses when nothing is tuned: power of two buckets from 16 bytes
+    std::vector<BucketLayout> DefaultLayout(const RangeEvaluator& evaluator, u32 maxElementSize)
+    {
+        const auto& classes = evaluator.classes;
+        std::vector<BucketLayout> layout;
+
+        size_t first = 0;
+        for (u32 elementSize = 16; elementSize <= maxElementSize && first < classes.size(); elementSize *= 2)
+        {
+            size_t last = first;
+            while (last < classes.size() && classes[last].size <= elementSize)
+                last++;
+
+            if (last > first)
+                layout.push_back(evaluator.Evaluate(first, last - 1, elementSize));
+
+            first = last;
+        }
+
+        return layout;
+    }
+
+    void PrintLayout(const char* name, const std::vector<BucketLayout>& layout)
+    {
+        u64 committed = 0;
+        u64 waste = 0;
+        u64 allocations = 0;
+
+        for (const BucketLayout& bucket : layout)
+        {
+            committed += bucket.committedSize;
+            waste += bucket.wasteBytes;
+            allocations += bucket.allocations;
+        }
+
+        printf("%s: %zu buckets, peak committed %.1f KB, average waste %.2f bytes per allocation\n", name, layout.size(),
+               committed / 1024.0, allocations > 0 ? (double)waste / allocations : 0.0);
+
+        for (const BucketLayout& bucket : layout)
+        {
+            printf("    %5u B: peak %8llu live, committed %9.1f KB, waste %6.2f B/alloc\n", bucket.elementSize, bucket.peakLive,
+                   bucket.committedSize / 1024.0, bucket.allocations > 0 ? (double)bucket.wasteBytes / bucket.allocations : 0.0);
+        }
+    }
+
+    std::string SizeLiteral(u64 size)
+    {
+        if (size % (1024 * 1024) == 0)
+            return std::to_string(size / (1024 * 1024)) + "_MB";
+
+        if (size % 1024 == 0)
+            return std::to_string(size / 1024) + "_KB";
+
+        return std::to_string(size);
+    }
+
+    void EmitLayout(const Options& options, const std::vector<BucketLayout>& layout, size_t numEvents)
+    {
+        FILE* layoutFile = options.layoutOutPath ? fopen(options.layoutOutPath, "w") : nullptr;
+
+        printf("\n// generated by allocator_tuner from %s (%zu events)\n", options.tracePath, numEvents);
+
+        for (const BucketLayout& bucket : layout)
+        {
+            // reserve headroom over the recorded peak, commit the peak up front
+            u64 reserved = AlignUp(bucket.committedSize * options.reserveFactor, options.pageSize);
+            u64 initial = bucket.committedSize;
+
+            printf("initDesc.bucketsInfo.push_back({%u, %s, %s});\n", bucket.elementSize, SizeLiteral(reserved).c_str(), SizeLiteral(initial).c_str());
+
+            if (layoutFile)
+                fprintf(layoutFile, "%u %llu %llu\n", bucket.elementSize, reserved, initial);
+        }
+
+        if (layoutFile)
+            fclose(layoutFile);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!ParseOptions(argc, argv, options))
+    {
+        printf("usage: allocator_tuner <trace.bin> [--max-buckets N] [--max-element-size BYTES] [--alignment BYTES] "
+               "[--page-size BYTES] [--reserve-factor N] [--layout-out FILE]\n");
+        return 1;
+    }
+
+    std::vector<trace::Event> events;
+    if (!LoadTrace(options.tracePath, events))
+    {
+        printf("can't read trace %s\n", options.tracePath);
+        return 1;
+    }
+
+    // keep the range search affordable: widen size classes until there are at most 512 of them
+    std::vector<SizeClass> classes;
+    for (u32 granularity = options.alignment;; granularity *= 2)
+    {
+        classes = BuildSizeClasses(events, options.maxElementSize, granularity);
+        if (classes.size() <= 512)
+            break;
+    }
+
+    if (classes.empty())
+    {
+        printf("trace %s has no allocations up to %u bytes\n", options.tracePath, options.maxElementSize);
+        return 1;
+    }
+
+    u64 allocations = 0;
+    u64 lifetimeSum = 0;
+    for (const SizeClass& sizeClass : classes)
+    {
+        allocations += sizeClass.allocations;
+        lifetimeSum += sizeClass.lifetimeSum;
+    }
+
+    printf("%zu events, %llu bucket sized allocations in %zu size classes, average lifetime %.1f events\n\n", events.size(), allocations,
+           classes.size(), (double)lifetimeSum / allocations);
+
+    RangeEvaluator evaluator(classes, options);
+
+    std::vector<BucketLayout> defaultLayout = DefaultLayout(evaluator, options.maxElementSize);
+    std::vector<BucketLayout> tunedLayout = TuneLayout(evaluator, options.maxBuckets);
+
+    PrintLayout("default", defaultLayout);
+    PrintLayout("tuned", tunedLayout);
+
+    EmitLayout(options, tunedLayout, events.size());
+    return 0;
+}